@@ -18,12 +18,15 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	../../../../../../src/AnimationManager.cpp \
 	../../../../../../src/AnimationMedia.cpp \
 	../../../../../../src/AnimationSet.cpp \
+	../../../../../../src/AStarClusterGraph.cpp \
 	../../../../../../src/AStarContainer.cpp \
 	../../../../../../src/AStarNode.cpp \
 	../../../../../../src/Avatar.cpp \
 	../../../../../../src/Camera.cpp \
 	../../../../../../src/CampaignManager.cpp \
 	../../../../../../src/CombatText.cpp \
+	../../../../../../src/CompiledFile.cpp \
+	../../../../../../src/CompiledMap.cpp \
 	../../../../../../src/CursorManager.cpp \
 	../../../../../../src/DeviceList.cpp \
 	../../../../../../src/EffectManager.cpp \
@@ -57,6 +60,8 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	../../../../../../src/Map.cpp \
 	../../../../../../src/MapParallax.cpp \
 	../../../../../../src/MapCollision.cpp \
+	../../../../../../src/MapLoader.cpp \
+	../../../../../../src/MapLayer.cpp \
 	../../../../../../src/MapRenderer.cpp \
 	../../../../../../src/Menu.cpp \
 	../../../../../../src/MenuActionBar.cpp \
@@ -84,13 +89,18 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	../../../../../../src/MenuTouchControls.cpp \
 	../../../../../../src/MenuVendor.cpp \
 	../../../../../../src/MessageEngine.cpp \
+	../../../../../../src/ModArchive.cpp \
+	../../../../../../src/ModIndex.cpp \
 	../../../../../../src/ModManager.cpp \
 	../../../../../../src/NPC.cpp \
 	../../../../../../src/NPCManager.cpp \
 	../../../../../../src/PowerManager.cpp \
+	../../../../../../src/Profiler.cpp \
 	../../../../../../src/QuestLog.cpp \
 	../../../../../../src/RenderDevice.cpp \
+	../../../../../../src/RenderableSorter.cpp \
 	../../../../../../src/SaveLoad.cpp \
+	../../../../../../src/SaveWriter.cpp \
 	../../../../../../src/SDLInputState.cpp \
 	../../../../../../src/SDLHardwareRenderDevice.cpp \
 	../../../../../../src/SDLSoftwareRenderDevice.cpp \
@@ -100,13 +110,18 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	../../../../../../src/SharedGameResources.cpp \
 	../../../../../../src/SharedResources.cpp \
 	../../../../../../src/SoundManager.cpp \
+	../../../../../../src/SpatialGrid.cpp \
 	../../../../../../src/StatBlock.cpp \
 	../../../../../../src/Stats.cpp \
 	../../../../../../src/Subtitles.cpp \
+	../../../../../../src/TextureAtlas.cpp \
 	../../../../../../src/TileSet.cpp \
+	../../../../../../src/TileChunkCache.cpp \
+	../../../../../../src/TimerWheel.cpp \
 	../../../../../../src/TooltipData.cpp \
 	../../../../../../src/TooltipManager.cpp \
 	../../../../../../src/Utils.cpp \
+	../../../../../../src/UtilsBlit.cpp \
 	../../../../../../src/UtilsDebug.cpp \
 	../../../../../../src/UtilsFileSystem.cpp \
 	../../../../../../src/UtilsParsing.cpp \
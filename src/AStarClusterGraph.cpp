@@ -0,0 +1,483 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "AStarClusterGraph.h"
+#include "MapCollision.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+
+namespace {
+	// entrance runs at least this long get an entrance at both ends instead of one in the middle
+	const int LONG_ENTRANCE = 6;
+
+	const float DIAGONAL_COST = 1.41421356f;
+
+	typedef std::pair<float, int> QueueItem;
+}
+
+AStarClusterGraph::Cluster::Cluster()
+	: offset(0)
+	, dirty(true)
+{
+}
+
+AStarClusterGraph::AStarClusterGraph()
+	: collider(NULL)
+	, movement_type(0)
+	, needs_update(false)
+{
+}
+
+AStarClusterGraph::~AStarClusterGraph() {
+}
+
+void AStarClusterGraph::init(const MapCollision* _collider, int _movement_type) {
+	collider = _collider;
+	movement_type = _movement_type;
+	map_size = collider->map_size;
+
+	cluster_count.x = (map_size.x + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+	cluster_count.y = (map_size.y + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+
+	const size_t count = static_cast<size_t>(cluster_count.x) * cluster_count.y;
+
+	clusters.clear();
+	clusters.resize(count);
+
+	borders_h.clear();
+	borders_h.resize(count);
+	borders_v.clear();
+	borders_v.resize(count);
+	borders_h_dirty.assign(count, true);
+	borders_v_dirty.assign(count, true);
+
+	local_dist.resize(CLUSTER_SIZE * CLUSTER_SIZE);
+	local_closed.resize(CLUSTER_SIZE * CLUSTER_SIZE);
+
+	needs_update = true;
+}
+
+void AStarClusterGraph::invalidateTile(int tile_x, int tile_y) {
+	if (clusters.empty() || tile_x < 0 || tile_y < 0 || tile_x >= map_size.x || tile_y >= map_size.y)
+		return;
+
+	int cx = tile_x / CLUSTER_SIZE;
+	int cy = tile_y / CLUSTER_SIZE;
+	int cluster = cx + cy * cluster_count.x;
+
+	clusters[cluster].dirty = true;
+
+	// entrances only exist on cluster edges
+	if (tile_x % CLUSTER_SIZE == CLUSTER_SIZE - 1)
+		borders_h_dirty[cluster] = true;
+	if (tile_x % CLUSTER_SIZE == 0 && cx > 0)
+		borders_h_dirty[cluster - 1] = true;
+	if (tile_y % CLUSTER_SIZE == CLUSTER_SIZE - 1)
+		borders_v_dirty[cluster] = true;
+	if (tile_y % CLUSTER_SIZE == 0 && cy > 0)
+		borders_v_dirty[cluster - cluster_count.x] = true;
+
+	needs_update = true;
+}
+
+int AStarClusterGraph::getClusterIndex(const Point& tile) const {
+	return (tile.x / CLUSTER_SIZE) + (tile.y / CLUSTER_SIZE) * cluster_count.x;
+}
+
+Rect AStarClusterGraph::getClusterRect(int cluster) const {
+	Rect r;
+	r.x = (cluster % cluster_count.x) * CLUSTER_SIZE;
+	r.y = (cluster / cluster_count.x) * CLUSTER_SIZE;
+	r.w = std::min(CLUSTER_SIZE, map_size.x - r.x);
+	r.h = std::min(CLUSTER_SIZE, map_size.y - r.y);
+	return r;
+}
+
+/**
+ * Only paths that leave the immediate neighbourhood of the start cluster are worth a graph search
+ */
+bool AStarClusterGraph::isFar(const Point& start, const Point& end) const {
+	int dx = abs(start.x / CLUSTER_SIZE - end.x / CLUSTER_SIZE);
+	int dy = abs(start.y / CLUSTER_SIZE - end.y / CLUSTER_SIZE);
+	return dx > 1 || dy > 1;
+}
+
+/**
+ * Rebuild everything that was flagged since the last search
+ */
+void AStarClusterGraph::update() {
+	for (size_t i = 0; i < clusters.size(); ++i) {
+		int cx = static_cast<int>(i) % cluster_count.x;
+		int cy = static_cast<int>(i) / cluster_count.x;
+
+		if (borders_h_dirty[i]) {
+			updateBorder(static_cast<int>(i), false);
+			clusters[i].dirty = true;
+			if (cx + 1 < cluster_count.x)
+				clusters[i + 1].dirty = true;
+		}
+		if (borders_v_dirty[i]) {
+			updateBorder(static_cast<int>(i), true);
+			clusters[i].dirty = true;
+			if (cy + 1 < cluster_count.y)
+				clusters[i + cluster_count.x].dirty = true;
+		}
+	}
+
+	for (size_t i = 0; i < clusters.size(); ++i) {
+		if (clusters[i].dirty)
+			updateCluster(static_cast<int>(i));
+	}
+
+	updatePartners();
+
+	needs_update = false;
+}
+
+/**
+ * Find the entrances between a cluster and its right (or lower, if vertical) neighbour
+ */
+void AStarClusterGraph::updateBorder(int border, bool vertical) {
+	std::vector<Point>& entrances = vertical ? borders_v[border] : borders_h[border];
+	entrances.clear();
+
+	if (vertical)
+		borders_v_dirty[border] = false;
+	else
+		borders_h_dirty[border] = false;
+
+	Rect r = getClusterRect(border);
+
+	// the last row/column of clusters has no neighbour
+	if (!vertical && r.x + r.w >= map_size.x)
+		return;
+	if (vertical && r.y + r.h >= map_size.y)
+		return;
+
+	int length = vertical ? r.w : r.h;
+	int run_start = -1;
+
+	for (int i = 0; i <= length; ++i) {
+		bool open = false;
+		Point tile;
+
+		if (i < length) {
+			if (vertical)
+				tile = Point(r.x + i, r.y + r.h - 1);
+			else
+				tile = Point(r.x + r.w - 1, r.y + i);
+
+			Point other = vertical ? Point(tile.x, tile.y + 1) : Point(tile.x + 1, tile.y);
+			open = collider->isValidTerrain(tile.x, tile.y, movement_type) && collider->isValidTerrain(other.x, other.y, movement_type);
+		}
+
+		if (open && run_start == -1) {
+			run_start = i;
+		}
+		else if (!open && run_start != -1) {
+			int run_end = i - 1;
+			if (run_end - run_start + 1 >= LONG_ENTRANCE) {
+				entrances.push_back(vertical ? Point(r.x + run_start, r.y + r.h - 1) : Point(r.x + r.w - 1, r.y + run_start));
+				entrances.push_back(vertical ? Point(r.x + run_end, r.y + r.h - 1) : Point(r.x + r.w - 1, r.y + run_end));
+			}
+			else {
+				int mid = (run_start + run_end) / 2;
+				entrances.push_back(vertical ? Point(r.x + mid, r.y + r.h - 1) : Point(r.x + r.w - 1, r.y + mid));
+			}
+			run_start = -1;
+		}
+	}
+}
+
+/**
+ * Collect the entrance nodes of a cluster and the walking distances between them
+ * Nodes are ordered: right border, lower border, left border, upper border
+ */
+void AStarClusterGraph::updateCluster(int cluster) {
+	Cluster& c = clusters[cluster];
+	int cx = cluster % cluster_count.x;
+	int cy = cluster / cluster_count.x;
+
+	c.nodes.clear();
+	c.nodes.insert(c.nodes.end(), borders_h[cluster].begin(), borders_h[cluster].end());
+	c.nodes.insert(c.nodes.end(), borders_v[cluster].begin(), borders_v[cluster].end());
+	if (cx > 0) {
+		const std::vector<Point>& left = borders_h[cluster - 1];
+		for (size_t i = 0; i < left.size(); ++i)
+			c.nodes.push_back(Point(left[i].x + 1, left[i].y));
+	}
+	if (cy > 0) {
+		const std::vector<Point>& up = borders_v[cluster - cluster_count.x];
+		for (size_t i = 0; i < up.size(); ++i)
+			c.nodes.push_back(Point(up[i].x, up[i].y + 1));
+	}
+
+	const size_t node_count = c.nodes.size();
+	c.dist.resize(node_count * node_count);
+
+	std::vector<float> node_dist;
+	for (size_t i = 0; i < node_count; ++i) {
+		clusterDistances(cluster, c.nodes[i], node_dist);
+		for (size_t j = 0; j < node_count; ++j) {
+			c.dist[i * node_count + j] = node_dist[j];
+		}
+	}
+
+	c.dirty = false;
+}
+
+/**
+ * Assign graph-wide node indexes and link both sides of every entrance
+ */
+void AStarClusterGraph::updatePartners() {
+	int total = 0;
+	for (size_t i = 0; i < clusters.size(); ++i) {
+		clusters[i].offset = total;
+		total += static_cast<int>(clusters[i].nodes.size());
+	}
+
+	graph_pos.resize(total);
+
+	for (size_t i = 0; i < clusters.size(); ++i) {
+		Cluster& c = clusters[i];
+		int cx = static_cast<int>(i) % cluster_count.x;
+		int cy = static_cast<int>(i) / cluster_count.x;
+
+		c.partners.assign(c.nodes.size(), -1);
+		for (size_t j = 0; j < c.nodes.size(); ++j) {
+			graph_pos[c.offset + j] = c.nodes[j];
+		}
+
+		int index = 0;
+		int n_right = static_cast<int>(borders_h[i].size());
+		int n_down = static_cast<int>(borders_v[i].size());
+
+		// the right neighbour lists these entrances after its own right and lower ones
+		if (cx + 1 < cluster_count.x) {
+			const Cluster& other = clusters[i + 1];
+			int other_start = other.offset + static_cast<int>(borders_h[i + 1].size() + borders_v[i + 1].size());
+			for (int k = 0; k < n_right; ++k)
+				c.partners[index + k] = other_start + k;
+		}
+		index += n_right;
+
+		// the lower neighbour lists these entrances after its own right, lower and left ones
+		if (cy + 1 < cluster_count.y) {
+			size_t below = i + cluster_count.x;
+			const Cluster& other = clusters[below];
+			int other_start = other.offset + static_cast<int>(borders_h[below].size() + borders_v[below].size());
+			if (cx > 0)
+				other_start += static_cast<int>(borders_h[below - 1].size());
+			for (int k = 0; k < n_down; ++k)
+				c.partners[index + k] = other_start + k;
+		}
+		index += n_down;
+
+		if (cx > 0) {
+			const Cluster& other = clusters[i - 1];
+			int n_left = static_cast<int>(borders_h[i - 1].size());
+			for (int k = 0; k < n_left; ++k)
+				c.partners[index + k] = other.offset + k;
+			index += n_left;
+		}
+
+		if (cy > 0) {
+			size_t above = i - cluster_count.x;
+			const Cluster& other = clusters[above];
+			int n_up = static_cast<int>(borders_v[above].size());
+			for (int k = 0; k < n_up; ++k)
+				c.partners[index + k] = other.offset + static_cast<int>(borders_h[above].size()) + k;
+		}
+	}
+}
+
+/**
+ * Dijkstra search restricted to a single cluster
+ * Fills node_dist with the distance from source to each of the cluster's nodes (-1 if unreachable)
+ */
+void AStarClusterGraph::clusterDistances(int cluster, const Point& source, std::vector<float>& node_dist) {
+	const Cluster& c = clusters[cluster];
+	Rect r = getClusterRect(cluster);
+
+	node_dist.assign(c.nodes.size(), -1);
+
+	if (!collider->isValidTerrain(source.x, source.y, movement_type))
+		return;
+
+	std::fill(local_dist.begin(), local_dist.end(), -1.f);
+	std::fill(local_closed.begin(), local_closed.end(), false);
+
+	std::vector<QueueItem> queue;
+	queue.reserve(r.w * r.h);
+
+	int source_index = (source.x - r.x) + (source.y - r.y) * CLUSTER_SIZE;
+	local_dist[source_index] = 0;
+	queue.push_back(QueueItem(0.f, source_index));
+
+	while (!queue.empty()) {
+		std::pop_heap(queue.begin(), queue.end(), std::greater<QueueItem>());
+		QueueItem item = queue.back();
+		queue.pop_back();
+
+		int index = item.second;
+		if (local_closed[index])
+			continue;
+		local_closed[index] = true;
+
+		int x = index % CLUSTER_SIZE;
+		int y = index / CLUSTER_SIZE;
+
+		for (int dy = -1; dy <= 1; ++dy) {
+			for (int dx = -1; dx <= 1; ++dx) {
+				if (dx == 0 && dy == 0)
+					continue;
+
+				int nx = x + dx;
+				int ny = y + dy;
+				if (nx < 0 || ny < 0 || nx >= r.w || ny >= r.h)
+					continue;
+
+				int n_index = nx + ny * CLUSTER_SIZE;
+				if (local_closed[n_index] || !collider->isValidTerrain(r.x + nx, r.y + ny, movement_type))
+					continue;
+
+				float cost = item.first + ((dx != 0 && dy != 0) ? DIAGONAL_COST : 1.f);
+				if (local_dist[n_index] < 0 || cost < local_dist[n_index]) {
+					local_dist[n_index] = cost;
+					queue.push_back(QueueItem(cost, n_index));
+					std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>());
+				}
+			}
+		}
+	}
+
+	for (size_t i = 0; i < c.nodes.size(); ++i) {
+		node_dist[i] = local_dist[(c.nodes[i].x - r.x) + (c.nodes[i].y - r.y) * CLUSTER_SIZE];
+	}
+}
+
+/**
+ * Search the abstract graph for a route from start to end
+ * On success, waypoints holds the entrance tiles to walk through in order, followed by end
+ */
+bool AStarClusterGraph::findPath(const Point& start, const Point& end, std::vector<Point>& waypoints) {
+	waypoints.clear();
+
+	if (clusters.empty())
+		return false;
+	if (start.x < 0 || start.y < 0 || start.x >= map_size.x || start.y >= map_size.y)
+		return false;
+	if (end.x < 0 || end.y < 0 || end.x >= map_size.x || end.y >= map_size.y)
+		return false;
+
+	if (needs_update)
+		update();
+
+	int start_cluster = getClusterIndex(start);
+	int end_cluster = getClusterIndex(end);
+
+	std::vector<float> start_dist;
+	std::vector<float> end_dist;
+	clusterDistances(start_cluster, start, start_dist);
+	clusterDistances(end_cluster, end, end_dist);
+
+	const int node_count = static_cast<int>(graph_pos.size());
+	const int START = node_count;
+	const int GOAL = node_count + 1;
+
+	graph_g.assign(node_count + 2, -1);
+	graph_parent.assign(node_count + 2, -1);
+	graph_closed.assign(node_count + 2, false);
+
+	std::vector<QueueItem> queue;
+
+	graph_g[START] = 0;
+	queue.push_back(QueueItem(Utils::calcDist(FPoint(start), FPoint(end)), START));
+
+	while (!queue.empty()) {
+		std::pop_heap(queue.begin(), queue.end(), std::greater<QueueItem>());
+		int id = queue.back().second;
+		queue.pop_back();
+
+		if (graph_closed[id])
+			continue;
+		graph_closed[id] = true;
+
+		if (id == GOAL)
+			break;
+
+		// collect the edges leaving this node
+		std::vector< std::pair<int, float> > edges;
+
+		if (id == START) {
+			const Cluster& c = clusters[start_cluster];
+			for (size_t j = 0; j < c.nodes.size(); ++j) {
+				if (start_dist[j] >= 0)
+					edges.push_back(std::pair<int, float>(c.offset + static_cast<int>(j), start_dist[j]));
+			}
+		}
+		else {
+			int cluster = getClusterIndex(graph_pos[id]);
+			const Cluster& c = clusters[cluster];
+			const size_t local = static_cast<size_t>(id - c.offset);
+			const size_t n = c.nodes.size();
+
+			for (size_t j = 0; j < n; ++j) {
+				if (j != local && c.dist[local * n + j] >= 0)
+					edges.push_back(std::pair<int, float>(c.offset + static_cast<int>(j), c.dist[local * n + j]));
+			}
+
+			if (c.partners[local] != -1)
+				edges.push_back(std::pair<int, float>(c.partners[local], 1.f));
+
+			if (cluster == end_cluster && end_dist[local] >= 0)
+				edges.push_back(std::pair<int, float>(GOAL, end_dist[local]));
+		}
+
+		for (size_t j = 0; j < edges.size(); ++j) {
+			int next = edges[j].first;
+			if (graph_closed[next])
+				continue;
+
+			float g = graph_g[id] + edges[j].second;
+			if (graph_g[next] < 0 || g < graph_g[next]) {
+				graph_g[next] = g;
+				graph_parent[next] = id;
+
+				Point next_pos = (next == GOAL) ? end : graph_pos[next];
+				queue.push_back(QueueItem(g + Utils::calcDist(FPoint(next_pos), FPoint(end)), next));
+				std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>());
+			}
+		}
+	}
+
+	if (!graph_closed[GOAL])
+		return false;
+
+	// walk back from the goal, then put the waypoints in walking order
+	waypoints.push_back(end);
+	for (int id = graph_parent[GOAL]; id != START && id != -1; id = graph_parent[id]) {
+		const Point& p = graph_pos[id];
+		if (p.x != waypoints.back().x || p.y != waypoints.back().y)
+			waypoints.push_back(p);
+	}
+	std::reverse(waypoints.begin(), waypoints.end());
+
+	return true;
+}
@@ -0,0 +1,101 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class AStarClusterGraph
+ *
+ * An abstract graph of the collision map used for long distance pathfinding (HPA*).
+ *
+ * The map is divided into square clusters. Wherever two neighbouring clusters share a run of passable tiles
+ * along their border, an entrance is placed in the middle of that run. Entrances are the nodes of the graph.
+ * Nodes inside the same cluster are connected by their walking distance, and the two sides of an entrance are connected to each other.
+ *
+ * A search on this graph only returns the entrance tiles to pass through.
+ * MapCollision refines each leg between those waypoints with a regular (short) A* search.
+ */
+
+#ifndef ASTAR_CLUSTER_GRAPH_H
+#define ASTAR_CLUSTER_GRAPH_H
+
+#include <vector>
+
+#include "Utils.h"
+
+class MapCollision;
+
+class AStarClusterGraph {
+public:
+	static const int CLUSTER_SIZE = 16;
+
+	AStarClusterGraph();
+	~AStarClusterGraph();
+
+	// prepares the graph for a new map. The graph itself is built on the next call to findPath()
+	void init(const MapCollision* _collider, int _movement_type);
+	// flags the clusters affected by a change of the collision tile at this position
+	void invalidateTile(int tile_x, int tile_y);
+
+	bool isFar(const Point& start, const Point& end) const;
+	bool findPath(const Point& start, const Point& end, std::vector<Point>& waypoints);
+
+private:
+	class Cluster {
+	public:
+		std::vector<Point> nodes;
+		std::vector<int> partners; // graph-wide index of the node on the other side of each entrance
+		std::vector<float> dist; // nodes.size() x nodes.size() walking distances, -1 if not connected
+		int offset; // graph-wide index of nodes[0]
+		bool dirty;
+		Cluster();
+	};
+
+	int getClusterIndex(const Point& tile) const;
+	Rect getClusterRect(int cluster) const;
+
+	void update();
+	void updateBorder(int border, bool vertical);
+	void updateCluster(int cluster);
+	void updatePartners();
+
+	void clusterDistances(int cluster, const Point& source, std::vector<float>& node_dist);
+
+	const MapCollision* collider;
+	int movement_type;
+	Point map_size;
+	Point cluster_count;
+	bool needs_update;
+
+	std::vector<Cluster> clusters;
+
+	// entrances along the border to the right of / below each cluster, stored as the tile on the left / top side
+	std::vector< std::vector<Point> > borders_h;
+	std::vector< std::vector<Point> > borders_v;
+	std::vector<bool> borders_h_dirty;
+	std::vector<bool> borders_v_dirty;
+
+	// working memory for cluster-local Dijkstra searches
+	std::vector<float> local_dist;
+	std::vector<bool> local_closed;
+
+	// working memory for searches on the abstract graph
+	std::vector<float> graph_g;
+	std::vector<int> graph_parent;
+	std::vector<bool> graph_closed;
+	std::vector<Point> graph_pos;
+};
+
+#endif
@@ -17,194 +17,173 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 */
 
 #include "AStarContainer.h"
-#include <cstring>
-#include <cfloat>
-
-AStarContainer::AStarContainer(unsigned int _map_width, unsigned int _map_height, unsigned int _node_limit)
-	: size(0)
-	, node_limit(_node_limit)
-	, map_width(_map_width)
-	, map_height(_map_height)
-{
-	nodes.resize(node_limit, NULL);
 
-	//initialise the map array. A -1 value will mean there is no node at that position
-	map_pos.resize(map_width);
-	for (unsigned i=0; i<map_width; ++i) {
-		map_pos[i].resize(map_height, -1);
-	}
+AStarContainer::AStarContainer()
+	: map_width(0)
+	, map_height(0)
+	, generation(0)
+	, heap_size(0)
+	, close_size(0)
+	, shortest_h(-1)
+{
 }
 
 AStarContainer::~AStarContainer() {
-	for(unsigned int i=0; i<size; i++)
-		delete nodes[i];
-	nodes.clear();
 }
 
-int AStarContainer::getSize() {
-	return size;
-}
+void AStarContainer::init(unsigned int _map_width, unsigned int _map_height) {
+	map_width = _map_width;
+	map_height = _map_height;
 
-void AStarContainer::add(AStarNode* node) {
-	if (size >= node_limit) return;
+	const size_t count = static_cast<size_t>(map_width) * map_height;
 
-	//add the new node at the end and update its index
-	nodes[size] = node;
-	map_pos[node->getX()][node->getY()] = static_cast<short>(size);
+	nodes.resize(count);
+	heap_pos.resize(count);
+	heap.resize(count);
 
-	//reorder the heap based on f ordering, staring with thenewly added node and working up the tree from there
-	int m = size;
+	// a stamp of 0 is never used by a search, so every node starts out unvisited
+	node_gen.assign(count, 0);
+	generation = 0;
 
-	AStarNode* temp = NULL;
-	while(m != 0) {
-		//if the current nodes f value is shorter than its parent, they need to be swapped
-		if(nodes[m]->getFinalCost() <= nodes[m/2]->getFinalCost()) {
-			temp = nodes[m/2];
-			nodes[m/2] = nodes[m];
-			map_pos[nodes[m/2]->getX()][nodes[m/2]->getY()] = static_cast<short>(m/2);
-			nodes[m] = temp;
-			map_pos[nodes[m]->getX()][nodes[m]->getY()] = static_cast<short>(m);
-			m=m/2;
-		}
-		else
-			break;
-	}
-	size++;
+	heap_size = 0;
+	close_size = 0;
+	shortest_h = -1;
 }
 
-AStarNode* AStarContainer::get_shortest_f() {
-	return nodes[0];
-}
+void AStarContainer::reset() {
+	generation++;
 
-void AStarContainer::remove(AStarNode* node) {
+	// when the stamp wraps around, old stamps could match again, so start over
+	if (generation == 0) {
+		node_gen.assign(node_gen.size(), 0);
+		generation = 1;
+	}
 
-	unsigned int heap_indexv = map_pos[node->getX()][node->getY()] + 1;
+	heap_size = 0;
+	close_size = 0;
+	shortest_h = -1;
+}
 
-	//swap the last node in the list with the node being deleted
-	nodes[heap_indexv-1] = nodes[size-1];
-	map_pos[nodes[heap_indexv-1]->getX()][nodes[heap_indexv-1]->getY()] = static_cast<short>(heap_indexv-1);
+int AStarContainer::getOpenSize() {
+	return heap_size;
+}
 
-	size--;
+int AStarContainer::getCloseSize() {
+	return close_size;
+}
 
-	if(size == 0) {
-		map_pos[node->getX()][node->getY()] = -1;
-		return;
-	}
+bool AStarContainer::isOpenEmpty() {
+	return heap_size == 0;
+}
 
-	// reorder the heap to maintain the f ordering, starting at the node which replaced the deleted node, and working down the tree
-
-	while(true) {
-		//start at the node which dropped down the tree on the previous iteration
-		unsigned int heap_indexu = heap_indexv;
-		if(2*heap_indexu+1 <= size) { //if both children exist
-			//Select the lowest of the two children.
-			if(nodes[heap_indexu-1]->getFinalCost() >= nodes[2*heap_indexu-1]->getFinalCost()) heap_indexv = 2*heap_indexu;
-			if(nodes[heap_indexv-1]->getFinalCost() >= nodes[2*heap_indexu]->getFinalCost()) heap_indexv = 2*heap_indexu+1;
-		}
-		else if (2*heap_indexu <= size) { //if only child #1 exists
-			//Check if the F cost is greater than the child
-			if(nodes[heap_indexu-1]->getFinalCost() >= nodes[2*heap_indexu-1]->getFinalCost()) heap_indexv = 2*heap_indexu;
-		}
-
-		if(heap_indexu != heap_indexv) { //If parent's F > one or both of its children, swap them
-			AStarNode* temp = nodes[heap_indexu-1];
-			nodes[heap_indexu-1] = nodes[heap_indexv-1];
-			map_pos[nodes[heap_indexu-1]->getX()][nodes[heap_indexu-1]->getY()] = static_cast<short>(heap_indexu-1);
-			nodes[heap_indexv-1] = temp;
-			map_pos[nodes[heap_indexv-1]->getX()][nodes[heap_indexv-1]->getY()] = static_cast<short>(heap_indexv-1);
-		}
-		else {
-			break;//if item <= both children, exit loop
-		}
-	}//Repeat forever
-
-	//remove the node from the map pos index
-	map_pos[node->getX()][node->getY()] = -1;
-}
-
-bool AStarContainer::exists(const Point& pos) {
-	return map_pos[pos.x][pos.y] != -1;
+int AStarContainer::getIndex(int x, int y) {
+	return x + y * static_cast<int>(map_width);
 }
 
-AStarNode* AStarContainer::get(int x, int y) {
-	return nodes[map_pos[x][y]];
-}
-
-bool AStarContainer::isEmpty() {
-	return size == 0;
-}
-
-void AStarContainer::updateParent(const Point& pos, const Point& parent_pos, float score) {
-	get(pos.x, pos.y)->setParent(parent_pos);
-	get(pos.x, pos.y)->setActualCost(score);
-
-	//reorder the heap based on the new f value of this node. starting at the updated node and working up the tree
-	int m = map_pos[pos.x][pos.y];
-	AStarNode* temp = NULL;
-	while(m != 0) {
-		//if the current node has a lower f value than its parent in the heap, swap them
-		if(nodes[m]->getFinalCost() <= nodes[m/2]->getFinalCost()) {
-			temp = nodes[m/2];
-			nodes[m/2] = nodes[m];
-			map_pos[nodes[m/2]->getX()][nodes[m/2]->getY()] = static_cast<short>(m/2);
-			nodes[m] = temp;
-			map_pos[nodes[m]->getX()][nodes[m]->getY()] = static_cast<short>(m);
-			m=m/2;
-		}
-		else
+bool AStarContainer::nodeCompare(int a, int b) {
+	return nodes[heap[a]].getFinalCost() <= nodes[heap[b]].getFinalCost();
+}
+
+void AStarContainer::heapUp(int m) {
+	// if the current node's f value is shorter than its parent, they need to be swapped
+	while (m != 0) {
+		int parent = (m-1) / 2;
+		if (!nodeCompare(m, parent))
 			break;
+
+		int temp = heap[parent];
+		heap[parent] = heap[m];
+		heap[m] = temp;
+		heap_pos[heap[parent]] = parent;
+		heap_pos[heap[m]] = m;
+		m = parent;
 	}
 }
 
-AStarCloseContainer::AStarCloseContainer(unsigned int _map_width, unsigned int _map_height, unsigned int _node_limit)
-	: size(0)
-	, node_limit(_node_limit)
-	, map_width(_map_width)
-	, map_height(_map_height)
-{
-	nodes.resize(node_limit, NULL);
+void AStarContainer::heapDown(int m) {
+	// swap the node with its lowest child until both children have a greater f value
+	while (true) {
+		int child = 2*m + 1;
+		if (child >= heap_size)
+			break;
+
+		if (child + 1 < heap_size && !nodeCompare(child, child + 1))
+			child++;
+
+		if (nodeCompare(m, child))
+			break;
 
-	//initialise the map array. A -1 value will mean there is no node at that position
-	map_pos.resize(map_width);
-	for (unsigned i=0; i<map_width; ++i) {
-		map_pos[i].resize(map_height, -1);
+		int temp = heap[child];
+		heap[child] = heap[m];
+		heap[m] = temp;
+		heap_pos[heap[child]] = child;
+		heap_pos[heap[m]] = m;
+		m = child;
 	}
 }
 
-AStarCloseContainer::~AStarCloseContainer() {
-	for(unsigned int i=0; i<size; i++)
-		delete nodes[i];
-	nodes.clear();
+void AStarContainer::addOpen(const Point& pos, const Point& parent_pos, float g, float h) {
+	int index = getIndex(pos.x, pos.y);
+
+	AStarNode& node = nodes[index];
+	node = AStarNode(pos);
+	node.setParent(parent_pos);
+	node.setActualCost(g);
+	node.setEstimatedCost(h);
+	node_gen[index] = generation;
+
+	// add the new node at the end and work up the tree from there
+	heap[heap_size] = index;
+	heap_pos[index] = heap_size;
+	heap_size++;
+
+	heapUp(heap_size - 1);
 }
 
-int AStarCloseContainer::getSize() {
-	return size;
+Point AStarContainer::closeShortestF() {
+	int index = heap[0];
+
+	// replace the root with the last node in the heap and work down the tree from there
+	heap_size--;
+	if (heap_size > 0) {
+		heap[0] = heap[heap_size];
+		heap_pos[heap[0]] = 0;
+		heapDown(0);
+	}
+
+	heap_pos[index] = NODE_CLOSED;
+	close_size++;
+
+	// keep track of the closest node to the goal, in case the goal can't be reached
+	if (shortest_h == -1 || nodes[index].getH() < nodes[shortest_h].getH())
+		shortest_h = index;
+
+	return Point(nodes[index].getX(), nodes[index].getY());
 }
 
-void AStarCloseContainer::add(AStarNode* node) {
-	if (size >= node_limit) return;
+void AStarContainer::updateParent(const Point& pos, const Point& parent_pos, float g) {
+	int index = getIndex(pos.x, pos.y);
+	nodes[index].setParent(parent_pos);
+	nodes[index].setActualCost(g);
 
-	nodes[size] = node;
-	map_pos[node->getX()][node->getY()] = static_cast<short>(size);
-	size++;
+	// the f value can only have decreased, so the node may need to move up the tree
+	heapUp(heap_pos[index]);
 }
 
-bool AStarCloseContainer::exists(const Point& pos) {
-	return map_pos[pos.x][pos.y] != -1;
+bool AStarContainer::isOpen(const Point& pos) {
+	int index = getIndex(pos.x, pos.y);
+	return node_gen[index] == generation && heap_pos[index] != NODE_CLOSED;
 }
 
-AStarNode* AStarCloseContainer::get(int x, int y) {
-	return nodes[map_pos[x][y]];
+bool AStarContainer::isClosed(const Point& pos) {
+	int index = getIndex(pos.x, pos.y);
+	return node_gen[index] == generation && heap_pos[index] == NODE_CLOSED;
 }
 
-AStarNode* AStarCloseContainer::get_shortest_h() {
-	AStarNode *current = NULL;
-	float lowest_score = FLT_MAX;
-	for(unsigned int i = 0; i < size; i++) {
-		if(nodes[i]->getH() < lowest_score) {
-			lowest_score = nodes[i]->getH();
-			current = nodes[i];
-		}
-	}
-	return current;
+AStarNode* AStarContainer::get(int x, int y) {
+	return &nodes[getIndex(x, y)];
+}
+
+Point AStarContainer::getShortestH() {
+	return Point(nodes[shortest_h].getX(), nodes[shortest_h].getY());
 }
@@ -22,91 +22,85 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "AStarNode.h"
 
-typedef std::vector< std::vector<short> > AStar_Grid;
-
-/* Designed to be used for the Open nodes.
-*  Unsuitable for Closed nodes but a close node conatiner is declared below
+/* Reusable storage for both the Open and Closed node lists of an A* search.
+*  It is owned by MapCollision and sized once per map, so a search does not allocate any memory.
+*
+*  Every map tile has a slot in a flat node array (indexed by x + y * map_width).
+*  Instead of clearing this array before each search, every slot is stamped with the generation of the search that last touched it.
+*  A slot with an older stamp is treated as unvisited.
 *
-*  All code in the class assumes that the nodes and points provided are within the bounds of the map limits
+*  All code in the class assumes that the points provided are within the bounds of the map limits
 */
 class AStarContainer {
 public:
-	AStarContainer(unsigned int _map_width, unsigned int _map_height, unsigned int _node_limit);
-	AStarContainer(const AStarContainer&); // copy constructor not yet implemented
-
+	AStarContainer();
 	~AStarContainer();
-	int getSize();
-	//assumes that the node is not already in the collection
-	void add(AStarNode* node);
-	//assumes that there is at least 1 node in the collection
-	AStarNode* get_shortest_f();
-	//assumes that the node exists in the collection
-	void remove(AStarNode* node);
-	bool exists(const Point& pos);
-	//assumes that the node exists in the collection
+
+	// resizes the node arrays. Only needs to be called when the map dimensions change
+	void init(unsigned int _map_width, unsigned int _map_height);
+	// begins a new search by invalidating all nodes from the previous one
+	void reset();
+
+	int getOpenSize();
+	int getCloseSize();
+	bool isOpenEmpty();
+
+	//assumes that the node is in neither list
+	void addOpen(const Point& pos, const Point& parent_pos, float g, float h);
+	//assumes that there is at least 1 open node. Moves the node with the lowest f value to the closed list and returns its position
+	Point closeShortestF();
+	//assumes that the node is in the open list
+	void updateParent(const Point& pos, const Point& parent_pos, float g);
+
+	bool isOpen(const Point& pos);
+	bool isClosed(const Point& pos);
+	//assumes that the node is in one of the lists
 	AStarNode* get(int x, int y);
-	bool isEmpty();
-	void updateParent(const Point& pos, const Point& parent_pos, float score);
+	//assumes that there is at least 1 closed node
+	Point getShortestH();
 
 private:
-	unsigned int size;
-	unsigned int node_limit;
+	AStarContainer(const AStarContainer&); // copy constructor not implemented
+
+	enum {
+		NODE_CLOSED = -1
+	};
+
+	int getIndex(int x, int y);
+	bool nodeCompare(int a, int b);
+	void heapUp(int m);
+	void heapDown(int m);
+
 	unsigned int map_width;
 	unsigned int map_height;
+	unsigned int generation;
+	int heap_size;
+	int close_size;
+	int shortest_h;
 
-	/* This is an array of AStarNode pointers. This is the main data for this collection.
-	*  The size of the array is based on the node limit.
+	// one node per map tile
+	std::vector<AStarNode> nodes;
+
+	// the search generation that each node was last touched by
+	std::vector<unsigned int> node_gen;
+
+	// position of each node within the open heap, or NODE_CLOSED if the node has been moved to the closed list
+	std::vector<int> heap_pos;
+
+	/* This is the open list, stored as indexes into the node array.
 	*
 	*  The nodes in this array are ordered based on their f value and the node with the lowest f value is always at position 0.
 	*  The ordering is not linear, so after positon 0, we cannot assume that position 1 has the second shortest f value.
 	*
 	*  The ordering is based on a binary heap structure.
-	*  Essentially, each node can have up to 2 child nodes and each child node must have a lower f value than its parent.
-	*  This rule must be maintained whenever nodes are added or removed or their f value changes
-	*
+	*  Essentially, each node can have up to 2 child nodes and each child node must have a higher f value than its parent.
 	*  The tree is represented by a 1 dimentional array where position 0 has children at position 1 and 2
 	*  Node 1 would have children at position 3 and 4 and node 2 would have children at position 5 and 6 and so on
 	*
 	*  A more detailed explanation of the structure can be found at the below web address.
-	*  Please note that there is additional code found in this class which is not mentioned in the article. This is to provide an index based on map position.
-	*  Also note that the code within the article is based on arrays with starting position 1, whereas we use 0 based arrays.
 	*  http://www.policyalmanac.org/games/binaryHeaps.htm
 	*/
-	std::vector<AStarNode*> nodes;
-
-	/* This is a 2d array of shorts ([map_width][map_height]) which acts as an index for the main node array.
-	*  Elements can be accessed using cartesian coordinates e.g. map_pos[x][y]
-	*  To access an AStarNode based on map position use: nodes[map_pos[x][y]]
-	*
-	*  The data in this array is initialised as -1, which indicates hat there is no corresponding node for that position
-	*  This must be maintained when nodes are added, removed and re-ordered in the node array
-	*/
-	AStar_Grid map_pos;
-};
-
-/* This class is used to store the closed list of a* nodes
-*  The nodes within this class have no ordering but stil have a map position index
-*/
-class AStarCloseContainer {
-public:
-	AStarCloseContainer(unsigned int _map_width, unsigned int _map_height, unsigned int _node_limit);
-	AStarCloseContainer(const AStarCloseContainer&); // copy constructor not yet implemented
-	~AStarCloseContainer();
-
-	int getSize();
-	void add(AStarNode* node);
-	bool exists(const Point& pos);
-	AStarNode* get(int x, int y);
-	AStarNode* get_shortest_h();
-
-private:
-	unsigned int size;
-	unsigned int node_limit;
-	unsigned int map_width;
-	unsigned int map_height;
-	std::vector<AStarNode*> nodes;
-	AStar_Grid map_pos;
-
+	std::vector<int> heap;
 };
 
 #endif // ASTARCONTAINER_H
@@ -27,10 +27,10 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #ifndef ASTARNODE_H
 #define ASTARNODE_H
 
-#include <list>
 #include "Utils.h"
 
 const int node_stride = 1; // minimal stride between nodes
+const int node_max_neighbours = 8;
 
 class AStarNode {
 protected:
@@ -56,8 +56,8 @@ public:
 	Point getParent() const;
 	void setParent(const Point& p);
 
-	// return a list of coordinates of all neighbours
-	std::list<Point> getNeighbours(int limitX=0, int limitY=0) const;
+	// fill an array of node_max_neighbours coordinates with all neighbours and return how many were written
+	int getNeighbours(Point* neighbours, int limitX=0, int limitY=0) const;
 
 	float getActualCost() const;
 	void setActualCost(const float G);
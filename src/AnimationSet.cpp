@@ -44,6 +44,23 @@ Animation *AnimationSet::getAnimation(const std::string &_name) {
 	return new Animation(*defaultAnimation);
 }
 
+void AnimationSet::getImageFilenames(const std::string& filename, std::vector<std::string>& image_filenames) {
+	image_filenames.clear();
+
+	FileParser parser;
+	if (filename.empty() || !parser.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NONE))
+		return;
+
+	while (parser.next()) {
+		if (parser.section.empty() && parser.key == "image") {
+			std::string img_filename = Parse::popFirstString(parser.val);
+			if (!img_filename.empty())
+				image_filenames.push_back(img_filename);
+		}
+	}
+	parser.close();
+}
+
 unsigned AnimationSet::getAnimationFrames(const std::string &_name) {
 	if (!loaded)
 		load();
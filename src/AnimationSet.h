@@ -66,6 +66,9 @@ public:
 	void setParent(AnimationSet *other) {
 		parent = other;
 	}
+
+	// the sprite sheet images used by an animation definition, without loading them
+	static void getImageFilenames(const std::string& filename, std::vector<std::string>& image_filenames);
 };
 
 #endif // __ANIMATION_SET__
@@ -54,7 +54,6 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "SharedResources.h"
 #include "SoundManager.h"
 #include "Utils.h"
-#include "UtilsFileSystem.h"
 #include "UtilsMath.h"
 #include "UtilsParsing.h"
 
@@ -172,9 +171,6 @@ void Avatar::init() {
 		if (untransform_power == 0 && power_it->second.required_items.empty() && power_it->second.spawn_type == "untransform") {
 			untransform_power = power_it->first;
 		}
-
-		power_cooldown_timers[power_it->first] = Timer();
-		power_cast_timers[power_it->first] = Timer();
 	}
 
 	stats.animations = "animations/hero.txt";
@@ -455,7 +451,7 @@ void Avatar::logic() {
 				lock_enemy = NULL;
 				mm_can_use_power = false;
 			}
-			else if (!power_cooldown_timers[mm_attack_id].isEnd()) {
+			else if (!power_cooldown_timers.isEnd(mm_attack_id)) {
 				lock_enemy = NULL;
 				mm_can_use_power = false;
 			}
@@ -585,7 +581,7 @@ void Avatar::logic() {
 							anims[i]->setSpeed(attack_speed);
 					}
 					playAttackSound(attack_anim);
-					power_cast_timers[current_power].setDuration(activeAnimation->getDuration());
+					power_cast_timers.setDuration(current_power, activeAnimation->getDuration());
 				}
 
 				// do power
@@ -595,7 +591,7 @@ void Avatar::logic() {
 					mapr->collider.block(stats.pos.x, stats.pos.y, !MapCollision::IS_ALLY);
 
 					powers->activate(current_power, &stats, act_target);
-					power_cooldown_timers[current_power].setDuration(powers->powers[current_power].cooldown);
+					power_cooldown_timers.setDuration(current_power, powers->powers[current_power].cooldown);
 
 					if (!stats.state_timer.isEnd())
 						stats.hold_state = true;
@@ -634,7 +630,7 @@ void Avatar::logic() {
 					stats.effects.triggered_hit = true;
 
 					if (stats.block_power != 0) {
-						power_cooldown_timers[stats.block_power].setDuration(powers->powers[stats.block_power].cooldown);
+						power_cooldown_timers.setDuration(stats.block_power, powers->powers[stats.block_power].cooldown);
 						stats.block_power = 0;
 					}
 				}
@@ -665,11 +661,8 @@ void Avatar::logic() {
 					stats.powers_passive.clear();
 
 					// reset power cooldowns
-					std::map<size_t, Timer>::iterator pct_it;
-					for (pct_it = power_cooldown_timers.begin(); pct_it != power_cooldown_timers.end(); ++pct_it) {
-						pct_it->second.reset(Timer::END);
-						power_cast_timers[pct_it->first].reset(Timer::END);
-					}
+					power_cooldown_timers.resetAll();
+					power_cast_timers.resetAll();
 
 					// close menus in GameStatePlay
 					close_menus = true;
@@ -751,7 +744,7 @@ void Avatar::logic() {
 						continue;
 					if (power.requires_empty_target && !mapr->collider.isEmpty(target.x, target.y))
 						continue;
-					if (!power_cooldown_timers[power_id].isEnd())
+					if (!power_cooldown_timers.isEnd(power_id))
 						continue;
 					if (!powers->hasValidTarget(power_id, &stats, target))
 						continue;
@@ -791,7 +784,7 @@ void Avatar::logic() {
 
 						case Power::STATE_INSTANT:	// handle instant powers
 							powers->activate(power_id, &stats, target);
-							power_cooldown_timers[power_id].setDuration(power.cooldown);
+							power_cooldown_timers.setDuration(power_id, power.cooldown);
 							break;
 
 						default:
@@ -832,11 +825,8 @@ void Avatar::logic() {
 	mapr->checkEvents(stats.pos);
 
 	// decrement all cooldowns
-	std::map<size_t, Timer>::iterator pct_it;
-	for (pct_it = power_cooldown_timers.begin(); pct_it != power_cooldown_timers.end(); ++pct_it) {
-		pct_it->second.tick();
-		power_cast_timers[pct_it->first].tick();
-	}
+	power_cooldown_timers.tick();
+	power_cast_timers.tick();
 
 	// make the current square solid
 	mapr->collider.block(stats.pos.x, stats.pos.y, !MapCollision::IS_ALLY);
@@ -1056,7 +1046,7 @@ std::string Avatar::getGfxFromType(const std::string& gfx_type) {
 
 	// fall back to default if it exists
 	if (gfx.empty()) {
-		if (Filesystem::fileExists(mods->locate("animations/avatar/" + stats.gfx_base + "/default_" + gfx_type + ".txt")))
+		if (!mods->locate("animations/avatar/" + stats.gfx_base + "/default_" + gfx_type + ".txt").empty())
 			gfx = "default_" + gfx_type;
 	}
 
@@ -29,6 +29,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "CommonIncludes.h"
 #include "Entity.h"
+#include "TimerWheel.h"
 #include "Utils.h"
 
 class Entity;
@@ -134,8 +135,8 @@ public:
 	bool respawn;
 	bool close_menus;
 	bool allow_movement;
-	std::map<PowerID, Timer> power_cooldown_timers;
-	std::map<PowerID, Timer> power_cast_timers;
+	TimerWheel power_cooldown_timers;
+	TimerWheel power_cast_timers;
 	Entity* cursor_enemy; // enemy selected with the mouse cursor
 	Entity* lock_enemy;
 	unsigned long time_played;
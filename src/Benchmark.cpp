@@ -0,0 +1,429 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * flare-bench
+ *
+ * Runs GameStatePlay::logic() for a fixed number of ticks without a window or audio device.
+ * A scenario (enemies, hazards and loot around the hero) is set up using a fixed random seed,
+ * so that repeated runs of the same build do the same amount of work.
+ * The time spent in each profiled subsystem is written as JSON.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "AnimationManager.h"
+#include "Avatar.h"
+#include "CombatText.h"
+#include "DeviceList.h"
+#include "EngineSettings.h"
+#include "Entity.h"
+#include "EntityManager.h"
+#include "FontEngine.h"
+#include "GameStatePlay.h"
+#include "Hazard.h"
+#include "HazardManager.h"
+#include "InputState.h"
+#include "ItemManager.h"
+#include "LootManager.h"
+#include "MapRenderer.h"
+#include "MessageEngine.h"
+#include "ModManager.h"
+#include "NullRenderDevice.h"
+#include "NullSoundManager.h"
+#include "PowerManager.h"
+#include "Profiler.h"
+#include "SaveLoad.h"
+#include "Settings.h"
+#include "SharedGameResources.h"
+#include "SharedResources.h"
+#include "Stats.h"
+#include "TooltipManager.h"
+#include "Utils.h"
+#include "UtilsFileSystem.h"
+#include "UtilsParsing.h"
+#include "Version.h"
+
+class BenchmarkArgs {
+public:
+	std::vector<std::string> mod_list;
+	std::string map;
+	std::string output;
+	unsigned int seed;
+	int ticks;
+	std::string enemy_type;
+	int enemy_count;
+	PowerID hazard_power;
+	int hazard_count;
+	int hazard_interval;
+	ItemID loot_item;
+	int loot_count;
+	int spawn_radius;
+	bool render;
+
+	BenchmarkArgs()
+		: map("maps/spawn.txt")
+		, output("")
+		, seed(1)
+		, ticks(1000)
+		, enemy_type("")
+		, enemy_count(0)
+		, hazard_power(0)
+		, hazard_count(0)
+		, hazard_interval(0)
+		, loot_item(0)
+		, loot_count(0)
+		, spawn_radius(10)
+		, render(false) {
+	}
+};
+
+#define PLATFORM_CPP_INCLUDE
+
+#ifdef _WIN32
+#include "PlatformWin32.cpp"
+#else
+#include "PlatformLinux.cpp"
+#endif
+
+static bool init(const BenchmarkArgs& args) {
+	platform.setPaths();
+
+	Utils::logInfo(VersionInfo::createVersionStringFull().c_str());
+
+	// no video or audio subsystems are needed
+	if (SDL_Init(0) < 0) {
+		Utils::logError("flare-bench: Could not initialize SDL: %s", SDL_GetError());
+		return false;
+	}
+
+	mods = new ModManager(&(args.mod_list));
+
+	if (!mods->haveFallbackMod()) {
+		Utils::logError("flare-bench: Could not find the default mod. Use --data-path to point to the directory containing 'mods/'.");
+		return false;
+	}
+
+	settings->loadSettings();
+	settings->audio = false;
+
+	save_load = new SaveLoad();
+	msg = new MessageEngine();
+	font = getFontEngine();
+	anim = new AnimationManager();
+	comb = new CombatText();
+
+	eset = new EngineSettings();
+	eset->load();
+
+	inpt = getInputManager();
+	icons = NULL;
+
+	Stats::init();
+
+	render_device = new NullRenderDevice();
+	render_device->createContext();
+	render_device->reloadGraphics();
+
+	snd = new NullSoundManager();
+
+	tooltipm = new TooltipManager();
+
+	profiler = new Profiler();
+
+	return true;
+}
+
+static void cleanup() {
+	delete profiler;
+	profiler = NULL;
+
+	delete tooltipm;
+	delete anim;
+	delete comb;
+	delete font;
+	delete inpt;
+	delete msg;
+	delete snd;
+	delete save_load;
+	delete eset;
+
+	// fonts and music read from mod archives while they are open, so the archives have to be closed last
+	delete mods;
+
+	if (render_device)
+		render_device->destroyContext();
+	delete render_device;
+
+	SDL_Quit();
+}
+
+/**
+ * Pick a random open tile within 'radius' tiles of the hero
+ * Returns false if no such tile was found after a few attempts
+ */
+static bool getRandomTileNearHero(int radius, Point& tile) {
+	const Point hero_tile(pc->stats.pos);
+
+	for (int attempt = 0; attempt < 20; ++attempt) {
+		tile.x = hero_tile.x + (rand() % (radius * 2 + 1)) - radius;
+		tile.y = hero_tile.y + (rand() % (radius * 2 + 1)) - radius;
+
+		if (tile.x == hero_tile.x && tile.y == hero_tile.y)
+			continue;
+
+		if (mapr->collider.isValidPosition(static_cast<float>(tile.x) + 0.5f, static_cast<float>(tile.y) + 0.5f, MapCollision::MOVE_NORMAL, MapCollision::COLLIDE_NORMAL))
+			return true;
+	}
+
+	return false;
+}
+
+static void spawnHazards(const BenchmarkArgs& args) {
+	if (args.hazard_power == 0 || args.hazard_power >= powers->powers.size())
+		return;
+
+	for (int i = 0; i < args.hazard_count; ++i) {
+		Point tile;
+		if (getRandomTileNearHero(args.spawn_radius, tile))
+			powers->activate(args.hazard_power, &pc->stats, FPoint(tile));
+	}
+}
+
+static void setupScenario(const BenchmarkArgs& args) {
+	if (!args.enemy_type.empty()) {
+		for (int i = 0; i < args.enemy_count; ++i) {
+			Point tile;
+			if (getRandomTileNearHero(args.spawn_radius, tile))
+				entitym->spawn(args.enemy_type, tile);
+		}
+	}
+
+	if (args.loot_item > 0 && items->items.find(args.loot_item) != items->items.end()) {
+		for (int i = 0; i < args.loot_count; ++i) {
+			Point tile;
+			if (getRandomTileNearHero(args.spawn_radius, tile))
+				loot->addLoot(ItemStack(args.loot_item, 1), FPoint(tile), !LootManager::DROPPED_BY_HERO);
+		}
+	}
+
+	spawnHazards(args);
+}
+
+static void writeReport(const BenchmarkArgs& args, float total_ms) {
+	FILE *out = stdout;
+	if (!args.output.empty()) {
+		out = fopen(args.output.c_str(), "w");
+		if (!out) {
+			Utils::logError("flare-bench: Could not open '%s' for writing.", args.output.c_str());
+			out = stdout;
+		}
+	}
+
+	size_t entities_alive = 0;
+	for (size_t i = 0; i < entitym->entities.size(); ++i) {
+		if (entitym->entities[i]->stats.alive)
+			entities_alive++;
+	}
+
+	fprintf(out, "{\n");
+	fprintf(out, "  \"version\": \"%s\",\n", VersionInfo::createVersionStringFull().c_str());
+	fprintf(out, "  \"map\": \"%s\",\n", args.map.c_str());
+	fprintf(out, "  \"seed\": %u,\n", args.seed);
+	fprintf(out, "  \"ticks\": %d,\n", args.ticks);
+	fprintf(out, "  \"enemies\": %d,\n", args.enemy_count);
+	fprintf(out, "  \"hazards\": %d,\n", args.hazard_count);
+	fprintf(out, "  \"loot\": %d,\n", args.loot_count);
+	fprintf(out, "  \"render\": %s,\n", args.render ? "true" : "false");
+	fprintf(out, "  \"total_ms\": %.3f,\n", total_ms);
+	fprintf(out, "  \"ms_per_tick\": %.4f,\n", args.ticks > 0 ? total_ms / static_cast<float>(args.ticks) : 0.f);
+
+	// sections are inclusive: pathfinding and effects are also counted in entity_ai
+	fprintf(out, "  \"sections\": {\n");
+	for (int i = 0; i < Profiler::SECTION_COUNT; ++i) {
+		const Profiler::Section& section = profiler->getSection(i);
+		fprintf(out, "    \"%s\": { \"total_ms\": %.3f, \"ms_per_tick\": %.4f, \"max_ms\": %.4f, \"calls\": %lu }%s\n",
+			Profiler::getSectionName(i).c_str(),
+			profiler->getMilliseconds(section.ticks),
+			args.ticks > 0 ? profiler->getMilliseconds(section.ticks) / static_cast<float>(args.ticks) : 0.f,
+			profiler->getMilliseconds(section.max_ticks),
+			static_cast<unsigned long>(section.calls),
+			(i < Profiler::SECTION_COUNT - 1 ? "," : ""));
+	}
+	fprintf(out, "  },\n");
+
+	// the end state can be compared between runs to confirm they did the same work
+	fprintf(out, "  \"final_state\": { \"entities\": %lu, \"entities_alive\": %lu, \"hazards\": %lu, \"hero_pos\": [%.3f, %.3f] }\n",
+		static_cast<unsigned long>(entitym->entities.size()),
+		static_cast<unsigned long>(entities_alive),
+		static_cast<unsigned long>(hazards->h.size()),
+		pc->stats.pos.x, pc->stats.pos.y);
+	fprintf(out, "}\n");
+
+	if (out != stdout)
+		fclose(out);
+}
+
+static void run(const BenchmarkArgs& args) {
+	srand(args.seed);
+
+	GameStatePlay* play = new GameStatePlay();
+	play->resetGame();
+	mapr->teleport_mapname = args.map;
+
+	// the first tick starts loading the map, which finishes on a later tick
+	play->logic();
+	while (play->isLoadingMap()) {
+		SDL_Delay(1);
+		play->logic();
+	}
+
+	if (!mapr->collider.isOutsideMap(pc->stats.pos.x, pc->stats.pos.y)) {
+		setupScenario(args);
+	}
+	else {
+		Utils::logError("flare-bench: Hero is outside of map '%s'. Skipping scenario setup.", args.map.c_str());
+	}
+
+	profiler->reset();
+
+	uint64_t start = SDL_GetPerformanceCounter();
+
+	for (int tick = 0; tick < args.ticks; ++tick) {
+		// keep the hero alive, so that the scenario runs to the end
+		pc->stats.hp = pc->stats.get(Stats::HP_MAX);
+
+		if (args.hazard_interval > 0 && tick > 0 && tick % args.hazard_interval == 0)
+			spawnHazards(args);
+
+		play->logic();
+
+		// draws to the null render device, so that map rendering and renderable sorting can be measured
+		if (args.render)
+			play->render();
+	}
+
+	float total_ms = profiler->getMilliseconds(SDL_GetPerformanceCounter() - start);
+
+	writeReport(args, total_ms);
+
+	delete play;
+}
+
+static std::string parseArg(const std::string &arg) {
+	std::string result = "";
+
+	// arguments must start with '--'
+	if (arg.length() > 2 && arg[0] == '-' && arg[1] == '-') {
+		for (unsigned i = 2; i < arg.length(); ++i) {
+			if (arg[i] == '=') break;
+			result += arg[i];
+		}
+	}
+
+	return result;
+}
+
+static std::string parseArgValue(const std::string &arg) {
+	size_t pos = arg.find('=');
+	if (pos == std::string::npos)
+		return "";
+
+	return arg.substr(pos + 1);
+}
+
+int main(int argc, char *argv[]) {
+	settings = new Settings();
+
+	BenchmarkArgs args;
+	bool done = false;
+
+	for (int i = 1 ; i < argc; i++) {
+		std::string arg_full = std::string(argv[i]);
+		std::string arg = parseArg(arg_full);
+		std::string val = parseArgValue(arg_full);
+
+		if (arg == "data-path") {
+			settings->custom_path_data = Filesystem::removeTrailingSlash(val);
+			if (!settings->custom_path_data.empty() && Filesystem::pathExists(settings->custom_path_data)) {
+				settings->custom_path_data += "/";
+			}
+			else {
+				Utils::logError("flare-bench: Invalid custom data path: \"%s\"", val.c_str());
+				settings->custom_path_data.clear();
+			}
+		}
+		else if (arg == "mods") {
+			while (!val.empty()) {
+				args.mod_list.push_back(Parse::popFirstString(val));
+			}
+		}
+		else if (arg == "map") args.map = val;
+		else if (arg == "output") args.output = val;
+		else if (arg == "seed") args.seed = static_cast<unsigned int>(Parse::toInt(val));
+		else if (arg == "ticks") args.ticks = Parse::toInt(val);
+		else if (arg == "enemy") args.enemy_type = val;
+		else if (arg == "enemies") args.enemy_count = Parse::toInt(val);
+		else if (arg == "hazard-power") args.hazard_power = Parse::toPowerID(val);
+		else if (arg == "hazards") args.hazard_count = Parse::toInt(val);
+		else if (arg == "hazard-interval") args.hazard_interval = Parse::toInt(val);
+		else if (arg == "loot-item") args.loot_item = Parse::toItemID(val);
+		else if (arg == "loot") args.loot_count = Parse::toInt(val);
+		else if (arg == "spawn-radius") args.spawn_radius = std::max(1, Parse::toInt(val));
+		else if (arg == "render") args.render = true;
+		else if (arg == "help") {
+			Utils::logInfo("Command line options:\n\
+--help                   Prints this message.\n\
+--data-path=<PATH>       Specifies an exact path to look for mod data.\n\
+--mods=<MOD>,...         Runs with only these mods enabled.\n\
+--map=<MAP>              The map to load. The default is 'maps/spawn.txt'.\n\
+--ticks=<N>              The number of logic ticks to run. The default is 1000.\n\
+--seed=<N>               The random seed. The default is 1.\n\
+--enemy=<FILE>           The enemy definition to spawn, e.g. 'enemies/goblin.txt'.\n\
+--enemies=<N>            The number of enemies to spawn.\n\
+--hazard-power=<ID>      The power the hero activates, aimed at random tiles within the spawn radius.\n\
+--hazards=<N>            The number of times the hazard power is activated.\n\
+--hazard-interval=<N>    Activates the hazard power again every N ticks.\n\
+--loot-item=<ID>         The item to drop as loot.\n\
+--loot=<N>               The number of loot stacks to drop.\n\
+--spawn-radius=<N>       Everything is placed within N tiles of the hero. The default is 10.\n\
+--render                 Also renders every tick, using a render device that draws nothing.\n\
+--output=<FILE>          Writes the JSON report to this file instead of stdout.");
+			done = true;
+		}
+		else {
+			Utils::logError("'%s' is not a valid command line option. Try '--help' for a list of valid options.", argv[i]);
+		}
+	}
+
+	int status = 0;
+
+	if (!done) {
+		if (init(args))
+			run(args);
+		else
+			status = 1;
+
+		cleanup();
+	}
+
+	delete settings;
+
+	return status;
+}
@@ -41,7 +41,15 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 CampaignManager::CampaignManager()
 	: bonus_xp(0.0)
+	, revision(0)
+	, status_changes_start(0)
+	, last_level(-1)
+	, last_class("")
+	, last_inventory_hash(0)
 	, random_status(0) {
+	for (int i = 0; i < CHANGE_COUNT; ++i) {
+		change_revision[i] = 0;
+	}
 }
 
 StatusID CampaignManager::registerStatus(const std::string& s) {
@@ -110,6 +118,7 @@ void CampaignManager::setStatus(const StatusID s) {
 
 	status[s].first = true;
 	pc->stats.check_title = true;
+	addStatusChange(s);
 }
 
 void CampaignManager::unsetStatus(const StatusID s) {
@@ -118,6 +127,7 @@ void CampaignManager::unsetStatus(const StatusID s) {
 
 	status[s].first = false;
 	pc->stats.check_title = true;
+	addStatusChange(s);
 }
 
 void CampaignManager::resetAllStatuses() {
@@ -125,6 +135,9 @@ void CampaignManager::resetAllStatuses() {
 	for (it = status.begin(); it != status.end(); ++it) {
 		it->second.first = false;
 	}
+
+	// too many changes to list; everything needs to be checked again
+	clearStatusChanges();
 }
 
 void CampaignManager::getSetStatusStrings(std::vector<std::string>& status_strings) {
@@ -151,6 +164,7 @@ void CampaignManager::removeCurrency(int quantity) {
 
 	if (max_amount > 0) {
 		menu->inv->removeCurrency(max_amount);
+		addChange(CHANGE_ITEM);
 		pc->logMsg(msg->getv("%d %s removed.", max_amount, eset->loot.currency.c_str()), Avatar::MSG_UNIQUE);
 		items->playSound(eset->misc.currency_id);
 	}
@@ -169,6 +183,8 @@ void CampaignManager::removeItem(ItemStack istack) {
 	int max_amount = std::min(item_count, istack.quantity);
 
 	if (menu->inv->remove(istack.item, max_amount)) {
+		addChange(CHANGE_ITEM);
+
 		if (max_amount > 1)
 			pc->logMsg(msg->getv("%s x%d removed.", items->getItemName(istack.item).c_str(), max_amount), Avatar::MSG_UNIQUE);
 		else if (max_amount == 1)
@@ -184,6 +200,7 @@ void CampaignManager::rewardItem(ItemStack istack) {
 		return;
 
 	menu->inv->add(istack, MenuInventory::CARRIED, ItemStorage::NO_SLOT, MenuInventory::ADD_PLAY_SOUND, MenuInventory::ADD_AUTO_EQUIP);
+	addChange(CHANGE_ITEM);
 
 	if (istack.item == eset->misc.currency_id) {
 		pc->logMsg(msg->getv("You receive %d %s.", istack.quantity, eset->loot.currency.c_str()), Avatar::MSG_UNIQUE);
@@ -303,6 +320,120 @@ bool CampaignManager::checkRequirementsInVector(const std::vector<EventComponent
 	return true;
 }
 
+/**
+ * Hero level, class and items can change from many places, so they are polled once per frame instead
+ */
+void CampaignManager::logic() {
+	if (pc->stats.level != last_level) {
+		last_level = pc->stats.level;
+		addChange(CHANGE_LEVEL);
+	}
+
+	if (pc->stats.character_class != last_class) {
+		last_class = pc->stats.character_class;
+		addChange(CHANGE_CLASS);
+	}
+
+	unsigned long inventory_hash = getInventoryHash();
+	if (inventory_hash != last_inventory_hash) {
+		last_inventory_hash = inventory_hash;
+		addChange(CHANGE_ITEM);
+	}
+}
+
+unsigned long CampaignManager::getRevision() {
+	return revision;
+}
+
+/**
+ * Returns the revision of the last change of the given type
+ */
+unsigned long CampaignManager::getChangeRevision(int change_type) {
+	if (change_type < 0 || change_type >= CHANGE_COUNT)
+		return revision;
+
+	return change_revision[change_type];
+}
+
+/**
+ * Appends the statuses that were set or unset after the revision 'since'
+ * Returns false if those changes are no longer known, in which case every status must be assumed to have changed
+ */
+bool CampaignManager::getChangedStatuses(unsigned long since, std::vector<StatusID>& changed) {
+	if (since < status_changes_start)
+		return false;
+
+	for (size_t i = status_changes.size(); i > 0; --i) {
+		if (status_changes[i-1].first <= since)
+			break;
+
+		changed.push_back(status_changes[i-1].second);
+	}
+
+	return true;
+}
+
+/**
+ * Returns which kind of change can alter the result of the given requirement check, or -1 if it isn't a requirement
+ */
+int CampaignManager::getRequirementChangeType(int ec_type) {
+	if (ec_type == EventComponent::REQUIRES_STATUS || ec_type == EventComponent::REQUIRES_NOT_STATUS)
+		return CHANGE_STATUS;
+	else if (ec_type == EventComponent::REQUIRES_CURRENCY || ec_type == EventComponent::REQUIRES_NOT_CURRENCY)
+		return CHANGE_ITEM;
+	else if (ec_type == EventComponent::REQUIRES_ITEM || ec_type == EventComponent::REQUIRES_NOT_ITEM)
+		return CHANGE_ITEM;
+	else if (ec_type == EventComponent::REQUIRES_LEVEL || ec_type == EventComponent::REQUIRES_NOT_LEVEL)
+		return CHANGE_LEVEL;
+	else if (ec_type == EventComponent::REQUIRES_CLASS || ec_type == EventComponent::REQUIRES_NOT_CLASS)
+		return CHANGE_CLASS;
+
+	return -1;
+}
+
+void CampaignManager::addChange(int change_type) {
+	revision++;
+	change_revision[change_type] = revision;
+}
+
+void CampaignManager::addStatusChange(const StatusID s) {
+	addChange(CHANGE_STATUS);
+
+	if (status_changes.size() >= STATUS_CHANGES_MAX) {
+		// drop the older half of the list
+		size_t drop_count = status_changes.size() / 2;
+		status_changes_start = status_changes[drop_count-1].first;
+		status_changes.erase(status_changes.begin(), status_changes.begin() + drop_count);
+	}
+
+	status_changes.push_back(std::pair<unsigned long, StatusID>(revision, s));
+}
+
+void CampaignManager::clearStatusChanges() {
+	addChange(CHANGE_STATUS);
+	status_changes.clear();
+	status_changes_start = revision;
+}
+
+unsigned long CampaignManager::getInventoryHash() {
+	// FNV-1a over the item stacks that checkItem() looks at
+	unsigned long hash = 2166136261UL;
+
+	ItemStorage& carried = menu->inv->inventory[MenuInventory::CARRIED];
+	for (int i = 0; i < carried.getSlotNumber(); ++i) {
+		hash = (hash ^ static_cast<unsigned long>(carried[i].item)) * 16777619UL;
+		hash = (hash ^ static_cast<unsigned long>(carried[i].quantity)) * 16777619UL;
+	}
+
+	ItemStorage& equipment = menu->inv->inventory[MenuInventory::EQUIPMENT];
+	for (int i = 0; i < menu->inv->getEquippedCount(); ++i) {
+		hash = (hash ^ static_cast<unsigned long>(menu->inv->isActive(i) ? equipment[i].item : 0)) * 16777619UL;
+		hash = (hash ^ static_cast<unsigned long>(menu->inv->isActive(i) ? equipment[i].quantity : 0)) * 16777619UL;
+	}
+
+	return hash;
+}
+
 void CampaignManager::randomStatusAppend(const StatusID s) {
 	if (std::find(random_status_pool.begin(), random_status_pool.end(), s) == random_status_pool.end()) {
 		if (random_status_pool.empty())
@@ -37,6 +37,15 @@ class CampaignManager {
 public:
 	typedef std::map<StatusID, std::pair<bool, std::string> > StatusMap;
 
+	// the kinds of game state that requirement checks depend on
+	enum {
+		CHANGE_STATUS = 0,
+		CHANGE_ITEM = 1, // includes currency
+		CHANGE_LEVEL = 2,
+		CHANGE_CLASS = 3,
+		CHANGE_COUNT = 4
+	};
+
 	CampaignManager();
 	~CampaignManager();
 
@@ -59,6 +68,12 @@ public:
 	bool checkAllRequirements(const EventComponent& ec);
 	bool checkRequirementsInVector(const std::vector<EventComponent>& ec_vec);
 
+	void logic();
+	unsigned long getRevision();
+	unsigned long getChangeRevision(int change_type);
+	bool getChangedStatuses(unsigned long since, std::vector<StatusID>& changed);
+	static int getRequirementChangeType(int ec_type);
+
 	void randomStatusAppend(const StatusID s);
 	void randomStatusClear();
 	void randomStatusRoll();
@@ -72,8 +87,29 @@ public:
 	static const bool XP_SHOW_MSG = true;
 
 private:
+	static const size_t STATUS_CHANGES_MAX = 1024;
+
+	void addChange(int change_type);
+	void addStatusChange(const StatusID s);
+	void clearStatusChanges();
+	unsigned long getInventoryHash();
+
 	StatusMap status;
 
+	// every change bumps the revision, so that requirement checks can be skipped until something they depend on has changed
+	unsigned long revision;
+	unsigned long change_revision[CHANGE_COUNT];
+
+	// statuses that were set or unset, along with the revision of the change
+	// changes at or before status_changes_start have been dropped
+	std::vector< std::pair<unsigned long, StatusID> > status_changes;
+	unsigned long status_changes_start;
+
+	// hero state as of the last logic()
+	int last_level;
+	std::string last_class;
+	unsigned long last_inventory_hash;
+
 	std::vector<StatusID> random_status_pool;
 	StatusID random_status;
 };
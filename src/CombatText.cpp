@@ -31,6 +31,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "EngineSettings.h"
 #include "FileParser.h"
 #include "FontEngine.h"
+#include "InputState.h"
+#include "RenderDevice.h"
 #include "Settings.h"
 #include "SharedResources.h"
 #include "UtilsParsing.h"
@@ -40,6 +42,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 Combat_Text_Item::Combat_Text_Item()
 	: label(NULL)
+	, bounds(Rect())
 	, lifespan(0)
 	, pos(FPoint())
 	, floating_offset(0)
@@ -53,7 +56,12 @@ Combat_Text_Item::~Combat_Text_Item() {
 	// label deletion is handled by CombatText class
 }
 
-CombatText::CombatText() {
+CombatText::CombatText()
+	: glyphs(5 * GLYPH_COUNT, static_cast<Sprite*>(NULL))
+	, glyph_width(GLYPH_COUNT, -1)
+	, glyph_height(-1)
+	, overlap_grid_size(0, 0)
+{
 	msg_color[MSG_GIVEDMG] = font->getColor(FontEngine::COLOR_COMBAT_GIVEDMG);
 	msg_color[MSG_TAKEDMG] = font->getColor(FontEngine::COLOR_COMBAT_TAKEDMG);
 	msg_color[MSG_CRIT] = font->getColor(FontEngine::COLOR_COMBAT_CRIT);
@@ -98,32 +106,22 @@ CombatText::CombatText() {
 }
 
 CombatText::~CombatText() {
-	// delete all messages
-	while (combat_text.size() > 0) {
-		delete combat_text.begin()->label;
-		combat_text.erase(combat_text.begin());
+	clear();
+
+	for (size_t i = 0; i < 5; ++i) {
+		for (size_t j = 0; j < label_pool[i].size(); ++j) {
+			delete label_pool[i][j];
+		}
 	}
+
+	clearGlyphs();
 }
 
 void CombatText::addString(const std::string& message, const FPoint& location, int displaytype) {
 	if (!settings->combat_text)
 		return;
 
-	Combat_Text_Item c;
-	c.pos.x = location.x;
-	c.pos.y = location.y;
-	c.floating_offset = static_cast<float>(offset);
-	c.text = message;
-	c.lifespan = duration;
-	c.displaytype = displaytype;
-
-	c.label = new WidgetLabel();
-	c.label->setPos(static_cast<int>(c.pos.x), static_cast<int>(c.pos.y));
-	c.label->setJustify(FontEngine::JUSTIFY_CENTER);
-	c.label->setVAlign(LabelInfo::VALIGN_BOTTOM);
-	c.label->setText(c.text);
-	c.label->setColor(msg_color[c.displaytype]);
-	combat_text.push_back(c);
+	add(message, location, displaytype, false, 0);
 }
 
 void CombatText::addFloat(float num, const FPoint& location, int displaytype) {
@@ -134,54 +132,183 @@ void CombatText::addFloat(float num, const FPoint& location, int displaytype) {
 	for (std::vector<Combat_Text_Item>::iterator it = combat_text.begin(); it != combat_text.end(); ++it) {
 		if (it->is_number && it->displaytype == displaytype && it->lifespan == duration && it->pos.x == location.x && it->pos.y == location.y) {
 			it->number_value += num;
-			it->text = Utils::floatToString(it->number_value, eset->number_format.combat_text);
-			it->label->setText(it->text);
+			setText(*it, Utils::floatToString(it->number_value, eset->number_format.combat_text));
+			updatePos(*it);
 			return;
 		}
 	}
 
-	addString(Utils::floatToString(num, eset->number_format.combat_text), location, displaytype);
+	add(Utils::floatToString(num, eset->number_format.combat_text), location, displaytype, true, num);
+}
 
-	combat_text.back().is_number = true;
-	combat_text.back().number_value = num;
+void CombatText::add(const std::string& message, const FPoint& location, int displaytype, bool is_number, float number_value) {
+	Combat_Text_Item c;
+	c.pos.x = location.x;
+	c.pos.y = location.y;
+	c.floating_offset = static_cast<float>(offset);
+	c.lifespan = duration;
+	c.displaytype = displaytype;
+	c.is_number = is_number;
+	c.number_value = number_value;
+
+	setText(c, message);
+	updatePos(c);
+	combat_text.push_back(c);
+}
+
+/**
+ * Numbers are drawn from the glyph cache. Anything else (or a number the cache can't draw) gets a label
+ */
+void CombatText::setText(Combat_Text_Item& c, const std::string& message) {
+	c.text = message;
+
+	if (c.is_number && setGlyphText(c)) {
+		releaseLabel(c);
+	}
+	else if (c.label) {
+		c.label->setText(c.text);
+	}
+	else {
+		c.label = getLabel(c.text, c.displaytype);
+	}
+}
+
+void CombatText::updatePos(Combat_Text_Item& c) {
+	Point scr_pos = Utils::mapToScreen(c.pos.x, c.pos.y, cam.x, cam.y);
+	scr_pos.y -= static_cast<int>(c.floating_offset);
+
+	if (c.label) {
+		c.label->setPos(scr_pos.x, scr_pos.y);
+		c.bounds = *(c.label->getBounds());
+	}
+	else {
+		// same placement as a label using JUSTIFY_CENTER and VALIGN_BOTTOM
+		c.bounds.x = scr_pos.x - c.bounds.w/2;
+		c.bounds.y = scr_pos.y - c.bounds.h;
+	}
 }
 
 void CombatText::logic(const FPoint& _cam) {
 	cam = _cam;
 
-	for(std::vector<Combat_Text_Item>::iterator it = combat_text.end(); it != combat_text.begin();) {
-		--it;
+	// the font may have been resized, so the glyphs need to be rendered again
+	if (inpt->window_resized) {
+		clearGlyphs();
+		for (size_t i = 0; i < combat_text.size(); ++i) {
+			if (!combat_text[i].label)
+				setText(combat_text[i], combat_text[i].text);
+		}
+	}
+
+	for (size_t i = 0; i < combat_text.size(); ++i) {
+		combat_text[i].lifespan--;
+		combat_text[i].floating_offset += speed;
+		updatePos(combat_text[i]);
+	}
+
+	resolveOverlap();
 
-		it->lifespan--;
-		it->floating_offset += speed;
+	// delete expired messages
+	size_t count = 0;
+	for (size_t i = 0; i < combat_text.size(); ++i) {
+		if (combat_text[i].lifespan <= 0) {
+			releaseLabel(combat_text[i]);
+			continue;
+		}
 
-		Point scr_pos;
-		scr_pos = Utils::mapToScreen(it->pos.x, it->pos.y, cam.x, cam.y);
-		scr_pos.y -= static_cast<int>(it->floating_offset);
+		if (count != i)
+			combat_text[count] = combat_text[i];
+		count++;
+	}
+	combat_text.resize(count);
+}
 
-		it->label->setPos(scr_pos.x, scr_pos.y);
+/**
+ * Try to prevent messages from overlapping
+ * Going from newest to oldest, each message is pushed up above any newer message that it overlaps.
+ * Placed messages are kept in a screen-space grid, so each message only looks at its neighbors.
+ */
+void CombatText::resolveOverlap() {
+	if (combat_text.empty())
+		return;
 
-		// try to prevent messages from overlapping
-		for (std::vector<Combat_Text_Item>::iterator overlap_it = it; overlap_it != combat_text.begin();) {
-			--overlap_it;
-			Rect bounds = *(it->label->getBounds());
-			Rect overlap_bounds = *(overlap_it->label->getBounds());
-			if (Utils::rectsOverlap(bounds, overlap_bounds)) {
-				overlap_it->floating_offset += static_cast<float>(overlap_bounds.h + (overlap_bounds.y - bounds.y));
+	Point grid_size;
+	grid_size.x = std::max(1, (settings->view_w + OVERLAP_CELL_SIZE - 1) / OVERLAP_CELL_SIZE);
+	grid_size.y = std::max(1, (settings->view_h + OVERLAP_CELL_SIZE - 1) / OVERLAP_CELL_SIZE);
 
-				scr_pos = Utils::mapToScreen(overlap_it->pos.x, overlap_it->pos.y, cam.x, cam.y);
-				scr_pos.y -= static_cast<int>(overlap_it->floating_offset);
+	if (grid_size.x != overlap_grid_size.x || grid_size.y != overlap_grid_size.y) {
+		overlap_grid_size = grid_size;
+		overlap_grid.clear();
+		overlap_grid.resize(grid_size.x * grid_size.y);
+	}
+
+	for (size_t i = combat_text.size(); i > 0; --i) {
+		Combat_Text_Item& c = combat_text[i-1];
+
+		// every push moves the message strictly upwards, so this stops once it has cleared its neighbors
+		// the limit is only there as a safeguard
+		Rect overlap_bounds;
+		size_t pushes = 0;
+		while (pushes < combat_text.size() && findOverlap(c.bounds, overlap_bounds)) {
+			c.floating_offset += static_cast<float>(c.bounds.h + (c.bounds.y - overlap_bounds.y));
+			updatePos(c);
+			pushes++;
+		}
 
-				overlap_it->label->setPos(scr_pos.x, scr_pos.y);
+		Point first, last;
+		getOverlapCells(c.bounds, first, last);
+		for (int cy = first.y; cy <= last.y; ++cy) {
+			for (int cx = first.x; cx <= last.x; ++cx) {
+				size_t cell = static_cast<size_t>(cx + cy * overlap_grid_size.x);
+				if (overlap_grid[cell].empty())
+					overlap_cells_used.push_back(cell);
+				overlap_grid[cell].push_back(i-1);
 			}
 		}
 	}
 
-	// delete expired messages
-	while (combat_text.size() && combat_text.begin()->lifespan <= 0) {
-		delete combat_text.begin()->label;
-		combat_text.erase(combat_text.begin());
+	// empty the grid, but keep the memory around for the next frame
+	for (size_t i = 0; i < overlap_cells_used.size(); ++i) {
+		overlap_grid[overlap_cells_used[i]].clear();
 	}
+	overlap_cells_used.clear();
+}
+
+/**
+ * Get the range of grid cells covered by a screen area. Areas outside of the screen use the nearest edge cells
+ */
+void CombatText::getOverlapCells(const Rect& bounds, Point& first, Point& last) {
+	first.x = bounds.x < 0 ? 0 : std::min(bounds.x / OVERLAP_CELL_SIZE, overlap_grid_size.x - 1);
+	first.y = bounds.y < 0 ? 0 : std::min(bounds.y / OVERLAP_CELL_SIZE, overlap_grid_size.y - 1);
+
+	int right = bounds.x + bounds.w;
+	int bottom = bounds.y + bounds.h;
+	last.x = right < 0 ? 0 : std::min(right / OVERLAP_CELL_SIZE, overlap_grid_size.x - 1);
+	last.y = bottom < 0 ? 0 : std::min(bottom / OVERLAP_CELL_SIZE, overlap_grid_size.y - 1);
+}
+
+/**
+ * Find a message already placed by resolveOverlap() that overlaps the given area
+ * Areas that only share an edge are not counted as overlapping
+ */
+bool CombatText::findOverlap(const Rect& bounds, Rect& overlap_bounds) {
+	Point first, last;
+	getOverlapCells(bounds, first, last);
+
+	for (int cy = first.y; cy <= last.y; ++cy) {
+		for (int cx = first.x; cx <= last.x; ++cx) {
+			const std::vector<size_t>& cell = overlap_grid[cx + cy * overlap_grid_size.x];
+			for (size_t i = 0; i < cell.size(); ++i) {
+				const Rect& other = combat_text[cell[i]].bounds;
+				if (bounds.x < other.x + other.w && other.x < bounds.x + bounds.w && bounds.y < other.y + other.h && other.y < bounds.y + bounds.h) {
+					overlap_bounds = other;
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
 }
 
 void CombatText::render() {
@@ -189,18 +316,142 @@ void CombatText::render() {
 
 	for(std::vector<Combat_Text_Item>::iterator it = combat_text.begin(); it != combat_text.end(); ++it) {
 		if (it->lifespan > 0) {
+			uint8_t alpha = 255;
+
 			// fade out
 			if (it->lifespan < fade_duration)
-				it->label->setAlpha(static_cast<uint8_t>((static_cast<float>(it->lifespan) / static_cast<float>(fade_duration)) * 255.f));
+				alpha = static_cast<uint8_t>((static_cast<float>(it->lifespan) / static_cast<float>(fade_duration)) * 255.f);
+
+			if (it->label) {
+				it->label->setAlpha(alpha);
+				it->label->render();
+				continue;
+			}
 
-			it->label->render();
+			int x = it->bounds.x;
+			for (size_t i = 0; i < it->text.length(); ++i) {
+				unsigned char ch = static_cast<unsigned char>(it->text[i]);
+				Sprite* glyph = getGlyph(it->displaytype, ch);
+				if (glyph) {
+					glyph->setDest(x, it->bounds.y);
+					glyph->alpha_mod = alpha;
+					render_device->render(glyph);
+				}
+				x += glyph_width[ch];
+			}
 		}
 	}
 }
 
 void CombatText::clear() {
-	while (combat_text.size()) {
-		delete combat_text.begin()->label;
-		combat_text.erase(combat_text.begin());
+	for (size_t i = 0; i < combat_text.size(); ++i) {
+		releaseLabel(combat_text[i]);
+	}
+	combat_text.clear();
+}
+
+/**
+ * Get a label for a new message. Expired labels are reused, preferably one that already has the same text
+ */
+WidgetLabel* CombatText::getLabel(const std::string& message, int displaytype) {
+	std::vector<WidgetLabel*>& pool = label_pool[displaytype];
+	WidgetLabel* label = NULL;
+
+	for (size_t i = pool.size(); i > 0; --i) {
+		if (pool[i-1]->getText() == message) {
+			label = pool[i-1];
+			pool.erase(pool.begin() + (i-1));
+			break;
+		}
+	}
+
+	if (!label && !pool.empty()) {
+		label = pool.back();
+		pool.pop_back();
+	}
+
+	if (!label) {
+		label = new WidgetLabel();
+		label->setJustify(FontEngine::JUSTIFY_CENTER);
+		label->setVAlign(LabelInfo::VALIGN_BOTTOM);
+		label->setColor(msg_color[displaytype]);
+	}
+
+	label->setAlpha(255);
+	label->setText(message);
+	return label;
+}
+
+void CombatText::releaseLabel(Combat_Text_Item& c) {
+	if (!c.label)
+		return;
+
+	std::vector<WidgetLabel*>& pool = label_pool[c.displaytype];
+	if (pool.size() < LABEL_POOL_MAX)
+		pool.push_back(c.label);
+	else
+		delete c.label;
+
+	c.label = NULL;
+}
+
+/**
+ * Measure a message for drawing from the glyph cache
+ * Returns false if the message has characters that the cache doesn't hold
+ */
+bool CombatText::setGlyphText(Combat_Text_Item& c) {
+	bool font_set = false;
+	int width = 0;
+
+	for (size_t i = 0; i < c.text.length(); ++i) {
+		unsigned char ch = static_cast<unsigned char>(c.text[i]);
+		if (ch >= GLYPH_COUNT)
+			return false;
+
+		if (glyph_width[ch] == -1 || glyph_height == -1) {
+			if (!font_set) {
+				font->setFont(WidgetLabel::DEFAULT_FONT);
+				font_set = true;
+			}
+			glyph_width[ch] = font->calc_width(std::string(1, static_cast<char>(ch)));
+			glyph_height = font->getFontHeight();
+		}
+
+		width += glyph_width[ch];
+	}
+
+	c.bounds.w = width;
+	c.bounds.h = std::max(glyph_height, 0);
+	return true;
+}
+
+/**
+ * Get the cached sprite of a glyph measured by setGlyphText(), rendering it the first time it's needed
+ */
+Sprite* CombatText::getGlyph(int displaytype, unsigned char ch) {
+	size_t index = static_cast<size_t>(displaytype) * GLYPH_COUNT + ch;
+
+	if (!glyphs[index] && glyph_width[ch] > 0 && glyph_height > 0) {
+		Image *image = render_device->createImage(glyph_width[ch], glyph_height);
+		if (!image) return NULL;
+
+		font->setFont(WidgetLabel::DEFAULT_FONT);
+		font->renderShadowed(std::string(1, static_cast<char>(ch)), 0, 0, FontEngine::JUSTIFY_LEFT, image, 0, msg_color[displaytype]);
+		glyphs[index] = image->createSprite();
+		image->unref();
+	}
+
+	return glyphs[index];
+}
+
+void CombatText::clearGlyphs() {
+	for (size_t i = 0; i < glyphs.size(); ++i) {
+		delete glyphs[i];
+		glyphs[i] = NULL;
+	}
+
+	for (size_t i = 0; i < glyph_width.size(); ++i) {
+		glyph_width[i] = -1;
 	}
+	glyph_height = -1;
 }
@@ -23,6 +23,9 @@ FLARE.  If not, see http://www.gnu.org/licenses/
  * The CombatText class displays floating damage numbers and miss messages
  * above the targets.
  *
+ * Numbers are drawn from a cache of pre-rendered glyphs, so they never need a fresh font render.
+ * Other messages use labels that are recycled once their message expires.
+ *
  */
 
 #ifndef COMBAT_TEXT_H
@@ -31,6 +34,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "CommonIncludes.h"
 #include "Utils.h"
 
+class Sprite;
 class WidgetLabel;
 
 class Combat_Text_Item {
@@ -38,7 +42,8 @@ public:
 	Combat_Text_Item();
 	~Combat_Text_Item();
 
-	WidgetLabel *label;
+	WidgetLabel *label; // NULL when the text is drawn from the glyph cache
+	Rect bounds; // screen area, updated by CombatText::updatePos()
 	int lifespan;
 	FPoint pos;
 	float floating_offset;
@@ -67,9 +72,40 @@ public:
 		MSG_BUFF = 4
 	};
 private:
+	static const unsigned GLYPH_COUNT = 128;
+	static const size_t LABEL_POOL_MAX = 16;
+	static const int OVERLAP_CELL_SIZE = 32;
+
+	void add(const std::string& message, const FPoint& location, int displaytype, bool is_number, float number_value);
+	void setText(Combat_Text_Item& c, const std::string& message);
+	void updatePos(Combat_Text_Item& c);
+	void resolveOverlap();
+	void getOverlapCells(const Rect& bounds, Point& first, Point& last);
+	bool findOverlap(const Rect& bounds, Rect& overlap_bounds);
+
+	WidgetLabel* getLabel(const std::string& message, int displaytype);
+	void releaseLabel(Combat_Text_Item& c);
+
+	bool setGlyphText(Combat_Text_Item& c);
+	Sprite* getGlyph(int displaytype, unsigned char ch);
+	void clearGlyphs();
+
 	FPoint cam;
 	std::vector<Combat_Text_Item> combat_text;
 
+	// expired labels, grouped by message type so their color is already set
+	std::vector<WidgetLabel*> label_pool[5];
+
+	// glyph_width and glyph_height are -1 until measured
+	std::vector<Sprite*> glyphs;
+	std::vector<int> glyph_width;
+	int glyph_height;
+
+	// screen-space buckets of the messages that have already been placed this frame
+	std::vector< std::vector<size_t> > overlap_grid;
+	std::vector<size_t> overlap_cells_used;
+	Point overlap_grid_size;
+
 	Color msg_color[5];
 	int duration;
 	int fade_duration;
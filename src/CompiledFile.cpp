@@ -0,0 +1,374 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "CompiledFile.h"
+#include "FileParser.h"
+#include "ModManager.h"
+#include "Settings.h"
+#include "SharedResources.h"
+#include "Utils.h"
+#include "UtilsFileSystem.h"
+
+#include <string.h>
+
+// a key pair is written as this many uint32 values, see CompiledFile::save()
+static const size_t KEY_PAIR_FIELDS = 9;
+
+/**
+ * Helpers for reading and writing the blob in native byte order.
+ * A blob written on a machine with a different byte order fails the MAGIC check and gets recompiled.
+ */
+static void writeU32(std::string& out, uint32_t value) {
+	out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void writeU64(std::string& out, uint64_t value) {
+	out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void writeString(std::string& out, const std::string& s) {
+	writeU32(out, static_cast<uint32_t>(s.length()));
+	out.append(s);
+}
+
+class CompiledFileReader {
+public:
+	const std::vector<char>& buffer;
+	size_t pos;
+	bool ok;
+
+	explicit CompiledFileReader(const std::vector<char>& _buffer)
+		: buffer(_buffer)
+		, pos(0)
+		, ok(true)
+	{}
+
+	uint32_t readU32() {
+		uint32_t value = 0;
+		if (!ok || sizeof(value) > buffer.size() - pos) {
+			ok = false;
+			return 0;
+		}
+		memcpy(&value, &buffer[pos], sizeof(value));
+		pos += sizeof(value);
+		return value;
+	}
+
+	uint64_t readU64() {
+		uint64_t value = 0;
+		if (!ok || sizeof(value) > buffer.size() - pos) {
+			ok = false;
+			return 0;
+		}
+		memcpy(&value, &buffer[pos], sizeof(value));
+		pos += sizeof(value);
+		return value;
+	}
+
+	void readString(std::string& s) {
+		uint32_t length = readU32();
+		if (!ok || length > buffer.size() - pos) {
+			ok = false;
+			s.clear();
+			return;
+		}
+		s.assign(buffer.begin() + pos, buffer.begin() + pos + length);
+		pos += length;
+	}
+
+	size_t remaining() const {
+		return buffer.size() - pos;
+	}
+};
+
+CompiledFile::Source::Source()
+	: path("")
+	, size(0)
+	, modified_time(0)
+{
+}
+
+CompiledFile::KeyPair::KeyPair()
+	: new_section(false)
+	, section(0)
+	, section_length(0)
+	, key(0)
+	, key_length(0)
+	, val(0)
+	, val_length(0)
+	, source(0)
+	, line_number(0)
+{
+}
+
+CompiledFile::CompiledFile()
+	: root_count(0)
+{
+}
+
+CompiledFile::~CompiledFile() {
+}
+
+void CompiledFile::clear() {
+	sources.clear();
+	root_count = 0;
+	key_pairs.clear();
+	strings.clear();
+}
+
+std::string CompiledFile::getCachePath(const std::string& filename) {
+	std::stringstream ss;
+	ss << settings->path_user << "cache/defs/" << Utils::hashString(filename) << ".bin";
+	return ss.str();
+}
+
+bool CompiledFile::getSourceInfo(Source& source) {
+	return mods->getFileInfo(source.path, &source.size, &source.modified_time);
+}
+
+uint32_t CompiledFile::addSource(const std::string& path) {
+	for (size_t i = sources.size(); i > 0; --i) {
+		if (sources[i-1].path == path)
+			return static_cast<uint32_t>(i-1);
+	}
+
+	sources.push_back(Source());
+	sources.back().path = path;
+	getSourceInfo(sources.back());
+	return static_cast<uint32_t>(sources.size() - 1);
+}
+
+uint32_t CompiledFile::addString(const std::string& s) {
+	uint32_t offset = static_cast<uint32_t>(strings.size());
+	strings.append(s);
+	return offset;
+}
+
+/**
+ * Read the file(s) as text. Returns false if nothing could be read.
+ */
+bool CompiledFile::compile(const std::string& filename, int error_mode) {
+	clear();
+
+	std::vector<std::string> paths = mods->list(Filesystem::convertSlashes(filename), ModManager::LIST_FULL_PATHS);
+	for (size_t i = 0; i < paths.size(); ++i) {
+		addSource(paths[i]);
+	}
+	root_count = sources.size();
+
+	FileParser infile;
+	if (!infile.open(filename, FileParser::MOD_FILE, error_mode)) {
+		clear();
+		return false;
+	}
+
+	while (infile.next()) {
+		// sections are shared by all the key pairs that follow them, so only store each one once
+		bool same_section = !key_pairs.empty() && !infile.new_section && key_pairs.back().section_length == infile.section.length() &&
+		                    strings.compare(key_pairs.back().section, key_pairs.back().section_length, infile.section) == 0;
+
+		key_pairs.push_back(KeyPair());
+		KeyPair& kp = key_pairs.back();
+
+		kp.new_section = infile.new_section;
+		if (same_section) {
+			kp.section = key_pairs[key_pairs.size() - 2].section;
+		}
+		else {
+			kp.section = addString(infile.section);
+		}
+		kp.section_length = static_cast<uint32_t>(infile.section.length());
+		kp.key = addString(infile.key);
+		kp.key_length = static_cast<uint32_t>(infile.key.length());
+		kp.val = addString(infile.val);
+		kp.val_length = static_cast<uint32_t>(infile.val.length());
+		kp.source = addSource(infile.getFilename());
+		kp.line_number = infile.getLineNumber();
+	}
+
+	infile.close();
+	return true;
+}
+
+/**
+ * Returns true if the source files have not changed since this file was compiled
+ */
+bool CompiledFile::isCurrent(const std::string& filename) {
+	std::vector<std::string> paths = mods->list(Filesystem::convertSlashes(filename), ModManager::LIST_FULL_PATHS);
+	if (paths.size() != root_count)
+		return false;
+
+	for (size_t i = 0; i < root_count; ++i) {
+		if (paths[i] != sources[i].path)
+			return false;
+	}
+
+	for (size_t i = 0; i < sources.size(); ++i) {
+		Source current;
+		current.path = sources[i].path;
+		if (!getSourceInfo(current) || current.size != sources[i].size || current.modified_time != sources[i].modified_time)
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Read the cached version of a file. Returns false if there is none or if it is out of date.
+ */
+bool CompiledFile::load(const std::string& filename) {
+	clear();
+
+	std::ifstream infile(getCachePath(filename).c_str(), std::ios::in | std::ios::binary);
+	if (!infile.is_open())
+		return false;
+
+	infile.seekg(0, std::ios::end);
+	std::streamoff length = infile.tellg();
+	infile.seekg(0, std::ios::beg);
+	if (length <= 0) {
+		infile.close();
+		return false;
+	}
+
+	std::vector<char> buffer(static_cast<size_t>(length));
+	infile.read(&buffer[0], length);
+	bool read_ok = !infile.fail();
+	infile.close();
+	if (!read_ok)
+		return false;
+
+	CompiledFileReader reader(buffer);
+
+	if (reader.readU32() != MAGIC || reader.readU32() != VERSION)
+		return false;
+
+	std::string cached_filename;
+	reader.readString(cached_filename);
+	if (cached_filename != filename)
+		return false;
+
+	uint32_t source_count = reader.readU32();
+	root_count = reader.readU32();
+	for (uint32_t i = 0; i < source_count && reader.ok; ++i) {
+		sources.push_back(Source());
+		reader.readString(sources.back().path);
+		sources.back().size = reader.readU64();
+		sources.back().modified_time = static_cast<int64_t>(reader.readU64());
+	}
+
+	if (!reader.ok || root_count > sources.size() || !isCurrent(filename)) {
+		clear();
+		return false;
+	}
+
+	reader.readString(strings);
+
+	uint32_t key_pair_count = reader.readU32();
+
+	// a damaged count shouldn't be able to reserve more key pairs than the file holds
+	if (key_pair_count > reader.remaining() / (KEY_PAIR_FIELDS * sizeof(uint32_t)))
+		reader.ok = false;
+	if (reader.ok)
+		key_pairs.reserve(key_pair_count);
+
+	for (uint32_t i = 0; i < key_pair_count && reader.ok; ++i) {
+		key_pairs.push_back(KeyPair());
+		KeyPair& kp = key_pairs.back();
+		kp.new_section = (reader.readU32() != 0);
+		kp.section = reader.readU32();
+		kp.section_length = reader.readU32();
+		kp.key = reader.readU32();
+		kp.key_length = reader.readU32();
+		kp.val = reader.readU32();
+		kp.val_length = reader.readU32();
+		kp.source = reader.readU32();
+		kp.line_number = reader.readU32();
+
+		if (kp.source >= sources.size() ||
+		    kp.section > strings.size() || kp.section_length > strings.size() - kp.section ||
+		    kp.key > strings.size() || kp.key_length > strings.size() - kp.key ||
+		    kp.val > strings.size() || kp.val_length > strings.size() - kp.val)
+		{
+			reader.ok = false;
+		}
+	}
+
+	if (!reader.ok) {
+		Utils::logError("CompiledFile: '%s' is damaged and will be rebuilt.", getCachePath(filename).c_str());
+		clear();
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Write this file to the cache
+ */
+bool CompiledFile::save(const std::string& filename) {
+	std::string out;
+
+	writeU32(out, MAGIC);
+	writeU32(out, VERSION);
+	writeString(out, filename);
+
+	writeU32(out, static_cast<uint32_t>(sources.size()));
+	writeU32(out, static_cast<uint32_t>(root_count));
+	for (size_t i = 0; i < sources.size(); ++i) {
+		writeString(out, sources[i].path);
+		writeU64(out, sources[i].size);
+		writeU64(out, static_cast<uint64_t>(sources[i].modified_time));
+	}
+
+	writeString(out, strings);
+
+	writeU32(out, static_cast<uint32_t>(key_pairs.size()));
+	for (size_t i = 0; i < key_pairs.size(); ++i) {
+		const KeyPair& kp = key_pairs[i];
+		writeU32(out, kp.new_section ? 1 : 0);
+		writeU32(out, kp.section);
+		writeU32(out, kp.section_length);
+		writeU32(out, kp.key);
+		writeU32(out, kp.key_length);
+		writeU32(out, kp.val);
+		writeU32(out, kp.val_length);
+		writeU32(out, kp.source);
+		writeU32(out, kp.line_number);
+	}
+
+	Filesystem::createDir(settings->path_user + "cache");
+	Filesystem::createDir(settings->path_user + "cache/defs");
+
+	if (!Filesystem::writeFileAtomic(getCachePath(filename), out)) {
+		Utils::logError("CompiledFile: Could not write '%s'.", getCachePath(filename).c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool CompiledFile::loadOrCompile(const std::string& filename, int error_mode) {
+	if (load(filename))
+		return true;
+
+	if (!compile(filename, error_mode))
+		return false;
+
+	save(filename);
+	return true;
+}
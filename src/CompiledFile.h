@@ -0,0 +1,90 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class CompiledFile
+ *
+ * A binary version of a definition file (items, powers, effects, loot tables, enemies) that can be read without parsing text.
+ *
+ * Compiling walks the file(s) with a FileParser and stores every key pair in order, with all strings packed into one buffer.
+ * FileParser::openCompiled() hands the key pairs back to the regular loaders, so the result is the same as reading the text.
+ * Like CompiledMap, the resolved definitions are not cached, because they refer to ids that are registered at runtime.
+ *
+ * Compiled files are cached in the user directory. A cached file is only used if the list of source
+ * files (including any APPEND and INCLUDE files) and their sizes and modification times still match.
+ */
+
+#ifndef COMPILED_FILE_H
+#define COMPILED_FILE_H
+
+#include "CommonIncludes.h"
+
+class CompiledFile {
+public:
+	static const uint32_t MAGIC = 0x464c4446; // "FLDF"
+	static const uint32_t VERSION = 1;
+
+	class Source {
+	public:
+		std::string path;
+		uint64_t size;
+		int64_t modified_time;
+		Source();
+	};
+
+	class KeyPair {
+	public:
+		bool new_section;
+		uint32_t section; // offset into strings
+		uint32_t section_length;
+		uint32_t key;
+		uint32_t key_length;
+		uint32_t val;
+		uint32_t val_length;
+		uint32_t source; // index into sources
+		uint32_t line_number;
+		KeyPair();
+	};
+
+	CompiledFile();
+	~CompiledFile();
+
+	void clear();
+	bool compile(const std::string& filename, int error_mode);
+	bool load(const std::string& filename);
+	bool save(const std::string& filename);
+
+	// uses the cache if it is up to date, otherwise compiles the file and updates the cache
+	bool loadOrCompile(const std::string& filename, int error_mode);
+
+	// the first root_count sources are the file in each mod, the rest are INCLUDE files
+	std::vector<Source> sources;
+	size_t root_count;
+
+	std::vector<KeyPair> key_pairs;
+	std::string strings;
+
+private:
+	static std::string getCachePath(const std::string& filename);
+	static bool getSourceInfo(Source& source);
+
+	uint32_t addSource(const std::string& path);
+	uint32_t addString(const std::string& s);
+	bool isCurrent(const std::string& filename);
+};
+
+#endif
@@ -0,0 +1,483 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "CompiledMap.h"
+#include "FileParser.h"
+#include "ModManager.h"
+#include "Settings.h"
+#include "SharedResources.h"
+#include "Utils.h"
+#include "UtilsFileSystem.h"
+#include "UtilsParsing.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Helpers for reading and writing the blob in native byte order.
+ * A blob written on a machine with a different byte order fails the MAGIC check and gets recompiled.
+ */
+static void writeData(std::string& out, const void* data, size_t size) {
+	out.append(static_cast<const char*>(data), size);
+}
+
+static void writeU32(std::string& out, uint32_t value) {
+	writeData(out, &value, sizeof(value));
+}
+
+static void writeU64(std::string& out, uint64_t value) {
+	writeData(out, &value, sizeof(value));
+}
+
+static void writeString(std::string& out, const std::string& s) {
+	writeU32(out, static_cast<uint32_t>(s.length()));
+	out.append(s);
+}
+
+class CompiledMapReader {
+public:
+	const std::vector<char>& buffer;
+	size_t pos;
+	bool ok;
+
+	explicit CompiledMapReader(const std::vector<char>& _buffer)
+		: buffer(_buffer)
+		, pos(0)
+		, ok(true)
+	{}
+
+	bool readData(void* dest, size_t size) {
+		if (!ok || size > buffer.size() - pos) {
+			ok = false;
+			return false;
+		}
+		if (size > 0)
+			memcpy(dest, &buffer[pos], size);
+		pos += size;
+		return true;
+	}
+
+	uint32_t readU32() {
+		uint32_t value = 0;
+		readData(&value, sizeof(value));
+		return value;
+	}
+
+	uint64_t readU64() {
+		uint64_t value = 0;
+		readData(&value, sizeof(value));
+		return value;
+	}
+
+	std::string readString() {
+		uint32_t length = readU32();
+		if (!ok || length > buffer.size() - pos) {
+			ok = false;
+			return "";
+		}
+		std::string s(buffer.begin() + pos, buffer.begin() + pos + length);
+		pos += length;
+		return s;
+	}
+
+	size_t remaining() const {
+		return buffer.size() - pos;
+	}
+};
+
+CompiledMap::Source::Source()
+	: path("")
+	, size(0)
+	, modified_time(0)
+{
+}
+
+CompiledMap::KeyPair::KeyPair()
+	: new_section(false)
+	, section("")
+	, key("")
+	, val("")
+	, source(0)
+	, line_number(0)
+	, layer(-1)
+{
+}
+
+CompiledMap::Layer::Layer()
+	: w(0)
+	, h(0)
+{
+}
+
+CompiledMap::CompiledMap()
+	: root_count(0)
+{
+}
+
+CompiledMap::~CompiledMap() {
+}
+
+void CompiledMap::clear() {
+	sources.clear();
+	root_count = 0;
+	key_pairs.clear();
+	layers.clear();
+}
+
+std::string CompiledMap::getCachePath(const std::string& filename) {
+	std::stringstream ss;
+	ss << settings->path_user << "cache/maps/" << Utils::hashString(filename) << ".bin";
+	return ss.str();
+}
+
+bool CompiledMap::getSourceInfo(Source& source) {
+	return mods->getFileInfo(source.path, &source.size, &source.modified_time);
+}
+
+uint32_t CompiledMap::addSource(const std::string& path) {
+	for (size_t i = 0; i < sources.size(); ++i) {
+		if (sources[i].path == path)
+			return static_cast<uint32_t>(i);
+	}
+
+	sources.push_back(Source());
+	sources.back().path = path;
+	getSourceInfo(sources.back());
+	return static_cast<uint32_t>(sources.size() - 1);
+}
+
+/**
+ * Parse a row of comma separated tile ids
+ * Returns false if the row does not contain exactly 'width' values
+ */
+bool CompiledMap::parseLayerRow(const std::string& row, unsigned short width, std::vector<unsigned short>& values) {
+	values.clear();
+
+	const char* c = row.c_str();
+	const char* end = c + row.length();
+
+	while (c < end) {
+		char* next = NULL;
+		long value = strtol(c, &next, 10);
+		values.push_back(static_cast<unsigned short>(value));
+
+		const char* comma = std::find(static_cast<const char*>(next), end, ',');
+		if (comma == end)
+			break;
+		c = comma + 1;
+	}
+
+	return values.size() == width;
+}
+
+/**
+ * Read the map file(s) as text. Returns false if the map is missing or has malformed layer data.
+ */
+bool CompiledMap::compile(const std::string& filename) {
+	clear();
+
+	std::vector<std::string> paths = mods->list(Filesystem::convertSlashes(filename), ModManager::LIST_FULL_PATHS);
+	if (paths.empty())
+		return false;
+
+	for (size_t i = 0; i < paths.size(); ++i) {
+		addSource(paths[i]);
+	}
+	root_count = sources.size();
+
+	FileParser infile;
+	if (!infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+		clear();
+		return false;
+	}
+
+	// track the map size the same way Map::loadHeader() does
+	unsigned short w = 1;
+	unsigned short h = 1;
+	std::vector<unsigned short> row;
+
+	while (infile.next()) {
+		key_pairs.push_back(KeyPair());
+		KeyPair& kp = key_pairs.back();
+
+		kp.new_section = infile.new_section;
+		kp.section = infile.section;
+		kp.key = infile.key;
+		kp.val = infile.val;
+		kp.source = addSource(infile.getFilename());
+		kp.line_number = infile.getLineNumber();
+
+		if (infile.section == "header") {
+			if (infile.key == "width")
+				w = static_cast<unsigned short>(std::max(Parse::toInt(infile.val), 1));
+			else if (infile.key == "height")
+				h = static_cast<unsigned short>(std::max(Parse::toInt(infile.val), 1));
+		}
+		else if (infile.section == "layer" && infile.key == "data") {
+			kp.layer = static_cast<int>(layers.size());
+
+			layers.push_back(Layer());
+			Layer& layer = layers.back();
+			layer.w = w;
+			layer.h = h;
+			layer.data.resize(static_cast<size_t>(w) * h);
+
+			for (unsigned short j = 0; j < h; ++j) {
+				std::string val = infile.getRawLine();
+				infile.incrementLineNum();
+
+				// leave malformed data to the text loader, which reports the error
+				if (!parseLayerRow(val, w, row)) {
+					infile.close();
+					clear();
+					return false;
+				}
+				std::copy(row.begin(), row.end(), layer.data.begin() + static_cast<size_t>(j) * w);
+			}
+		}
+	}
+
+	infile.close();
+	return true;
+}
+
+/**
+ * Returns true if the map files have not changed since this map was compiled
+ */
+bool CompiledMap::isCurrent(const std::string& filename) {
+	std::vector<std::string> paths = mods->list(Filesystem::convertSlashes(filename), ModManager::LIST_FULL_PATHS);
+	if (paths.size() != root_count)
+		return false;
+
+	for (size_t i = 0; i < root_count; ++i) {
+		if (paths[i] != sources[i].path)
+			return false;
+	}
+
+	for (size_t i = 0; i < sources.size(); ++i) {
+		Source current;
+		current.path = sources[i].path;
+		if (!getSourceInfo(current) || current.size != sources[i].size || current.modified_time != sources[i].modified_time)
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Read the cached version of a map. Returns false if there is none or if it is out of date.
+ */
+bool CompiledMap::load(const std::string& filename) {
+	clear();
+
+	std::ifstream infile(getCachePath(filename).c_str(), std::ios::in | std::ios::binary);
+	if (!infile.is_open())
+		return false;
+
+	infile.seekg(0, std::ios::end);
+	std::streamoff length = infile.tellg();
+	infile.seekg(0, std::ios::beg);
+	if (length <= 0) {
+		infile.close();
+		return false;
+	}
+
+	std::vector<char> buffer(static_cast<size_t>(length));
+	infile.read(&buffer[0], length);
+	bool read_ok = !infile.fail();
+	infile.close();
+	if (!read_ok)
+		return false;
+
+	CompiledMapReader reader(buffer);
+
+	if (reader.readU32() != MAGIC || reader.readU32() != VERSION)
+		return false;
+
+	if (reader.readString() != filename)
+		return false;
+
+	uint32_t source_count = reader.readU32();
+	root_count = reader.readU32();
+	for (uint32_t i = 0; i < source_count && reader.ok; ++i) {
+		sources.push_back(Source());
+		sources.back().path = reader.readString();
+		sources.back().size = reader.readU64();
+		sources.back().modified_time = static_cast<int64_t>(reader.readU64());
+	}
+
+	if (!reader.ok || root_count > sources.size() || !isCurrent(filename)) {
+		clear();
+		return false;
+	}
+
+	uint32_t layer_count = reader.readU32();
+	for (uint32_t i = 0; i < layer_count && reader.ok; ++i) {
+		layers.push_back(Layer());
+		Layer& layer = layers.back();
+		layer.w = static_cast<unsigned short>(reader.readU32());
+		layer.h = static_cast<unsigned short>(reader.readU32());
+
+		// a damaged size could ask for far more memory than the file holds
+		const size_t layer_size = static_cast<size_t>(layer.w) * layer.h;
+		if (layer_size > reader.remaining() / sizeof(unsigned short)) {
+			reader.ok = false;
+			break;
+		}
+
+		layer.data.resize(layer_size);
+		if (!layer.data.empty())
+			reader.readData(&layer.data[0], layer.data.size() * sizeof(unsigned short));
+	}
+
+	uint32_t key_pair_count = reader.readU32();
+	for (uint32_t i = 0; i < key_pair_count && reader.ok; ++i) {
+		key_pairs.push_back(KeyPair());
+		KeyPair& kp = key_pairs.back();
+		kp.new_section = (reader.readU32() != 0);
+		kp.section = reader.readString();
+		kp.key = reader.readString();
+		kp.val = reader.readString();
+		kp.source = reader.readU32();
+		kp.line_number = reader.readU32();
+		kp.layer = static_cast<int>(reader.readU32());
+
+		if (kp.source >= sources.size() || (kp.layer != -1 && (kp.layer < 0 || static_cast<size_t>(kp.layer) >= layers.size())))
+			reader.ok = false;
+	}
+
+	if (!reader.ok) {
+		Utils::logError("CompiledMap: '%s' is damaged and will be rebuilt.", getCachePath(filename).c_str());
+		clear();
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Write this map to the cache. The file is written under a temporary name first, so that an
+ * interrupted write never leaves a partial map behind.
+ */
+bool CompiledMap::save(const std::string& filename) {
+	std::string out;
+
+	writeU32(out, MAGIC);
+	writeU32(out, VERSION);
+	writeString(out, filename);
+
+	writeU32(out, static_cast<uint32_t>(sources.size()));
+	writeU32(out, static_cast<uint32_t>(root_count));
+	for (size_t i = 0; i < sources.size(); ++i) {
+		writeString(out, sources[i].path);
+		writeU64(out, sources[i].size);
+		writeU64(out, static_cast<uint64_t>(sources[i].modified_time));
+	}
+
+	writeU32(out, static_cast<uint32_t>(layers.size()));
+	for (size_t i = 0; i < layers.size(); ++i) {
+		writeU32(out, layers[i].w);
+		writeU32(out, layers[i].h);
+		if (!layers[i].data.empty())
+			writeData(out, &layers[i].data[0], layers[i].data.size() * sizeof(unsigned short));
+	}
+
+	writeU32(out, static_cast<uint32_t>(key_pairs.size()));
+	for (size_t i = 0; i < key_pairs.size(); ++i) {
+		const KeyPair& kp = key_pairs[i];
+		writeU32(out, kp.new_section ? 1 : 0);
+		writeString(out, kp.section);
+		writeString(out, kp.key);
+		writeString(out, kp.val);
+		writeU32(out, kp.source);
+		writeU32(out, kp.line_number);
+		writeU32(out, static_cast<uint32_t>(kp.layer));
+	}
+
+	Filesystem::createDir(settings->path_user + "cache");
+	Filesystem::createDir(settings->path_user + "cache/maps");
+
+	const std::string path = getCachePath(filename);
+	const std::string temp_path = path + ".tmp";
+
+	std::ofstream outfile(temp_path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!outfile.is_open()) {
+		Utils::logError("CompiledMap: Could not write '%s'.", temp_path.c_str());
+		return false;
+	}
+	outfile.write(out.data(), static_cast<std::streamsize>(out.size()));
+	bool write_ok = !outfile.fail();
+	outfile.close();
+
+	if (!write_ok) {
+		Filesystem::removeFile(temp_path);
+		return false;
+	}
+
+	if (Filesystem::fileExists(path))
+		Filesystem::removeFile(path);
+
+	return Filesystem::renameFile(temp_path, path);
+}
+
+bool CompiledMap::loadOrCompile(const std::string& filename) {
+	if (load(filename))
+		return true;
+
+	if (!compile(filename))
+		return false;
+
+	save(filename);
+	return true;
+}
+
+/**
+ * The tileset named in the map header, if any
+ */
+std::string CompiledMap::getTileset() const {
+	std::string tileset;
+	for (size_t i = 0; i < key_pairs.size(); ++i) {
+		if (key_pairs[i].section == "header" && key_pairs[i].key == "tileset")
+			tileset = key_pairs[i].val;
+	}
+	return tileset;
+}
+
+/**
+ * Compile every map in the enabled mods (used by the --compile-maps command line option)
+ */
+void CompiledMap::compileAll() {
+	std::vector<std::string> map_filenames = mods->list("maps", !ModManager::LIST_FULL_PATHS);
+
+	size_t count = 0;
+	for (size_t i = 0; i < map_filenames.size(); ++i) {
+		const std::string& fname = map_filenames[i];
+		if (fname.length() < 4 || fname.substr(fname.length() - 4) != ".txt")
+			continue;
+
+		CompiledMap compiled;
+		if (compiled.compile(fname) && compiled.save(fname)) {
+			Utils::logInfo("CompiledMap: Compiled '%s'.", fname.c_str());
+			count++;
+		}
+		else {
+			Utils::logError("CompiledMap: Could not compile '%s'.", fname.c_str());
+		}
+	}
+
+	Utils::logInfo("CompiledMap: Compiled %u map(s) to '%scache/maps/'.", static_cast<unsigned>(count), settings->path_user.c_str());
+}
@@ -0,0 +1,100 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class CompiledMap
+ *
+ * A binary version of a map file that can be loaded without parsing text.
+ *
+ * Compiling a map walks the map file(s) with a FileParser and stores every key pair in order,
+ * with layer data already converted to arrays of tile ids. Map::load() hands the key pairs back
+ * to its regular loaders, so events, enemy groups and NPCs behave exactly as if read from text.
+ * Statuses and other ids are registered at runtime, so they are resolved while loading, not while compiling.
+ *
+ * Compiled maps are cached in the user directory. A cached map is only used if the list of source
+ * files (including any APPEND and INCLUDE files) and their sizes and modification times still match.
+ */
+
+#ifndef COMPILED_MAP_H
+#define COMPILED_MAP_H
+
+#include "CommonIncludes.h"
+
+class CompiledMap {
+public:
+	static const uint32_t MAGIC = 0x464c4d42; // "FLMB"
+	static const uint32_t VERSION = 1;
+
+	class Source {
+	public:
+		std::string path;
+		uint64_t size;
+		int64_t modified_time;
+		Source();
+	};
+
+	class KeyPair {
+	public:
+		bool new_section;
+		std::string section;
+		std::string key;
+		std::string val;
+		uint32_t source; // index into sources
+		uint32_t line_number;
+		int layer; // index into layers for layer data, -1 for all other keys
+		KeyPair();
+	};
+
+	class Layer {
+	public:
+		unsigned short w;
+		unsigned short h;
+		std::vector<unsigned short> data; // row by row, like the text format
+		Layer();
+	};
+
+	CompiledMap();
+	~CompiledMap();
+
+	void clear();
+	bool compile(const std::string& filename);
+	bool load(const std::string& filename);
+	bool save(const std::string& filename);
+
+	// uses the cache if it is up to date, otherwise compiles the map and updates the cache
+	bool loadOrCompile(const std::string& filename);
+	std::string getTileset() const;
+
+	static void compileAll();
+	static bool parseLayerRow(const std::string& row, unsigned short width, std::vector<unsigned short>& values);
+
+	// the first root_count sources are the map file in each mod, the rest are INCLUDE files
+	std::vector<Source> sources;
+	size_t root_count;
+
+	std::vector<KeyPair> key_pairs;
+	std::vector<Layer> layers;
+
+private:
+	static std::string getCachePath(const std::string& filename);
+	static bool getSourceInfo(Source& source);
+
+	uint32_t addSource(const std::string& path);
+	bool isCurrent(const std::string& filename);
+};
+
+#endif
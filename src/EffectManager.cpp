@@ -64,7 +64,7 @@ Effect::Effect()
 	: id("")
 	, name("")
 	, icon(-1)
-	, timer()
+	, timer_id(0)
 	, type(Effect::NONE)
 	, magnitude(0)
 	, magnitude_max(0)
@@ -100,7 +100,7 @@ Effect& Effect::operator=(const Effect& other) {
 	id = other.id;
 	name = other.name;
 	icon = other.icon;
-	timer = other.timer;
+	timer_id = other.timer_id;
 	type = other.type;
 	magnitude = other.magnitude;
 	magnitude_max = other.magnitude_max;
@@ -259,7 +259,8 @@ bool Effect::isImmunityTypeString(const std::string& type_str) {
 }
 
 EffectManager::EffectManager()
-	: bonus(std::vector<float>(Stats::COUNT + eset->damage_types.count + eset->elements.list.size(), 0))
+	: status_dirty(false)
+	, bonus(std::vector<float>(Stats::COUNT + eset->damage_types.count + eset->elements.list.size(), 0))
 	, bonus_multiplier(std::vector<float>(bonus.size(), 1))
 	, bonus_primary(std::vector<int>(eset->primary_stats.list.size(), 0))
 	, triggered_others(false)
@@ -268,7 +269,8 @@ EffectManager::EffectManager()
 	, triggered_halfdeath(false)
 	, triggered_joincombat(false)
 	, triggered_death(false)
-	, refresh_stats(false) {
+	, refresh_stats(false)
+	, bonus_changed(true) {
 	clearStatus();
 }
 
@@ -276,17 +278,28 @@ EffectManager::~EffectManager() {
 }
 
 void EffectManager::clearStatus() {
+	clearTimedStatus();
+	clearBonusStatus();
+}
+
+/**
+ * Values that only last for the frame they were triggered on
+ */
+void EffectManager::clearTimedStatus() {
 	damage = 0;
 	damage_percent = 0;
 	hpot = 0;
 	hpot_percent = 0;
 	mpot = 0;
 	mpot_percent = 0;
+	death_sentence = false;
+}
+
+void EffectManager::clearBonusStatus() {
 	speed = 100;
 	stun = false;
 	revive = false;
 	convert = false;
-	death_sentence = false;
 	fear = false;
 	knockback_speed = 0;
 
@@ -300,41 +313,21 @@ void EffectManager::clearStatus() {
 	}
 }
 
-void EffectManager::logic() {
-	clearStatus();
+/**
+ * Total up the magnitudes of the active effects
+ * This only needs to happen when the effect list has changed
+ */
+void EffectManager::updateStatus() {
+	if (!status_dirty)
+		return;
 
-	for (size_t i=0; i<effect_list.size(); ++i) {
-		Effect& ei = effect_list[i];
+	clearBonusStatus();
 
-		// @CLASS EffectManager|Description of "type" in powers/effects.txt
-		// expire timed effects and total up magnitudes of active effects
-		if (ei.timer.getDuration() > 0) {
-			if (ei.timer.isEnd()) {
-				//death sentence is only applied at the end of the timer
-				// @TYPE death_sentence|Causes sudden death at the end of the effect duration.
-				if (ei.type == Effect::DEATH_SENTENCE) death_sentence = true;
-				removeEffect(i);
-				i--;
-				continue;
-			}
-		}
+	for (size_t i=0; i<effect_list.size(); ++i) {
+		const Effect& ei = effect_list[i];
 
-		bool do_timed_effect = ei.timer.isWholeSecond() || (ei.timer.getDuration() < settings->max_frames_per_sec && ei.timer.isBegin());
-
-		// @TYPE damage|Damage per second
-		if (ei.type == Effect::DAMAGE && do_timed_effect) damage += ei.magnitude;
-		// @TYPE damage_percent|Damage per second (percentage of max HP)
-		else if (ei.type == Effect::DAMAGE_PERCENT && do_timed_effect) damage_percent += ei.magnitude;
-		// @TYPE hpot|HP restored per second
-		else if (ei.type == Effect::HPOT && do_timed_effect) hpot += ei.magnitude;
-		// @TYPE hpot_percent|HP restored per second (percentage of max HP)
-		else if (ei.type == Effect::HPOT_PERCENT && do_timed_effect) hpot_percent += ei.magnitude;
-		// @TYPE mpot|MP restored per second
-		else if (ei.type == Effect::MPOT && do_timed_effect) mpot += ei.magnitude;
-		// @TYPE mpot_percent|MP restored per second (percentage of max MP)
-		else if (ei.type == Effect::MPOT_PERCENT && do_timed_effect) mpot_percent += ei.magnitude;
 		// @TYPE speed|Changes movement speed. A magnitude of 100 is 100% speed (aka normal speed).
-		else if (ei.type == Effect::SPEED) speed = (static_cast<float>(ei.magnitude) * speed) / 100.f;
+		if (ei.type == Effect::SPEED) speed = (static_cast<float>(ei.magnitude) * speed) / 100.f;
 		// @TYPE attack_speed|Changes attack speed. A magnitude of 100 is 100% speed (aka normal speed).
 		// attack speed is calculated when getAttackSpeed() is called
 
@@ -372,8 +365,36 @@ void EffectManager::logic() {
 		else if (ei.type >= Effect::TYPE_COUNT) {
 			bonus_primary[ei.type - Effect::TYPE_COUNT - Stats::COUNT - eset->damage_types.count - eset->elements.list.size()] += static_cast<int>(ei.magnitude);
 		}
+	}
+
+	status_dirty = false;
+	bonus_changed = true;
+}
+
+void EffectManager::logic() {
+	clearTimedStatus();
 
-		ei.timer.tick();
+	for (size_t i=0; i<effect_list.size(); ++i) {
+		Effect& ei = effect_list[i];
+
+		// @CLASS EffectManager|Description of "type" in powers/effects.txt
+		// total up magnitudes of periodic effects. Timed effects are expired by onTimerEnd()
+		bool do_timed_effect = timers.isWholeSecond(ei.timer_id) || (timers.getDuration(ei.timer_id) < settings->max_frames_per_sec && timers.isBegin(ei.timer_id));
+
+		if (do_timed_effect) {
+			// @TYPE damage|Damage per second
+			if (ei.type == Effect::DAMAGE) damage += ei.magnitude;
+			// @TYPE damage_percent|Damage per second (percentage of max HP)
+			else if (ei.type == Effect::DAMAGE_PERCENT) damage_percent += ei.magnitude;
+			// @TYPE hpot|HP restored per second
+			else if (ei.type == Effect::HPOT) hpot += ei.magnitude;
+			// @TYPE hpot_percent|HP restored per second (percentage of max HP)
+			else if (ei.type == Effect::HPOT_PERCENT) hpot_percent += ei.magnitude;
+			// @TYPE mpot|MP restored per second
+			else if (ei.type == Effect::MPOT) mpot += ei.magnitude;
+			// @TYPE mpot_percent|MP restored per second (percentage of max MP)
+			else if (ei.type == Effect::MPOT_PERCENT) mpot_percent += ei.magnitude;
+		}
 
 		// expire shield effects
 		if (ei.magnitude_max > 0 && ei.magnitude == 0) {
@@ -400,10 +421,29 @@ void EffectManager::logic() {
 				ei.animation->advanceFrame();
 		}
 	}
+
+	timers.tick(this);
+
+	// re-total the stat bonuses if effects were added or removed (including the ones that expired above)
+	updateStatus();
+}
+
+void EffectManager::onTimerEnd(size_t id) {
+	for (size_t i = 0; i < effect_list.size(); ++i) {
+		if (effect_list[i].timer_id != id)
+			continue;
+
+		//death sentence is only applied at the end of the timer
+		// @TYPE death_sentence|Causes sudden death at the end of the effect duration.
+		if (effect_list[i].type == Effect::DEATH_SENTENCE) death_sentence = true;
+		removeEffect(i);
+		return;
+	}
 }
 
 void EffectManager::addEffect(StatBlock* stats, EffectDef &effect, EffectParams &params) {
 	refresh_stats = true;
+	status_dirty = true;
 
 	// if we're already immune, don't add negative effects
 	if (stats) {
@@ -507,7 +547,7 @@ void EffectManager::addEffect(StatBlock* stats, EffectDef &effect, EffectParams
 		e.loadAnimation(effect.animation);
 	}
 
-	e.timer.setDuration(params.duration);
+	e.timer_id = timers.add(params.duration);
 	e.magnitude = e.magnitude_max = params.magnitude;
 	e.is_from_item = params.is_from_item;
 	e.is_multiplier = params.is_multiplier;
@@ -532,8 +572,10 @@ void EffectManager::addEffect(StatBlock* stats, EffectDef &effect, EffectParams
 }
 
 void EffectManager::removeEffect(size_t id) {
+	timers.remove(effect_list[id].timer_id);
 	effect_list.erase(effect_list.begin()+id);
 	refresh_stats = true;
+	status_dirty = true;
 }
 
 void EffectManager::removeEffectType(const int type) {
@@ -571,6 +613,8 @@ void EffectManager::clearEffects() {
 	}
 
 	clearStatus();
+	bonus_changed = true;
+	status_dirty = false;
 
 	// clear triggers
 	triggered_others = triggered_block = triggered_hit = triggered_halfdeath = triggered_joincombat = triggered_death = false;
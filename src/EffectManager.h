@@ -25,6 +25,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #define EFFECT_MANAGER_H
 
 #include "CommonIncludes.h"
+#include "TimerWheel.h"
 #include "Utils.h"
 
 class Animation;
@@ -80,7 +81,7 @@ public:
 	std::string id;
 	std::string name;
 	int icon;
-	Timer timer;
+	size_t timer_id; // id of the duration timer in EffectManager::timers
 	int type;
 	float magnitude;
 	float magnitude_max;
@@ -130,15 +131,23 @@ public:
 	PowerID power_id;
 };
 
-class EffectManager {
+class EffectManager : public TimerWheel::Listener {
 private:
 	void removeEffect(size_t id);
 	void clearStatus();
+	void clearTimedStatus();
+	void clearBonusStatus();
+
+	// removes timed effects when their duration ends
+	void onTimerEnd(size_t id);
+
+	bool status_dirty;
 
 public:
 	EffectManager();
 	~EffectManager();
 	void logic();
+	void updateStatus();
 	void addEffect(StatBlock* stats, EffectDef &effect, EffectParams &params);
 	void removeEffectType(const int type);
 	void removeEffectPassive(size_t id);
@@ -157,6 +166,9 @@ public:
 
 	std::vector<Effect> effect_list;
 
+	// the duration of every effect in effect_list. Ticked once per logic(), so only the effects that run out are looked at
+	TimerWheel timers;
+
 	// TODO rename these to *_per_second; maybe make into array?
 	float damage;
 	float damage_percent;
@@ -187,6 +199,9 @@ public:
 
 	bool refresh_stats;
 
+	// set when the stat bonuses above have been totaled again; cleared by StatBlock::applyEffects()
+	bool bonus_changed;
+
 	static const int NO_POWER = 0;
 };
 
@@ -481,7 +481,14 @@ void EntityBehavior::checkMove() {
 				if (recalculate_path) {
 					chance_calc_path = -100;
 					path.clear();
-					path_found = mapr->collider.computePath(e->stats.pos, pursue_pos, path, e->stats.movement_type, MapCollision::DEFAULT_PATH_LIMIT);
+					path_found = false;
+
+					// hostile entities chasing the hero share a single flow field instead of each running their own search
+					if (!e->stats.hero_ally && !fleeing && pursue_pos.x == pc->stats.pos.x && pursue_pos.y == pc->stats.pos.y)
+						path_found = mapr->collider.computeFlowPath(e->stats.pos, pursue_pos, path, e->stats.movement_type);
+
+					if (!path_found)
+						path_found = mapr->collider.computePath(e->stats.pos, pursue_pos, path, e->stats.movement_type, MapCollision::DEFAULT_PATH_LIMIT);
 
 					if (!path_found) {
 						path_found_fails++;
@@ -597,7 +604,7 @@ void EntityBehavior::checkMoveStateMove() {
 	else {
 		can_attack = false;
 		for (size_t i = 0; i < e->stats.powers_ai.size(); ++i) {
-			if (e->stats.powers_ai[i].cooldown.isEnd()) {
+			if (e->stats.powers_ai_cooldowns.isEnd(i)) {
 				can_attack = true;
 				break;
 			}
@@ -725,7 +732,7 @@ void EntityBehavior::updateState() {
 				// set cooldown for all ai powers with the same power id
 				for (size_t i = 0; i < e->stats.powers_ai.size(); ++i) {
 					if (e->stats.activated_power->id == e->stats.powers_ai[i].id) {
-						e->stats.powers_ai[i].cooldown.setDuration(powers->powers[power_id].cooldown);
+						e->stats.powers_ai_cooldowns.setDuration(i, powers->powers[power_id].cooldown);
 					}
 				}
 
@@ -35,6 +35,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "MapRenderer.h"
 #include "MenuActionBar.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "Settings.h"
 #include "SharedGameResources.h"
@@ -43,7 +44,9 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include <limits>
 
 EntityManager::EntityManager()
-	: entities()
+	: spatial_grid_dirty(true)
+	, spatial_grid_size(0)
+	, entities()
 	, hero_stealth(0)
 	, player_blocked(false)
 	, player_blocked_timer(settings->max_frames_per_sec / 6) {
@@ -125,6 +128,9 @@ void EntityManager::handleNewMap () {
 	}
 	entities.clear();
 
+	spatial_grid.init(mapr->w, mapr->h);
+	spatial_grid_dirty = true;
+	max_render_extent = Point();
 
 	for (unsigned int i=0; i < prototypes.size(); i++) {
 		prototypes[i].unloadSounds();
@@ -378,6 +384,7 @@ bool EntityManager::checkPartyMembers() {
  * perform logic() for all entities
  */
 void EntityManager::logic() {
+	PROFILE_SCOPE(Profiler::SECTION_ENTITY_AI);
 
 	if (player_blocked) {
 		player_blocked_timer.tick();
@@ -395,41 +402,107 @@ void EntityManager::logic() {
 			(*it)->logic();
 		}
 	}
+
+	spatial_grid_dirty = true;
+}
+
+void EntityManager::invalidateSpatialGrid() {
+	spatial_grid_dirty = true;
+}
+
+/**
+ * Rebuild the spatial grid if entities have moved, or were added/removed behind our back (e.g. NPCs joining the party)
+ */
+void EntityManager::updateSpatialGrid() {
+	if (!spatial_grid_dirty && spatial_grid_size == entities.size())
+		return;
+
+	spatial_grid.clear();
+	for (size_t i = 0; i < entities.size(); ++i) {
+		spatial_grid.add(static_cast<int>(i), entities[i]->stats.pos);
+	}
+
+	spatial_grid_size = entities.size();
+	spatial_grid_dirty = false;
+}
+
+/**
+ * Get all entities that pass Utils::isWithinRadius(), in list order
+ */
+void EntityManager::getEntitiesInRadius(const FPoint& center, float radius, std::vector<Entity*>& result) {
+	result.clear();
+	updateSpatialGrid();
+
+	spatial_grid.queryRadius(center, radius, spatial_query);
+	for (size_t i = 0; i < spatial_query.size(); ++i) {
+		result.push_back(entities[spatial_query[i]]);
+	}
 }
 
 Entity* EntityManager::entityFocus(const Point& mouse, const FPoint& cam, bool alive_only) {
-	Point p;
-	Rect r;
-	for(unsigned int i = 0; i < entities.size(); i++) {
-		if(alive_only && (entities[i]->stats.cur_state == StatBlock::ENTITY_DEAD || entities[i]->stats.cur_state == StatBlock::ENTITY_CRITDEAD)) {
+	updateSpatialGrid();
+
+	// only entities whose sprite could reach the mouse cursor need to be checked
+	FPoint mouse_pos = Utils::screenToMap(mouse.x, mouse.y, cam.x, cam.y);
+	// before anything has been rendered on this map, the sprite sizes are unknown and every entity is checked
+	float range = static_cast<float>(std::max(mapr->w, mapr->h));
+	if (max_render_extent.x > 0 && max_render_extent.y > 0 && eset->tileset.tile_w_half > 0 && eset->tileset.tile_h_half > 0)
+		range = 1.f + static_cast<float>(max_render_extent.x) / static_cast<float>(eset->tileset.tile_w_half) + static_cast<float>(max_render_extent.y) / static_cast<float>(eset->tileset.tile_h_half);
+
+	spatial_grid.queryRect(FPoint(mouse_pos.x - range, mouse_pos.y - range), FPoint(mouse_pos.x + range, mouse_pos.y + range), spatial_query);
+
+	for (size_t i = 0; i < spatial_query.size(); i++) {
+		Entity *entity = entities[spatial_query[i]];
+		if(alive_only && (entity->stats.cur_state == StatBlock::ENTITY_DEAD || entity->stats.cur_state == StatBlock::ENTITY_CRITDEAD)) {
 			continue;
 		}
 
-		if (Utils::isWithinRect(entities[i]->getRenderBounds(cam), mouse)) {
-			Entity *entity = entities[i];
+		if (Utils::isWithinRect(entity->getRenderBounds(cam), mouse)) {
 			return entity;
 		}
 	}
 	return NULL;
 }
 
+/**
+ * Searches rings of grid cells outward from pos, stopping once no further ring can hold anything closer
+ */
 Entity* EntityManager::getNearestEntity(const FPoint& pos, bool get_corpse, float *saved_distance, float max_range) {
 	Entity* nearest = NULL;
+	int nearest_index = -1;
 	float best_distance = std::numeric_limits<float>::max();
 
-	for (unsigned i=0; i<entities.size(); i++) {
-		if(!get_corpse && (entities[i]->stats.cur_state == StatBlock::ENTITY_DEAD || entities[i]->stats.cur_state == StatBlock::ENTITY_CRITDEAD)) {
-			continue;
-		}
-		if (get_corpse && !entities[i]->stats.corpse) {
-			continue;
-		}
+	updateSpatialGrid();
+
+	for (int ring = 0; ; ++ring) {
+		// without a saved distance, nothing beyond max_range is wanted
+		if (!saved_distance && spatial_grid.getRingDistance(ring - 1) > max_range)
+			break;
+
+		spatial_query.clear();
+		if (!spatial_grid.queryRing(pos, ring, spatial_query))
+			break;
 
-		float distance = Utils::calcDist(pos, entities[i]->stats.pos);
-		if (distance < best_distance) {
-			best_distance = distance;
-			nearest = entities[i];
+		for (size_t j = 0; j < spatial_query.size(); j++) {
+			Entity* e = entities[spatial_query[j]];
+			if(!get_corpse && (e->stats.cur_state == StatBlock::ENTITY_DEAD || e->stats.cur_state == StatBlock::ENTITY_CRITDEAD)) {
+				continue;
+			}
+			if (get_corpse && !e->stats.corpse) {
+				continue;
+			}
+
+			// ties go to the entity that comes first in the list
+			float distance = Utils::calcDist(pos, e->stats.pos);
+			if (distance < best_distance || (distance == best_distance && spatial_query[j] < nearest_index)) {
+				best_distance = distance;
+				nearest = e;
+				nearest_index = spatial_query[j];
+			}
 		}
+
+		if (nearest && best_distance < spatial_grid.getRingDistance(ring))
+			break;
 	}
 
 	if (nearest && saved_distance)
@@ -479,6 +552,9 @@ void EntityManager::spawn(const std::string& entity_type, const Point& target) {
  * to collect all mobile sprites each frame.
  */
 void EntityManager::addRenders(std::vector<Renderable> &r, std::vector<Renderable> &r_dead) {
+	size_t r_start = r.size();
+	size_t r_dead_start = r_dead.size();
+
 	std::vector<Entity*>::iterator it;
 	for (it = entities.begin(); it != entities.end(); ++it) {
 		if (mapr->fogofwar > FogOfWar::TYPE_MINIMAP) {
@@ -496,6 +572,16 @@ void EntityManager::addRenders(std::vector<Renderable> &r, std::vector<Renderabl
 				(*it)->addRenders(r);
 		}
 	}
+
+	// keep track of how far entity sprites reach from their position
+	for (size_t i = r_start; i < r.size(); ++i) {
+		max_render_extent.x = std::max(max_render_extent.x, std::max(r[i].offset.x, r[i].src.w - r[i].offset.x));
+		max_render_extent.y = std::max(max_render_extent.y, std::max(r[i].offset.y, r[i].src.h - r[i].offset.y));
+	}
+	for (size_t i = r_dead_start; i < r_dead.size(); ++i) {
+		max_render_extent.x = std::max(max_render_extent.x, std::max(r_dead[i].offset.x, r_dead[i].src.w - r_dead[i].offset.x));
+		max_render_extent.y = std::max(max_render_extent.y, std::max(r_dead[i].offset.y, r_dead[i].src.h - r_dead[i].offset.y));
+	}
 }
 
 EntityManager::~EntityManager() {
@@ -27,6 +27,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #define ENTITY_MANAGER_H
 
 #include "CommonIncludes.h"
+#include "SpatialGrid.h"
 #include "Utils.h"
 
 class Animation;
@@ -41,6 +42,17 @@ protected:
 
 	std::vector<Entity> prototypes;
 
+	void updateSpatialGrid();
+
+	// entity positions bucketed by tile, rebuilt on demand after entities have moved
+	SpatialGrid spatial_grid;
+	bool spatial_grid_dirty;
+	size_t spatial_grid_size;
+	std::vector<int> spatial_query;
+
+	// the largest distance (in pixels) that an entity's sprite reaches from its position, used to narrow down entityFocus()
+	Point max_render_extent;
+
 public:
 	EntityManager();
 	~EntityManager();
@@ -57,6 +69,8 @@ public:
 	void spawn(const std::string& entity_type, const Point& target);
 	Entity *entityFocus(const Point& mouse, const FPoint& cam, bool alive_only);
 	Entity* getNearestEntity(const FPoint& pos, bool get_corpse, float *saved_distance, float max_range);
+	void getEntitiesInRadius(const FPoint& center, float radius, std::vector<Entity*>& result);
+	void invalidateSpatialGrid();
 
 	// vars
 	std::vector<Entity*> entities;
@@ -62,7 +62,10 @@ Event::Event()
 	, delay()
 	, keep_after_trigger(true)
 	, center(FPoint(-1, -1))
-	, reachable_from(Rect()) {
+	, reachable_from(Rect())
+	, requirements_checked(false)
+	, requirements_met(false)
+	, requirements_revision(0) {
 }
 
 Event::~Event() {
@@ -826,7 +829,7 @@ bool EventManager::executeEventInternal(Event &ev, bool skip_delay) {
 				ec->data[1].Int = random_ec.data[1].Int;
 			}
 
-			if (Filesystem::fileExists(mods->locate(ec->s))) {
+			if (!mods->locate(ec->s).empty()) {
 				mapr->teleportation = true;
 				mapr->teleport_mapname = ec->s;
 
@@ -855,7 +858,7 @@ bool EventManager::executeEventInternal(Event &ev, bool skip_delay) {
 		else if (ec->type == EventComponent::MAPMOD) {
 			if (ec->s == "collision") {
 				if (ec->data[0].Int >= 0 && ec->data[0].Int < mapr->w && ec->data[1].Int >= 0 && ec->data[1].Int < mapr->h) {
-					mapr->collider.colmap[ec->data[0].Int][ec->data[1].Int] = static_cast<unsigned short>(ec->data[2].Int);
+					mapr->collider.setTile(ec->data[0].Int, ec->data[1].Int, static_cast<unsigned short>(ec->data[2].Int));
 					mapr->map_change = true;
 				}
 				else
@@ -867,8 +870,10 @@ bool EventManager::executeEventInternal(Event &ev, bool skip_delay) {
 					Utils::logError("EventManager: Mapmod at position (%d, %d) contains invalid tile id (%d).", ec->data[0].Int, ec->data[1].Int, ec->data[2].Int);
 				else if (index >= mapr->layers.size())
 					Utils::logError("EventManager: Mapmod at position (%d, %d) is on an invalid layer.", ec->data[0].Int, ec->data[1].Int);
-				else if (ec->data[0].Int >= 0 && ec->data[0].Int < mapr->w && ec->data[1].Int >= 0 && ec->data[1].Int < mapr->h)
-					mapr->layers[index][ec->data[0].Int][ec->data[1].Int] = static_cast<unsigned short>(ec->data[2].Int);
+				else if (ec->data[0].Int >= 0 && ec->data[0].Int < mapr->w && ec->data[1].Int >= 0 && ec->data[1].Int < mapr->h) {
+					mapr->layers[index].set(ec->data[0].Int, ec->data[1].Int, static_cast<unsigned short>(ec->data[2].Int));
+					mapr->invalidateTileCache(index, ec->data[0].Int, ec->data[1].Int);
+				}
 				else
 					Utils::logError("EventManager: Mapmod at position (%d, %d) is out of bounds 0-255.", ec->data[0].Int, ec->data[1].Int);
 			}
@@ -1101,6 +1106,33 @@ bool EventManager::isActive(const Event &e) {
 	return camp->checkRequirementsInVector(e.components);
 }
 
+/**
+ * Same as isActive(), but the requirements are only checked again after
+ * something they depend on (statuses, items, level or class) has changed
+ */
+bool EventManager::isActiveCached(Event &e) {
+	const unsigned long revision = camp->getRevision();
+
+	if (e.requirements_checked && e.requirements_revision != revision) {
+		for (size_t i = 0; i < e.components.size(); ++i) {
+			int change_type = CampaignManager::getRequirementChangeType(e.components[i].type);
+			if (change_type != -1 && camp->getChangeRevision(change_type) > e.requirements_revision) {
+				e.requirements_checked = false;
+				break;
+			}
+		}
+		e.requirements_revision = revision;
+	}
+
+	if (!e.requirements_checked) {
+		e.requirements_met = isActive(e);
+		e.requirements_checked = true;
+		e.requirements_revision = revision;
+	}
+
+	return e.requirements_met;
+}
+
 void EventManager::executeScript(const std::string& filename, float x, float y) {
 	FileParser script_file;
 	std::queue<Event> script_evnt;
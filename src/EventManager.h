@@ -144,6 +144,11 @@ public:
 	FPoint center;
 	Rect reachable_from;
 
+	// result of the last requirement check, see EventManager::isActiveCached()
+	bool requirements_checked;
+	bool requirements_met;
+	unsigned long requirements_revision;
+
 	Event();
 	~Event();
 
@@ -162,6 +167,7 @@ public:
 	static bool executeEvent(Event &e);
 	static bool executeDelayedEvent(Event &e);
 	static bool isActive(const Event &e);
+	static bool isActiveCached(Event &e);
 	static void executeScript(const std::string& filename, float x, float y);
 
 private:
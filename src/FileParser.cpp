@@ -16,27 +16,52 @@ You should have received a copy of the GNU General Public License along with
 FLARE.  If not, see http://www.gnu.org/licenses/
 */
 
+#include "CompiledFile.h"
 #include "FileParser.h"
 #include "ModManager.h"
 #include "SharedResources.h"
+#include "Utils.h"
 #include "UtilsFileSystem.h"
-#include "UtilsParsing.h"
 
+#include <cstring>
 #include <stdarg.h>
 
 FileParser::FileParser()
 	: current_index(0)
 	, is_mod_file(false)
 	, error_mode(ERROR_NORMAL)
+	, buf(NULL)
+	, buf_size(0)
+	, buf_pos(0)
+	, buf_eof(true)
 	, line("")
 	, line_number(0)
 	, include_fp(NULL)
+	, compiled(NULL)
+	, compiled_pos(0)
 	, new_section(false)
 	, section("")
 	, key("")
 	, val("") {
 }
 
+namespace {
+	const char* TRIM_CHARS = " \f\n\r\t\v";
+
+	void trimRange(const char** start, size_t* length) {
+		while (*length > 0 && strchr(TRIM_CHARS, (*start)[*length - 1]))
+			(*length)--;
+		while (*length > 0 && strchr(TRIM_CHARS, **start)) {
+			(*start)++;
+			(*length)--;
+		}
+	}
+
+	bool rangeEquals(const char* start, size_t length, const char* str) {
+		return length == strlen(str) && memcmp(start, str, length) == 0;
+	}
+}
+
 bool FileParser::open(const std::string& _filename, bool _is_mod_file, int _error_mode) {
 	is_mod_file = _is_mod_file;
 	error_mode = _error_mode;
@@ -61,46 +86,84 @@ bool FileParser::open(const std::string& _filename, bool _is_mod_file, int _erro
 
 	// Cycle through all filenames from the end, stopping when a file is to overwrite all further files.
 	for (size_t i=filenames.size(); i>0; i--) {
-		infile.open(filenames[i-1].c_str(), std::ios::in);
-		ret = infile.is_open();
+		ret = openFile(filenames[i-1]);
 
 		if (ret) {
 			// This will be the first file to be parsed. Seek to the start of the file and leave it open.
-			if (infile.good() && Parse::trim(Parse::getLine(infile)) != "APPEND") {
-				std::string test_line;
-
-				// get the first non-comment, non blank line
-				while (infile.good()) {
-					test_line = Parse::trim(Parse::getLine(infile));
-					if (test_line.length() == 0) continue;
-					else if (test_line.at(0) == '#') continue;
-					else break;
-				}
-
-				if (test_line != "APPEND") {
-					current_index = static_cast<unsigned>(i)-1;
-					infile.clear(); // reset flags
-					infile.seekg(0, std::ios::beg);
-					break;
-				}
+			if (!isAppendFile()) {
+				current_index = static_cast<unsigned>(i)-1;
+				buf_pos = 0;
+				buf_eof = false;
+				break;
 			}
 
 			// don't close the final file if it's the only one with an "APPEND" line
 			if (i > 1) {
-				infile.close();
-				infile.clear();
+				closeFile();
 			}
 		}
 		else {
 			if (error_mode != ERROR_NONE)
 				Utils::logError("FileParser: Could not open text file: %s", filenames[i-1].c_str());
-			infile.clear();
 		}
 	}
 
 	return ret;
 }
 
+bool FileParser::openCompiled(const std::string& _filename, int _error_mode) {
+	close();
+
+	is_mod_file = MOD_FILE;
+	error_mode = _error_mode;
+
+	compiled = new CompiledFile();
+	if (!compiled->loadOrCompile(_filename, error_mode)) {
+		delete compiled;
+		compiled = NULL;
+		return false;
+	}
+
+	filenames.clear();
+	for (size_t i = 0; i < compiled->sources.size(); ++i) {
+		filenames.push_back(compiled->sources[i].path);
+	}
+	current_index = 0;
+	line_number = 0;
+	compiled_pos = 0;
+
+	return true;
+}
+
+/**
+ * A file starting with an "APPEND" line is added to the lower priority files instead of replacing them.
+ * "APPEND" can either be the first line or the first non-comment line after it.
+ */
+bool FileParser::isAppendFile() {
+	const char* start;
+	size_t length;
+
+	if (!good())
+		return true;
+
+	readLine(&start, &length);
+	trimRange(&start, &length);
+	if (rangeEquals(start, length, "APPEND"))
+		return true;
+
+	// get the first non-comment, non blank line
+	length = 0;
+	while (good()) {
+		readLine(&start, &length);
+		trimRange(&start, &length);
+		if (length == 0) continue;
+		else if (start[0] == '#') continue;
+		else break;
+	}
+
+	return rangeEquals(start, length, "APPEND");
+}
+
 void FileParser::close() {
 	if (include_fp) {
 		include_fp->close();
@@ -108,9 +171,68 @@ void FileParser::close() {
 		include_fp = NULL;
 	}
 
-	if (infile.is_open())
-		infile.close();
-	infile.clear();
+	if (compiled) {
+		delete compiled;
+		compiled = NULL;
+	}
+
+	closeFile();
+}
+
+/**
+ * Files in mod archives are parsed in place. Other files are read into memory in one go.
+ */
+bool FileParser::openFile(const std::string& filename) {
+	closeFile();
+
+	if (mods->getArchivedFile(filename, &buf, &buf_size)) {
+		buf_eof = false;
+		return true;
+	}
+
+	if (!mods->readFile(filename, file_data))
+		return false;
+
+	buf = file_data.data();
+	buf_size = file_data.size();
+	buf_eof = false;
+	return true;
+}
+
+void FileParser::closeFile() {
+	buf = NULL;
+	buf_size = 0;
+	buf_pos = 0;
+	buf_eof = true;
+}
+
+bool FileParser::good() {
+	return !buf_eof;
+}
+
+void FileParser::readLine(const char** start, size_t* length) {
+	*start = buf + buf_pos;
+	*length = 0;
+
+	if (buf_pos >= buf_size) {
+		buf_eof = true;
+		return;
+	}
+
+	const char* end = static_cast<const char*>(memchr(*start, '\n', buf_size - buf_pos));
+	if (end) {
+		*length = static_cast<size_t>(end - *start);
+		buf_pos += *length + 1;
+	}
+	else {
+		*length = buf_size - buf_pos;
+		buf_pos = buf_size;
+		buf_eof = true;
+	}
+
+	// strip carriage return if exists
+	if (*length > 0 && (*start)[*length - 1] == '\r')
+		(*length)--;
 }
 
 /**
@@ -120,12 +242,28 @@ void FileParser::close() {
  * @return false if EOF, otherwise true
  */
 bool FileParser::next() {
-
-	std::string starts_with;
+	const char* start;
+	size_t length;
 	new_section = false;
 
+	if (compiled) {
+		if (compiled_pos >= compiled->key_pairs.size())
+			return false;
+
+		const CompiledFile::KeyPair& kp = compiled->key_pairs[compiled_pos];
+		compiled_pos++;
+
+		new_section = kp.new_section;
+		section.assign(compiled->strings, kp.section, kp.section_length);
+		key.assign(compiled->strings, kp.key, kp.key_length);
+		val.assign(compiled->strings, kp.val, kp.val_length);
+		current_index = kp.source;
+		line_number = kp.line_number;
+		return true;
+	}
+
 	while (current_index < filenames.size()) {
-		while (infile.good()) {
+		while (good()) {
 			if (include_fp) {
 				if (include_fp->next()) {
 					new_section = include_fp->new_section;
@@ -142,71 +280,83 @@ bool FileParser::next() {
 				}
 			}
 
-			line = Parse::trim(Parse::getLine(infile));
+			readLine(&start, &length);
+			trimRange(&start, &length);
 			line_number++;
 
 			// skip ahead if this line is empty
-			if (line.length() == 0) continue;
-
-			starts_with = line.at(0);
+			if (length == 0) continue;
 
 			// skip ahead if this line is a comment
-			if (starts_with == "#") continue;
+			if (start[0] == '#') continue;
 
 			// set new section if this line is a section declaration
-			if (starts_with == "[") {
+			if (start[0] == '[') {
 				new_section = true;
-				section = Parse::getSectionTitle(line);
+				const char* bracket = static_cast<const char*>(memchr(start, ']', length));
+				if (bracket)
+					section.assign(start + 1, static_cast<size_t>(bracket - start) - 1);
+				else
+					section.clear();
 
 				// keep searching for a key-pair
 				continue;
 			}
 
 			// skip the string used to combine files
-			if (line == "APPEND") continue;
+			if (rangeEquals(start, length, "APPEND")) continue;
 
 			// read from a separate file
-			std::size_t first_space = line.find(' ');
-
-			if (first_space != std::string::npos) {
-				std::string directive = line.substr(0, first_space);
+			const char* first_space = static_cast<const char*>(memchr(start, ' ', length));
 
-				if (directive == "INCLUDE") {
-					std::string tmp = line.substr(first_space+1);
+			if (first_space && rangeEquals(start, static_cast<size_t>(first_space - start), "INCLUDE")) {
+				std::string tmp(first_space + 1, length - static_cast<size_t>(first_space - start) - 1);
 
-					include_fp = new FileParser();
-					if (!include_fp || !include_fp->open(tmp, is_mod_file, error_mode)) {
-						delete include_fp;
-						include_fp = NULL;
-					}
-
-					if (include_fp) {
-						// INCLUDE file will inherit the current section
-						include_fp->section = section;
-					}
+				include_fp = new FileParser();
+				if (!include_fp || !include_fp->open(tmp, is_mod_file, error_mode)) {
+					delete include_fp;
+					include_fp = NULL;
+				}
 
-					continue;
+				if (include_fp) {
+					// INCLUDE file will inherit the current section
+					include_fp->section = section;
 				}
+
+				continue;
 			}
 
 			// this is a keypair. Perform basic parsing and return
-			Parse::getKeyPair(line, key, val);
+			// key and val are assigned in place, so they only allocate when they need to grow
+			const char* separator = static_cast<const char*>(memchr(start, '=', length));
+			if (!separator) {
+				key.clear();
+				val.clear();
+				return true;
+			}
+
+			const char* key_start = start;
+			size_t key_length = static_cast<size_t>(separator - start);
+			const char* val_start = separator + 1;
+			size_t val_length = length - key_length - 1;
+			trimRange(&key_start, &key_length);
+			trimRange(&val_start, &val_length);
+
+			key.assign(key_start, key_length);
+			val.assign(val_start, val_length);
 			return true;
 		}
 
-		infile.close();
-		infile.clear();
+		closeFile();
 
 		current_index++;
 		if (current_index == filenames.size()) return false;
 
 		line_number = 0;
-		const std::string current_filename = filenames[current_index];
-		infile.open(current_filename.c_str(), std::ios::in);
-		if (!infile.is_open()) {
+		const std::string& current_filename = filenames[current_index];
+		if (!openFile(current_filename)) {
 			if (error_mode != ERROR_NONE)
 				Utils::logError("FileParser: Could not open text file: %s", current_filename.c_str());
-			infile.clear();
 			return false;
 		}
 		// a new file starts a new section
@@ -223,8 +373,11 @@ bool FileParser::next() {
 std::string FileParser::getRawLine() {
 	line = "";
 
-	if (infile.good()) {
-		line = Parse::getLine(infile);
+	if (good()) {
+		const char* start;
+		size_t length;
+		readLine(&start, &length);
+		line.assign(start, length);
 	}
 	return line;
 }
@@ -255,6 +408,35 @@ void FileParser::incrementLineNum() {
 	line_number++;
 }
 
+/**
+ * The full path of the file that the current key pair was read from
+ */
+std::string FileParser::getFilename() {
+	if (include_fp)
+		return include_fp->getFilename();
+
+	if (current_index < filenames.size())
+		return filenames[current_index];
+
+	return "";
+}
+
+unsigned FileParser::getLineNumber() {
+	if (include_fp)
+		return include_fp->getLineNumber();
+
+	return line_number;
+}
+
+void FileParser::setErrorLocation(const std::string& filename, unsigned _line_number) {
+	if (filenames.size() != 1 || filenames[0] != filename) {
+		filenames.clear();
+		filenames.push_back(filename);
+	}
+	current_index = 0;
+	line_number = _line_number;
+}
+
 FileParser::~FileParser() {
 	close();
 }
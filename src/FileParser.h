@@ -27,22 +27,41 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "CommonIncludes.h"
 
+class CompiledFile;
+
 class FileParser {
 private:
 	void errorBuf(const char* buffer);
+	bool openFile(const std::string& filename);
+	void closeFile();
+	bool isAppendFile();
+
+	// reads the next line from the buffer, with the same end of file behavior as std::getline()
+	void readLine(const char** start, size_t* length);
+	bool good();
 
 	std::vector<std::string> filenames;
 	unsigned current_index;
 	bool is_mod_file;
 	int error_mode;
 
-	std::ifstream infile;
+	// the current file. Points into a mod archive or into file_data
+	const char* buf;
+	size_t buf_size;
+	size_t buf_pos;
+	bool buf_eof;
+	std::string file_data;
+
 	std::string line;
 
 	unsigned line_number;
 
 	FileParser* include_fp;
 
+	// set by openCompiled(). Key pairs are then read from here instead of from the text files
+	CompiledFile* compiled;
+	size_t compiled_pos;
+
 public:
 	enum {
 		ERROR_NONE = 0,
@@ -70,12 +89,30 @@ public:
 	 */
 	bool open(const std::string& filename, bool _is_mod_file, int _error_mode);
 
+	/**
+	 * @brief openCompiled
+	 * Like open() for a mod file, but reads the key pairs from the definition cache (see CompiledFile).
+	 * The cache is rebuilt from the text files if any of them changed.
+	 * getRawLine() is not available for files opened this way.
+	 */
+	bool openCompiled(const std::string& filename, int _error_mode);
+
 	void close();
 	bool next();
 	std::string getRawLine();
 	void error(const char* format, ...);
 	void incrementLineNum();
 
+	std::string getFilename();
+	unsigned getLineNumber();
+
+	/**
+	 * @brief setErrorLocation
+	 * Used when handing key pairs that were parsed earlier (see CompiledMap) to code
+	 * that expects a FileParser, so that error() still points at the original file.
+	 */
+	void setErrorLocation(const std::string& filename, unsigned _line_number);
+
 	/**
 	 * @brief new_section is set to true whenever a new [section] starts. If opening
 	 * multiple files it is also true whenever a new file is opened. Note: This
@@ -196,16 +196,16 @@ void FogOfWar::handleIntramapTeleport() {
 	for (int x = bounds.x; x <= bounds.w; x++) {
 		for (int y = bounds.y; y <= bounds.h; y++) {
 			if (x>=0 && y>=0 && x < mapr->w && y < mapr->h) {
-				mapr->layers[fog_layer_id][x][y] = TILE_HIDDEN;
+				mapr->layers[fog_layer_id].set(x, y, TILE_HIDDEN);
 			}
 		}
 	}
 }
 
 Color FogOfWar::getTileColorMod(const int_fast16_t x, const int_fast16_t y) {
-	if (mapr->layers[dark_layer_id][x][y] == 0 && mapr->layers[fog_layer_id][x][y] > 0)
+	if (mapr->layers[dark_layer_id].get(x, y) == 0 && mapr->layers[fog_layer_id].get(x, y) > 0)
 		return color_fog;
-	else if (mapr->layers[dark_layer_id][x][y] > 0)
+	else if (mapr->layers[dark_layer_id].get(x, y) > 0)
 		return color_dark;
 	else
 		return color_sight;
@@ -240,12 +240,12 @@ void FogOfWar::updateTiles() {
 	for (int x = bounds.x; x <= bounds.w; x++) {
 		for (int y = bounds.y; y <= bounds.h; y++) {
 			if (x>=0 && y>=0 && x < mapr->w && y < mapr->h) {
-				unsigned short prev_dark_tile = mapr->layers[dark_layer_id][x][y];
+				unsigned short prev_dark_tile = mapr->layers[dark_layer_id].get(x, y);
 
-				mapr->layers[dark_layer_id][x][y] &= *mask;
-				mapr->layers[fog_layer_id][x][y] = *mask;
+				mapr->layers[dark_layer_id].set(x, y, prev_dark_tile & *mask);
+				mapr->layers[fog_layer_id].set(x, y, *mask);
 
-				if (prev_dark_tile != mapr->layers[dark_layer_id][x][y]) {
+				if (prev_dark_tile != mapr->layers[dark_layer_id].get(x, y)) {
 					update_minimap = true;
 				}
 			}
@@ -66,6 +66,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "NPC.h"
 #include "NPCManager.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "QuestLog.h"
 #include "RenderDevice.h"
 #include "SaveLoad.h"
@@ -75,6 +76,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "SoundManager.h"
 #include "UtilsParsing.h"
 #include "WidgetLabel.h"
+#include "WidgetTooltip.h"
 #include "XPScaling.h"
 
 #include <cassert>
@@ -84,6 +86,7 @@ GameStatePlay::GameStatePlay()
 	, enemy(NULL)
 	, npc_id(-1)
 	, is_first_map_load(true)
+	, teleport_start_ticks(0)
 {
 	second_timer.setDuration(settings->max_frames_per_sec);
 
@@ -290,7 +293,25 @@ void GameStatePlay::checkLoot() {
 }
 
 void GameStatePlay::checkTeleport() {
-	bool on_load_teleport = false;
+	// a map is being loaded in the background; finish the teleport once it is ready
+	if (map_loader.isRunning()) {
+		if (map_loader.isDone()) {
+			const uint64_t setup_start_ticks = SDL_GetPerformanceCounter();
+			const std::string teleport_mapname = map_loader.getFilename();
+
+			bool on_load_teleport = changeMap();
+			render_device->clearPrefetchedImages();
+			endTeleport(on_load_teleport);
+
+			const uint64_t end_ticks = SDL_GetPerformanceCounter();
+			Utils::logInfo("GameStatePlay: Teleport to '%s' took %.1f ms (%.1f ms loading in the background, %.1f ms setting up the map).",
+				teleport_mapname.c_str(),
+				profiler->getMilliseconds(end_ticks - teleport_start_ticks),
+				profiler->getMilliseconds(setup_start_ticks - teleport_start_ticks),
+				profiler->getMilliseconds(end_ticks - setup_start_ticks));
+		}
+		return;
+	}
 
 	// both map events and player powers can cause teleportation
 	if (mapr->teleportation || pc->stats.teleportation) {
@@ -324,6 +345,7 @@ void GameStatePlay::checkTeleport() {
 					mapr->collider.block(entitym->entities[i]->stats.pos.x, entitym->entities[i]->stats.pos.y, MapCollision::IS_ALLY);
 				}
 			}
+			entitym->invalidateSpatialGrid();
 		}
 
 		// process intermap teleport
@@ -335,71 +357,98 @@ void GameStatePlay::checkTeleport() {
 			mapr->executeOnMapExitEvents();
 			showLoading();
 			save_load->saveGame();
-			mapr->load(teleport_mapname);
-			setLoadingFrame();
-
-			// use the default hero spawn position for this map
-			if (mapr->teleport_destination.x == -1 && mapr->teleport_destination.y == -1) {
-				pc->stats.pos.x = mapr->hero_pos.x;
-				pc->stats.pos.y = mapr->hero_pos.y;
-				mapr->cam.warpTo(pc->stats.pos);
-			}
 
-			// store this as the new respawn point (provided the tile is open)
-			if (mapr->collider.isValidPosition(pc->stats.pos.x, pc->stats.pos.y, MapCollision::MOVE_NORMAL, MapCollision::COLLIDE_HERO)) {
-				mapr->respawn_map = teleport_mapname;
-				mapr->respawn_point = pc->stats.pos;
-			}
-			else {
-				Utils::logError("GameStatePlay: Spawn position (%d, %d) is blocked.", static_cast<int>(pc->stats.pos.x), static_cast<int>(pc->stats.pos.y));
-			}
+			// the rest of the teleport happens in changeMap() once the map is loaded
+			teleport_start_ticks = SDL_GetPerformanceCounter();
+			map_loader.start(teleport_mapname, mapr->getTileset());
+			return;
+		}
 
-			pc->handleNewMap();
-			hazards->handleNewMap();
-			loot->handleNewMap();
-			powers->handleNewMap(&mapr->collider);
-			menu->enemy->handleNewMap();
-			menu->stash->visible = false;
+		endTeleport(false);
+	}
+	else if (mapr->teleport_mapname.empty()) {
+		mapr->teleportation = false;
+	}
+}
 
-			// switch off teleport flag so we can check if an on_load event has teleportation
-			mapr->teleportation = false;
+/**
+ * Set up the map that was loaded by map_loader
+ * Returns true if an on_load event of the new map starts another teleport
+ */
+bool GameStatePlay::changeMap() {
+	bool on_load_teleport = false;
+	const std::string teleport_mapname = map_loader.getFilename();
 
-			mapr->executeOnLoadEvents();
-			if (mapr->teleportation)
-				on_load_teleport = true;
+	mapr->load(teleport_mapname, map_loader.finish());
+	setLoadingFrame();
 
-			// enemies and npcs should be initialized AFTER on_load events execute
-			entitym->handleNewMap();
-			npcs->handleNewMap();
-			resetNPC();
+	// use the default hero spawn position for this map
+	if (mapr->teleport_destination.x == -1 && mapr->teleport_destination.y == -1) {
+		pc->stats.pos.x = mapr->hero_pos.x;
+		pc->stats.pos.y = mapr->hero_pos.y;
+		mapr->cam.warpTo(pc->stats.pos);
+	}
 
-			menu->mini->prerender(&mapr->collider, mapr->w, mapr->h);
+	// store this as the new respawn point (provided the tile is open)
+	if (mapr->collider.isValidPosition(pc->stats.pos.x, pc->stats.pos.y, MapCollision::MOVE_NORMAL, MapCollision::COLLIDE_HERO)) {
+		mapr->respawn_map = teleport_mapname;
+		mapr->respawn_point = pc->stats.pos;
+	}
+	else {
+		Utils::logError("GameStatePlay: Spawn position (%d, %d) is blocked.", static_cast<int>(pc->stats.pos.x), static_cast<int>(pc->stats.pos.y));
+	}
 
-			// return to title (permadeath) OR auto-save
-			if (pc->stats.permadeath && pc->stats.cur_state == StatBlock::ENTITY_DEAD) {
-				snd->stopMusic();
-				showLoading();
-				setRequestedGameState(new GameStateTitle());
-			}
-			else if (eset->misc.save_onload) {
-				if (!is_first_map_load)
-					save_load->saveGame();
-				else
-					is_first_map_load = false;
-			}
-		}
+	pc->handleNewMap();
+	hazards->handleNewMap();
+	loot->handleNewMap();
+	powers->handleNewMap(&mapr->collider);
+	menu->enemy->handleNewMap();
+	menu->stash->visible = false;
 
-		if (mapr->collider.isOutsideMap(pc->stats.pos.x, pc->stats.pos.y)) {
-			Utils::logError("GameStatePlay: Teleport position is outside of map bounds.");
-			pc->stats.pos.x = 0.5f;
-			pc->stats.pos.y = 0.5f;
-		}
+	// switch off teleport flag so we can check if an on_load event has teleportation
+	mapr->teleportation = false;
 
-		mapr->collider.block(pc->stats.pos.x, pc->stats.pos.y, !MapCollision::IS_ALLY);
+	mapr->executeOnLoadEvents();
+	if (mapr->teleportation)
+		on_load_teleport = true;
 
-		pc->stats.teleportation = false;
+	// enemies and npcs should be initialized AFTER on_load events execute
+	entitym->handleNewMap();
+	npcs->handleNewMap();
+	resetNPC();
+
+	menu->mini->prerender(&mapr->collider, mapr->w, mapr->h);
+
+	// return to title (permadeath) OR auto-save
+	if (pc->stats.permadeath && pc->stats.cur_state == StatBlock::ENTITY_DEAD) {
+		snd->stopMusic();
+		showLoading();
+		setRequestedGameState(new GameStateTitle());
+	}
+	else if (eset->misc.save_onload) {
+		if (!is_first_map_load)
+			save_load->saveGame();
+		else
+			is_first_map_load = false;
 	}
 
+	return on_load_teleport;
+}
+
+/**
+ * Place the player on the map after a teleport has finished
+ */
+void GameStatePlay::endTeleport(bool on_load_teleport) {
+	if (mapr->collider.isOutsideMap(pc->stats.pos.x, pc->stats.pos.y)) {
+		Utils::logError("GameStatePlay: Teleport position is outside of map bounds.");
+		pc->stats.pos.x = 0.5f;
+		pc->stats.pos.y = 0.5f;
+	}
+
+	mapr->collider.block(pc->stats.pos.x, pc->stats.pos.y, !MapCollision::IS_ALLY);
+
+	pc->stats.teleportation = false;
+
 	if (!on_load_teleport && mapr->teleport_mapname.empty())
 		mapr->teleportation = false;
 }
@@ -830,6 +879,21 @@ void GameStatePlay::updateActionBar(unsigned index) {
  * This includes some message passing between child object
  */
 void GameStatePlay::logic() {
+	PROFILE_SCOPE(Profiler::SECTION_LOGIC);
+
+	// the game is paused while a new map is loaded in the background
+	if (map_loader.isRunning()) {
+		// closing the window doesn't wait for the map. The game was already saved when the teleport started
+		if (inpt->done) {
+			map_loader.cancel();
+			render_device->clearPrefetchedImages();
+			return;
+		}
+
+		checkTeleport();
+		return;
+	}
+
 	if (inpt->window_resized)
 		refreshWidgets();
 
@@ -853,8 +917,13 @@ void GameStatePlay::logic() {
 		checkEnemyFocus();
 		checkNPCFocus();
 		if (pc->stats.alive) {
-			mapr->checkHotspots();
-			mapr->checkNearestEvent();
+			{
+				PROFILE_SCOPE(Profiler::SECTION_MAP_EVENTS);
+				// pick up changes made by the menus, so that event requirements are up to date
+				camp->logic();
+				mapr->checkHotspots();
+				mapr->checkNearestEvent();
+			}
 			checkNPCInteraction();
 		}
 		checkTitle();
@@ -902,8 +971,12 @@ void GameStatePlay::logic() {
 	checkNotifications();
 	checkCancel();
 
-	mapr->logic(isPaused());
+	{
+		PROFILE_SCOPE(Profiler::SECTION_MAP_EVENTS);
+		mapr->logic(isPaused());
+	}
 	mapr->enemies_cleared = entitym->isCleared();
+	camp->logic();
 	quests->logic();
 
 	pc->checkTransform();
@@ -1009,10 +1082,15 @@ void GameStatePlay::render() {
 	if (mapr->is_spawn_map)
 		return;
 
+	if (map_loader.isRunning()) {
+		loading_tip->render(loading_tip_buf, Point(settings->view_w, settings->view_h), TooltipData::STYLE_FLOAT);
+		return;
+	}
+
 	// Create a list of Renderables from all objects not already on the map.
 	// split the list into the beings alive (may move) and dead beings (must not move)
-	std::vector<Renderable> rens;
-	std::vector<Renderable> rens_dead;
+	rens.clear();
+	rens_dead.clear();
 
 	pc->addRenders(rens);
 
@@ -1049,6 +1127,10 @@ bool GameStatePlay::isPaused() {
 	return menu->pause;
 }
 
+bool GameStatePlay::isLoadingMap() {
+	return map_loader.isRunning();
+}
+
 void GameStatePlay::resetNPC() {
 	npc_id = -1;
 	menu->talker->npc_from_map = true;
@@ -1095,6 +1177,10 @@ bool GameStatePlay::checkPrimaryStat(const std::string& first, const std::string
 }
 
 GameStatePlay::~GameStatePlay() {
+	// the loading thread reads enemyg, which is deleted below
+	map_loader.cancel();
+	render_device->clearPrefetchedImages();
+
 	curs->setLowHP(false);
 
 	delete quests;
@@ -29,6 +29,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "CommonIncludes.h"
 #include "GameState.h"
+#include "MapLoader.h"
+#include "RenderDevice.h"
 #include "Utils.h"
 
 class Avatar;
@@ -71,6 +73,8 @@ private:
 	void checkLoot();
 	void checkLootDrop();
 	void checkTeleport();
+	bool changeMap();
+	void endTeleport(bool on_load_teleport);
 	void checkCancel();
 	void checkLog();
 	void checkBook();
@@ -95,6 +99,13 @@ private:
 
 	bool is_first_map_load;
 
+	// renderables are collected here every frame. Kept as members so their memory is reused
+	std::vector<Renderable> rens;
+	std::vector<Renderable> rens_dead;
+
+	MapLoader map_loader;
+	uint64_t teleport_start_ticks; // when map_loader was started, for logging how long the teleport took
+
 	static const unsigned UPDATE_ACTIONBAR_ALL = 0;
 
 public:
@@ -103,6 +114,7 @@ public:
 	void refreshWidgets();
 
 	bool isPaused();
+	bool isLoadingMap();
 	void logic();
 	void render();
 	void resetGame();
@@ -39,6 +39,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "GameStateTitle.h"
 #include "GameSwitcher.h"
 #include "InputState.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "Settings.h"
 #include "SharedResources.h"
@@ -54,9 +55,11 @@ GameSwitcher::GameSwitcher()
 	, background_filename("")
 	, fps_update()
 	, last_fps(0)
+	, profiler_update()
 {
 	// update the fps counter 4 times per second
 	fps_update.setDuration(settings->max_frames_per_sec / 4);
+	profiler_update.setDuration(settings->max_frames_per_sec / 4);
 
 	// The initial state is the intro cutscene and then title screen
 	GameStateTitle *title=new GameStateTitle();
@@ -232,6 +235,45 @@ void GameSwitcher::showFPS(float fps) {
 	}
 }
 
+/**
+ * Lists the per-frame cost of each profiled section below the fps counter
+ */
+void GameSwitcher::showProfiler() {
+	if (!profiler || !profiler->show_overlay)
+		return;
+
+	if (labels_profiler.empty()) {
+		for (int i = 0; i < Profiler::SECTION_COUNT; ++i) {
+			labels_profiler.push_back(new WidgetLabel());
+		}
+	}
+
+	if (profiler_update.isEnd()) {
+		profiler_update.reset(Timer::BEGIN);
+
+		font->setFont("font_regular");
+		const int line_height = font->getLineHeight();
+
+		for (int i = 0; i < Profiler::SECTION_COUNT; ++i) {
+			std::string text = Profiler::getSectionName(i) + " " + Utils::floatToString(profiler->getFrameAverage(i), 2) + " / " + Utils::floatToString(profiler->getFrameMax(i), 2) + " ms";
+
+			Rect pos = fps_position;
+			pos.y += (i + 1) * line_height;
+			pos.w = font->calc_width(text);
+			Utils::alignToScreenEdge(fps_corner, &pos);
+
+			labels_profiler[i]->setPos(pos.x, pos.y);
+			labels_profiler[i]->setText(text);
+			labels_profiler[i]->setColor(fps_color);
+		}
+	}
+
+	for (size_t i = 0; i < labels_profiler.size(); ++i) {
+		labels_profiler[i]->render();
+	}
+	profiler_update.tick();
+}
+
 void GameSwitcher::loadFPS() {
 	// Load FPS rendering settings
 	FileParser infile;
@@ -299,6 +341,9 @@ void GameSwitcher::saveUserSettings() {
 GameSwitcher::~GameSwitcher() {
 	delete currentState;
 	delete label_fps;
+	for (size_t i = 0; i < labels_profiler.size(); ++i) {
+		delete labels_profiler[i];
+	}
 	snd->unloadMusic();
 	freeBackground();
 	background_list.clear();
@@ -59,6 +59,9 @@ private:
 	Timer fps_update;
 	float last_fps;
 
+	std::vector<WidgetLabel*> labels_profiler;
+	Timer profiler_update;
+
 public:
 	GameSwitcher();
 	GameSwitcher(const GameSwitcher &copy); // not implemented.
@@ -72,6 +75,7 @@ public:
 	void logic();
 	void render();
 	void showFPS(float fps);
+	void showProfiler();
 	void saveUserSettings();
 	bool done;
 };
@@ -31,6 +31,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "Hazard.h"
 #include "HazardManager.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "SharedGameResources.h"
 #include "SharedResources.h"
@@ -43,6 +44,7 @@ HazardManager::HazardManager()
 }
 
 void HazardManager::logic() {
+	PROFILE_SCOPE(Profiler::SECTION_HAZARDS);
 
 	// remove all hazards with lifespan 0.  Most hazards still display their last frame.
 	for (size_t i=h.size(); i>0; i--) {
@@ -89,21 +91,22 @@ void HazardManager::logic() {
 	// handle collisions
 	for (size_t i=0; i<h.size(); i++) {
 		if (h[i]->isDangerousNow()) {
+			// only entities within the hazard's radius can be hit
+			entitym->getEntitiesInRadius(h[i]->pos, h[i]->power->radius, nearby_entities);
 
 			// process hazards that can hurt enemies
 			if (h[i]->source_type != Power::SOURCE_TYPE_ENEMY) { //hero or neutral sources
-				for (unsigned int eindex = 0; eindex < entitym->entities.size(); eindex++) {
+				for (size_t eindex = 0; eindex < nearby_entities.size(); eindex++) {
+					Entity* e = nearby_entities[eindex];
 
 					// only check living enemies
-					if (entitym->entities[eindex]->stats.hp > 0 && h[i]->active && (entitym->entities[eindex]->stats.hero_ally == h[i]->power->target_party)) {
-						if (Utils::isWithinRadius(h[i]->pos, h[i]->power->radius, entitym->entities[eindex]->stats.pos)) {
-							if (!h[i]->hasEntity(entitym->entities[eindex])) {
-								// hit!
-								h[i]->addEntity(entitym->entities[eindex]);
-								hitEntity(i, entitym->entities[eindex]->takeHit(*h[i]));
-								if (!h[i]->power->beacon) {
-									last_enemy = entitym->entities[eindex];
-								}
+					if (e->stats.hp > 0 && h[i]->active && (e->stats.hero_ally == h[i]->power->target_party)) {
+						if (!h[i]->hasEntity(e)) {
+							// hit!
+							h[i]->addEntity(e);
+							hitEntity(i, e->takeHit(*h[i]));
+							if (!h[i]->power->beacon) {
+								last_enemy = e;
 							}
 						}
 					}
@@ -124,15 +127,15 @@ void HazardManager::logic() {
 				}
 
 				//now process allies
-				for (unsigned int eindex = 0; eindex < entitym->entities.size(); eindex++) {
+				for (size_t eindex = 0; eindex < nearby_entities.size(); eindex++) {
+					Entity* e = nearby_entities[eindex];
+
 					// only check living allies
-					if (entitym->entities[eindex]->stats.hp > 0 && h[i]->active && entitym->entities[eindex]->stats.hero_ally) {
-						if (Utils::isWithinRadius(h[i]->pos, h[i]->power->radius, entitym->entities[eindex]->stats.pos)) {
-							if (!h[i]->hasEntity(entitym->entities[eindex])) {
-								// hit!
-								h[i]->addEntity(entitym->entities[eindex]);
-								hitEntity(i, entitym->entities[eindex]->takeHit(*h[i]));
-							}
+					if (e->stats.hp > 0 && h[i]->active && e->stats.hero_ally) {
+						if (!h[i]->hasEntity(e)) {
+							// hit!
+							h[i]->addEntity(e);
+							hitEntity(i, e->takeHit(*h[i]));
 						}
 					}
 				}
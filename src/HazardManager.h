@@ -36,6 +36,9 @@ class HazardManager {
 private:
 	void hitEntity(size_t index, const bool hit);
 
+	// entities near the hazard currently being checked
+	std::vector<Entity*> nearby_entities;
+
 public:
 	HazardManager();
 	~HazardManager();
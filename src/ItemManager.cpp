@@ -122,7 +122,7 @@ void ItemManager::loadItems(const std::string& filename) {
 	FileParser infile;
 
 	// @CLASS ItemManager: Items|Description about the class and it usage, items/items.txt...
-	if (!infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+	if (!infile.openCompiled(filename, FileParser::ERROR_NORMAL))
 		return;
 
 	// used to clear vectors when overriding items
@@ -388,7 +388,7 @@ void ItemManager::loadTypes(const std::string& filename) {
 	FileParser infile;
 
 	// @CLASS ItemManager: Types|Definition of a item types, items/types.txt...
-	if (infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.openCompiled(filename, FileParser::ERROR_NORMAL)) {
 		while (infile.next()) {
 			if (infile.new_section) {
 				if (infile.section == "type") {
@@ -430,7 +430,7 @@ void ItemManager::loadQualities(const std::string& filename) {
 	FileParser infile;
 
 	// @CLASS ItemManager: Qualities|Definition of a item qualities, items/types.txt...
-	if (infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.openCompiled(filename, FileParser::ERROR_NORMAL)) {
 		while (infile.next()) {
 			if (infile.new_section) {
 				if (infile.section == "quality") {
@@ -520,7 +520,7 @@ void ItemManager::loadSets(const std::string& filename) {
 	FileParser infile;
 
 	// @CLASS ItemManager: Sets|Definition of a item sets, items/sets.txt...
-	if (!infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+	if (!infile.openCompiled(filename, FileParser::ERROR_NORMAL))
 		return;
 
 	bool clear_bonus = true;
@@ -59,6 +59,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 LootManager::LootManager()
 	: sfx_loot(snd->load(eset->loot.sfx_loot, "LootManager dropping loot"))
 	, sfx_loot_channel("loot")
+	, loot_grid_dirty(true)
 {
 	loadGraphics();
 	loadLootTables();
@@ -86,6 +87,8 @@ void LootManager::loadGraphics() {
 
 void LootManager::handleNewMap() {
 	loot.clear();
+	loot_grid.init(mapr->w, mapr->h);
+	loot_grid_dirty = true;
 	enemiesDroppingLoot.clear();
 }
 
@@ -401,6 +404,7 @@ void LootManager::addLoot(ItemStack stack, const FPoint& pos, bool dropped_by_he
 	}
 
 	loot.push_back(ld);
+	loot_grid_dirty = true;
 	snd->play(sfx_loot, sfx_loot_channel, pos, false);
 }
 
@@ -418,8 +422,9 @@ ItemStack LootManager::checkPickup(const Point& mouse, const FPoint& cam, const
 		// location, picking it back up will work like a stack.
 		std::vector<Loot>::iterator it, it_tip, it_hotspot;
 		it_tip = it_hotspot = loot.end();
-		for (it = loot.end(); it != loot.begin(); ) {
-			--it;
+		getLootNear(hero_pos, eset->misc.interact_range);
+		for (size_t i = loot_query.size(); i > 0; --i) {
+			it = loot.begin() + loot_query[i-1];
 
 			// loot close enough to pickup?
 			if (fabs(hero_pos.x - it->pos.x) < eset->misc.interact_range && fabs(hero_pos.y - it->pos.y) < eset->misc.interact_range && !it->isFlying()) {
@@ -456,12 +461,14 @@ ItemStack LootManager::checkPickup(const Point& mouse, const FPoint& cam, const
 			inpt->lock[Input::MAIN1] = true;
 			loot_stack = it_tip->stack;
 			loot.erase(it_tip);
+			loot_grid_dirty = true;
 			return loot_stack;
 		}
 		else if (it_hotspot != loot.end()) {
 			inpt->lock[Input::MAIN1] = true;
 			loot_stack = it_hotspot->stack;
 			loot.erase(it_hotspot);
+			loot_grid_dirty = true;
 			return loot_stack;
 		}
 	}
@@ -485,12 +492,14 @@ ItemStack LootManager::checkAutoPickup(const FPoint& hero_pos) {
 	ItemStack loot_stack;
 
 	std::vector<Loot>::iterator it;
-	for (it = loot.end(); it != loot.begin(); ) {
-		--it;
+	getLootNear(hero_pos, eset->loot.autopickup_range);
+	for (size_t i = loot_query.size(); i > 0; --i) {
+		it = loot.begin() + loot_query[i-1];
 		if (!it->dropped_by_hero && fabs(hero_pos.x - it->pos.x) < eset->loot.autopickup_range && fabs(hero_pos.y - it->pos.y) < eset->loot.autopickup_range && !it->isFlying()) {
 			if (it->stack.item == eset->misc.currency_id && eset->loot.autopickup_currency) {
 				loot_stack = it->stack;
-				it = loot.erase(it);
+				loot.erase(it);
+				loot_grid_dirty = true;
 				return loot_stack;
 			}
 		}
@@ -506,8 +515,9 @@ ItemStack LootManager::checkNearestPickup(const FPoint& hero_pos) {
 	std::vector<Loot>::iterator it;
 	std::vector<Loot>::iterator nearest = loot.end();
 
-	for (it = loot.end(); it != loot.begin(); ) {
-		--it;
+	getLootNear(hero_pos, eset->misc.interact_range);
+	for (size_t i = loot_query.size(); i > 0; --i) {
+		it = loot.begin() + loot_query[i-1];
 
 		float distance = Utils::calcDist(hero_pos, it->pos);
 		if (distance < eset->misc.interact_range && distance < best_distance) {
@@ -519,12 +529,32 @@ ItemStack LootManager::checkNearestPickup(const FPoint& hero_pos) {
 	if (nearest != loot.end() && !nearest->stack.empty()) {
 		loot_stack = nearest->stack;
 		loot.erase(nearest);
+		loot_grid_dirty = true;
 		return loot_stack;
 	}
 
 	return loot_stack;
 }
 
+void LootManager::updateLootGrid() {
+	if (!loot_grid_dirty)
+		return;
+
+	loot_grid.clear();
+	for (size_t i = 0; i < loot.size(); ++i) {
+		loot_grid.add(static_cast<int>(i), loot[i].pos);
+	}
+	loot_grid_dirty = false;
+}
+
+/**
+ * Fills loot_query with the indices of all loot within a square of the given range around pos, in ascending order
+ */
+void LootManager::getLootNear(const FPoint& pos, float range) {
+	updateLootGrid();
+	loot_grid.queryRect(FPoint(pos.x - range, pos.y - range), FPoint(pos.x + range, pos.y + range), loot_query);
+}
+
 void LootManager::addRenders(std::vector<Renderable> &ren, std::vector<Renderable> &ren_dead) {
 	std::vector<Loot>::iterator it;
 	for (it = loot.begin(); it != loot.end(); ++it) {
@@ -627,7 +657,7 @@ void LootManager::loadLootTables() {
 	// @CLASS LootManger|Description of loot tables in loot/
 	for (unsigned i=0; i<filenames.size(); i++) {
 		FileParser infile;
-		if (!infile.open(filenames[i], FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+		if (!infile.openCompiled(filenames[i], FileParser::ERROR_NORMAL))
 			continue;
 
 		std::vector<EventComponent> *ec_list = &loot_tables[filenames[i]];
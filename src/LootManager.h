@@ -31,6 +31,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "FileParser.h"
 #include "ItemManager.h"
 #include "Loot.h"
+#include "SpatialGrid.h"
 #include "Utils.h"
 
 class Animation;
@@ -54,6 +55,8 @@ private:
 	void loadLootTables();
 	void getLootTable(const std::string &filename, std::vector<EventComponent> *ec_list);
 	void checkLootComponent(EventComponent* ec, FPoint *pos, std::vector<ItemStack> *itemstack_vec);
+	void updateLootGrid();
+	void getLootNear(const FPoint& pos, float range);
 
 	SoundID sfx_loot;
 	std::string sfx_loot_channel;
@@ -61,6 +64,11 @@ private:
 	// loot refers to ItemManager indices
 	std::vector<Loot> loot;
 
+	// loot positions bucketed by tile. Needs to be rebuilt whenever loot is added or removed
+	SpatialGrid loot_grid;
+	bool loot_grid_dirty;
+	std::vector<int> loot_query;
+
 	// enemies which should drop loot, but didnt yet.
 	std::vector<class StatBlock*> enemiesDroppingLoot;
 
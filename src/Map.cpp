@@ -20,6 +20,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 
 #include "CampaignManager.h"
+#include "CompiledMap.h"
 #include "EffectManager.h"
 #include "EngineSettings.h"
 #include "EventManager.h"
@@ -76,7 +77,7 @@ void Map::removeLayer(unsigned index) {
 	layers.erase(layers.begin() + index);
 }
 
-int Map::load(const std::string& fname) {
+int Map::load(const std::string& fname, CompiledMap* compiled) {
 	FileParser infile;
 
 	clearEvents();
@@ -95,39 +96,33 @@ int Map::load(const std::string& fname) {
 	hero_pos.x = 0;
 	hero_pos.y = 0;
 
-	// @CLASS Map|Description of maps/
-	if (!infile.open(fname, FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
-		return 0;
-
-	Utils::logInfo("Map: Loading map '%s'", fname.c_str());
+	// use the compiled version of the map if it is up to date, otherwise compile it now for next time
+	CompiledMap local_compiled;
+	if (!compiled) {
+		compiled = &local_compiled;
+		compiled->loadOrCompile(fname);
+	}
 
-	this->filename = fname;
+	if (!compiled->sources.empty()) {
+		Utils::logInfo("Map: Loading map '%s'", fname.c_str());
+		this->filename = fname;
+		loadCompiled(*compiled);
+	}
+	else {
+		// @CLASS Map|Description of maps/
+		if (!infile.open(fname, FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+			return 0;
 
-	while (infile.next()) {
-		if (infile.new_section) {
+		Utils::logInfo("Map: Loading map '%s'", fname.c_str());
 
-			// for sections that are stored in collections, add a new object here
-			if (infile.section == "enemy")
-				enemy_groups.push(Map_Group());
-			else if (infile.section == "npc")
-				map_npcs.push(Map_NPC());
-			else if (infile.section == "event")
-				events.push_back(Event());
+		this->filename = fname;
 
+		while (infile.next()) {
+			loadKeyPair(infile);
 		}
-		if (infile.section == "header")
-			loadHeader(infile);
-		else if (infile.section == "layer")
-			loadLayer(infile);
-		else if (infile.section == "enemy")
-			loadEnemyGroup(infile, &enemy_groups.back());
-		else if (infile.section == "npc")
-			loadNPC(infile);
-		else if (infile.section == "event")
-			EventManager::loadEvent(infile, &events.back());
-	}
 
-	infile.close();
+		infile.close();
+	}
 
 	if (fogofwar) fow->load();
 
@@ -144,10 +139,7 @@ int Map::load(const std::string& fname) {
 	if (std::find(layernames.begin(), layernames.end(), "collision") == layernames.end()) {
 		layernames.push_back("collision");
 		layers.resize(layers.size()+1);
-		layers.back().resize(w);
-		for (size_t i=0; i<layers.back().size(); ++i) {
-			layers.back()[i].resize(h, 0);
-		}
+		layers.back().resize(w, h, 0);
 	}
 
 	// ensure that our map contains a fog of war layer
@@ -156,6 +148,8 @@ int Map::load(const std::string& fname) {
 			std::stringstream ss;
 			ss.str("");
 			ss << settings->path_user << "saves/" << eset->misc.save_prefix << "/" << save_load->getGameSlot() << "/fow/" << Utils::hashString(mapr->getFilename()) << ".txt";
+			// the fog of war for this map may still be queued for writing
+			save_load->flushSaves();
 			if (infile.open(ss.str(), !FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
 				while (infile.next()) {
 					if (infile.section == "layer") {
@@ -168,19 +162,13 @@ int Map::load(const std::string& fname) {
 		if (std::find(layernames.begin(), layernames.end(), "fow_fog") == layernames.end()) {
 			layernames.push_back("fow_fog");
 			layers.resize(layers.size()+1);
-			layers.back().resize(w);
-			for (size_t i=0; i<layers.back().size(); ++i) {
-				layers.back()[i].resize(h, FogOfWar::TILE_HIDDEN);
-			}
+			layers.back().resize(w, h, FogOfWar::TILE_HIDDEN);
 		}
 
 		if (std::find(layernames.begin(), layernames.end(), "fow_dark") == layernames.end()) {
 			layernames.push_back("fow_dark");
 			layers.resize(layers.size()+1);
-			layers.back().resize(w);
-			for (size_t i=0; i<layers.back().size(); ++i) {
-				layers.back()[i].resize(h, FogOfWar::TILE_HIDDEN);
-			}
+			layers.back().resize(w, h, FogOfWar::TILE_HIDDEN);
 		}
 	}
 
@@ -191,6 +179,63 @@ int Map::load(const std::string& fname) {
 	return 0;
 }
 
+void Map::loadKeyPair(FileParser &infile) {
+	if (infile.new_section) {
+
+		// for sections that are stored in collections, add a new object here
+		if (infile.section == "enemy")
+			enemy_groups.push(Map_Group());
+		else if (infile.section == "npc")
+			map_npcs.push(Map_NPC());
+		else if (infile.section == "event")
+			events.push_back(Event());
+
+	}
+	if (infile.section == "header")
+		loadHeader(infile);
+	else if (infile.section == "layer")
+		loadLayer(infile);
+	else if (infile.section == "enemy")
+		loadEnemyGroup(infile, &enemy_groups.back());
+	else if (infile.section == "npc")
+		loadNPC(infile);
+	else if (infile.section == "event")
+		EventManager::loadEvent(infile, &events.back());
+}
+
+/**
+ * Feed the key pairs of a compiled map through the regular loaders
+ * Layer data is copied from the pre-parsed arrays instead of being read from text
+ */
+void Map::loadCompiled(const CompiledMap &compiled) {
+	FileParser infile;
+
+	for (size_t k = 0; k < compiled.key_pairs.size(); ++k) {
+		const CompiledMap::KeyPair& kp = compiled.key_pairs[k];
+
+		infile.setErrorLocation(compiled.sources[kp.source].path, kp.line_number);
+		infile.new_section = kp.new_section;
+		infile.section = kp.section;
+		infile.key = kp.key;
+		infile.val = kp.val;
+
+		if (kp.layer == -1) {
+			loadKeyPair(infile);
+			continue;
+		}
+
+		const CompiledMap::Layer& layer = compiled.layers[kp.layer];
+		if (layers.empty() || layer.w != w || layer.h != h) {
+			infile.error("Map: Layer data does not match the size of the map.");
+			continue;
+		}
+
+		for (unsigned short j = 0; j < h; ++j) {
+			layers.back().setRow(j, &layer.data[j * w]);
+		}
+	}
+}
+
 void Map::loadHeader(FileParser &infile) {
 	if (infile.key == "title") {
 		// @ATTR title|string|Title of map
@@ -252,10 +297,7 @@ void Map::loadLayer(FileParser &infile) {
 	if (infile.key == "type") {
 		// @ATTR layer.type|string|Map layer type.
 		layers.resize(layers.size()+1);
-		layers.back().resize(w);
-		for (size_t i=0; i<layers.back().size(); ++i) {
-			layers.back()[i].resize(h);
-		}
+		layers.back().resize(w, h);
 		layernames.push_back(infile.val);
 	}
 	else if (infile.key == "format") {
@@ -271,26 +313,19 @@ void Map::loadLayer(FileParser &infile) {
 		// @ATTR layer.data|raw|Raw map layer data
 		// layer map data handled as a special case
 		// The next h lines must contain layer data.
+		std::vector<unsigned short> row;
 		for (int j=0; j<h; j++) {
 			std::string val = infile.getRawLine();
 			infile.incrementLineNum();
-			if (!val.empty() && val[val.length()-1] != ',') {
-				val += ',';
-			}
 
 			// verify the width of this row
-			int comma_count = 0;
-			for (unsigned i=0; i<val.length(); ++i) {
-				if (val[i] == ',') comma_count++;
-			}
-			if (comma_count != w) {
+			if (!CompiledMap::parseLayerRow(val, w, row)) {
 				infile.error("Map: A row of layer data has a width not equal to %d.", w);
 				mods->resetModConfig();
 				Utils::Exit(1);
 			}
 
-			for (int i=0; i<w; i++)
-				layers.back()[i][j] = static_cast<unsigned short>(Parse::popFirstInt(val));
+			layers.back().setRow(j, &row[0]);
 		}
 	}
 	else {
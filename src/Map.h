@@ -26,6 +26,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "MapCollision.h"
 #include "Utils.h"
 
+class CompiledMap;
 class Event;
 class FileParser;
 class StatBlock;
@@ -141,6 +142,8 @@ public:
 
 class Map {
 protected:
+	void loadKeyPair(FileParser &infile);
+	void loadCompiled(const CompiledMap &compiled);
 	void loadHeader(FileParser &infile);
 	void loadLayer(FileParser &infile);
 	void loadEnemyGroup(FileParser &infile, Map_Group *group);
@@ -161,7 +164,8 @@ public:
 	void setTileset(const std::string& tset) { tileset = tset; }
 	void removeLayer(unsigned index);
 
-	int load(const std::string& filename);
+	// compiled can be a map that was already loaded by MapLoader
+	int load(const std::string& filename, CompiledMap* compiled = NULL);
 
 	std::string music_filename;
 
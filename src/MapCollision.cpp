@@ -30,10 +30,9 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #define NDEBUG
 #endif
 
-#include "AStarContainer.h"
-#include "AStarNode.h"
 #include "EngineSettings.h"
 #include "MapCollision.h"
+#include "Profiler.h"
 #include "SharedResources.h"
 
 #include <cfloat>
@@ -45,24 +44,30 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 // so if an entity has a position of (1-MIN_TILE_GAP, 0) and moves to the east, they will move to (1,0)
 const float MapCollision::MIN_TILE_GAP = 0.001f;
 
+MapCollision::FlowField::FlowField()
+	: target(-1, -1)
+	, valid(false)
+{
+}
+
 MapCollision::MapCollision()
 	: map_size(Point())
 {
-	colmap.resize(1);
-	colmap[0].resize(1);
+	colmap.resize(1, 1);
 }
 
 void MapCollision::setMap(const Map_Layer& _colmap, unsigned short w, unsigned short h) {
-	colmap.resize(w);
-	for (unsigned i=0; i<w; ++i) {
-		colmap[i].resize(h);
-	}
-	for (unsigned i=0; i<w; i++)
-		for (unsigned j=0; j<h; j++)
-			colmap[i][j] = _colmap[i][j];
+	colmap = _colmap;
 
 	map_size.x = w;
 	map_size.y = h;
+
+	astar.init(w, h);
+	invalidateFlowFields();
+
+	for (int i = 0; i < MOVEMENT_TYPE_COUNT; ++i) {
+		cluster_graphs[i].init(this, i);
+	}
 }
 
 int sgn(float f) {
@@ -221,7 +226,8 @@ bool MapCollision::isEmpty(const float& x, const float& y) const {
 	if (isTileOutsideMap(tile_x, tile_y)) return false;
 
 	// collision type check
-	return (colmap[tile_x][tile_y] == BLOCKS_NONE || colmap[tile_x][tile_y] == MAP_ONLY || colmap[tile_x][tile_y] == MAP_ONLY_ALT);
+	const unsigned short tile = colmap.get(tile_x, tile_y);
+	return (tile == BLOCKS_NONE || tile == MAP_ONLY || tile == MAP_ONLY_ALT);
 }
 
 /**
@@ -235,7 +241,8 @@ bool MapCollision::isWall(const float& x, const float& y) const {
 	if (isTileOutsideMap(tile_x, tile_y)) return true;
 
 	// collision type check
-	return (colmap[tile_x][tile_y] == BLOCKS_ALL || colmap[tile_x][tile_y] == BLOCKS_ALL_HIDDEN);
+	const unsigned short tile = colmap.get(tile_x, tile_y);
+	return (tile == BLOCKS_ALL || tile == BLOCKS_ALL_HIDDEN);
 }
 
 /**
@@ -245,14 +252,16 @@ bool MapCollision::isValidTile(const int& tile_x, const int& tile_y, int movemen
 	// outside the map isn't valid
 	if (isTileOutsideMap(tile_x,tile_y)) return false;
 
+	const unsigned short tile = colmap.get(tile_x, tile_y);
+
 	if (collide_type == COLLIDE_NORMAL) {
-		if (colmap[tile_x][tile_y] == BLOCKS_ENEMIES)
+		if (tile == BLOCKS_ENEMIES)
 			return false;
-		if (colmap[tile_x][tile_y] == BLOCKS_ENTITIES)
+		if (tile == BLOCKS_ENTITIES)
 			return false;
 	}
 	else if (collide_type == COLLIDE_HERO) {
-		if (colmap[tile_x][tile_y] == BLOCKS_ENEMIES && !eset->misc.enable_ally_collision)
+		if (tile == BLOCKS_ENEMIES && !eset->misc.enable_ally_collision)
 			return true;
 	}
 
@@ -262,14 +271,35 @@ bool MapCollision::isValidTile(const int& tile_x, const int& tile_y, int movemen
 
 	// flying creatures can't be in walls
 	if (movement_type == MOVE_FLYING) {
-		return (!(colmap[tile_x][tile_y] == BLOCKS_ALL || colmap[tile_x][tile_y] == BLOCKS_ALL_HIDDEN));
+		return (!(tile == BLOCKS_ALL || tile == BLOCKS_ALL_HIDDEN));
 	}
 
-	if (colmap[tile_x][tile_y] == MAP_ONLY || colmap[tile_x][tile_y] == MAP_ONLY_ALT)
+	if (tile == MAP_ONLY || tile == MAP_ONLY_ALT)
 		return true;
 
 	// normal creatures can only be in empty spaces
-	return (colmap[tile_x][tile_y] == BLOCKS_NONE);
+	return (tile == BLOCKS_NONE);
+}
+
+/**
+ * Is this tile passable for this movement type if no entities were on the map?
+ */
+bool MapCollision::isValidTerrain(const int& tile_x, const int& tile_y, int movement_type) const {
+	if (isTileOutsideMap(tile_x,tile_y)) return false;
+
+	unsigned short tile = colmap.get(tile_x, tile_y);
+
+	// block() only ever places entities on empty tiles
+	if (tile == BLOCKS_ENTITIES || tile == BLOCKS_ENEMIES)
+		tile = BLOCKS_NONE;
+
+	if (movement_type == MOVE_INTANGIBLE)
+		return true;
+
+	if (movement_type == MOVE_FLYING)
+		return (!(tile == BLOCKS_ALL || tile == BLOCKS_ALL_HIDDEN));
+
+	return (tile == BLOCKS_NONE || tile == MAP_ONLY || tile == MAP_ONLY_ALT);
 }
 
 /**
@@ -342,8 +372,8 @@ bool MapCollision::lineOfMovement(const float& x1, const float& y1, const float&
 	int tile_x = int(x2);
 	int tile_y = int(y2);
 	bool target_blocks = false;
-	int target_blocks_type = colmap[tile_x][tile_y];
-	if (colmap[tile_x][tile_y] == BLOCKS_ENTITIES || colmap[tile_x][tile_y] == BLOCKS_ENEMIES) {
+	int target_blocks_type = colmap.get(tile_x, tile_y);
+	if (colmap.get(tile_x, tile_y) == BLOCKS_ENTITIES || colmap.get(tile_x, tile_y) == BLOCKS_ENEMIES) {
 		target_blocks = true;
 		unblock(x2,y2);
 	}
@@ -390,9 +420,13 @@ bool MapCollision::isFacing(const float& x1, const float& y1, char direction, co
 * @return true if a path is found
 */
 bool MapCollision::computePath(const FPoint& start_pos, const FPoint& end_pos, std::vector<FPoint> &path, int movement_type, unsigned int limit) {
+	PROFILE_SCOPE(Profiler::SECTION_PATHFINDING);
 
 	if (isOutsideMap(end_pos.x, end_pos.y)) return false;
 
+	// long paths on the default limit go through the cluster graph, so the limit only has to cover a single leg
+	bool use_clusters = (limit == DEFAULT_PATH_LIMIT && movement_type >= 0 && movement_type < MOVEMENT_TYPE_COUNT && movement_type != MOVE_INTANGIBLE);
+
 	// default limit set to 10% of the total map size
 	if (limit == 0)
 		limit = (map_size.x * map_size.y) / 10;
@@ -407,43 +441,58 @@ bool MapCollision::computePath(const FPoint& start_pos, const FPoint& end_pos, s
 
 	// if the target square has an entity, temporarily clear it to compute the path
 	bool target_blocks = false;
-	int target_blocks_type = colmap[end.x][end.y];
-	if (colmap[end.x][end.y] == BLOCKS_ENTITIES || colmap[end.x][end.y] == BLOCKS_ENEMIES) {
+	int target_blocks_type = colmap.get(end.x, end.y);
+	if (colmap.get(end.x, end.y) == BLOCKS_ENTITIES || colmap.get(end.x, end.y) == BLOCKS_ENEMIES) {
 		target_blocks = true;
 		unblock(end_pos.x, end_pos.y);
 	}
 
-	Point current = start;
-	AStarNode* node = new AStarNode(start);
-	node->setActualCost(0);
-	node->setEstimatedCost(Utils::calcDist(FPoint(start),FPoint(end)));
-	node->setParent(current);
+	bool found = false;
+	if (use_clusters && !isOutsideMap(start_pos.x, start_pos.y) && cluster_graphs[movement_type].isFar(start, end))
+		found = computeClusterPath(start, end, path, movement_type, limit);
+
+	if (!found)
+		computeLocalPath(start, end, path, movement_type, limit);
+
+	// reblock target if needed
+	if (target_blocks) block(end_pos.x, end_pos.y, target_blocks_type == BLOCKS_ENEMIES);
+
+	return !path.empty();
+}
+
+/**
+* A* search between two tiles
+* If the end can't be reached within the node limit, the path leads to the closest node found instead
+* @return true if the path reaches end
+*/
+bool MapCollision::computeLocalPath(const Point& start, const Point& end, std::vector<FPoint> &path, int movement_type, unsigned int limit) {
+	if (!path.empty())
+		path.clear();
 
-	AStarContainer open(map_size.x, map_size.y, limit);
-	AStarCloseContainer close(map_size.x, map_size.y, limit);
+	Point current = start;
 
-	open.add(node);
+	astar.reset();
+	astar.addOpen(start, start, 0, Utils::calcDist(FPoint(start),FPoint(end)));
 
-	while (!open.isEmpty() && static_cast<unsigned>(close.getSize()) < limit) {
-		node = open.get_shortest_f();
+	Point neighbours[node_max_neighbours];
 
-		current.x = node->getX();
-		current.y = node->getY();
-		close.add(node);
-		open.remove(node);
+	while (!astar.isOpenEmpty() && static_cast<unsigned>(astar.getCloseSize()) < limit) {
+		current = astar.closeShortestF();
 
 		if ( current.x == end.x && current.y == end.y)
 			break; //path found !
 
+		AStarNode* node = astar.get(current.x, current.y);
+
 		//limit evaluated nodes to the size of the map
-		std::list<Point> neighbours = node->getNeighbours(map_size.x, map_size.y);
+		int neighbour_count = node->getNeighbours(neighbours, map_size.x, map_size.y);
 
 		// for every neighbour of current node
-		for (std::list<Point>::iterator it=neighbours.begin(); it != neighbours.end(); ++it)	{
-			Point neighbour = *it;
+		for (int i = 0; i < neighbour_count; ++i) {
+			const Point& neighbour = neighbours[i];
 
 			// do not exceed the node limit when adding nodes
-			if (static_cast<unsigned>(open.getSize()) >= limit) {
+			if (static_cast<unsigned>(astar.getOpenSize()) >= limit) {
 				break;
 			}
 
@@ -451,55 +500,266 @@ bool MapCollision::computePath(const FPoint& start_pos, const FPoint& end_pos, s
 			if (!isValidTile(neighbour.x,neighbour.y,movement_type, MapCollision::COLLIDE_NORMAL))
 				continue;
 			// if nabour is already in close, skip it
-			if(close.exists(neighbour))
+			if(astar.isClosed(neighbour))
 				continue;
 
+			float cost = node->getActualCost() + Utils::calcDist(FPoint(current),FPoint(neighbour));
+
 			// if neighbour isn't inside open, add it as a new Node
-			if(!open.exists(neighbour)) {
-				AStarNode* newNode = new AStarNode(neighbour);
-				newNode->setActualCost(node->getActualCost() + Utils::calcDist(FPoint(current),FPoint(neighbour)));
-				newNode->setParent(current);
-				newNode->setEstimatedCost(Utils::calcDist(FPoint(neighbour),FPoint(end)));
-				open.add(newNode);
+			if(!astar.isOpen(neighbour)) {
+				astar.addOpen(neighbour, current, cost, Utils::calcDist(FPoint(neighbour),FPoint(end)));
 			}
 			// else, update it's cost if better
-			else {
-				AStarNode* i = open.get(neighbour.x, neighbour.y);
-				if (node->getActualCost() + Utils::calcDist(FPoint(current),FPoint(neighbour)) < i->getActualCost()) {
-					Point pos(i->getX(), i->getY());
-					Point parent_pos(node->getX(), node->getY());
-					open.updateParent(pos, parent_pos, node->getActualCost() + Utils::calcDist(FPoint(current),FPoint(neighbour)));
-				}
+			else if (cost < astar.get(neighbour.x, neighbour.y)->getActualCost()) {
+				astar.updateParent(neighbour, current, cost);
 			}
 		}
 	}
 
-	if (!(current.x == end.x && current.y == end.y)) {
+	bool found = (current.x == end.x && current.y == end.y);
 
+	if (!found) {
 		//couldnt find the target so map a path to the closest node found
-		node = close.get_shortest_h();
-		current.x = node->getX();
-		current.y = node->getY();
+		current = astar.getShortestH();
+	}
+
+	// store path from end to start
+	while (!(current.x == start.x && current.y == start.y)) {
+		path.push_back(collisionToMap(current));
+		current = astar.get(current.x, current.y)->getParent();
+	}
+
+	return found;
+}
+
+/**
+* Compute a long path by searching the cluster graph, then connecting its waypoints with short A* searches
+* @return false if any part of the path could not be found
+*/
+bool MapCollision::computeClusterPath(const Point& start, const Point& end, std::vector<FPoint> &path, int movement_type, unsigned int limit) {
+	if (!cluster_graphs[movement_type].findPath(start, end, cluster_waypoints))
+		return false;
+
+	// refine the last leg first, so that the path ends up stored from end to start
+	for (size_t i = cluster_waypoints.size(); i > 0; --i) {
+		const Point leg_start = (i >= 2) ? cluster_waypoints[i-2] : start;
+		const Point leg_end = cluster_waypoints[i-1];
+
+		if (leg_start.x == leg_end.x && leg_start.y == leg_end.y)
+			continue;
 
-		while (!(current.x == start.x && current.y == start.y)) {
-			path.push_back(collisionToMap(current));
-			current = close.get(current.x, current.y)->getParent();
+		// an entity standing on a waypoint should not break the whole path
+		int leg_blocks_type = colmap.get(leg_end.x, leg_end.y);
+		bool leg_blocks = (leg_blocks_type == BLOCKS_ENTITIES || leg_blocks_type == BLOCKS_ENEMIES);
+		if (leg_blocks)
+			colmap.set(leg_end.x, leg_end.y, BLOCKS_NONE);
+
+		bool found = computeLocalPath(leg_start, leg_end, cluster_segment, movement_type, limit);
+
+		if (leg_blocks)
+			colmap.set(leg_end.x, leg_end.y, static_cast<unsigned short>(leg_blocks_type));
+
+		if (!found) {
+			path.clear();
+			return false;
 		}
+
+		path.insert(path.end(), cluster_segment.begin(), cluster_segment.end());
+	}
+
+	return !path.empty();
+}
+
+/**
+ * (Re)build a flow field towards the target tile
+ * Uses the same node limit as the default for computePath()
+ */
+void MapCollision::updateFlowField(FlowField& ff, const Point& target, int movement_type) {
+	const size_t map_area = static_cast<size_t>(map_size.x) * map_size.y;
+	if (ff.dist.size() != map_area) {
+		ff.dist.assign(map_area, -1);
+		ff.reached.clear();
+		ff.reached.reserve(map_area);
 	}
 	else {
-		// store path from end to start
-		path.push_back(collisionToMap(end));
-		while (!(current.x == start.x && current.y == start.y)) {
-			path.push_back(collisionToMap(current));
-			current = close.get(current.x, current.y)->getParent();
+		for (size_t i = 0; i < ff.reached.size(); ++i) {
+			ff.dist[ff.reached[i]] = -1;
 		}
+		ff.reached.clear();
 	}
-	// reblock target if needed
-	if (target_blocks) block(end_pos.x, end_pos.y, target_blocks_type == BLOCKS_ENEMIES);
+
+	ff.target = target;
+	ff.valid = true;
+
+	if (!isValidTerrain(target.x, target.y, movement_type))
+		return;
+
+	unsigned int limit = static_cast<unsigned>(map_area / 10);
+
+	// Dijkstra's algorithm is A* without an estimated cost
+	astar.reset();
+	astar.addOpen(target, target, 0, 0);
+
+	Point neighbours[node_max_neighbours];
+
+	while (!astar.isOpenEmpty() && static_cast<unsigned>(astar.getCloseSize()) < limit) {
+		Point current = astar.closeShortestF();
+		AStarNode* node = astar.get(current.x, current.y);
+
+		int index = current.x + current.y * map_size.x;
+		ff.dist[index] = node->getActualCost();
+		ff.reached.push_back(index);
+
+		int neighbour_count = node->getNeighbours(neighbours, map_size.x, map_size.y);
+
+		for (int i = 0; i < neighbour_count; ++i) {
+			const Point& neighbour = neighbours[i];
+
+			if (static_cast<unsigned>(astar.getOpenSize()) >= limit)
+				break;
+
+			if (!isValidTerrain(neighbour.x, neighbour.y, movement_type))
+				continue;
+			if (astar.isClosed(neighbour))
+				continue;
+
+			float cost = node->getActualCost() + Utils::calcDist(FPoint(current),FPoint(neighbour));
+
+			if (!astar.isOpen(neighbour))
+				astar.addOpen(neighbour, current, cost, 0);
+			else if (cost < astar.get(neighbour.x, neighbour.y)->getActualCost())
+				astar.updateParent(neighbour, current, cost);
+		}
+	}
+}
+
+void MapCollision::invalidateFlowFields() {
+	for (int i = 0; i < MOVEMENT_TYPE_COUNT; ++i) {
+		flow_fields[i].valid = false;
+	}
+}
+
+/**
+* Compute a path from start to end by following the shared flow field towards end
+* The flow field is only rebuilt when the target tile changes, so many entities chasing the same target share the work
+* Stores waypoints in the same order as computePath()
+* @return false if start was not reached by the flow field, in which case computePath() should be used instead
+*/
+bool MapCollision::computeFlowPath(const FPoint& start_pos, const FPoint& end_pos, std::vector<FPoint> &path, int movement_type) {
+	PROFILE_SCOPE(Profiler::SECTION_PATHFINDING);
+
+	if (movement_type < 0 || movement_type >= MOVEMENT_TYPE_COUNT) return false;
+	if (isOutsideMap(start_pos.x, start_pos.y) || isOutsideMap(end_pos.x, end_pos.y)) return false;
+
+	Point start(start_pos);
+	Point end(end_pos);
+
+	FlowField& ff = flow_fields[movement_type];
+	if (!ff.valid || ff.target.x != end.x || ff.target.y != end.y)
+		updateFlowField(ff, end, movement_type);
+
+	int start_index = start.x + start.y * map_size.x;
+	if (ff.dist[start_index] < 0)
+		return false;
+
+	if (!path.empty())
+		path.clear();
+
+	Point current = start;
+	Point neighbours[node_max_neighbours];
+	AStarNode node;
+
+	// a path can never be longer than the number of tiles in the field
+	for (size_t steps = 0; steps < ff.reached.size(); ++steps) {
+		if (current.x == end.x && current.y == end.y)
+			break;
+
+		float current_dist = ff.dist[current.x + current.y * map_size.x];
+		int best = -1;
+		float best_dist = current_dist;
+		int best_free = -1;
+		float best_free_dist = current_dist;
+
+		node = AStarNode(current);
+		int neighbour_count = node.getNeighbours(neighbours, map_size.x, map_size.y);
+
+		for (int i = 0; i < neighbour_count; ++i) {
+			float dist = ff.dist[neighbours[i].x + neighbours[i].y * map_size.x];
+			if (dist < 0 || dist >= current_dist)
+				continue;
+
+			if (dist < best_dist) {
+				best = i;
+				best_dist = dist;
+			}
+
+			// on the first step, prefer going around other entities
+			bool is_end = (neighbours[i].x == end.x && neighbours[i].y == end.y);
+			if (steps == 0 && dist < best_free_dist && (is_end || isValidTile(neighbours[i].x, neighbours[i].y, movement_type, COLLIDE_NORMAL))) {
+				best_free = i;
+				best_free_dist = dist;
+			}
+		}
+
+		if (best_free != -1)
+			best = best_free;
+
+		if (best == -1)
+			break;
+
+		current = neighbours[best];
+		path.push_back(collisionToMap(current));
+	}
+
+	// waypoints are stored from end to start
+	std::reverse(path.begin(), path.end());
 
 	return !path.empty();
 }
 
+/**
+ * Change the collision type of a single tile (e.g. from a map event)
+ * Flow fields are only thrown away if the change could alter them, and only the surrounding clusters of the cluster graph are rebuilt
+ */
+void MapCollision::setTile(int tile_x, int tile_y, unsigned short value) {
+	if (isTileOutsideMap(tile_x, tile_y))
+		return;
+
+	bool was_valid[MOVEMENT_TYPE_COUNT];
+	for (int i = 0; i < MOVEMENT_TYPE_COUNT; ++i) {
+		was_valid[i] = isValidTerrain(tile_x, tile_y, i);
+	}
+
+	colmap.set(tile_x, tile_y, value);
+
+	for (int i = 0; i < MOVEMENT_TYPE_COUNT; ++i) {
+		if (was_valid[i] != isValidTerrain(tile_x, tile_y, i))
+			cluster_graphs[i].invalidateTile(tile_x, tile_y);
+
+		FlowField& ff = flow_fields[i];
+		if (!ff.valid || was_valid[i] == isValidTerrain(tile_x, tile_y, i))
+			continue;
+
+		if (was_valid[i]) {
+			// a tile that was never reached can be blocked without consequence
+			if (ff.dist[tile_x + tile_y * map_size.x] >= 0)
+				ff.valid = false;
+		}
+		else {
+			// a newly opened tile only matters if the field can flow into it
+			AStarNode node(Point(tile_x, tile_y));
+			Point neighbours[node_max_neighbours];
+			int neighbour_count = node.getNeighbours(neighbours, map_size.x, map_size.y);
+			for (int j = 0; j < neighbour_count; ++j) {
+				if (ff.dist[neighbours[j].x + neighbours[j].y * map_size.x] >= 0) {
+					ff.valid = false;
+					break;
+				}
+			}
+		}
+	}
+}
+
 void MapCollision::block(const float& map_x, const float& map_y, bool is_ally) {
 	const int tile_x = int(map_x);
 	const int tile_y = int(map_y);
@@ -507,11 +767,11 @@ void MapCollision::block(const float& map_x, const float& map_y, bool is_ally) {
 	if (isTileOutsideMap(tile_x, tile_y))
 		return;
 
-	if (colmap[tile_x][tile_y] == BLOCKS_NONE) {
+	if (colmap.get(tile_x, tile_y) == BLOCKS_NONE) {
 		if(is_ally)
-			colmap[tile_x][tile_y] = BLOCKS_ENEMIES;
+			colmap.set(tile_x, tile_y, BLOCKS_ENEMIES);
 		else
-			colmap[tile_x][tile_y] = BLOCKS_ENTITIES;
+			colmap.set(tile_x, tile_y, BLOCKS_ENTITIES);
 	}
 
 }
@@ -523,8 +783,8 @@ void MapCollision::unblock(const float& map_x, const float& map_y) {
 	if (isTileOutsideMap(tile_x, tile_y))
 		return;
 
-	if (colmap[tile_x][tile_y] == BLOCKS_ENTITIES || colmap[tile_x][tile_y] == BLOCKS_ENEMIES) {
-		colmap[tile_x][tile_y] = BLOCKS_NONE;
+	if (colmap.get(tile_x, tile_y) == BLOCKS_ENTITIES || colmap.get(tile_x, tile_y) == BLOCKS_ENEMIES) {
+		colmap.set(tile_x, tile_y, BLOCKS_NONE);
 	}
 
 }
@@ -26,11 +26,12 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #ifndef MAP_COLLISION_H
 #define MAP_COLLISION_H
 
+#include "AStarClusterGraph.h"
+#include "AStarContainer.h"
 #include "CommonIncludes.h"
+#include "MapLayer.h"
 #include "Utils.h"
 
-typedef std::vector< std::vector<unsigned short> > Map_Layer;
-
 class MapCollision {
 private:
 	static const float MIN_TILE_GAP;
@@ -56,6 +57,36 @@ private:
 
 	FPoint collisionToMap(const Point& p);
 
+	// node storage reused by every call to computePath()
+	AStarContainer astar;
+
+	/**
+	 * A Dijkstra map of the walking distance from every reached tile to a single target tile.
+	 * Only terrain is taken into account, so entities blocking/unblocking their tiles do not invalidate it.
+	 */
+	class FlowField {
+	public:
+		Point target;
+		bool valid;
+		std::vector<float> dist; // -1 means the tile was not reached
+		std::vector<int> reached; // indexes of tiles with a distance, used to clear them for the next update
+		FlowField();
+	};
+
+	static const int MOVEMENT_TYPE_COUNT = 3;
+	FlowField flow_fields[MOVEMENT_TYPE_COUNT];
+
+	// abstract graphs for long distance paths, one per movement type
+	AStarClusterGraph cluster_graphs[MOVEMENT_TYPE_COUNT];
+	std::vector<Point> cluster_waypoints;
+	std::vector<FPoint> cluster_segment;
+
+	bool computeLocalPath(const Point& start, const Point& end, std::vector<FPoint> &path, int movement_type, unsigned int limit);
+	bool computeClusterPath(const Point& start, const Point& end, std::vector<FPoint> &path, int movement_type, unsigned int limit);
+
+	void updateFlowField(FlowField& ff, const Point& target, int movement_type);
+	void invalidateFlowFields();
+
 public:
 	// const flags
 	static const bool IGNORE_BLOCKED = true;
@@ -102,6 +133,7 @@ public:
 	bool isWall(const float& x, const float& y) const;
 
 	bool isValidPosition(const float& x, const float& y, int movement_type, int collide_type) const;
+	bool isValidTerrain(const int& tile_x, const int& tile_y, int movement_type) const;
 
 	bool lineOfSight(const float& x1, const float& y1, const float& x2, const float& y2);
 	bool lineOfMovement(const float& x1, const float& y1, const float& x2, const float& y2, int movement_type);
@@ -109,6 +141,9 @@ public:
 	bool isFacing(const float& x1, const float& y1, char direction, const float& x2, const float& y2);
 
 	bool computePath(const FPoint& start, const FPoint& end, std::vector<FPoint> &path, int movement_type, unsigned int limit);
+	bool computeFlowPath(const FPoint& start, const FPoint& end, std::vector<FPoint> &path, int movement_type);
+
+	void setTile(int tile_x, int tile_y, unsigned short value);
 
 	void block(const float& map_x, const float& map_y, bool is_ally);
 	void unblock(const float& map_x, const float& map_y);
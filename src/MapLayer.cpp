@@ -0,0 +1,71 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "MapLayer.h"
+
+Map_Layer::Map_Layer()
+	: w(0)
+	, h(0)
+	, blocks_w(0)
+{
+}
+
+Map_Layer::Map_Layer(unsigned short _w, unsigned short _h, unsigned short value)
+	: w(0)
+	, h(0)
+	, blocks_w(0)
+{
+	resize(_w, _h, value);
+}
+
+Map_Layer::~Map_Layer() {
+}
+
+void Map_Layer::resize(unsigned short _w, unsigned short _h, unsigned short value) {
+	w = _w;
+	h = _h;
+	blocks_w = (static_cast<size_t>(w) + BLOCK_MASK) >> BLOCK_SHIFT;
+
+#ifdef FLARE_MAP_LAYER_TILED
+	// partial blocks at the right and bottom edges are padded
+	const size_t blocks_h = (static_cast<size_t>(h) + BLOCK_MASK) >> BLOCK_SHIFT;
+	tiles.assign((blocks_w * blocks_h) << (BLOCK_SHIFT * 2), value);
+#else
+	tiles.assign(static_cast<size_t>(w) * static_cast<size_t>(h), value);
+#endif
+}
+
+void Map_Layer::setRow(size_t y, const unsigned short* values) {
+#ifdef FLARE_MAP_LAYER_TILED
+	for (size_t x = 0; x < w; ++x) {
+		set(x, y, values[x]);
+	}
+#else
+	std::copy(values, values + w, tiles.begin() + y * w);
+#endif
+}
+
+void Map_Layer::fill(unsigned short value) {
+	std::fill(tiles.begin(), tiles.end(), value);
+}
+
+void Map_Layer::clear() {
+	tiles.clear();
+	w = 0;
+	h = 0;
+	blocks_w = 0;
+}
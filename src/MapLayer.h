@@ -0,0 +1,73 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class Map_Layer
+ *
+ * A width x height grid of tile ids stored in a single allocation.
+ * Tiles are stored row by row (index = y * width + x), the same order as the map files
+ * and the order in which orthogonal maps are rendered.
+ *
+ * When built with FLARE_MAP_LAYER_TILED (cmake -DMAP_LAYER_TILED=ON), tiles are instead stored
+ * in blocks of 8x8, which keeps the diagonal walks of isometric rendering within fewer cache lines.
+ */
+
+#ifndef MAP_LAYER_H
+#define MAP_LAYER_H
+
+#include "CommonIncludes.h"
+
+class Map_Layer {
+public:
+	static const size_t BLOCK_SHIFT = 3; // 8x8 blocks when FLARE_MAP_LAYER_TILED is defined
+	static const size_t BLOCK_MASK = (1 << BLOCK_SHIFT) - 1;
+
+	Map_Layer();
+	Map_Layer(unsigned short _w, unsigned short _h, unsigned short value = 0);
+	~Map_Layer();
+
+	// sets the size of the layer. All tiles are set to value
+	void resize(unsigned short _w, unsigned short _h, unsigned short value = 0);
+	void fill(unsigned short value);
+	void clear();
+
+	bool isEmpty() const { return tiles.empty(); }
+	unsigned short getWidth() const { return w; }
+	unsigned short getHeight() const { return h; }
+
+	unsigned short get(size_t x, size_t y) const { return tiles[getIndex(x, y)]; }
+	void set(size_t x, size_t y, unsigned short value) { tiles[getIndex(x, y)] = value; }
+
+	// copies a full row of width tiles
+	void setRow(size_t y, const unsigned short* values);
+
+private:
+	size_t getIndex(size_t x, size_t y) const {
+#ifdef FLARE_MAP_LAYER_TILED
+		return ((((y >> BLOCK_SHIFT) * blocks_w) + (x >> BLOCK_SHIFT)) << (BLOCK_SHIFT * 2)) + ((y & BLOCK_MASK) << BLOCK_SHIFT) + (x & BLOCK_MASK);
+#else
+		return y * w + x;
+#endif
+	}
+
+	std::vector<unsigned short> tiles;
+	unsigned short w;
+	unsigned short h;
+	size_t blocks_w;
+};
+
+#endif
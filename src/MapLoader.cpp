@@ -0,0 +1,165 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "AnimationSet.h"
+#include "EnemyGroupManager.h"
+#include "MapLoader.h"
+#include "RenderDevice.h"
+#include "SharedGameResources.h"
+#include "SharedResources.h"
+#include "StatBlock.h"
+#include "TileSet.h"
+#include "Utils.h"
+
+MapLoader::MapLoader()
+	: thread(NULL)
+	, mutex(SDL_CreateMutex())
+	, running(false)
+	, done(false)
+	, cancelled(false)
+{
+}
+
+MapLoader::~MapLoader() {
+	cancel();
+	SDL_DestroyMutex(mutex);
+}
+
+void MapLoader::start(const std::string& _filename, const std::string& loaded_tileset) {
+	wait();
+
+	filename = _filename;
+	skip_tileset = loaded_tileset;
+	compiled.clear();
+	running = true;
+	done = false;
+	cancelled = false;
+
+	thread = SDL_CreateThread(threadFunction, "MapLoader", this);
+	if (!thread) {
+		// load on this thread instead
+		Utils::logError("MapLoader: Could not create thread: %s", SDL_GetError());
+		load();
+	}
+}
+
+bool MapLoader::isRunning() const {
+	return running;
+}
+
+bool MapLoader::isDone() {
+	SDL_LockMutex(mutex);
+	bool result = done;
+	SDL_UnlockMutex(mutex);
+	return result;
+}
+
+CompiledMap* MapLoader::finish() {
+	wait();
+	running = false;
+	return &compiled;
+}
+
+void MapLoader::cancel() {
+	SDL_LockMutex(mutex);
+	cancelled = true;
+	SDL_UnlockMutex(mutex);
+
+	wait();
+	running = false;
+	compiled.clear();
+}
+
+const std::string& MapLoader::getFilename() const {
+	return filename;
+}
+
+int MapLoader::threadFunction(void* data) {
+	static_cast<MapLoader*>(data)->load();
+	return 0;
+}
+
+void MapLoader::load() {
+	compiled.loadOrCompile(filename);
+
+	// decode the tile sheets, the textures are created when MapRenderer loads the tileset
+	const std::string tileset = compiled.getTileset();
+	if (!tileset.empty() && tileset != skip_tileset) {
+		std::vector<std::string> image_filenames;
+		TileSet::getImageFilenames(tileset, image_filenames);
+		for (size_t i = 0; i < image_filenames.size() && !isCancelled(); ++i) {
+			render_device->prefetchImage(image_filenames[i]);
+		}
+	}
+
+	if (!isCancelled())
+		prefetchEnemyImages();
+
+	SDL_LockMutex(mutex);
+	done = true;
+	SDL_UnlockMutex(mutex);
+}
+
+/**
+ * Enemy groups pick their enemies at random when the map is set up, so the sprite sheets of every enemy in
+ * the categories of the map's groups are decoded. The ones that aren't used are freed with the other prefetched images.
+ */
+void MapLoader::prefetchEnemyImages() {
+	if (!enemyg)
+		return;
+
+	std::set<std::string> categories;
+	for (size_t i = 0; i < compiled.key_pairs.size(); ++i) {
+		const CompiledMap::KeyPair& key_pair = compiled.key_pairs[i];
+		if (key_pair.section == "enemy" && key_pair.key == "category")
+			categories.insert(key_pair.val);
+	}
+
+	std::set<std::string> enemy_types;
+	for (std::set<std::string>::iterator it = categories.begin(); it != categories.end(); ++it) {
+		std::vector<Enemy_Level> enemies = enemyg->getEnemiesInCategory(*it);
+		for (size_t i = 0; i < enemies.size(); ++i) {
+			enemy_types.insert(enemies[i].type);
+		}
+	}
+
+	// enemies often share their animations, so the sheets are collected first
+	std::set<std::string> images;
+	std::vector<std::string> image_filenames;
+	for (std::set<std::string>::iterator it = enemy_types.begin(); it != enemy_types.end() && !isCancelled(); ++it) {
+		AnimationSet::getImageFilenames(StatBlock::getAnimationsFilename(*it), image_filenames);
+		images.insert(image_filenames.begin(), image_filenames.end());
+	}
+
+	for (std::set<std::string>::iterator it = images.begin(); it != images.end() && !isCancelled(); ++it) {
+		render_device->prefetchImage(*it);
+	}
+}
+
+bool MapLoader::isCancelled() {
+	SDL_LockMutex(mutex);
+	bool result = cancelled;
+	SDL_UnlockMutex(mutex);
+	return result;
+}
+
+void MapLoader::wait() {
+	if (thread) {
+		SDL_WaitThread(thread, NULL);
+		thread = NULL;
+	}
+}
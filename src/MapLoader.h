@@ -0,0 +1,75 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class MapLoader
+ *
+ * Loads the parts of a map that don't need the rendering context on a background thread:
+ * the map file itself (from the compiled map cache or the text files) and the decoded tile sheet images.
+ * The main thread keeps running while this happens. Once isDone() returns true,
+ * MapRenderer::load() is called with the result and only has to create the textures.
+ *
+ * The sprite sheets of the enemies that the map's enemy groups can spawn are decoded as well.
+ *
+ * The loading thread only uses ModManager::locate(), FileParser, CompiledMap, the (read-only) EnemyGroupManager
+ * and RenderDevice::prefetchImage(). Everything else (enemy stats, powers, sounds, textures) is still loaded on
+ * the main thread, since those go through managers that are not safe to use from another thread.
+ */
+
+#ifndef MAP_LOADER_H
+#define MAP_LOADER_H
+
+#include "CommonIncludes.h"
+#include "CompiledMap.h"
+
+class MapLoader {
+public:
+	MapLoader();
+	~MapLoader();
+
+	// loaded_tileset is the tileset of the current map, which doesn't need to be loaded again
+	void start(const std::string& _filename, const std::string& loaded_tileset);
+	bool isRunning() const;
+	bool isDone();
+
+	// waits for the loading thread. The returned map is owned by the MapLoader until the next start()
+	CompiledMap* finish();
+
+	// stops the loading thread as soon as possible and throws away what it loaded
+	void cancel();
+
+	const std::string& getFilename() const;
+
+private:
+	static int threadFunction(void* data);
+	void load();
+	void prefetchEnemyImages();
+	bool isCancelled();
+	void wait();
+
+	std::string filename;
+	std::string skip_tileset;
+	CompiledMap compiled;
+
+	SDL_Thread* thread;
+	SDL_mutex* mutex;
+	bool running;
+	bool done;
+	bool cancelled;
+};
+
+#endif
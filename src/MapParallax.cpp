@@ -162,3 +162,17 @@ void MapParallax::render(const FPoint& cam, const std::string& map_layer) {
 	}
 }
 
+
+/**
+ * Returns true if render() draws anything for this map layer
+ */
+bool MapParallax::hasLayer(const std::string& map_layer) const {
+	if (!settings->parallax_layers)
+		return false;
+
+	for (size_t i = 0; i < layers.size(); ++i) {
+		if (layers[i].map_layer == map_layer)
+			return true;
+	}
+	return false;
+}
@@ -47,6 +47,7 @@ public:
 	void load(const std::string& filename);
 	void setMapCenter(int x, int y);
 	void render(const FPoint& cam, const std::string& map_layer);
+	bool hasLayer(const std::string& map_layer) const;
 
 private:
 	std::vector<MapParallaxLayer> layers;
@@ -41,6 +41,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "NPC.h"
 #include "NPCManager.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "Settings.h"
 #include "SharedGameResources.h"
@@ -63,6 +64,9 @@ MapRenderer::MapRenderer()
 	, show_tooltip(false)
 	, entity_hidden_normal(NULL)
 	, entity_hidden_enemy(NULL)
+	, hidden_entity_max_offset(0)
+	, events_indexed(0)
+	, events_index_valid(false)
 	, cam()
 	, map_change(false)
 	, teleportation(false)
@@ -78,6 +82,7 @@ MapRenderer::MapRenderer()
 	, show_book("")
 	, index_objectlayer(0)
 	, is_spawn_map(false)
+	, tile_cache_enabled(true)
 {
 	// Load entity markers
 	Image *gfx = render_device->loadImage("images/menus/entity_hidden.png", RenderDevice::ERROR_NORMAL);
@@ -182,7 +187,7 @@ void MapRenderer::clearLayers() {
 	index_objectlayer = 0;
 }
 
-int MapRenderer::load(const std::string& fname) {
+int MapRenderer::load(const std::string& fname, CompiledMap* compiled) {
 	// unload sounds
 	snd->reset();
 	while (!sids.empty()) {
@@ -200,20 +205,22 @@ int MapRenderer::load(const std::string& fname) {
 
 	show_tooltip = false;
 	is_spawn_map = (fname == "maps/spawn.txt");
+	events_index_valid = false;
 
-	Map::load(fname);
+	Map::load(fname, compiled);
 
 	loadMusic();
 
 	for (unsigned i = 0; i < layers.size(); ++i) {
 		if (layernames[i] == "collision") {
-			short width = static_cast<short>(layers[i].size());
+			short width = static_cast<short>(layers[i].getWidth());
 			if (width == 0) {
 				Utils::logError("MapRenderer: Map width is 0. Can't set collision layer.");
 				break;
 			}
-			short height = static_cast<short>(layers[i][0].size());
+			short height = static_cast<short>(layers[i].getHeight());
 			collider.setMap(layers[i], width, height);
+			hidden_entity_grid.init(width, height);
 			removeLayer(i);
 		}
 	}
@@ -238,9 +245,9 @@ int MapRenderer::load(const std::string& fname) {
 
 	std::vector<unsigned> corrupted;
 	for (unsigned i = 0; i < layers.size(); ++i) {
-		for (unsigned x = 0; x < layers[i].size(); ++x) {
-			for (unsigned y = 0; y < layers[i][x].size(); ++y) {
-				const unsigned tile_id = layers[i][x][y];
+		for (unsigned y = 0; y < layers[i].getHeight(); ++y) {
+			for (unsigned x = 0; x < layers[i].getWidth(); ++x) {
+				const unsigned tile_id = layers[i].get(x, y);
 				TileSet* tile_set = &tset;
 
 				if (fogofwar == FogOfWar::TYPE_OVERLAY) {
@@ -255,7 +262,7 @@ int MapRenderer::load(const std::string& fname) {
 					if (std::find(corrupted.begin(), corrupted.end(), tile_id) == corrupted.end()) {
 						corrupted.push_back(tile_id);
 					}
-					layers[i][x][y] = 0;
+					layers[i].set(x, y, 0);
 				}
 			}
 		}
@@ -269,6 +276,21 @@ int MapRenderer::load(const std::string& fname) {
 		}
 	}
 
+	// layers with animated tiles are always drawn tile by tile
+	tile_cache.init(w, h, &tset);
+	animated_layers.clear();
+	animated_layers.resize(index_objectlayer, false);
+	for (unsigned i = 0; i < index_objectlayer; ++i) {
+		for (unsigned y = 0; y < layers[i].getHeight() && !animated_layers[i]; ++y) {
+			for (unsigned x = 0; x < layers[i].getWidth(); ++x) {
+				if (tset.isAnimated(layers[i].get(x, y))) {
+					animated_layers[i] = true;
+					break;
+				}
+			}
+		}
+	}
+
 	setMapParallax(parallax_filename);
 
 	render_device->setBackgroundColor(background_color);
@@ -307,9 +329,7 @@ void MapRenderer::logic(bool paused) {
 
 	// handle statblock logic for map powers
 	for (unsigned i=0; i<statblocks.size(); ++i) {
-		for (size_t j=0; j<statblocks[i].powers_ai.size(); ++j) {
-			statblocks[i].powers_ai[j].cooldown.tick();
-		}
+		statblocks[i].powers_ai_cooldowns.tick();
 	}
 
 	// handle event cooldowns
@@ -336,10 +356,6 @@ void MapRenderer::logic(bool paused) {
 	cam.logic();
 }
 
-bool priocompare(const Renderable &r1, const Renderable &r2) {
-	return r1.prio < r2.prio;
-}
-
 /**
  * Sort in the same order as the tiles are drawn
  * Depends upon the map implementation
@@ -364,25 +380,38 @@ void calculatePriosOrtho(std::vector<Renderable> &r) {
 }
 
 void MapRenderer::render(std::vector<Renderable> &r, std::vector<Renderable> &r_dead) {
+	PROFILE_SCOPE(Profiler::SECTION_MAP_RENDER);
+
+	render_device->beginWorldLayer(getTileOrigin());
 
 	map_parallax.render(cam.shake, "");
 
 	if (eset->tileset.orientation == eset->tileset.TILESET_ORTHOGONAL) {
 		calculatePriosOrtho(r);
 		calculatePriosOrtho(r_dead);
-		std::sort(r.begin(), r.end(), priocompare);
-		std::sort(r_dead.begin(), r_dead.end(), priocompare);
+		{
+			PROFILE_SCOPE(Profiler::SECTION_RENDER_SORT);
+			render_sorter.sort(r);
+			render_sorter_dead.sort(r_dead);
+		}
+		updateHiddenEntityGrid(r);
 		renderOrtho(r, r_dead);
 	}
 	else {
 		calculatePriosIso(r);
 		calculatePriosIso(r_dead);
-		std::sort(r.begin(), r.end(), priocompare);
-		std::sort(r_dead.begin(), r_dead.end(), priocompare);
+		{
+			PROFILE_SCOPE(Profiler::SECTION_RENDER_SORT);
+			render_sorter.sort(r);
+			render_sorter_dead.sort(r_dead);
+		}
+		updateHiddenEntityGrid(r);
 		renderIso(r, r_dead);
 	}
 
 	drawHiddenEntityMarkers();
+
+	render_device->endWorldLayer();
 }
 
 void MapRenderer::drawRenderable(std::vector<Renderable>::iterator r_cursor) {
@@ -438,7 +467,7 @@ void MapRenderer::renderIsoLayer(const Map_Layer& layerdata, const TileSet& tile
 			++tiles_width;
 			p.x += eset->tileset.tile_w;
 
-			if (const uint_fast16_t current_tile = layerdata[i][j]) {
+			if (const uint_fast16_t current_tile = layerdata.get(i, j)) {
 				const Tile_Def &tile = tile_set.tiles[current_tile];
 				dest.x = p.x - tile.offset.x;
 				dest.y = p.y - tile.offset.y;
@@ -446,7 +475,7 @@ void MapRenderer::renderIsoLayer(const Map_Layer& layerdata, const TileSet& tile
 				//skip rendering tiles that are underneath fow hidden tiles
 				if (fogofwar == FogOfWar::TYPE_OVERLAY) {
 					if (&layerdata != &layers[fow->dark_layer_id]) {
-						if (layers[fow->dark_layer_id][i][j] == FogOfWar::TILE_HIDDEN) {
+						if (layers[fow->dark_layer_id].get(i, j) == FogOfWar::TILE_HIDDEN) {
 
 							//check tile's corners
 							Point t_l(Utils::screenToMap(dest.x, dest.y, cam.shake.x, cam.shake.y));
@@ -475,10 +504,10 @@ void MapRenderer::renderIsoLayer(const Map_Layer& layerdata, const TileSet& tile
 							if (b_r.y < 0) b_r.y = 0;
 							if (b_r.y >= h) b_r.y = h-1;
 
-							if (layers[fow->dark_layer_id][t_l.x][t_l.y] == FogOfWar::TILE_HIDDEN) {
-								if (layers[fow->dark_layer_id][t_r.x][t_r.y] == FogOfWar::TILE_HIDDEN) {
-									if (layers[fow->dark_layer_id][b_l.x][b_l.y] == FogOfWar::TILE_HIDDEN) {
-										if (layers[fow->dark_layer_id][b_r.x][b_r.y] == FogOfWar::TILE_HIDDEN) {
+							if (layers[fow->dark_layer_id].get(t_l.x, t_l.y) == FogOfWar::TILE_HIDDEN) {
+								if (layers[fow->dark_layer_id].get(t_r.x, t_r.y) == FogOfWar::TILE_HIDDEN) {
+									if (layers[fow->dark_layer_id].get(b_l.x, b_l.y) == FogOfWar::TILE_HIDDEN) {
+										if (layers[fow->dark_layer_id].get(b_r.x, b_r.y) == FogOfWar::TILE_HIDDEN) {
 											continue;
 										}
 									}
@@ -537,7 +566,7 @@ void MapRenderer::renderIsoFrontObjects(std::vector<Renderable> &r) {
 	std::queue<std::vector<Renderable>::iterator> render_behind_NE;
 	std::queue<std::vector<Renderable>::iterator> render_behind_none;
 
-	Map_Layer drawn_tiles(w, std::vector<unsigned short>(h, 0));
+	drawn_tiles.resize(w, h, 0);
 
 	for (uint_fast16_t y = max_tiles_height ; y; --y) {
 		int_fast16_t tiles_width = 0;
@@ -584,8 +613,8 @@ void MapRenderer::renderIsoFrontObjects(std::vector<Renderable> &r) {
 				++r_pre_cursor;
 			}
 
-			if (draw_tile && !drawn_tiles[i][j]) {
-				if (const uint_fast16_t current_tile = current_layer[i][j]) {
+			if (draw_tile && !drawn_tiles.get(i, j)) {
+				if (const uint_fast16_t current_tile = current_layer.get(i, j)) {
 					const Tile_Def &tile = tset.tiles[current_tile];
 					dest.x = p.x - tile.offset.x;
 					dest.y = p.y - tile.offset.y;
@@ -594,7 +623,7 @@ void MapRenderer::renderIsoFrontObjects(std::vector<Renderable> &r) {
 					//skip rendering tiles that are underneath fow hidden tiles
 					if (fogofwar == FogOfWar::TYPE_OVERLAY) {
 						if (&current_layer != &layers[fow->dark_layer_id]) {
-							if (layers[fow->dark_layer_id][i][j] == FogOfWar::TILE_HIDDEN) {
+							if (layers[fow->dark_layer_id].get(i, j) == FogOfWar::TILE_HIDDEN) {
 
 								//check tile's corners
 								Point t_l(Utils::screenToMap(dest.x, dest.y, cam.shake.x, cam.shake.y));
@@ -623,10 +652,10 @@ void MapRenderer::renderIsoFrontObjects(std::vector<Renderable> &r) {
 								if (b_r.y < 0) b_r.y = 0;
 								if (b_r.y >= h) b_r.y = h-1;
 
-								if (layers[fow->dark_layer_id][t_l.x][t_l.y] == FogOfWar::TILE_HIDDEN) {
-									if (layers[fow->dark_layer_id][t_r.x][t_r.y] == FogOfWar::TILE_HIDDEN) {
-										if (layers[fow->dark_layer_id][b_l.x][b_l.y] == FogOfWar::TILE_HIDDEN) {
-											if (layers[fow->dark_layer_id][b_r.x][b_r.y] == FogOfWar::TILE_HIDDEN) {
+								if (layers[fow->dark_layer_id].get(t_l.x, t_l.y) == FogOfWar::TILE_HIDDEN) {
+									if (layers[fow->dark_layer_id].get(t_r.x, t_r.y) == FogOfWar::TILE_HIDDEN) {
+										if (layers[fow->dark_layer_id].get(b_l.x, b_l.y) == FogOfWar::TILE_HIDDEN) {
+											if (layers[fow->dark_layer_id].get(b_r.x, b_r.y) == FogOfWar::TILE_HIDDEN) {
 												continue;
 											}
 										}
@@ -641,7 +670,7 @@ void MapRenderer::renderIsoFrontObjects(std::vector<Renderable> &r) {
 						tile.tile->color_mod = fow->getTileColorMod(i, j);
 					}
 					render_device->render(tile.tile);
-					drawn_tiles[i][j] = 1;
+					drawn_tiles.set(i, j, 1);
 				}
 			}
 
@@ -715,8 +744,8 @@ do_last_NE_tile:
 			}
 
 			// draw the south-west tile
-			if (draw_SW_tile && i-2 >= 0 && j+2 < h && !drawn_tiles[i-2][j+2]) {
-				if (const uint_fast16_t current_tile = current_layer[i-2][j+2]) {
+			if (draw_SW_tile && i-2 >= 0 && j+2 < h && !drawn_tiles.get(i-2, j+2)) {
+				if (const uint_fast16_t current_tile = current_layer.get(i-2, j+2)) {
 					const Tile_Def &tile = tset.tiles[current_tile];
 					dest.x = tile_SW_center.x - tile.offset.x;
 					dest.y = tile_SW_center.y - tile.offset.y;
@@ -726,7 +755,7 @@ do_last_NE_tile:
 						tile.tile->color_mod = fow->getTileColorMod(i, j);
 					}
 					render_device->render(tile.tile);
-					drawn_tiles[i-2][j+2] = 1;
+					drawn_tiles.set(i-2, j+2, 1);
 				}
 			}
 
@@ -736,8 +765,8 @@ do_last_NE_tile:
 			}
 
 			// draw the north-east tile
-			if (draw_NE_tile && !draw_tile && !drawn_tiles[i][j]) {
-				if (const uint_fast16_t current_tile = current_layer[i][j]) {
+			if (draw_NE_tile && !draw_tile && !drawn_tiles.get(i, j)) {
+				if (const uint_fast16_t current_tile = current_layer.get(i, j)) {
 					const Tile_Def &tile = tset.tiles[current_tile];
 					dest.x = tile_NE_center.x - tile.offset.x;
 					dest.y = tile_NE_center.y - tile.offset.y;
@@ -747,7 +776,7 @@ do_last_NE_tile:
 						tile.tile->color_mod = fow->getTileColorMod(i, j);
 					}
 					render_device->render(tile.tile);
-					drawn_tiles[i][j] = 1;
+					drawn_tiles.set(i, j, 1);
 				}
 			}
 
@@ -786,6 +815,7 @@ do_last_NE_tile:
 void MapRenderer::renderIso(std::vector<Renderable> &r, std::vector<Renderable> &r_dead) {
 	size_t index = 0;
 
+	renderCachedLayers(index);
 	while (index < index_objectlayer) {
 		renderIsoLayer(layers[index], tset);
 		map_parallax.render(cam.shake, layernames[index]);
@@ -840,7 +870,7 @@ void MapRenderer::renderOrthoLayer(const Map_Layer& layerdata, const TileSet& ti
 		p = centerTile(p);
 		for (i = starti; i < max_tiles_width; i++) {
 
-			if (const unsigned short current_tile = layerdata[i][j]) {
+			if (const unsigned short current_tile = layerdata.get(i, j)) {
 				const Tile_Def &tile = tile_set.tiles[current_tile];
 				dest.x = p.x - tile.offset.x;
 				dest.y = p.y - tile.offset.y;
@@ -850,7 +880,7 @@ void MapRenderer::renderOrthoLayer(const Map_Layer& layerdata, const TileSet& ti
 				//skip rendering tiles that are underneath fow hidden tiles
 				if (fogofwar == FogOfWar::TYPE_OVERLAY) {
 					if (&layerdata != &layers[fow->dark_layer_id]) {
-						if (layers[fow->dark_layer_id][i][j] == FogOfWar::TILE_HIDDEN) {
+						if (layers[fow->dark_layer_id].get(i, j) == FogOfWar::TILE_HIDDEN) {
 
 							//check tile's corners
 							Point t_l(Utils::screenToMap(dest.x, dest.y, cam.shake.x, cam.shake.y));
@@ -879,10 +909,10 @@ void MapRenderer::renderOrthoLayer(const Map_Layer& layerdata, const TileSet& ti
 							if (b_r.y < 0) b_r.y = 0;
 							if (b_r.y >= h) b_r.y = h-1;
 
-							if (layers[fow->dark_layer_id][t_l.x][t_l.y] == FogOfWar::TILE_HIDDEN) {
-								if (layers[fow->dark_layer_id][t_r.x][t_r.y] == FogOfWar::TILE_HIDDEN) {
-									if (layers[fow->dark_layer_id][b_l.x][b_l.y] == FogOfWar::TILE_HIDDEN) {
-										if (layers[fow->dark_layer_id][b_r.x][b_r.y] == FogOfWar::TILE_HIDDEN) {
+							if (layers[fow->dark_layer_id].get(t_l.x, t_l.y) == FogOfWar::TILE_HIDDEN) {
+								if (layers[fow->dark_layer_id].get(t_r.x, t_r.y) == FogOfWar::TILE_HIDDEN) {
+									if (layers[fow->dark_layer_id].get(b_l.x, b_l.y) == FogOfWar::TILE_HIDDEN) {
+										if (layers[fow->dark_layer_id].get(b_r.x, b_r.y) == FogOfWar::TILE_HIDDEN) {
 											skip_tile_render = true;
 										}
 									}
@@ -938,7 +968,7 @@ void MapRenderer::renderOrthoFrontObjects(std::vector<Renderable> &r) {
 		p = centerTile(p);
 		for (i = starti; i<max_tiles_width; i++) {
 
-			if (const unsigned short current_tile = layers[index_objectlayer][i][j]) {
+			if (const unsigned short current_tile = layers[index_objectlayer].get(i, j)) {
 				const Tile_Def &tile = tset.tiles[current_tile];
 				dest.x = p.x - tile.offset.x;
 				dest.y = p.y - tile.offset.y;
@@ -949,7 +979,7 @@ void MapRenderer::renderOrthoFrontObjects(std::vector<Renderable> &r) {
 				//skip rendering tiles that are underneath fow hidden tiles
 				if (fogofwar == FogOfWar::TYPE_OVERLAY) {
 					if (&layers[index_objectlayer] != &layers[fow->dark_layer_id]) {
-						if (layers[fow->dark_layer_id][i][j] == FogOfWar::TILE_HIDDEN) {
+						if (layers[fow->dark_layer_id].get(i, j) == FogOfWar::TILE_HIDDEN) {
 
 							//check tile's corners
 							Point t_l(Utils::screenToMap(dest.x, dest.y, cam.shake.x, cam.shake.y));
@@ -978,10 +1008,10 @@ void MapRenderer::renderOrthoFrontObjects(std::vector<Renderable> &r) {
 							if (b_r.y < 0) b_r.y = 0;
 							if (b_r.y >= h) b_r.y = h-1;
 
-							if (layers[fow->dark_layer_id][t_l.x][t_l.y] == FogOfWar::TILE_HIDDEN) {
-								if (layers[fow->dark_layer_id][t_r.x][t_r.y] == FogOfWar::TILE_HIDDEN) {
-									if (layers[fow->dark_layer_id][b_l.x][b_l.y] == FogOfWar::TILE_HIDDEN) {
-										if (layers[fow->dark_layer_id][b_r.x][b_r.y] == FogOfWar::TILE_HIDDEN) {
+							if (layers[fow->dark_layer_id].get(t_l.x, t_l.y) == FogOfWar::TILE_HIDDEN) {
+								if (layers[fow->dark_layer_id].get(t_r.x, t_r.y) == FogOfWar::TILE_HIDDEN) {
+									if (layers[fow->dark_layer_id].get(b_l.x, b_l.y) == FogOfWar::TILE_HIDDEN) {
+										if (layers[fow->dark_layer_id].get(b_r.x, b_r.y) == FogOfWar::TILE_HIDDEN) {
 											skip_tile_render = true;
 										}
 									}
@@ -1014,7 +1044,9 @@ void MapRenderer::renderOrthoFrontObjects(std::vector<Renderable> &r) {
 }
 
 void MapRenderer::renderOrtho(std::vector<Renderable> &r, std::vector<Renderable> &r_dead) {
-	unsigned index = 0;
+	size_t index = 0;
+
+	renderCachedLayers(index);
 	while (index < index_objectlayer) {
 		renderOrthoLayer(layers[index], tset);
 		map_parallax.render(cam.shake, layernames[index]);
@@ -1051,6 +1083,64 @@ void MapRenderer::renderOrtho(std::vector<Renderable> &r, std::vector<Renderable
 	drawDevCursor();
 }
 
+/**
+ * The number of layers (starting from the bottom) that can be drawn from the chunk cache.
+ * Layers with animated tiles, fog of war layers and layers that have parallax layers between them can't be combined.
+ * Fog of war tinting changes the color of tiles every time the player moves, so it disables the cache.
+ * Tiles hidden by the fog of war overlay are simply drawn into the chunks, since the overlay covers them anyway.
+ * Chunks hold premultiplied colors, so render devices that can't draw those don't use the cache either.
+ */
+size_t MapRenderer::getCachedLayerCount() {
+	if (!tile_cache_enabled || fogofwar == FogOfWar::TYPE_TINT || !render_device->supportsPremultipliedBlend())
+		return 0;
+
+	size_t count = 0;
+	while (count < index_objectlayer && count < animated_layers.size() && !animated_layers[count]) {
+		if (layernames[count] == "fow_dark" || layernames[count] == "fow_fog")
+			break;
+
+		count++;
+		if (map_parallax.hasLayer(layernames[count-1]))
+			break;
+	}
+	return count;
+}
+
+/**
+ * Screen position of the center of tile (0, 0)
+ * It is taken from the tile under the center of the screen, so that it is rounded the same way as the renderables
+ */
+Point MapRenderer::getTileOrigin() {
+	const Point center_tile(Utils::screenToMap(settings->view_w_half, settings->view_h_half, cam.shake.x, cam.shake.y));
+	const Point tile_pos = TileChunkCache::getTilePos(center_tile.x, center_tile.y);
+
+	Point origin = centerTile(Utils::mapToScreen(float(center_tile.x), float(center_tile.y), cam.shake.x, cam.shake.y));
+	origin.x -= tile_pos.x;
+	origin.y -= tile_pos.y;
+	return origin;
+}
+
+/**
+ * Draws the bottom layers that are covered by the chunk cache and advances index past them
+ */
+void MapRenderer::renderCachedLayers(size_t& index) {
+	const size_t count = getCachedLayerCount();
+
+	tile_cache.render(layers, count, getTileOrigin());
+
+	while (index < count) {
+		map_parallax.render(cam.shake, layernames[index]);
+		index++;
+	}
+}
+
+void MapRenderer::invalidateTileCache(size_t layer, int x, int y) {
+	if (layer < animated_layers.size() && tset.isAnimated(layers[layer].get(x, y)))
+		animated_layers[layer] = true;
+
+	tile_cache.invalidateTile(x, y);
+}
+
 void MapRenderer::executeOnLoadEvents() {
 	// if set from the command-line, execute a given script if this is our first map load
 	if (!settings->load_script.empty() && filename != "maps/spawn.txt") {
@@ -1121,23 +1211,33 @@ void MapRenderer::checkEvents(const FPoint& loc) {
 	maploc.y = int(loc.y);
 	std::vector<Event>::iterator it;
 
+	// only trigger areas around the hero can be entered
+	indexEvents();
+	FPoint top_left(loc.x - event_location_extent.x - 1, loc.y - event_location_extent.y - 1);
+	FPoint bottom_right(loc.x + event_location_extent.x + 1, loc.y + event_location_extent.y + 1);
+	queryEvents(event_location_grid, top_left, bottom_right, event_location_always);
+
 	// loop in reverse because we may erase elements
-	for (it = events.end(); it != events.begin(); ) {
-		--it;
+	for (size_t q = event_query.size(); q > 0; --q) {
+		it = events.begin() + event_query[q-1];
 
 		// skip inactive events
-		if (!EventManager::isActive(*it)) continue;
+		if (!EventManager::isActiveCached(*it)) continue;
 
 		// static events are run every frame without interaction from the player
 		if ((*it).activate_type == Event::ACTIVATE_STATIC) {
-			if (EventManager::executeEvent(*it))
-				it = events.erase(it);
+			if (EventManager::executeEvent(*it)) {
+				events.erase(it);
+				events_index_valid = false;
+			}
 			continue;
 		}
 
 		if ((*it).activate_type == Event::ACTIVATE_ON_CLEAR) {
-			if (enemies_cleared && EventManager::executeEvent(*it))
-				it = events.erase(it);
+			if (enemies_cleared && EventManager::executeEvent(*it)) {
+				events.erase(it);
+				events_index_valid = false;
+			}
 			continue;
 		}
 
@@ -1156,15 +1256,20 @@ void MapRenderer::checkEvents(const FPoint& loc) {
 			else {
 				if ((*it).getComponent(EventComponent::WAS_INSIDE_EVENT_AREA)) {
 					(*it).deleteAllComponents(EventComponent::WAS_INSIDE_EVENT_AREA);
-					if (EventManager::executeEvent(*it))
-						it = events.erase(it);
+					if (EventManager::executeEvent(*it)) {
+						events.erase(it);
+						events_index_valid = false;
+					}
 				}
 			}
 		}
 		else if ((*it).activate_type == Event::ACTIVATE_ON_TRIGGER) {
-			if (inside)
-				if (EventManager::executeEvent(*it))
-					it = events.erase(it);
+			if (inside) {
+				if (EventManager::executeEvent(*it)) {
+					events.erase(it);
+					events_index_valid = false;
+				}
+			}
 		}
 	}
 }
@@ -1185,13 +1290,38 @@ void MapRenderer::checkHotspots() {
 
 	std::vector<Event>::iterator it;
 
+	// get the area of the map where a tile could be drawn under the mouse
+	indexEvents();
+	FPoint corners[4];
+	corners[0] = Utils::screenToMap(inpt->mouse.x - event_tile_bounds.x - event_tile_bounds.w, inpt->mouse.y - event_tile_bounds.y - event_tile_bounds.h, cam.shake.x, cam.shake.y);
+	corners[1] = Utils::screenToMap(inpt->mouse.x - event_tile_bounds.x, inpt->mouse.y - event_tile_bounds.y - event_tile_bounds.h, cam.shake.x, cam.shake.y);
+	corners[2] = Utils::screenToMap(inpt->mouse.x - event_tile_bounds.x - event_tile_bounds.w, inpt->mouse.y - event_tile_bounds.y, cam.shake.x, cam.shake.y);
+	corners[3] = Utils::screenToMap(inpt->mouse.x - event_tile_bounds.x, inpt->mouse.y - event_tile_bounds.y, cam.shake.x, cam.shake.y);
+
+	FPoint top_left = corners[0];
+	FPoint bottom_right = corners[0];
+	for (int i = 1; i < 4; ++i) {
+		top_left.x = std::min(top_left.x, corners[i].x);
+		top_left.y = std::min(top_left.y, corners[i].y);
+		bottom_right.x = std::max(bottom_right.x, corners[i].x);
+		bottom_right.y = std::max(bottom_right.y, corners[i].y);
+	}
+
+	// pad by a tile to cover centerTile() and rounding, and by the size of the largest hotspot
+	top_left.x -= event_hotspot_extent.x + 2;
+	top_left.y -= event_hotspot_extent.y + 2;
+	bottom_right.x += event_hotspot_extent.x + 2;
+	bottom_right.y += event_hotspot_extent.y + 2;
+
+	queryEvents(event_hotspot_grid, top_left, bottom_right, event_hotspot_always);
+
 	// work backwards through events because events can be erased in the loop.
-	// this prevents the iterator from becoming invalid.
-	for (it = events.end(); it != events.begin(); ) {
-		--it;
+	// this prevents the indices from becoming invalid.
+	for (size_t q = event_query.size(); q > 0; --q) {
+		it = events.begin() + event_query[q-1];
 
 		// skip inactive events
-		if (!EventManager::isActive(*it)) continue;
+		if (!EventManager::isActiveCached(*it)) continue;
 
 		// skip events without hotspots
 		if (it->hotspot.h == 0) continue;
@@ -1228,7 +1358,7 @@ void MapRenderer::checkHotspots() {
 						Point p = Utils::mapToScreen(float(x), float(y), cam.shake.x, cam.shake.y);
 						p = centerTile(p);
 
-						if (const short current_tile = layers[index][x][y]) {
+						if (const short current_tile = layers[index].get(x, y)) {
 							// first check if mouse pointer is in rectangle of that tile:
 							const Tile_Def &tile = tset.tiles[current_tile];
 							Rect dest;
@@ -1266,8 +1396,10 @@ void MapRenderer::checkHotspots() {
 						else if (pc->using_main1) return;
 
 						inpt->lock[Input::MAIN1] = true;
-						if (EventManager::executeEvent(*it))
-							it = events.erase(it);
+						if (EventManager::executeEvent(*it)) {
+							events.erase(it);
+							events_index_valid = false;
+						}
 					}
 					return;
 				}
@@ -1284,12 +1416,16 @@ void MapRenderer::checkNearestEvent() {
 	std::vector<Event>::iterator nearest = events.end();
 	float best_distance = std::numeric_limits<float>::max();
 
-	// loop in reverse because we may erase elements
-	for (it = events.end(); it != events.begin(); ) {
-		--it;
+	indexEvents();
+	event_center_grid.queryRadius(pc->stats.pos, eset->misc.interact_range, event_query);
+	addQueryEvents(event_center_always);
+
+	// loop in reverse, so that the first of several events at the same distance is the last one in the list
+	for (size_t q = event_query.size(); q > 0; --q) {
+		it = events.begin() + event_query[q-1];
 
 		// skip inactive events
-		if (!EventManager::isActive(*it)) continue;
+		if (!EventManager::isActiveCached(*it)) continue;
 
 		// skip events without hotspots
 		if (it->hotspot.h == 0) continue;
@@ -1322,10 +1458,111 @@ void MapRenderer::checkNearestEvent() {
 		if (inpt->pressing[Input::ACCEPT] && !inpt->lock[Input::ACCEPT]) {
 			inpt->lock[Input::ACCEPT] = true;
 
-			if(EventManager::executeEvent(*nearest))
+			if(EventManager::executeEvent(*nearest)) {
 				events.erase(nearest);
+				events_index_valid = false;
+			}
+		}
+	}
+}
+
+/**
+ * Rebuild the spatial indices of the events if the list has changed since the last time
+ */
+void MapRenderer::indexEvents() {
+	if (events_index_valid && events_indexed == events.size())
+		return;
+
+	// events with an area larger than this are checked every frame, instead of widening every query
+	const int max_area_size = 16;
+
+	event_location_grid.init(w, h);
+	event_hotspot_grid.init(w, h);
+	event_center_grid.init(w, h);
+	event_location_always.clear();
+	event_hotspot_always.clear();
+	event_center_always.clear();
+	event_location_extent = FPoint(0, 0);
+	event_hotspot_extent = FPoint(0, 0);
+
+	for (size_t i = 0; i < events.size(); ++i) {
+		Event& ev = events[i];
+		const int id = static_cast<int>(i);
+
+		if (ev.activate_type == Event::ACTIVATE_ON_TRIGGER && ev.location.w <= max_area_size && ev.location.h <= max_area_size) {
+			FPoint location_center(static_cast<float>(ev.location.x) + static_cast<float>(ev.location.w)/2, static_cast<float>(ev.location.y) + static_cast<float>(ev.location.h)/2);
+			event_location_grid.add(id, location_center);
+			event_location_extent.x = std::max(event_location_extent.x, static_cast<float>(ev.location.w)/2);
+			event_location_extent.y = std::max(event_location_extent.y, static_cast<float>(ev.location.h)/2);
+		}
+		else if (ev.activate_type == Event::ACTIVATE_ON_TRIGGER || ev.activate_type == Event::ACTIVATE_ON_LEAVE || ev.activate_type == Event::ACTIVATE_STATIC || ev.activate_type == Event::ACTIVATE_ON_CLEAR) {
+			// on_leave events need to be checked after the hero has moved away
+			event_location_always.push_back(id);
+		}
+
+		// the remaining activation types are not handled by checkEvents()
+
+		if (ev.hotspot.h == 0)
+			continue;
+
+		const bool is_npc = (ev.getComponent(EventComponent::NPC_HOTSPOT) != NULL);
+
+		// NPC events are moved every frame without rebuilding the index, so they can't be in the grids
+		if (is_npc)
+			event_center_always.push_back(id);
+		else
+			event_center_grid.add(id, ev.center);
+
+		if (is_npc || ev.hotspot.w > max_area_size || ev.hotspot.h > max_area_size) {
+			// NPC hotspots use the bounds of the NPC sprite instead of map tiles
+			event_hotspot_always.push_back(id);
+		}
+		else {
+			FPoint hotspot_center(static_cast<float>(ev.hotspot.x) + static_cast<float>(ev.hotspot.w)/2, static_cast<float>(ev.hotspot.y) + static_cast<float>(ev.hotspot.h)/2);
+			event_hotspot_grid.add(id, hotspot_center);
+			event_hotspot_extent.x = std::max(event_hotspot_extent.x, static_cast<float>(ev.hotspot.w)/2);
+			event_hotspot_extent.y = std::max(event_hotspot_extent.y, static_cast<float>(ev.hotspot.h)/2);
 		}
 	}
+
+	// the screen area that any tile can cover, relative to the point given by centerTile()
+	int left = 0;
+	int top = 0;
+	int right = 0;
+	int bottom = 0;
+	for (size_t i = 0; i < tset.tiles.size(); ++i) {
+		const Tile_Def &tile = tset.tiles[i];
+		if (!tile.tile)
+			continue;
+
+		left = std::min(left, -tile.offset.x);
+		top = std::min(top, -tile.offset.y);
+		right = std::max(right, tile.tile->getClip().w - tile.offset.x);
+		bottom = std::max(bottom, tile.tile->getClip().h - tile.offset.y);
+	}
+	event_tile_bounds = Rect(left, top, right - left, bottom - top);
+
+	events_indexed = events.size();
+	events_index_valid = true;
+}
+
+/**
+ * Puts the events from the grid that are within the given area, plus the 'always' events, in event_query (sorted by index)
+ */
+void MapRenderer::queryEvents(SpatialGrid& grid, const FPoint& top_left, const FPoint& bottom_right, const std::vector<int>& always) {
+	grid.queryRect(top_left, bottom_right, event_query);
+	addQueryEvents(always);
+}
+
+/**
+ * Adds the 'always' events to the result of a grid query in event_query, keeping it sorted by index
+ */
+void MapRenderer::addQueryEvents(const std::vector<int>& always) {
+	if (!always.empty()) {
+		event_query.insert(event_query.end(), always.begin(), always.end());
+		std::sort(event_query.begin(), event_query.end());
+		event_query.erase(std::unique(event_query.begin(), event_query.end()), event_query.end());
+	}
 }
 
 void MapRenderer::checkTooltip() {
@@ -1358,8 +1595,8 @@ void MapRenderer::activatePower(PowerID power_index, unsigned statblock_index, c
 
 	if (statblock_index < statblocks.size()) {
 		// check power cooldown before activating
-		if (statblocks[statblock_index].powers_ai[0].cooldown.isEnd()) {
-			statblocks[statblock_index].powers_ai[0].cooldown.setDuration(powers->powers[power_index].cooldown);
+		if (statblocks[statblock_index].powers_ai_cooldowns.isEnd(0)) {
+			statblocks[statblock_index].powers_ai_cooldowns.setDuration(0, powers->powers[power_index].cooldown);
 			powers->activate(power_index, &statblocks[statblock_index], target);
 		}
 	}
@@ -1392,7 +1629,7 @@ Point MapRenderer::centerTile(const Point& p) {
 
 void MapRenderer::getTileBounds(const int_fast16_t x, const int_fast16_t y, const Map_Layer& layerdata, Rect& bounds, Point& center) {
 	if (x >= 0 && x < w && y >= 0 && y < h) {
-		if (const uint_fast16_t tile_index = layerdata[x][y]) {
+		if (const uint_fast16_t tile_index = layerdata.get(x, y)) {
 			const Tile_Def &tile = tset.tiles[tile_index];
 			if (!tile.tile)
 				return;
@@ -1540,6 +1777,25 @@ void MapRenderer::drawHiddenEntityMarkers() {
 	hidden_entities.clear();
 }
 
+/**
+ * Bucket the entity renderables by position, so that each tall tile only needs to check the ones that are nearby
+ */
+void MapRenderer::updateHiddenEntityGrid(std::vector<Renderable> &r) {
+	hidden_entity_grid.clear();
+	hidden_entity_max_offset = 0;
+
+	if (!settings->entity_markers)
+		return;
+
+	for (size_t i = 0; i < r.size(); ++i) {
+		if (r[i].type == Renderable::TYPE_NORMAL)
+			continue;
+
+		hidden_entity_grid.add(static_cast<int>(i), r[i].map_pos);
+		hidden_entity_max_offset = std::max(hidden_entity_max_offset, abs(r[i].offset.x));
+	}
+}
+
 void MapRenderer::checkHiddenEntities(const int_fast16_t x, const int_fast16_t y, const Map_Layer& layerdata, std::vector<Renderable> &r) {
 	if (!settings->entity_markers)
 		return;
@@ -1553,21 +1809,47 @@ void MapRenderer::checkHiddenEntities(const int_fast16_t x, const int_fast16_t y
 		return;
 	}
 
+	if (hidden_entity_grid.isEmpty())
+		return;
+
+	// get the area of the map that is covered by the tile, widened by how far a renderable can be offset from its position
+	Rect search_bounds = tile_bounds;
+	search_bounds.x -= hidden_entity_max_offset;
+	search_bounds.w += hidden_entity_max_offset * 2;
+
+	FPoint corners[4];
+	corners[0] = Utils::screenToMap(search_bounds.x, search_bounds.y, cam.shake.x, cam.shake.y);
+	corners[1] = Utils::screenToMap(search_bounds.x + search_bounds.w, search_bounds.y, cam.shake.x, cam.shake.y);
+	corners[2] = Utils::screenToMap(search_bounds.x, search_bounds.y + search_bounds.h, cam.shake.x, cam.shake.y);
+	corners[3] = Utils::screenToMap(search_bounds.x + search_bounds.w, search_bounds.y + search_bounds.h, cam.shake.x, cam.shake.y);
+
+	FPoint top_left = corners[0];
+	FPoint bottom_right = corners[0];
+	for (int i = 1; i < 4; ++i) {
+		top_left.x = std::min(top_left.x, corners[i].x);
+		top_left.y = std::min(top_left.y, corners[i].y);
+		bottom_right.x = std::max(bottom_right.x, corners[i].x);
+		bottom_right.y = std::max(bottom_right.y, corners[i].y);
+	}
+
+	// pad by a tile to cover rounding in Utils::mapToScreen()
+	top_left.x -= 1;
+	top_left.y -= 1;
+	bottom_right.x += 1;
+	bottom_right.y += 1;
+
+	hidden_entity_grid.queryRect(top_left, bottom_right, hidden_entity_query);
+
 	bool hero_is_hidden = false;
 
-	std::vector<Renderable>::iterator it = r.begin();
-	while (it != r.end()) {
-		if (it->type == Renderable::TYPE_NORMAL) {
-			++it;
-			continue;
-		}
+	for (size_t q = 0; q < hidden_entity_query.size(); ++q) {
+		std::vector<Renderable>::iterator it = r.begin() + hidden_entity_query[q];
 
 		const int it_x = static_cast<int>(it->map_pos.x);
 		const int it_y = static_cast<int>(it->map_pos.y);
 		if ((eset->tileset.orientation == eset->tileset.TILESET_ISOMETRIC && (x < it_x || y < it_y)) ||
 		    (eset->tileset.orientation == eset->tileset.TILESET_ORTHOGONAL && y < it_y))
 		{
-			++it;
 			continue;
 		}
 
@@ -1606,8 +1888,6 @@ void MapRenderer::checkHiddenEntities(const int_fast16_t x, const int_fast16_t y
 				hidden_entities.push_back(it);
 			}
 		}
-
-		++it;
 	}
 }
 
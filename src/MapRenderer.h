@@ -33,6 +33,9 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "Map.h"
 #include "MapCollision.h"
 #include "MapParallax.h"
+#include "RenderableSorter.h"
+#include "SpatialGrid.h"
+#include "TileChunkCache.h"
 #include "TileSet.h"
 #include "TooltipData.h"
 #include "Utils.h"
@@ -81,6 +84,7 @@ private:
 
 	void drawHiddenEntityMarkers();
 
+	void updateHiddenEntityGrid(std::vector<Renderable> &r);
 	void checkHiddenEntities(const int_fast16_t x, const int_fast16_t y, const Map_Layer& layerdata, std::vector<Renderable> &r);
 
 	TileSet tset;
@@ -92,6 +96,44 @@ private:
 
 	std::vector<std::vector<Renderable>::iterator> hidden_entities;
 
+	RenderableSorter render_sorter;
+	RenderableSorter render_sorter_dead;
+
+	// non-tile renderables (indices into the sorted list) that could be hidden behind tall tiles
+	SpatialGrid hidden_entity_grid;
+	std::vector<int> hidden_entity_query;
+	int hidden_entity_max_offset;
+
+	// tiles of the object layer that were already drawn this frame (isometric only)
+	Map_Layer drawn_tiles;
+
+	// pre-rendered chunks of the layers below the object layer
+	TileChunkCache tile_cache;
+	std::vector<bool> animated_layers;
+
+	// events bucketed by the center of their area, so only the ones near the hero/mouse need to be checked each frame
+	// indices are into 'events' and the grids are rebuilt whenever events are added or removed
+	SpatialGrid event_location_grid; // ACTIVATE_ON_TRIGGER events, by location
+	SpatialGrid event_hotspot_grid; // events with a tile hotspot, by hotspot
+	SpatialGrid event_center_grid; // events with a fixed hotspot, by center
+	std::vector<int> event_location_always; // events that are checked regardless of the hero position
+	std::vector<int> event_hotspot_always; // events that are checked regardless of the mouse position
+	std::vector<int> event_center_always; // NPC events, which follow their NPC around (see NPC::moveMapEvents())
+	FPoint event_location_extent; // the largest half size of a location in event_location_grid
+	FPoint event_hotspot_extent; // the largest half size of a hotspot in event_hotspot_grid
+	Rect event_tile_bounds; // covers the graphics of every tile, relative to the tile's screen position
+	std::vector<int> event_query;
+	size_t events_indexed;
+	bool events_index_valid;
+
+	void indexEvents();
+	void queryEvents(SpatialGrid& grid, const FPoint& top_left, const FPoint& bottom_right, const std::vector<int>& always);
+	void addQueryEvents(const std::vector<int>& always);
+
+	size_t getCachedLayerCount();
+	Point getTileOrigin();
+	void renderCachedLayers(size_t& index);
+
 public:
 	// functions
 	MapRenderer();
@@ -99,7 +141,7 @@ public:
 
 	MapRenderer(const MapRenderer &copy); // not implemented
 
-	int load(const std::string& filename);
+	int load(const std::string& filename, CompiledMap* compiled = NULL);
 	void logic(bool paused);
 	void render(std::vector<Renderable> &r, std::vector<Renderable> &r_dead);
 
@@ -122,6 +164,9 @@ public:
 
 	void setMapParallax(const std::string& mp_filename);
 
+	// must be called after changing a tile of one of the map layers
+	void invalidateTileCache(size_t layer, int x, int y);
+
 	// cam is where on the map the camera is pointing
 	Camera cam;
 
@@ -178,6 +223,9 @@ public:
 
 	// flag used to prevent rendering when in maps/spawn.txt
 	bool is_spawn_map;
+
+	// when false, every tile is drawn each frame (used to compare against the chunk cache)
+	bool tile_cache_enabled;
 };
 
 
@@ -340,7 +340,7 @@ void MenuActionBar::logic() {
 	}
 
 	// hero has no powers
-	if (pc->power_cast_timers.empty())
+	if (powers->powers.empty())
 		return;
 
 	for (unsigned i = 0; i < slots_count; i++) {
@@ -378,8 +378,8 @@ void MenuActionBar::logic() {
 			}
 
 			//see if the slot should be greyed out
-			slot_enabled[i] = pc->power_cooldown_timers[hotkeys_mod[i]].isEnd()
-							  && pc->power_cast_timers[hotkeys_mod[i]].isEnd()
+			slot_enabled[i] = pc->power_cooldown_timers.isEnd(hotkeys_mod[i])
+							  && pc->power_cast_timers.isEnd(hotkeys_mod[i])
 							  && pc->stats.canUsePower(hotkeys_mod[i], !StatBlock::CAN_USE_PASSIVE)
 							  && (twostep_slot == -1 || static_cast<unsigned>(twostep_slot) == i);
 
@@ -389,11 +389,11 @@ void MenuActionBar::logic() {
 			slot_enabled[i] = true;
 		}
 
-		if (!pc->power_cast_timers[hotkeys_mod[i]].isEnd() && pc->power_cast_timers[hotkeys_mod[i]].getDuration() > 0) {
-			slot_cooldown_size[i] = (eset->resolutions.icon_size * pc->power_cast_timers[hotkeys_mod[i]].getCurrent()) / pc->power_cast_timers[hotkeys_mod[i]].getDuration();
+		if (!pc->power_cast_timers.isEnd(hotkeys_mod[i]) && pc->power_cast_timers.getDuration(hotkeys_mod[i]) > 0) {
+			slot_cooldown_size[i] = (eset->resolutions.icon_size * pc->power_cast_timers.getCurrent(hotkeys_mod[i])) / pc->power_cast_timers.getDuration(hotkeys_mod[i]);
 		}
-		else if (!pc->power_cooldown_timers[hotkeys_mod[i]].isEnd() && pc->power_cooldown_timers[hotkeys_mod[i]].getDuration() > 0) {
-			slot_cooldown_size[i] = (eset->resolutions.icon_size * pc->power_cooldown_timers[hotkeys_mod[i]].getCurrent()) / pc->power_cooldown_timers[hotkeys_mod[i]].getDuration();
+		else if (!pc->power_cooldown_timers.isEnd(hotkeys_mod[i]) && pc->power_cooldown_timers.getDuration(hotkeys_mod[i]) > 0) {
+			slot_cooldown_size[i] = (eset->resolutions.icon_size * pc->power_cooldown_timers.getCurrent(hotkeys_mod[i])) / pc->power_cooldown_timers.getDuration(hotkeys_mod[i]);
 		}
 		else {
 			slot_cooldown_size[i] = (slot_enabled[i] ? 0 : eset->resolutions.icon_size);;
@@ -643,7 +643,7 @@ void MenuActionBar::checkAction(std::vector<ActionData> &action_queue) {
 				continue;
 			}
 
-			slot_fail_cooldown[i] = pc->power_cast_timers[action.power].getDuration();
+			slot_fail_cooldown[i] = pc->power_cast_timers.getDuration(action.power);
 
 			action.instant_item = false;
 			if (power.new_state == Power::STATE_INSTANT) {
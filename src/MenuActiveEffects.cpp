@@ -86,6 +86,8 @@ void MenuActiveEffects::logic() {
 
 	effect_icons.clear();
 
+	const TimerWheel& timers = pc->stats.effects.timers;
+
 	for (size_t i = 0; i < pc->stats.effects.effect_list.size(); ++i) {
 		if (pc->stats.effects.effect_list[i].icon == -1)
 			continue;
@@ -105,13 +107,13 @@ void MenuActiveEffects::logic() {
 				}else if (ed.type == Effect::HEAL){
 					//No special behavior
 				}else{
-					if (ed.timer.getCurrent() < static_cast<unsigned>(effect_icons[most_recent_id].current)){
-						if (ed.timer.getDuration() > 0)
-							effect_icons[most_recent_id].overlay.y = (eset->resolutions.icon_size * ed.timer.getCurrent()) / ed.timer.getDuration();
+					if (timers.getCurrent(ed.timer_id) < static_cast<unsigned>(effect_icons[most_recent_id].current)){
+						if (timers.getDuration(ed.timer_id) > 0)
+							effect_icons[most_recent_id].overlay.y = (eset->resolutions.icon_size * timers.getCurrent(ed.timer_id)) / timers.getDuration(ed.timer_id);
 						else
 							effect_icons[most_recent_id].overlay.y = eset->resolutions.icon_size;
-						effect_icons[most_recent_id].current = ed.timer.getCurrent();
-						effect_icons[most_recent_id].max = ed.timer.getDuration();
+						effect_icons[most_recent_id].current = timers.getCurrent(ed.timer_id);
+						effect_icons[most_recent_id].max = timers.getDuration(ed.timer_id);
 					}
 				}
 
@@ -158,12 +160,12 @@ void MenuActiveEffects::logic() {
 			// current and max are ignored
 		}
 		else {
-			if (ed.timer.getDuration() > 0)
-				ei.overlay.y = (eset->resolutions.icon_size * ed.timer.getCurrent()) / ed.timer.getDuration();
+			if (timers.getDuration(ed.timer_id) > 0)
+				ei.overlay.y = (eset->resolutions.icon_size * timers.getCurrent(ed.timer_id)) / timers.getDuration(ed.timer_id);
 			else
 				ei.overlay.y = eset->resolutions.icon_size;
-			ei.current = ed.timer.getCurrent();
-			ei.max = ed.timer.getDuration();
+			ei.current = timers.getCurrent(ed.timer_id);
+			ei.max = timers.getDuration(ed.timer_id);
 		}
 		ei.overlay.h = eset->resolutions.icon_size - ei.overlay.y;
 
@@ -36,6 +36,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "NPC.h"
 #include "NPCManager.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "Settings.h"
 #include "SharedGameResources.h"
 #include "SharedResources.h"
@@ -251,16 +252,16 @@ void MenuDevConsole::getTileInfo() {
 
 	std::stringstream ss;
 	for (size_t i = 0; i < mapr->layers.size(); ++i) {
-		if (mapr->layers[i][tile.x][tile.y] == 0)
+		if (mapr->layers[i].get(tile.x, tile.y) == 0)
 			continue;
 		ss.str("");
-		ss << "    " << mapr->layernames[i] << "=" << mapr->layers[i][tile.x][tile.y];
+		ss << "    " << mapr->layernames[i] << "=" << mapr->layers[i].get(tile.x, tile.y);
 		log_history->add(ss.str(), WidgetLog::MSG_NORMAL);
 	}
 
 	ss.str("");
-	ss << "    " << "collision=" << mapr->collider.colmap[tile.x][tile.y] << " (";
-	switch(mapr->collider.colmap[tile.x][tile.y]) {
+	ss << "    " << "collision=" << mapr->collider.colmap.get(tile.x, tile.y) << " (";
+	switch(mapr->collider.colmap.get(tile.x, tile.y)) {
 		case MapCollision::BLOCKS_NONE: ss << msg->get("none"); break;
 		case MapCollision::BLOCKS_ALL: ss << msg->get("wall"); break;
 		case MapCollision::BLOCKS_MOVEMENT: ss << msg->get("short wall / pit"); break;
@@ -386,6 +387,9 @@ void MenuDevConsole::execute() {
 		log_history->add("toggle_fps - " + msg->get("turns on/off the display of the FPS counter"), WidgetLog::MSG_UNIQUE);
 		log_history->add("toggle_hud - " + msg->get("turns on/off all of the HUD elements"), WidgetLog::MSG_UNIQUE);
 		log_history->add("toggle_devhud - " + msg->get("turns on/off the developer hud"), WidgetLog::MSG_UNIQUE);
+		log_history->add("toggle_tile_cache - " + msg->get("turns on/off drawing the lower map layers from pre-rendered chunks"), WidgetLog::MSG_UNIQUE);
+		log_history->add("toggle_profiler - " + msg->get("turns on/off the display of the profiler timings"), WidgetLog::MSG_UNIQUE);
+		log_history->add("profiler_trace - " + msg->get("records a number of frames (default 300) and writes them to profiler_trace.json as a Chrome trace"), WidgetLog::MSG_UNIQUE);
 		log_history->add("list_powers - " + msg->get("Prints a list of powers that match a search term. No search term will list all items"), WidgetLog::MSG_UNIQUE);
 		log_history->add("list_maps - " + msg->get("Prints out all the map filenames located in the \"maps/\" directory."), WidgetLog::MSG_UNIQUE);
 		log_history->add("list_status - " + msg->get("Prints out the active campaign statuses that match a search term. No search term will list all active statuses"), WidgetLog::MSG_UNIQUE);
@@ -410,6 +414,29 @@ void MenuDevConsole::execute() {
 		settings->show_fps = !settings->show_fps;
 		log_history->add(msg->get("Toggled the FPS counter"), WidgetLog::MSG_UNIQUE);
 	}
+	else if (args[0] == "toggle_tile_cache") {
+		mapr->tile_cache_enabled = !mapr->tile_cache_enabled;
+		log_history->add(msg->get("Toggled the tile chunk cache"), WidgetLog::MSG_UNIQUE);
+	}
+	else if (args[0] == "toggle_profiler" || args[0] == "profiler_trace") {
+		if (!profiler) {
+			log_history->setNextColor(font->getColor(FontEngine::COLOR_MENU_PENALTY));
+			log_history->add(msg->get("ERROR: The profiler is not enabled in this build"), WidgetLog::MSG_UNIQUE);
+		}
+		else if (args[0] == "toggle_profiler") {
+			profiler->show_overlay = !profiler->show_overlay;
+			log_history->add(msg->get("Toggled the profiler"), WidgetLog::MSG_UNIQUE);
+		}
+		else {
+			int frames = 300;
+			if (args.size() > 1)
+				frames = Parse::toInt(args[1]);
+
+			std::string filename = settings->path_user + "profiler_trace.json";
+			profiler->startTrace(frames, filename);
+			log_history->add(msg->getv("Recording %d frames to '%s'", frames, filename.c_str()), WidgetLog::MSG_UNIQUE);
+		}
+	}
 	else if (args[0] == "list_status") {
 		std::string search_terms;
 		for (size_t i=1; i<args.size(); i++) {
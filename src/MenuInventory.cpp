@@ -734,7 +734,7 @@ void MenuInventory::activate(const Point& position) {
 		}
 
 		// check power & item requirements
-		if (!pc->stats.canUsePower(power_id, !StatBlock::CAN_USE_PASSIVE) || !pc->power_cooldown_timers[power_id].isEnd()) {
+		if (!pc->stats.canUsePower(power_id, !StatBlock::CAN_USE_PASSIVE) || !pc->power_cooldown_timers.isEnd(power_id)) {
 			pc->logMsg(msg->get("You can't use this item right now."), Avatar::MSG_NORMAL);
 			return;
 		}
@@ -1207,6 +1207,7 @@ void MenuInventory::applyItemStats() {
 		pc->stats.item_base_dmg[i].min = pc->stats.item_base_dmg[i].max = 0;
 	}
 	pc->stats.item_base_abs.min = pc->stats.item_base_abs.max = 0;
+	pc->stats.stats_dirty = true;
 
 	// apply stats from all items
 	for (int i=0; i<MAX_EQUIPPED; i++) {
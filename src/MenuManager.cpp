@@ -53,6 +53,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "ModManager.h"
 #include "NPC.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "Settings.h"
 #include "SharedGameResources.h"
@@ -295,6 +296,8 @@ void MenuManager::handleKeyboardNavigation() {
 }
 
 void MenuManager::logic() {
+	PROFILE_SCOPE(Profiler::SECTION_MENU_LOGIC);
+
 	ItemStack stack;
 
 	subtitles->logic(snd->getLastPlayedSID());
@@ -1425,6 +1428,8 @@ void MenuManager::resetDrag() {
 }
 
 void MenuManager::render() {
+	PROFILE_SCOPE(Profiler::SECTION_MENU_RENDER);
+
 	if (!settings->show_hud) {
 		// if the hud is disabled, only show a few necessary menus
 
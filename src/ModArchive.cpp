@@ -0,0 +1,331 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "ModArchive.h"
+#include "Utils.h"
+#include "UtilsFileSystem.h"
+
+#include <climits>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const std::string ModArchive::EXTENSION = ".flaremod";
+
+namespace {
+	const char MAGIC[] = "FLAREMOD";
+	const size_t MAGIC_SIZE = 8;
+	const size_t HEADER_SIZE = MAGIC_SIZE + 8;
+	const size_t MIN_ENTRY_SIZE = 4 + 16; // path length, offset and size
+
+	uint32_t readU32(const char* p) {
+		const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+		return static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) | (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+	}
+
+	uint64_t readU64(const char* p) {
+		return static_cast<uint64_t>(readU32(p)) | (static_cast<uint64_t>(readU32(p + 4)) << 32);
+	}
+
+	void writeU32(std::string& out, uint32_t v) {
+		for (int i = 0; i < 4; ++i) {
+			out += static_cast<char>((v >> (i * 8)) & 0xFF);
+		}
+	}
+
+	void writeU64(std::string& out, uint64_t v) {
+		writeU32(out, static_cast<uint32_t>(v & 0xFFFFFFFF));
+		writeU32(out, static_cast<uint32_t>(v >> 32));
+	}
+
+	void collectFiles(const std::string& dir, const std::string& rel_dir, std::vector<std::string>& files) {
+		std::vector<std::string> file_names;
+		std::vector<std::string> dir_names;
+		Filesystem::getDirContents(dir, file_names, dir_names);
+
+		for (size_t i = 0; i < file_names.size(); ++i) {
+			files.push_back(rel_dir.empty() ? file_names[i] : rel_dir + "/" + file_names[i]);
+		}
+		for (size_t i = 0; i < dir_names.size(); ++i) {
+			collectFiles(dir + "/" + dir_names[i], rel_dir.empty() ? dir_names[i] : rel_dir + "/" + dir_names[i], files);
+		}
+	}
+}
+
+ModArchive::Entry::Entry()
+	: offset(0)
+	, size(0)
+{
+}
+
+ModArchive::ModArchive()
+	: modified_time(0)
+	, data(NULL)
+	, data_size(0)
+	, is_mapped(false)
+{
+}
+
+ModArchive::~ModArchive() {
+	close();
+}
+
+bool ModArchive::open(const std::string& _filename) {
+	close();
+
+	filename = Filesystem::convertSlashes(_filename);
+	uint64_t file_size = 0;
+	if (!Filesystem::getFileInfo(filename, &file_size, &modified_time))
+		return false;
+
+	if (!mapFile()) {
+		// fall back to reading the whole archive into memory
+		std::ifstream infile(filename.c_str(), std::ios::in | std::ios::binary);
+		if (!infile.is_open() || file_size == 0) {
+			Utils::logError("ModArchive: Could not open '%s'.", filename.c_str());
+			return false;
+		}
+		buffer.resize(static_cast<size_t>(file_size));
+		infile.read(&buffer[0], static_cast<std::streamsize>(file_size));
+		if (infile.fail()) {
+			Utils::logError("ModArchive: Could not read '%s'.", filename.c_str());
+			close();
+			return false;
+		}
+		data = &buffer[0];
+		data_size = buffer.size();
+	}
+
+	if (!readIndex()) {
+		Utils::logError("ModArchive: '%s' is not a valid mod archive.", filename.c_str());
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+bool ModArchive::mapFile() {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!mapping)
+		return false;
+
+	// the view keeps the file mapped after the handles are closed
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!view)
+		return false;
+
+	data = static_cast<const char*>(view);
+	data_size = static_cast<size_t>(size.QuadPart);
+#else
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd == -1)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+
+	void* view = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (view == MAP_FAILED)
+		return false;
+
+	data = static_cast<const char*>(view);
+	data_size = static_cast<size_t>(st.st_size);
+#endif
+
+	is_mapped = true;
+	return true;
+}
+
+bool ModArchive::readIndex() {
+	if (data_size < HEADER_SIZE || std::string(data, MAGIC_SIZE) != MAGIC)
+		return false;
+
+	if (readU32(data + MAGIC_SIZE) != VERSION)
+		return false;
+
+	const uint32_t entry_count = readU32(data + MAGIC_SIZE + 4);
+	size_t pos = HEADER_SIZE;
+
+	// don't trust the count with an allocation until it's known to fit in the file
+	if (entry_count > (data_size - HEADER_SIZE) / MIN_ENTRY_SIZE)
+		return false;
+
+	entries.resize(entry_count);
+	for (uint32_t i = 0; i < entry_count; ++i) {
+		if (4 > data_size - pos)
+			return false;
+		const uint32_t path_length = readU32(data + pos);
+		pos += 4;
+
+		if (path_length > data_size - pos || 16 > data_size - pos - path_length)
+			return false;
+		entries[i].path.assign(data + pos, path_length);
+		pos += path_length;
+
+		entries[i].offset = readU64(data + pos);
+		entries[i].size = readU64(data + pos + 8);
+		pos += 16;
+
+		if (entries[i].offset > data_size || entries[i].size > data_size - entries[i].offset)
+			return false;
+	}
+
+	return true;
+}
+
+void ModArchive::close() {
+	if (is_mapped) {
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+#else
+		munmap(const_cast<char*>(data), data_size);
+#endif
+	}
+
+	data = NULL;
+	data_size = 0;
+	is_mapped = false;
+	std::vector<char>().swap(buffer);
+	entries.clear();
+}
+
+const std::string& ModArchive::getFilename() const {
+	return filename;
+}
+
+int64_t ModArchive::getModifiedTime() const {
+	return modified_time;
+}
+
+const std::vector<ModArchive::Entry>& ModArchive::getEntries() const {
+	return entries;
+}
+
+const char* ModArchive::getData(size_t entry) const {
+	return data + entries[entry].offset;
+}
+
+SDL_RWops* ModArchive::openRW(size_t entry) const {
+	// SDL can't open memory blocks larger than this
+	if (entries[entry].size > static_cast<uint64_t>(INT_MAX)) {
+		Utils::logError("ModArchive: '%s' in '%s' is too large to open.", entries[entry].path.c_str(), filename.c_str());
+		return NULL;
+	}
+
+	return SDL_RWFromConstMem(getData(entry), static_cast<int>(entries[entry].size));
+}
+
+/**
+ * Used by the --pack-mod command line option
+ */
+bool ModArchive::pack(const std::string& mod_dir, const std::string& archive_filename) {
+	std::string root = Filesystem::removeTrailingSlash(mod_dir);
+	if (!Filesystem::isDirectory(root)) {
+		Utils::logError("ModArchive: '%s' is not a directory.", root.c_str());
+		return false;
+	}
+
+	std::vector<std::string> files;
+	collectFiles(root, "", files);
+
+	std::vector<uint64_t> sizes(files.size(), 0);
+	size_t index_size = 0;
+	for (size_t i = 0; i < files.size(); ++i) {
+		if (!Filesystem::getFileInfo(root + "/" + files[i], &sizes[i], NULL)) {
+			Utils::logError("ModArchive: Could not read '%s'.", files[i].c_str());
+			return false;
+		}
+		index_size += 4 + files[i].length() + 16;
+	}
+
+	std::string header(MAGIC, MAGIC_SIZE);
+	writeU32(header, VERSION);
+	writeU32(header, static_cast<uint32_t>(files.size()));
+
+	uint64_t offset = HEADER_SIZE + index_size;
+	for (size_t i = 0; i < files.size(); ++i) {
+		writeU32(header, static_cast<uint32_t>(files[i].length()));
+		header += files[i];
+		writeU64(header, offset);
+		writeU64(header, sizes[i]);
+		offset += sizes[i];
+	}
+
+	std::string out_path = Filesystem::convertSlashes(archive_filename);
+	std::string temp_path = out_path + ".tmp";
+
+	FILE* out = fopen(temp_path.c_str(), "wb");
+	if (!out) {
+		Utils::logError("ModArchive: Could not create '%s'.", temp_path.c_str());
+		return false;
+	}
+
+	bool success = (fwrite(header.c_str(), 1, header.size(), out) == header.size());
+
+	std::vector<char> file_data;
+	for (size_t i = 0; i < files.size() && success; ++i) {
+		if (sizes[i] == 0)
+			continue;
+
+		std::ifstream infile(Filesystem::convertSlashes(root + "/" + files[i]).c_str(), std::ios::in | std::ios::binary);
+		file_data.resize(static_cast<size_t>(sizes[i]));
+		infile.read(&file_data[0], static_cast<std::streamsize>(sizes[i]));
+
+		success = !infile.fail() && (fwrite(&file_data[0], 1, file_data.size(), out) == file_data.size());
+		if (!success)
+			Utils::logError("ModArchive: Could not pack '%s'.", files[i].c_str());
+	}
+
+	success = (fclose(out) == 0) && success;
+
+	if (success && Filesystem::fileExists(out_path))
+		success = Filesystem::removeFile(out_path);
+	if (success)
+		success = Filesystem::renameFile(temp_path, out_path);
+
+	if (!success) {
+		Filesystem::removeFile(temp_path);
+		return false;
+	}
+
+	Utils::logInfo("ModArchive: Packed %u file(s) from '%s' into '%s'.", static_cast<unsigned>(files.size()), root.c_str(), out_path.c_str());
+	return true;
+}
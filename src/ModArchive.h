@@ -0,0 +1,86 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class ModArchive
+ *
+ * A mod packed into a single file (mods/<name>.flaremod), as an alternative to a mod directory.
+ * The archive is memory-mapped, so its files can be read in place without opening them one by one.
+ *
+ * File format (all integers are little-endian):
+ * - "FLAREMOD", followed by the format version and the number of files (uint32 each)
+ * - the index. For each file: path length (uint32), path relative to the mod directory using '/' as separator,
+ *   offset of the file data from the start of the archive (uint64) and data size (uint64)
+ * - the uncompressed file data
+ *
+ * Files are stored in the same order as a directory scan finds them, so the mod behaves the same whether it is packed or not.
+ */
+
+#ifndef MOD_ARCHIVE_H
+#define MOD_ARCHIVE_H
+
+#include "CommonIncludes.h"
+
+class ModArchive {
+public:
+	static const std::string EXTENSION;
+	static const uint32_t VERSION = 1;
+
+	class Entry {
+	public:
+		std::string path;
+		uint64_t offset;
+		uint64_t size;
+		Entry();
+	};
+
+	ModArchive();
+	~ModArchive();
+
+	bool open(const std::string& _filename);
+	void close();
+
+	const std::string& getFilename() const;
+	int64_t getModifiedTime() const;
+
+	const std::vector<Entry>& getEntries() const;
+	const char* getData(size_t entry) const;
+
+	// returns a read-only SDL_RWops that reads the file straight from the mapped archive
+	SDL_RWops* openRW(size_t entry) const;
+
+	// writes all files in mod_dir to a new archive
+	static bool pack(const std::string& mod_dir, const std::string& archive_filename);
+
+private:
+	bool mapFile();
+	bool readIndex();
+
+	std::string filename;
+	int64_t modified_time;
+
+	const char* data;
+	size_t data_size;
+	bool is_mapped;
+
+	// used if the archive can't be memory-mapped on this platform
+	std::vector<char> buffer;
+
+	std::vector<Entry> entries;
+};
+
+#endif
@@ -0,0 +1,250 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "ModArchive.h"
+#include "ModIndex.h"
+#include "Settings.h"
+#include "SharedResources.h"
+#include "Utils.h"
+#include "UtilsFileSystem.h"
+#include "UtilsParsing.h"
+
+ModIndex::CachedDir::CachedDir()
+	: modified_time(0)
+{
+}
+
+ModIndex::ArchivedFile::ArchivedFile()
+	: archive(NULL)
+	, entry(0)
+{
+}
+
+ModIndex::ModIndex()
+	: cache_changed(false)
+{
+}
+
+ModIndex::~ModIndex() {
+	for (size_t i = 0; i < archives.size(); ++i) {
+		delete archives[i];
+	}
+}
+
+void ModIndex::build(const std::vector<std::string>& mod_roots) {
+	locations.clear();
+	listings.clear();
+	archived_files.clear();
+	for (size_t i = 0; i < archives.size(); ++i) {
+		delete archives[i];
+	}
+	archives.clear();
+
+	loadCache();
+
+	std::map<std::string, CachedDir> new_cache;
+	for (size_t i = 0; i < mod_roots.size(); ++i) {
+		std::string root = Filesystem::convertSlashes(mod_roots[i]);
+
+		// loose files override the archive of the same mod
+		addArchive(root + ModArchive::EXTENSION);
+		scanDir(root, "", new_cache);
+	}
+
+	// directories that are no longer part of any active mod
+	if (new_cache.size() != cache.size())
+		cache_changed = true;
+
+	cache.swap(new_cache);
+
+	if (cache_changed)
+		saveCache();
+
+	cache.clear();
+}
+
+/**
+ * Add a single file to the index. rel_dir is the directory containing the file, relative to the mod root
+ */
+void ModIndex::addFile(const std::string& full_path, const std::string& rel_path, const std::string& rel_dir) {
+	// later mods take priority
+	locations[rel_path] = full_path;
+	listings[rel_path].push_back(full_path);
+
+	// matches the extension filter used by ModManager::list()
+	if (!rel_dir.empty() && rel_path.length() > 3 && rel_path.substr(rel_path.length() - 3) == "txt")
+		listings[rel_dir].push_back(full_path);
+}
+
+void ModIndex::addArchive(const std::string& archive_path) {
+	if (!Filesystem::fileExists(archive_path))
+		return;
+
+	ModArchive* archive = new ModArchive();
+	if (!archive->open(archive_path)) {
+		delete archive;
+		return;
+	}
+	archives.push_back(archive);
+
+	const std::vector<ModArchive::Entry>& entries = archive->getEntries();
+	for (size_t i = 0; i < entries.size(); ++i) {
+		std::string rel_path = Filesystem::convertSlashes(entries[i].path);
+		std::string full_path = Filesystem::convertSlashes(archive_path + "/" + entries[i].path);
+
+		std::string rel_dir;
+		size_t sep = entries[i].path.rfind('/');
+		if (sep != std::string::npos)
+			rel_dir = Filesystem::convertSlashes(entries[i].path.substr(0, sep));
+
+		addFile(full_path, rel_path, rel_dir);
+
+		ArchivedFile& file = archived_files[full_path];
+		file.archive = archive;
+		file.entry = i;
+	}
+}
+
+/**
+ * Add all files below full_path to the index. rel_path is full_path relative to the mod root
+ */
+void ModIndex::scanDir(const std::string& full_path, const std::string& rel_path, std::map<std::string, CachedDir>& new_cache) {
+	int64_t modified_time;
+	if (!Filesystem::getFileInfo(full_path, NULL, &modified_time))
+		return;
+
+	std::map<std::string, CachedDir>::iterator it = cache.find(full_path);
+	if (it == cache.end() || it->second.modified_time != modified_time) {
+		CachedDir& dir = new_cache[full_path];
+		dir.modified_time = modified_time;
+		Filesystem::getDirContents(full_path, dir.files, dir.dirs);
+		cache_changed = true;
+	}
+	else {
+		new_cache[full_path] = it->second;
+	}
+
+	// std::map elements don't move when the recursive calls below add to new_cache
+	const CachedDir& dir = new_cache[full_path];
+
+	for (size_t i = 0; i < dir.files.size(); ++i) {
+		const std::string& name = dir.files[i];
+		std::string rel_file = rel_path.empty() ? name : Filesystem::convertSlashes(rel_path + "/" + name);
+		addFile(Filesystem::convertSlashes(full_path + "/" + name), rel_file, rel_path);
+	}
+
+	for (size_t i = 0; i < dir.dirs.size(); ++i) {
+		const std::string& name = dir.dirs[i];
+		std::string rel_dir = rel_path.empty() ? name : Filesystem::convertSlashes(rel_path + "/" + name);
+		scanDir(Filesystem::convertSlashes(full_path + "/" + name), rel_dir, new_cache);
+	}
+}
+
+std::string ModIndex::locate(const std::string& filename) const {
+	std::map<std::string, std::string>::const_iterator it = locations.find(filename);
+	if (it != locations.end())
+		return it->second;
+
+	return "";
+}
+
+void ModIndex::list(const std::string& path, std::vector<std::string>& result) const {
+	std::map<std::string, std::vector<std::string> >::const_iterator it = listings.find(path);
+	if (it != listings.end())
+		result.insert(result.end(), it->second.begin(), it->second.end());
+}
+
+bool ModIndex::findArchived(const std::string& full_path, const ModArchive** archive, size_t* entry) const {
+	if (archived_files.empty())
+		return false;
+
+	std::map<std::string, ArchivedFile>::const_iterator it = archived_files.find(full_path);
+	if (it == archived_files.end())
+		return false;
+
+	if (archive) *archive = it->second.archive;
+	if (entry) *entry = it->second.entry;
+	return true;
+}
+
+std::string ModIndex::getCachePath() {
+	return settings->path_user + "cache/mod_index.txt";
+}
+
+/**
+ * Cache file format:
+ * "dir <modified time> <full path>" followed by "f <name>" and "d <name>" for each file/directory in it
+ */
+void ModIndex::loadCache() {
+	cache.clear();
+	cache_changed = false;
+
+	std::ifstream infile(Filesystem::convertSlashes(getCachePath()).c_str(), std::ios::in);
+	if (!infile.is_open()) {
+		cache_changed = true;
+		return;
+	}
+
+	CachedDir* dir = NULL;
+	std::string line;
+
+	while (infile.good()) {
+		line = Parse::getLine(infile);
+
+		if (line.length() < 3 || line[0] == '#')
+			continue;
+
+		if (line.compare(0, 4, "dir ") == 0) {
+			size_t sep = line.find(' ', 4);
+			if (sep == std::string::npos) {
+				dir = NULL;
+				continue;
+			}
+			dir = &cache[line.substr(sep + 1)];
+			std::stringstream time_stream(line.substr(4, sep - 4));
+			time_stream >> dir->modified_time;
+		}
+		else if (dir && line.compare(0, 2, "f ") == 0) {
+			dir->files.push_back(line.substr(2));
+		}
+		else if (dir && line.compare(0, 2, "d ") == 0) {
+			dir->dirs.push_back(line.substr(2));
+		}
+	}
+
+	infile.close();
+}
+
+void ModIndex::saveCache() {
+	std::stringstream ss;
+	ss << "# flare-engine mod index cache. Safe to delete.\n";
+
+	std::map<std::string, CachedDir>::iterator it;
+	for (it = cache.begin(); it != cache.end(); ++it) {
+		ss << "dir " << it->second.modified_time << " " << it->first << "\n";
+		for (size_t i = 0; i < it->second.files.size(); ++i) {
+			ss << "f " << it->second.files[i] << "\n";
+		}
+		for (size_t i = 0; i < it->second.dirs.size(); ++i) {
+			ss << "d " << it->second.dirs[i] << "\n";
+		}
+	}
+
+	Filesystem::createDir(settings->path_user + "cache");
+	if (!Filesystem::writeFileAtomic(getCachePath(), ss.str()))
+		Utils::logError("ModIndex: Unable to write '%s'.", getCachePath().c_str());
+}
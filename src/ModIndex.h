@@ -0,0 +1,93 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class ModIndex
+ *
+ * An index of every file in the active mods, built once when the ModManager is created.
+ * ModManager::locate() and ModManager::list() are answered from this index instead of probing the disk.
+ *
+ * Scanning the mod directories is cached in [PATH_USER]/cache/mod_index.txt.
+ * A cached directory listing is reused as long as the modification time of that directory hasn't changed,
+ * so a warm start only needs to stat each directory once.
+ *
+ * A mod can also be packed into a ModArchive. Files in an archive get a full path below the archive's own path
+ * (e.g. "mods/fantasycore.flaremod/images/foo.png"); use findArchived() to check if a path refers to one of them.
+ * If a mod has both an archive and a directory, files in the directory take priority.
+ */
+
+#ifndef MOD_INDEX_H
+#define MOD_INDEX_H
+
+#include "CommonIncludes.h"
+
+class ModArchive;
+
+class ModIndex {
+public:
+	ModIndex();
+	~ModIndex();
+
+	// mod_roots are the mod directories, ordered from lowest to highest priority
+	void build(const std::vector<std::string>& mod_roots);
+
+	// the full path of the highest priority copy of this file. Empty if no mod has this file
+	std::string locate(const std::string& filename) const;
+
+	// if path is a file: the full paths of all copies of this file
+	// if path is a directory: the full paths of all *txt files directly inside of it
+	// Ordered from lowest to highest priority, like ModManager::list()
+	void list(const std::string& path, std::vector<std::string>& result) const;
+
+	// if full_path is a file inside of an archive, returns the archive and the file's entry index
+	bool findArchived(const std::string& full_path, const ModArchive** archive, size_t* entry) const;
+
+private:
+	class CachedDir {
+	public:
+		int64_t modified_time;
+		std::vector<std::string> files;
+		std::vector<std::string> dirs;
+		CachedDir();
+	};
+
+	class ArchivedFile {
+	public:
+		const ModArchive* archive;
+		size_t entry;
+		ArchivedFile();
+	};
+
+	void addFile(const std::string& full_path, const std::string& rel_path, const std::string& rel_dir);
+	void addArchive(const std::string& archive_path);
+	void scanDir(const std::string& full_path, const std::string& rel_path, std::map<std::string, CachedDir>& new_cache);
+	void loadCache();
+	void saveCache();
+	std::string getCachePath();
+
+	std::map<std::string, std::string> locations;
+	std::map<std::string, std::vector<std::string> > listings;
+
+	std::vector<ModArchive*> archives;
+	std::map<std::string, ArchivedFile> archived_files;
+
+	// directory listings, keyed by the full path of the directory
+	std::map<std::string, CachedDir> cache;
+	bool cache_changed;
+};
+
+#endif
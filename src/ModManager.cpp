@@ -17,6 +17,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 */
 
 #include "CommonIncludes.h"
+#include "ModArchive.h"
 #include "ModManager.h"
 #include "Platform.h"
 #include "Settings.h"
@@ -115,7 +116,8 @@ const std::string ModManager::FALLBACK_MOD = "default";
 const std::string ModManager::FALLBACK_GAME = "default";
 
 ModManager::ModManager(const std::vector<std::string> *_cmd_line_mods)
-	: cmd_line_mods(_cmd_line_mods)
+	: loc_cache_mutex(SDL_CreateMutex())
+	, cmd_line_mods(_cmd_line_mods)
 {
 	loc_cache.clear();
 	mod_dirs.clear();
@@ -126,6 +128,18 @@ ModManager::ModManager(const std::vector<std::string> *_cmd_line_mods)
 	Filesystem::getDirList(settings->path_data + "mods", mod_dirs_other);
 	Filesystem::getDirList(settings->path_user + "mods", mod_dirs_other);
 
+	// packed mods are listed by their name, without the file extension
+	std::vector<std::string> mod_archives;
+	Filesystem::getFileList(settings->path_data + "mods", ModArchive::EXTENSION, mod_archives);
+	Filesystem::getFileList(settings->path_user + "mods", ModArchive::EXTENSION, mod_archives);
+	for (size_t i = 0; i < mod_archives.size(); ++i) {
+		std::string archive_name = mod_archives[i].substr(0, mod_archives[i].length() - ModArchive::EXTENSION.length());
+		size_t sep = archive_name.find_last_of("/\\");
+		if (sep != std::string::npos)
+			archive_name = archive_name.substr(sep + 1);
+		mod_dirs_other.push_back(archive_name);
+	}
+
 	for (unsigned i=0; i<mod_dirs_other.size(); ++i) {
 		if (find(mod_dirs.begin(), mod_dirs.end(), mod_dirs_other[i]) == mod_dirs.end())
 			mod_dirs.push_back(mod_dirs_other[i]);
@@ -133,6 +147,7 @@ ModManager::ModManager(const std::vector<std::string> *_cmd_line_mods)
 
 	loadModList();
 	applyDepends();
+	buildIndex();
 
 	std::string active_mods_str = "Active mods: ";
 	for (size_t i = 0; i < mod_list.size(); ++i) {
@@ -234,60 +249,152 @@ void ModManager::loadModList() {
 	}
 }
 
+/**
+ * Build the index of all files in the active mods
+ * Mods are passed from lowest to highest priority, the same order that list() returns files in
+ */
+void ModManager::buildIndex() {
+	std::vector<std::string> mod_roots;
+
+	for (size_t i = 0; i < mod_list.size(); ++i) {
+		for (size_t j = mod_paths.size(); j > 0; j--) {
+			mod_roots.push_back(mod_paths[j-1] + "mods/" + mod_list[i].name);
+		}
+	}
+
+	index.build(mod_roots);
+}
+
 /**
  * Find the location (mod file name) for this data file.
- * Use private loc_cache to prevent excessive disk I/O
+ * Files in mods are looked up in the index. Files outside of mods are cached in loc_cache
  */
 std::string ModManager::locate(const std::string& _filename) {
 	std::string filename = Filesystem::convertSlashes(_filename);
 
+	std::string path = index.locate(filename);
+	if (!path.empty())
+		return path;
+
+	SDL_LockMutex(loc_cache_mutex);
+
 	// if we have this location already cached, return it
-	if (loc_cache.find(filename) != loc_cache.end()) {
-		return loc_cache[filename];
+	std::map<std::string, std::string>::iterator it = loc_cache.find(filename);
+	if (it != loc_cache.end()) {
+		path = it->second;
+		SDL_UnlockMutex(loc_cache_mutex);
+		return path;
 	}
 
-	// search through mods for the first instance of this filename
-	std::string test_path;
+	// all else failing, simply return the filename if it exists
+	path = Filesystem::convertSlashes(settings->path_data + filename);
+	if (!Filesystem::fileExists(path))
+		path = "";
 
-	for (size_t i = mod_list.size(); i > 0; i--) {
-		for (size_t j = 0; j < mod_paths.size(); j++) {
-			test_path = Filesystem::convertSlashes(mod_paths[j] + "mods/" + mod_list[i-1].name + "/" + filename);
-			if (Filesystem::fileExists(test_path)) {
-				loc_cache[filename] = test_path;
-				return test_path;
-			}
-		}
+	loc_cache[filename] = path;
+
+	SDL_UnlockMutex(loc_cache_mutex);
+	return path;
+}
+
+/**
+ * Open a file that was returned by locate() or list()
+ * Files in mod archives are read straight from the mapped archive
+ */
+SDL_RWops* ModManager::openRW(const std::string& path) {
+	const ModArchive* archive;
+	size_t entry;
+	if (index.findArchived(path, &archive, &entry))
+		return archive->openRW(entry);
+
+	return SDL_RWFromFile(path.c_str(), "rb");
+}
+
+/**
+ * Read the complete contents of a file that was returned by locate() or list()
+ */
+bool ModManager::readFile(const std::string& path, std::string& data) {
+	const ModArchive* archive;
+	size_t entry;
+	if (index.findArchived(path, &archive, &entry)) {
+		data.assign(archive->getData(entry), static_cast<size_t>(archive->getEntries()[entry].size));
+		return true;
 	}
 
-	// all else failing, simply return the filename if it exists
-	test_path = Filesystem::convertSlashes(settings->path_data + filename);
-	if (!Filesystem::fileExists(test_path))
-		test_path = "";
+	std::ifstream infile(path.c_str(), std::ios::in | std::ios::binary);
+	if (!infile.is_open())
+		return false;
+
+	infile.seekg(0, std::ios::end);
+	std::streamoff length = infile.tellg();
+	infile.seekg(0, std::ios::beg);
+	if (length < 0)
+		return false;
 
-	return test_path;
+	data.resize(static_cast<size_t>(length));
+	if (length > 0)
+		infile.read(&data[0], length);
+
+	return !infile.fail();
 }
 
-void amendPathToVector(const std::string &path, std::vector<std::string> &vec) {
-	if (Filesystem::pathExists(path)) {
-		if (Filesystem::isDirectory(path)) {
-			Filesystem::getFileList(path, "txt", vec);
-		}
-		else {
-			vec.push_back(path);
+bool ModManager::getArchivedFile(const std::string& path, const char** data, size_t* size) {
+	const ModArchive* archive;
+	size_t entry;
+	if (!index.findArchived(path, &archive, &entry))
+		return false;
+
+	*data = archive->getData(entry);
+	*size = static_cast<size_t>(archive->getEntries()[entry].size);
+	return true;
+}
+
+/**
+ * Like Filesystem::getFileInfo(), but also works for files in mod archives
+ */
+bool ModManager::getFileInfo(const std::string& path, uint64_t *size, int64_t *modified_time) {
+	const ModArchive* archive;
+	size_t entry;
+	if (index.findArchived(path, &archive, &entry)) {
+		if (size) *size = archive->getEntries()[entry].size;
+		if (modified_time) *modified_time = archive->getModifiedTime();
+		return true;
+	}
+
+	return Filesystem::getFileInfo(path, size, modified_time);
+}
+
+/**
+ * Read a file directly from a mod, which is either a directory or an archive
+ * Used before the index is built
+ */
+bool ModManager::readModFile(const std::string& mod_root, const std::string& filename, std::string& data) {
+	if (readFile(Filesystem::convertSlashes(mod_root + "/" + filename), data))
+		return true;
+
+	std::string archive_path = mod_root + ModArchive::EXTENSION;
+	if (!Filesystem::fileExists(archive_path))
+		return false;
+
+	ModArchive archive;
+	if (!archive.open(archive_path))
+		return false;
+
+	const std::vector<ModArchive::Entry>& entries = archive.getEntries();
+	for (size_t i = 0; i < entries.size(); ++i) {
+		if (entries[i].path == filename) {
+			data.assign(archive.getData(i), static_cast<size_t>(entries[i].size));
+			return true;
 		}
 	}
+
+	return false;
 }
 
 std::vector<std::string> ModManager::list(const std::string &path, bool full_paths) {
 	std::vector<std::string> ret;
-	std::string test_path;
 
-	for (size_t i = 0; i < mod_list.size(); ++i) {
-		for (size_t j = mod_paths.size(); j > 0; j--) {
-			test_path = Filesystem::convertSlashes(mod_paths[j-1] + "mods/" + mod_list[i].name + "/" + path);
-			amendPathToVector(test_path, ret);
-		}
-	}
+	index.list(Filesystem::convertSlashes(path), ret);
 
 	// we don't need to check for duplicates if there are no paths
 	if (ret.empty()) return ret;
@@ -328,15 +435,18 @@ void ModManager::setPaths() {
 
 Mod ModManager::loadMod(const std::string& name) {
 	Mod mod;
-	std::ifstream infile;
+	std::stringstream infile;
 	std::string starts_with, line, key, val;
 
 	mod.name = name;
 
 	// @CLASS ModManager|Description of mod settings.txt
 	for (unsigned i=0; i<mod_paths.size(); ++i) {
-		std::string path = Filesystem::convertSlashes(mod_paths[i] + "mods/" + name + "/settings.txt");
-		infile.open(path.c_str(), std::ios::in);
+		std::string data;
+		if (!readModFile(mod_paths[i] + "mods/" + name, "settings.txt", data))
+			continue;
+		infile.clear();
+		infile.str(data);
 
 		while (infile.good()) {
 			line = Parse::getLine(infile);
@@ -411,14 +521,8 @@ Mod ModManager::loadMod(const std::string& name) {
 			}
 		}
 		if (infile.good()) {
-			infile.close();
-			infile.clear();
 			break;
 		}
-		else {
-			infile.close();
-			infile.clear();
-		}
 	}
 
 	// ensure that engine min version <= engine max version
@@ -559,4 +663,5 @@ void ModManager::resetModConfig() {
 }
 
 ModManager::~ModManager() {
+	SDL_DestroyMutex(loc_cache_mutex);
 }
@@ -27,6 +27,7 @@ mods in priority order when loading data files.
 #define MOD_MANAGER_H
 
 #include "CommonIncludes.h"
+#include "ModIndex.h"
 
 class Version;
 
@@ -58,7 +59,12 @@ private:
 	void loadModList();
 	void setPaths();
 
+	void buildIndex();
+	bool readModFile(const std::string& mod_root, const std::string& filename, std::string& data);
+
+	ModIndex index;
 	std::map<std::string,std::string> loc_cache;
+	SDL_mutex* loc_cache_mutex; // locate() is also called by the map loading thread
 	std::vector<std::string> mod_paths;
 
 	const std::vector<std::string> *cmd_line_mods;
@@ -90,6 +96,13 @@ public:
 	// that can be passed to locate() later
 	std::vector<std::string> list(const std::string& path, bool full_paths);
 
+	// Access to files returned by locate() and list(), which may be stored in a mod archive
+	SDL_RWops* openRW(const std::string& path);
+	bool readFile(const std::string& path, std::string& data);
+	// the data of files in a mod archive can be accessed without copying it. It stays valid as long as this ModManager exists
+	bool getArchivedFile(const std::string& path, const char** data, size_t* size);
+	bool getFileInfo(const std::string& path, uint64_t *size, int64_t *modified_time);
+
 	std::vector<std::string> mod_dirs;
 	std::vector<Mod> mod_list;
 };
@@ -650,6 +650,7 @@ bool NPC::processDialog(unsigned int dialog_node, unsigned int &event_cursor) {
 							entitym->entities.erase(entitym->entities.begin() + i - 1);
 					}
 				}
+				entitym->invalidateSpatialGrid();
 			}
 		}
 		else if (dialog[dialog_node][event_cursor].type == EventComponent::NONE) {
@@ -0,0 +1,206 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include <SDL_image.h>
+
+#include "CursorManager.h"
+#include "IconManager.h"
+#include "ModManager.h"
+#include "NullRenderDevice.h"
+#include "SDLFontEngine.h"
+#include "Settings.h"
+#include "SharedResources.h"
+
+NullImage::NullImage(RenderDevice *_device, int _width, int _height)
+	: Image(_device)
+	, width(_width)
+	, height(_height) {
+}
+
+NullImage::~NullImage() {
+}
+
+int NullImage::getWidth() const {
+	return width;
+}
+
+int NullImage::getHeight() const {
+	return height;
+}
+
+void NullImage::fillWithColor(const Color& color) {
+	if (color.r) {} // suppress unused parameter warning
+}
+
+void NullImage::drawPixel(int x, int y, const Color& color) {
+	if (x || y || color.r) {} // suppress unused parameter warnings
+}
+
+void NullImage::drawLine(int x0, int y0, int x1, int y1, const Color& color) {
+	if (x0 || y0 || x1 || y1 || color.r) {} // suppress unused parameter warnings
+}
+
+Image* NullImage::resize(int _width, int _height) {
+	if (_width <= 0 || _height <= 0)
+		return NULL;
+
+	return new NullImage(device, _width, _height);
+}
+
+NullRenderDevice::NullRenderDevice()
+	: RenderDevice() {
+	Utils::logInfo("RenderDevice: Using NullRenderDevice (nothing will be drawn)");
+
+	// nothing is drawn, but the map renderer should take the same path as with the other devices
+	premultiplied_blend = true;
+}
+
+int NullRenderDevice::createContextInternal() {
+	if (!is_initialized) {
+		windowResize();
+		is_initialized = true;
+
+		// load persistent resources
+		delete icons;
+		icons = new IconManager();
+		delete curs;
+		curs = new CursorManager();
+	}
+
+	return 0;
+}
+
+void NullRenderDevice::createContextError() {
+	Utils::logError("NullRenderDevice: createContext() failed");
+}
+
+int NullRenderDevice::render(Renderable& r, Rect& dest) {
+	if (r.image || dest.x) {} // suppress unused parameter warnings
+	return 0;
+}
+
+int NullRenderDevice::render(Sprite *r) {
+	if (r) {} // suppress unused parameter warning
+	return 0;
+}
+
+int NullRenderDevice::renderToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest) {
+	if (!src_image || !dest_image || src.x || dest.x) {} // suppress unused parameter warnings
+	return 0;
+}
+
+Image* NullRenderDevice::renderTextToImage(FontStyle* font_style, const std::string& text, const Color& color, bool blended) {
+	if (color.r || blended) {} // suppress unused parameter warnings
+
+	// the text is measured, but never drawn
+	int w = 0;
+	int h = 0;
+	if (TTF_SizeUTF8(static_cast<SDLFontStyle *>(font_style)->ttfont, text.c_str(), &w, &h) != 0)
+		return NULL;
+
+	return new NullImage(this, w, h);
+}
+
+void NullRenderDevice::drawPixel(int x, int y, const Color& color) {
+	if (x || y || color.r) {} // suppress unused parameter warnings
+}
+
+void NullRenderDevice::drawLine(int x0, int y0, int x1, int y1, const Color& color) {
+	if (x0 || y0 || x1 || y1 || color.r) {} // suppress unused parameter warnings
+}
+
+void NullRenderDevice::drawRectangle(const Point& p0, const Point& p1, const Color& color) {
+	if (p0.x || p1.x || color.r) {} // suppress unused parameter warnings
+}
+
+void NullRenderDevice::blankScreen() {
+}
+
+void NullRenderDevice::commitFrame() {
+}
+
+void NullRenderDevice::destroyContext() {
+	RenderDevice::cacheRemoveAll();
+	reload_graphics = true;
+	resetRenderTargets();
+
+	if (icons) {
+		delete icons;
+		icons = NULL;
+	}
+	if (curs) {
+		delete curs;
+		curs = NULL;
+	}
+
+	is_initialized = false;
+}
+
+void NullRenderDevice::windowResize() {
+	windowResizeInternal();
+}
+
+Image *NullRenderDevice::createImage(int width, int height) {
+	if (width <= 0 || height <= 0)
+		return NULL;
+
+	return new NullImage(this, width, height);
+}
+
+void NullRenderDevice::setGamma(float g) {
+	if (g) {} // suppress unused parameter warning
+}
+
+void NullRenderDevice::resetGamma() {
+}
+
+void NullRenderDevice::updateTitleBar() {
+}
+
+Image *NullRenderDevice::loadImage(const std::string& filename, int error_type) {
+	// lookup image in cache
+	Image *img;
+	img = cacheLookup(filename);
+	if (img != NULL) return img;
+
+	// the pixel data isn't needed, but the image still has to be decoded to get its size
+	SDL_Surface *surface = IMG_Load_RW(mods->openRW(mods->locate(filename)), 1);
+	if (!surface) {
+		if (error_type != ERROR_NONE)
+			Utils::logError("NullRenderDevice: Couldn't load image: '%s'. %s", filename.c_str(), IMG_GetError());
+
+		if (error_type == ERROR_EXIT) {
+			mods->resetModConfig();
+			Utils::Exit(1);
+		}
+
+		return NULL;
+	}
+
+	NullImage *image = new NullImage(this, surface->w, surface->h);
+	SDL_FreeSurface(surface);
+
+	// store image to cache
+	cacheStore(filename, image);
+	return image;
+}
+
+void NullRenderDevice::getWindowSize(short unsigned *screen_w, short unsigned *screen_h) {
+	// there's no window, so just use the configured size
+	*screen_w = settings->screen_w;
+	*screen_h = settings->screen_h;
+}
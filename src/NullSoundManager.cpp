@@ -0,0 +1,84 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "NullSoundManager.h"
+
+NullSoundManager::NullSoundManager() {
+}
+
+NullSoundManager::~NullSoundManager() {
+}
+
+SoundID NullSoundManager::load(const std::string& filename, const std::string& errormessage) {
+	if (filename.empty() || errormessage.empty()) {} // suppress unused parameter warnings
+
+	// SoundID 0 is treated as "no sound" by callers
+	return 0;
+}
+
+void NullSoundManager::unload(SoundID) {
+}
+
+void NullSoundManager::play(SoundID, const std::string& channel, const FPoint& pos, bool loop, bool cleanup) {
+	if (channel.empty() || pos.x || loop || cleanup) {} // suppress unused parameter warnings
+}
+
+void NullSoundManager::pauseChannel(const std::string& channel) {
+	if (channel.empty()) {} // suppress unused parameter warning
+}
+
+void NullSoundManager::pauseAll() {
+}
+
+void NullSoundManager::resumeAll() {
+}
+
+void NullSoundManager::setVolumeSFX(int value) {
+	if (value) {} // suppress unused parameter warning
+}
+
+void NullSoundManager::loadMusic(const std::string& filename) {
+	if (filename.empty()) {} // suppress unused parameter warning
+}
+
+void NullSoundManager::unloadMusic() {
+}
+
+void NullSoundManager::playMusic() {
+}
+
+void NullSoundManager::stopMusic() {
+}
+
+void NullSoundManager::setVolumeMusic(int value) {
+	if (value) {} // suppress unused parameter warning
+}
+
+bool NullSoundManager::isPlayingMusic() {
+	return false;
+}
+
+void NullSoundManager::logic(const FPoint& center) {
+	if (center.x) {} // suppress unused parameter warning
+}
+
+void NullSoundManager::reset() {
+}
+
+SoundID NullSoundManager::getLastPlayedSID() {
+	return 0;
+}
@@ -0,0 +1,55 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class NullSoundManager
+ *
+ * A SoundManager that never plays anything. Used when running the game logic without an audio device, such as in flare-bench.
+ */
+
+#ifndef NULL_SOUND_MANAGER_H
+#define NULL_SOUND_MANAGER_H
+
+#include "SoundManager.h"
+
+class NullSoundManager : public SoundManager {
+public:
+	NullSoundManager();
+	~NullSoundManager();
+
+	SoundID load(const std::string& filename, const std::string& errormessage);
+	void unload(SoundID);
+	void play(SoundID, const std::string& channel, const FPoint& pos, bool loop, bool cleanup = true);
+	void pauseChannel(const std::string& channel);
+	void pauseAll();
+	void resumeAll();
+	void setVolumeSFX(int value);
+
+	void loadMusic(const std::string& filename);
+	void unloadMusic();
+	void playMusic();
+	void stopMusic();
+	void setVolumeMusic(int value);
+	bool isPlayingMusic();
+
+	void logic(const FPoint& center);
+	void reset();
+
+	SoundID getLastPlayedSID();
+};
+
+#endif
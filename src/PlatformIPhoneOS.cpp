@@ -43,6 +43,7 @@ int PlatformIPhoneOS::isExitEvent(void* userdata, SDL_Event* event) {
 	if (event->type == SDL_APP_TERMINATING) {
 		Utils::logInfo("Terminating app, saving...");
 		save_load->saveGame();
+		save_load->flushSaves();
 		Utils::logInfo("Saved, ready to exit.");
 		return 0;
 	}
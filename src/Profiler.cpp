@@ -0,0 +1,216 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "Profiler.h"
+#include "SharedResources.h"
+#include "Utils.h"
+
+#include <stdio.h>
+
+Profiler::Section::Section()
+	: ticks(0)
+	, max_ticks(0)
+	, calls(0)
+{
+}
+
+Profiler::Frame::Frame() {
+	for (int i = 0; i < SECTION_COUNT; ++i) {
+		ticks[i] = 0;
+	}
+}
+
+Profiler::TraceEvent::TraceEvent(int _section, uint64_t _start, uint64_t _end)
+	: section(_section)
+	, start(_start)
+	, end(_end)
+{
+}
+
+Profiler::Profiler()
+	: enabled(true)
+	, show_overlay(false)
+	, ticks_per_second(SDL_GetPerformanceFrequency())
+	, frames(FRAME_HISTORY)
+	, frame_index(0)
+	, frame_count(0)
+	, trace_frames_left(0)
+	, trace_start(0)
+{
+}
+
+Profiler::~Profiler() {
+	// don't lose a trace that was still being recorded
+	if (isTracing())
+		writeTrace();
+}
+
+void Profiler::reset() {
+	for (int i = 0; i < SECTION_COUNT; ++i) {
+		sections[i] = Section();
+	}
+
+	frames.assign(FRAME_HISTORY, Frame());
+	frame_index = 0;
+	frame_count = 0;
+	frame_current = Frame();
+}
+
+void Profiler::addSample(int section, uint64_t start, uint64_t end) {
+	if (section < 0 || section >= SECTION_COUNT)
+		return;
+
+	const uint64_t ticks = end - start;
+
+	Section& s = sections[section];
+	s.ticks += ticks;
+	s.calls++;
+	if (ticks > s.max_ticks)
+		s.max_ticks = ticks;
+
+	frame_current.ticks[section] += ticks;
+
+	if (trace_frames_left > 0 && trace_events.size() < TRACE_MAX_EVENTS)
+		trace_events.push_back(TraceEvent(section, start, end));
+}
+
+/**
+ * Called once per rendered frame to move the current frame totals into the history
+ */
+void Profiler::endFrame() {
+	frames[frame_index] = frame_current;
+	frame_index = (frame_index + 1) % FRAME_HISTORY;
+	if (frame_count < FRAME_HISTORY)
+		frame_count++;
+
+	frame_current = Frame();
+
+	if (trace_frames_left > 0) {
+		trace_frames_left--;
+		if (trace_frames_left == 0)
+			writeTrace();
+	}
+}
+
+const Profiler::Section& Profiler::getSection(int section) const {
+	return sections[section];
+}
+
+float Profiler::getMilliseconds(uint64_t ticks) const {
+	if (ticks_per_second == 0)
+		return 0;
+
+	return static_cast<float>(static_cast<double>(ticks) * 1000.0 / static_cast<double>(ticks_per_second));
+}
+
+/**
+ * Section names are used as keys when writing reports
+ */
+std::string Profiler::getSectionName(int section) {
+	if (section == SECTION_LOGIC) return "logic";
+	else if (section == SECTION_ENTITY_AI) return "entity_ai";
+	else if (section == SECTION_HAZARDS) return "hazards";
+	else if (section == SECTION_PATHFINDING) return "pathfinding";
+	else if (section == SECTION_EFFECTS) return "effects";
+	else if (section == SECTION_MAP_EVENTS) return "map_events";
+	else if (section == SECTION_FRAME_LOGIC) return "frame_logic";
+	else if (section == SECTION_MENU_LOGIC) return "menu_logic";
+	else if (section == SECTION_MAP_RENDER) return "map_render";
+	else if (section == SECTION_RENDER_SORT) return "render_sort";
+	else if (section == SECTION_MENU_RENDER) return "menu_render";
+	else if (section == SECTION_COMMIT_FRAME) return "commit_frame";
+
+	return "";
+}
+
+float Profiler::getFrameAverage(int section) const {
+	if (frame_count == 0)
+		return 0;
+
+	uint64_t total = 0;
+	for (size_t i = 0; i < frame_count; ++i) {
+		total += frames[i].ticks[section];
+	}
+	return getMilliseconds(total) / static_cast<float>(frame_count);
+}
+
+float Profiler::getFrameMax(int section) const {
+	uint64_t max_ticks = 0;
+	for (size_t i = 0; i < frame_count; ++i) {
+		if (frames[i].ticks[section] > max_ticks)
+			max_ticks = frames[i].ticks[section];
+	}
+	return getMilliseconds(max_ticks);
+}
+
+/**
+ * Record every profiled section for the next 'frames' frames. The trace is written to 'filename' afterwards.
+ */
+void Profiler::startTrace(int _frames, const std::string& filename) {
+	trace_events.clear();
+	trace_frames_left = std::max(_frames, 1);
+	trace_start = SDL_GetPerformanceCounter();
+	trace_filename = filename;
+}
+
+bool Profiler::isTracing() const {
+	return trace_frames_left > 0;
+}
+
+/**
+ * Write recorded events in the Chrome trace event format
+ */
+void Profiler::writeTrace() {
+	trace_frames_left = 0;
+
+	FILE *out = fopen(trace_filename.c_str(), "w");
+	if (!out) {
+		Utils::logError("Profiler: Could not open '%s' for writing.", trace_filename.c_str());
+		trace_events.clear();
+		return;
+	}
+
+	fprintf(out, "{\"traceEvents\":[\n");
+	for (size_t i = 0; i < trace_events.size(); ++i) {
+		const TraceEvent& e = trace_events[i];
+
+		// timestamps are in microseconds
+		const double ts = static_cast<double>(e.start - trace_start) * 1000000.0 / static_cast<double>(ticks_per_second);
+		const double dur = static_cast<double>(e.end - e.start) * 1000000.0 / static_cast<double>(ticks_per_second);
+
+		fprintf(out, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}%s\n",
+			getSectionName(e.section).c_str(), ts, dur, (i + 1 < trace_events.size() ? "," : ""));
+	}
+	fprintf(out, "],\"displayTimeUnit\":\"ms\"}\n");
+	fclose(out);
+
+	Utils::logInfo("Profiler: Wrote %u trace events to '%s'.", static_cast<unsigned>(trace_events.size()), trace_filename.c_str());
+	trace_events.clear();
+}
+
+ProfilerScope::ProfilerScope(int _section)
+	: section(_section)
+	, start(0)
+{
+	if (profiler && profiler->enabled)
+		start = SDL_GetPerformanceCounter();
+}
+
+ProfilerScope::~ProfilerScope() {
+	if (start != 0 && profiler && profiler->enabled)
+		profiler->addSample(section, start, SDL_GetPerformanceCounter());
+}
@@ -0,0 +1,134 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class Profiler
+ *
+ * Accumulates the time spent in the major engine subsystems.
+ * Code sections are timed by placing PROFILE_SCOPE() at the start of the block.
+ *
+ * Instrumentation is compiled out unless FLARE_PROFILER is defined (cmake -DPROFILER=ON).
+ * The last FRAME_HISTORY frames are kept for the in-game overlay, and a number of frames
+ * can be recorded as a Chrome trace (load the file in chrome://tracing or Perfetto).
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "CommonIncludes.h"
+
+#ifdef FLARE_PROFILER
+#define PROFILE_SCOPE_CONCAT2(a, b) a##b
+#define PROFILE_SCOPE_CONCAT(a, b) PROFILE_SCOPE_CONCAT2(a, b)
+#define PROFILE_SCOPE(section) ProfilerScope PROFILE_SCOPE_CONCAT(profile_scope_, __LINE__)(section)
+#else
+#define PROFILE_SCOPE(section)
+#endif
+
+class Profiler {
+public:
+	enum {
+		SECTION_LOGIC = 0,
+		SECTION_ENTITY_AI = 1,
+		SECTION_HAZARDS = 2,
+		SECTION_PATHFINDING = 3,
+		SECTION_EFFECTS = 4,
+		SECTION_MAP_EVENTS = 5,
+		SECTION_FRAME_LOGIC = 6,
+		SECTION_MENU_LOGIC = 7,
+		SECTION_MAP_RENDER = 8,
+		SECTION_RENDER_SORT = 9,
+		SECTION_MENU_RENDER = 10,
+		SECTION_COMMIT_FRAME = 11,
+		SECTION_COUNT = 12
+	};
+
+	static const size_t FRAME_HISTORY = 120;
+	static const size_t TRACE_MAX_EVENTS = 500000;
+
+	class Section {
+	public:
+		uint64_t ticks;
+		uint64_t max_ticks;
+		uint64_t calls;
+		Section();
+	};
+
+	Profiler();
+	~Profiler();
+
+	void reset();
+	void addSample(int section, uint64_t start, uint64_t end);
+	void endFrame();
+
+	const Section& getSection(int section) const;
+	float getMilliseconds(uint64_t ticks) const;
+	static std::string getSectionName(int section);
+
+	// average and worst time (in ms) per frame over the frame history
+	float getFrameAverage(int section) const;
+	float getFrameMax(int section) const;
+
+	void startTrace(int frames, const std::string& filename);
+	bool isTracing() const;
+
+	bool enabled;
+	bool show_overlay;
+
+private:
+	class Frame {
+	public:
+		uint64_t ticks[SECTION_COUNT];
+		Frame();
+	};
+
+	class TraceEvent {
+	public:
+		int section;
+		uint64_t start;
+		uint64_t end;
+		TraceEvent(int _section, uint64_t _start, uint64_t _end);
+	};
+
+	void writeTrace();
+
+	Section sections[SECTION_COUNT];
+	uint64_t ticks_per_second;
+
+	// ring buffer of per-frame totals, frame_current is being filled in
+	std::vector<Frame> frames;
+	size_t frame_index;
+	size_t frame_count;
+	Frame frame_current;
+
+	std::vector<TraceEvent> trace_events;
+	int trace_frames_left;
+	uint64_t trace_start;
+	std::string trace_filename;
+};
+
+class ProfilerScope {
+public:
+	explicit ProfilerScope(int _section);
+	~ProfilerScope();
+
+private:
+	int section;
+	uint64_t start;
+};
+
+#endif
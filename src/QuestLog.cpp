@@ -42,6 +42,7 @@ QuestLog::QuestLog(MenuLog *_log) {
 	log = _log;
 
 	newQuestNotification = false;
+	checked_revision = 0;
 	loadAll();
 }
 
@@ -57,6 +58,8 @@ void QuestLog::loadAll() {
 	std::sort(files.begin(), files.end());
 	for (unsigned int i = 0; i < files.size(); i++)
 		load(files[i]);
+
+	createDependencies();
 }
 
 /**
@@ -68,7 +71,7 @@ void QuestLog::loadAll() {
 void QuestLog::load(const std::string& filename) {
 	FileParser infile;
 	// @CLASS QuestLog|Description of quest files in quests/
-	if (!infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+	if (!infile.openCompiled(filename, FileParser::ERROR_NORMAL))
 		return;
 
 	quests.resize(quests.size()+1);
@@ -161,30 +164,148 @@ void QuestLog::load(const std::string& filename) {
 }
 
 void QuestLog::logic() {
-	createQuestList();
+	// nothing that quests depend on has changed
+	if (camp->getRevision() == checked_revision)
+		return;
+
+	std::vector<StatusID> changed_statuses;
+	if (section_active.size() != quest_sections.size() || !camp->getChangedStatuses(checked_revision, changed_statuses)) {
+		createQuestList();
+		return;
+	}
+
+	bool changed = false;
+
+	// only check the quests that depend on something that has changed
+	for (size_t i = 0; i < changed_statuses.size(); ++i) {
+		std::map<StatusID, std::vector<size_t> >::iterator it = status_sections.find(changed_statuses[i]);
+		if (it != status_sections.end()) {
+			for (size_t j = 0; j < it->second.size(); ++j) {
+				if (checkSection(it->second[j]))
+					changed = true;
+			}
+		}
+
+		it = status_quests.find(changed_statuses[i]);
+		if (it != status_quests.end()) {
+			for (size_t j = 0; j < it->second.size(); ++j) {
+				if (checkQuestComplete(it->second[j]))
+					changed = true;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < change_sections.size(); ++i) {
+		if (camp->getChangeRevision(static_cast<int>(i)) <= checked_revision)
+			continue;
+
+		for (size_t j = 0; j < change_sections[i].size(); ++j) {
+			if (checkSection(change_sections[i][j]))
+				changed = true;
+		}
+	}
+
+	checked_revision = camp->getRevision();
+
+	if (changed)
+		updateQuestList();
+}
+
+/**
+ * Index the quest sections by the statuses and other hero state that their requirements look at
+ */
+void QuestLog::createDependencies() {
+	status_sections.clear();
+	status_quests.clear();
+	change_sections.clear();
+	change_sections.resize(CampaignManager::CHANGE_COUNT);
+
+	for (size_t i = 0; i < quest_sections.size(); ++i) {
+		for (size_t j = 0; j < quest_sections[i].size(); ++j) {
+			const EventComponent& ec = quest_sections[i][j];
+			int change_type = CampaignManager::getRequirementChangeType(ec.type);
+
+			if (change_type == CampaignManager::CHANGE_STATUS) {
+				std::vector<size_t>& deps = status_sections[ec.status];
+				if (deps.empty() || deps.back() != i)
+					deps.push_back(i);
+			}
+			else if (change_type != -1) {
+				std::vector<size_t>& deps = change_sections[change_type];
+				if (deps.empty() || deps.back() != i)
+					deps.push_back(i);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < quests.size(); ++i) {
+		if (!quests[i].name.empty() && quests[i].complete_status != 0)
+			status_quests[quests[i].complete_status].push_back(i);
+	}
+}
+
+/**
+ * Returns true if the section's active state has changed
+ */
+bool QuestLog::checkSection(size_t index) {
+	bool active = camp->checkRequirementsInVector(quest_sections[index]);
+	if (active == section_active[index])
+		return false;
+
+	section_active[index] = active;
+	return true;
+}
+
+/**
+ * Returns true if the quest's completion state has changed
+ */
+bool QuestLog::checkQuestComplete(size_t index) {
+	bool complete = camp->checkStatus(quests[index].complete_status);
+	if (complete == quest_complete[index])
+		return false;
+
+	quest_complete[index] = complete;
+	return true;
 }
 
 /**
  * All active quests are placed in the Quest tab of the Log Menu
  */
 void QuestLog::createQuestList() {
-	std::vector<size_t> temp_quest_ids;
-	std::vector<size_t> temp_complete_quest_ids;
+	section_active.resize(quest_sections.size(), false);
+	quest_complete.resize(quests.size(), false);
 
 	// check quest requirements
 	for (size_t i=0; i<quest_sections.size(); i++) {
-		if (camp->checkRequirementsInVector(quest_sections[i])) {
-			// passed requirement checks, add ID to active quest list
-			temp_quest_ids.push_back(i);
-		}
+		checkSection(i);
 	}
 
 	// check quest completion status
 	for (size_t i=0; i<quests.size(); ++i) {
 		if (!quests[i].name.empty() && quests[i].complete_status != 0) {
-			if (camp->checkStatus(quests[i].complete_status)) {
-				temp_complete_quest_ids.push_back(i);
-			}
+			checkQuestComplete(i);
+		}
+	}
+
+	checked_revision = camp->getRevision();
+
+	updateQuestList();
+}
+
+void QuestLog::updateQuestList() {
+	std::vector<size_t> temp_quest_ids;
+	std::vector<size_t> temp_complete_quest_ids;
+
+	for (size_t i=0; i<section_active.size(); i++) {
+		if (section_active[i]) {
+			// passed requirement checks, add ID to active quest list
+			temp_quest_ids.push_back(i);
+		}
+	}
+
+	for (size_t i=0; i<quest_complete.size(); ++i) {
+		if (quest_complete[i]) {
+			temp_complete_quest_ids.push_back(i);
 		}
 	}
 
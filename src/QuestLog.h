@@ -48,6 +48,22 @@ private:
 	std::vector<size_t> complete_quest_ids;
 	std::vector<Quest> quests;
 
+	// results of the last requirement checks
+	std::vector<bool> section_active;
+	std::vector<bool> quest_complete;
+
+	// which quest sections/quests need to be checked again when something changes
+	std::map<StatusID, std::vector<size_t> > status_sections;
+	std::map<StatusID, std::vector<size_t> > status_quests;
+	std::vector< std::vector<size_t> > change_sections; // indexed by CampaignManager::CHANGE_*
+
+	unsigned long checked_revision;
+
+	void createDependencies();
+	bool checkSection(size_t index);
+	bool checkQuestComplete(size_t index);
+	void updateQuestList();
+
 public:
 	explicit QuestLog(MenuLog *_log);
 	~QuestLog();
@@ -85,6 +85,7 @@ Sprite::Sprite(Image *_image)
 	: local_frame(Rect())
 	, color_mod(255, 255, 255)
 	, alpha_mod(255)
+	, blend_mode(Renderable::BLEND_NORMAL)
 	, image(_image)
 	, src(Rect())
 	, offset()
@@ -171,11 +172,16 @@ RenderDevice::RenderDevice()
 	, destructive_fullscreen(false)
 	, is_initialized(false)
 	, reload_graphics(false)
+	, premultiplied_blend(false)
+	, target_generation(0)
 	, ddpi(0)
+	, prefetch_mutex(SDL_CreateMutex())
 {
 }
 
 RenderDevice::~RenderDevice() {
+	clearPrefetchedImages();
+	SDL_DestroyMutex(prefetch_mutex);
 }
 
 int RenderDevice::createContext() {
@@ -225,6 +231,53 @@ void RenderDevice::destroyContext() {
 	assert(cache.empty());
 }
 
+/**
+ * Render devices that can decode images without the rendering context override this
+ */
+void RenderDevice::prefetchImage(const std::string& filename) {
+	(void)filename;
+}
+
+void RenderDevice::clearPrefetchedImages() {
+	SDL_LockMutex(prefetch_mutex);
+	std::map<std::string, SDL_Surface*>::iterator it;
+	for (it = prefetched_images.begin(); it != prefetched_images.end(); ++it) {
+		SDL_FreeSurface(it->second);
+	}
+	prefetched_images.clear();
+	SDL_UnlockMutex(prefetch_mutex);
+}
+
+void RenderDevice::storePrefetchedImage(const std::string& filename, SDL_Surface* surface) {
+	SDL_LockMutex(prefetch_mutex);
+	std::map<std::string, SDL_Surface*>::iterator it = prefetched_images.find(filename);
+	if (it != prefetched_images.end()) {
+		SDL_FreeSurface(it->second);
+		it->second = surface;
+	}
+	else {
+		prefetched_images[filename] = surface;
+	}
+	SDL_UnlockMutex(prefetch_mutex);
+}
+
+/**
+ * Returns the decoded image and hands its ownership to the caller, or NULL if it wasn't prefetched
+ */
+SDL_Surface* RenderDevice::takePrefetchedImage(const std::string& filename) {
+	SDL_Surface* surface = NULL;
+
+	SDL_LockMutex(prefetch_mutex);
+	std::map<std::string, SDL_Surface*>::iterator it = prefetched_images.find(filename);
+	if (it != prefetched_images.end()) {
+		surface = it->second;
+		prefetched_images.erase(it);
+	}
+	SDL_UnlockMutex(prefetch_mutex);
+
+	return surface;
+}
+
 Image * RenderDevice::cacheLookup(const std::string &filename) {
 	IMAGE_CACHE_CONTAINER_ITER it;
 	it = cache.find(filename);
@@ -316,6 +369,18 @@ bool RenderDevice::reloadGraphics() {
 	return false;
 }
 
+bool RenderDevice::supportsPremultipliedBlend() const {
+	return premultiplied_blend;
+}
+
+unsigned RenderDevice::getTargetGeneration() const {
+	return target_generation;
+}
+
+void RenderDevice::resetRenderTargets() {
+	target_generation++;
+}
+
 void RenderDevice::freeImage(Image *image) {
 	if (!image) return;
 
@@ -323,6 +388,8 @@ void RenderDevice::freeImage(Image *image) {
 }
 
 void RenderDevice::windowResizeInternal() {
+	resetRenderTargets();
+
 	unsigned short old_view_w = settings->view_w;
 	unsigned short old_view_h = settings->view_h;
 	unsigned short old_screen_w = settings->screen_w;
@@ -380,6 +447,13 @@ void RenderDevice::setBackgroundColor(Color color) {
 	Utils::logError("RenderDevice: Renderer does not support setting background color!");
 }
 
+void RenderDevice::beginWorldLayer(const Point& origin) {
+	(void)origin;
+}
+
+void RenderDevice::endWorldLayer() {
+}
+
 void RenderDevice::setFullscreen(bool enable_fullscreen) {
 	Utils::logInfo("RenderDevice: Trying to set fullscreen=%d, without recreating the rendering context, but setFullscreen() is not implemented for this renderer.", enable_fullscreen);
 }
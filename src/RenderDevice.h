@@ -55,6 +55,7 @@ public:
 	Rect local_frame;
 	Color color_mod;
 	uint8_t alpha_mod;
+	uint8_t blend_mode; // one of Renderable::BLEND_*
 
 	Image * getGraphics();
 	void setOffset(const Point& _offset);
@@ -126,6 +127,7 @@ private:
 	virtual ~Image();
 	friend class SDLSoftwareImage;
 	friend class SDLHardwareImage;
+	friend class NullImage;
 
 private:
 	RenderDevice *device;
@@ -136,7 +138,8 @@ class Renderable {
 public:
 	enum {
 		BLEND_NORMAL = 0,
-		BLEND_ADD = 1
+		BLEND_ADD = 1,
+		BLEND_PREMULTIPLIED = 2 // the color of the image is already multiplied by its alpha
 	};
 
 	enum {
@@ -217,6 +220,13 @@ public:
 	virtual Image *createImage(int width, int height) = 0;
 	void freeImage(Image *image);
 
+	/**
+	 * Decodes an image file ahead of time, so that a later loadImage() only has to create the texture.
+	 * This is safe to call from a loading thread. Images that are never loaded are freed by clearPrefetchedImages().
+	 */
+	virtual void prefetchImage(const std::string& filename);
+	void clearPrefetchedImages();
+
 	/** Screen operations */
 	virtual int render(Sprite* r) = 0;
 	virtual int render(Renderable& r, Rect& dest) = 0;
@@ -231,11 +241,31 @@ public:
 	void drawEllipse(int x0, int y0, int x1, int y1, const Color& color, float step);
 	virtual void windowResize() = 0;
 	virtual void setBackgroundColor(Color color);
+
+	/**
+	 * Marks the draws between these calls as part of the scrolling map, where origin is the screen position of the map origin.
+	 * Devices that reuse the previous frame use this to tell a camera scroll apart from changed content.
+	 */
+	virtual void beginWorldLayer(const Point& origin);
+	virtual void endWorldLayer();
+
 	virtual void setFullscreen(bool enable_fullscreen);
 	virtual unsigned short getRefreshRate();
 
 	bool reloadGraphics();
 
+	/**
+	 * True if the device can draw images with Renderable::BLEND_PREMULTIPLIED.
+	 */
+	bool supportsPremultipliedBlend() const;
+
+	/**
+	 * Changes whenever images created with createImage() may have lost what was drawn on them,
+	 * such as after a window resize or when the graphics driver reset its render targets.
+	 */
+	unsigned getTargetGeneration() const;
+	void resetRenderTargets();
+
 protected:
 	/* Compute clipping and global position from local frame. */
 	bool localToGlobal(Sprite *r);
@@ -247,6 +277,10 @@ protected:
 	void cacheRemoveAll();
 	void windowResizeInternal();
 
+	/* Prefetched image operations, guarded by prefetch_mutex */
+	void storePrefetchedImage(const std::string& filename, SDL_Surface* surface);
+	SDL_Surface* takePrefetchedImage(const std::string& filename);
+
 	/** Context operations */
 	virtual int createContextInternal() = 0;
 	virtual void createContextError() = 0;
@@ -261,6 +295,8 @@ protected:
 
 	bool is_initialized;
 	bool reload_graphics;
+	bool premultiplied_blend;
+	unsigned target_generation;
 
 	float ddpi;
 
@@ -273,6 +309,9 @@ private:
 
 	IMAGE_CACHE_CONTAINER cache;
 
+	std::map<std::string, SDL_Surface*> prefetched_images;
+	SDL_mutex* prefetch_mutex;
+
 	virtual void getWindowSize(short unsigned *screen_w, short unsigned *screen_h) = 0;
 };
 
@@ -0,0 +1,152 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "RenderableSorter.h"
+
+#include <limits>
+
+RenderableSorter::SortKey::SortKey()
+	: prio(0)
+	, index(0)
+{
+}
+
+RenderableSorter::SortKey::SortKey(uint64_t _prio, unsigned _index)
+	: prio(_prio)
+	, index(_index)
+{
+}
+
+RenderableSorter::RenderableSorter() {
+}
+
+RenderableSorter::~RenderableSorter() {
+}
+
+void RenderableSorter::sort(std::vector<Renderable>& r) {
+	const size_t n = r.size();
+	if (n < 2) {
+		order.clear();
+		return;
+	}
+
+	keys.resize(n);
+
+	// start from last frame's order if the list has the same size
+	bool sorted = false;
+	if (order.size() == n) {
+		for (size_t i = 0; i < n; ++i) {
+			keys[i] = SortKey(r[order[i]].prio, order[i]);
+		}
+		sorted = insertionSort(n * MAX_MOVES_PER_ITEM);
+	}
+
+	if (!sorted) {
+		for (size_t i = 0; i < n; ++i) {
+			keys[i] = SortKey(r[i].prio, static_cast<unsigned>(i));
+		}
+
+		if (n <= INSERTION_SORT_SIZE)
+			insertionSort(std::numeric_limits<size_t>::max());
+		else
+			radixSort();
+	}
+
+	order.resize(n);
+	buffer.clear();
+	buffer.reserve(n);
+	for (size_t i = 0; i < n; ++i) {
+		order[i] = keys[i].index;
+		buffer.push_back(r[keys[i].index]);
+	}
+
+	// the old list becomes the buffer for the next frame
+	r.swap(buffer);
+}
+
+/**
+ * Returns false if the keys could not be sorted within max_moves
+ */
+bool RenderableSorter::insertionSort(size_t max_moves) {
+	size_t moves = 0;
+
+	for (size_t i = 1; i < keys.size(); ++i) {
+		if (keys[i-1].prio <= keys[i].prio)
+			continue;
+
+		const SortKey key = keys[i];
+		size_t j = i;
+		while (j > 0 && keys[j-1].prio > key.prio) {
+			keys[j] = keys[j-1];
+			--j;
+		}
+		keys[j] = key;
+
+		moves += i - j;
+		if (moves > max_moves)
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * LSD radix sort on 8 bit digits. Digits that are the same for every key are skipped,
+ * which usually leaves 5 or 6 passes, because map positions don't use the upper bits.
+ */
+void RenderableSorter::radixSort() {
+	static const int DIGITS = 8;
+	static const int BUCKETS = 256;
+
+	const size_t n = keys.size();
+	keys_swap.resize(n);
+
+	size_t counts[DIGITS][BUCKETS];
+	for (int d = 0; d < DIGITS; ++d) {
+		for (int b = 0; b < BUCKETS; ++b) {
+			counts[d][b] = 0;
+		}
+	}
+
+	for (size_t i = 0; i < n; ++i) {
+		uint64_t prio = keys[i].prio;
+		for (int d = 0; d < DIGITS; ++d) {
+			counts[d][prio & 0xff]++;
+			prio >>= 8;
+		}
+	}
+
+	for (int d = 0; d < DIGITS; ++d) {
+		const int shift = d * 8;
+
+		// every key has the same digit here, so this pass wouldn't change anything
+		if (counts[d][(keys[0].prio >> shift) & 0xff] == n)
+			continue;
+
+		size_t offset = 0;
+		for (int b = 0; b < BUCKETS; ++b) {
+			const size_t count = counts[d][b];
+			counts[d][b] = offset;
+			offset += count;
+		}
+
+		for (size_t i = 0; i < n; ++i) {
+			keys_swap[counts[d][(keys[i].prio >> shift) & 0xff]++] = keys[i];
+		}
+		keys.swap(keys_swap);
+	}
+}
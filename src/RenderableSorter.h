@@ -0,0 +1,65 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class RenderableSorter
+ *
+ * Sorts a list of Renderables by Renderable::prio, keeping the order of equal priorities stable.
+ *
+ * The lists are rebuilt every frame in roughly the same order, and most objects barely move between frames.
+ * So the order of the previous frame is tried first, and only needs a few insertion sort steps to be fixed.
+ * When that fails (objects were added or removed, or too much has changed), the keys are radix sorted.
+ * The sorter keeps its working memory between frames, so sorting doesn't allocate once the lists stop growing.
+ */
+
+#ifndef RENDERABLE_SORTER_H
+#define RENDERABLE_SORTER_H
+
+#include "CommonIncludes.h"
+#include "RenderDevice.h"
+
+class RenderableSorter {
+public:
+	// lists this short are always insertion sorted
+	static const size_t INSERTION_SORT_SIZE = 32;
+	// the previous order is discarded after this many insertion sort moves per renderable
+	static const size_t MAX_MOVES_PER_ITEM = 4;
+
+	RenderableSorter();
+	~RenderableSorter();
+
+	void sort(std::vector<Renderable>& r);
+
+private:
+	class SortKey {
+	public:
+		uint64_t prio;
+		unsigned index;
+		SortKey();
+		SortKey(uint64_t _prio, unsigned _index);
+	};
+
+	bool insertionSort(size_t max_moves);
+	void radixSort();
+
+	std::vector<SortKey> keys;
+	std::vector<SortKey> keys_swap;
+	std::vector<unsigned> order; // indices of the last sorted list, in sorted order
+	std::vector<Renderable> buffer;
+};
+
+#endif
@@ -42,37 +42,80 @@ SDLHardwareImage::SDLHardwareImage(RenderDevice *_device, SDL_Renderer *_rendere
 	: Image(_device)
 	, renderer(_renderer)
 	, surface(NULL)
+	, atlas_page(-1)
+	, atlas_generation(0)
+	, atlas_rect()
 	, pixel_batch_surface(NULL)
 	, pixel_batch_type(PIXEL_BATCH_NONE) {
 }
 
 SDLHardwareImage::~SDLHardwareImage() {
-	if (surface)
-		SDL_DestroyTexture(surface);
+	if (atlas_page != -1)
+		getDevice()->releaseAtlasImage(atlas_page, atlas_generation);
+	else if (surface)
+		getDevice()->destroyTexture(surface);
 	if (pixel_batch_surface)
 		SDL_FreeSurface(pixel_batch_surface);
 }
 
+SDLHardwareRenderDevice* SDLHardwareImage::getDevice() const {
+	return static_cast<SDLHardwareRenderDevice *>(device);
+}
+
 int SDLHardwareImage::getWidth() const {
+	if (atlas_page != -1)
+		return atlas_rect.w;
+
 	int w, h;
 	SDL_QueryTexture(surface, NULL, NULL, &w, &h);
 	return (surface ? w : 0);
 }
 
 int SDLHardwareImage::getHeight() const {
+	if (atlas_page != -1)
+		return atlas_rect.h;
+
 	int w, h;
 	SDL_QueryTexture(surface, NULL, NULL, &w, &h);
 	return (surface ? h : 0);
 }
 
+/**
+ * Atlas pages are static textures, which can't be drawn onto. An image that is going to be changed
+ * is moved to a render target texture of its own first.
+ */
+void SDLHardwareImage::detachFromAtlas() {
+	if (atlas_page == -1 || !surface)
+		return;
+
+	SDL_Texture *detached = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, atlas_rect.w, atlas_rect.h);
+	if (!detached) {
+		Utils::logError("SDLHardwareImage: SDL_CreateTexture failed: %s", SDL_GetError());
+		return;
+	}
+
+	SDL_Rect src = atlas_rect;
+	getDevice()->setRenderTarget(detached);
+	getDevice()->setTextureBlendMode(surface, SDL_BLENDMODE_NONE);
+	getDevice()->setTextureMods(surface, Color(255, 255, 255, 255), 255);
+	SDL_RenderCopy(renderer, surface, &src, NULL);
+	getDevice()->setRenderTarget(NULL);
+
+	getDevice()->releaseAtlasImage(atlas_page, atlas_generation);
+	surface = detached;
+	atlas_page = -1;
+	atlas_rect = Rect();
+}
+
 void SDLHardwareImage::fillWithColor(const Color& color) {
+	detachFromAtlas();
 	if (!surface) return;
 
-	SDL_SetRenderTarget(renderer, surface);
-	SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
+	getDevice()->setRenderTarget(surface);
+	getDevice()->setTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
 	SDL_SetRenderDrawColor(renderer, color.r, color.g , color.b, color.a);
 	SDL_RenderClear(renderer);
-	SDL_SetRenderTarget(renderer, NULL);
+	getDevice()->setRenderTarget(NULL);
 }
 
 /*
@@ -104,11 +147,13 @@ void SDLHardwareImage::drawPixel(int x, int y, const Color& color) {
 }
 
 void SDLHardwareImage::drawPixelSingle(int x, int y, const Color& color) {
-	SDL_SetRenderTarget(renderer, surface);
-	SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
+	detachFromAtlas();
+
+	getDevice()->setRenderTarget(surface);
+	getDevice()->setTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
 	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
 	SDL_RenderDrawPoint(renderer, x, y);
-	SDL_SetRenderTarget(renderer, NULL);
+	getDevice()->setRenderTarget(NULL);
 }
 
 void SDLHardwareImage::drawPixelBatch(int x, int y, const Color& color) {
@@ -153,11 +198,13 @@ void SDLHardwareImage::drawPixelBatch(int x, int y, const Color& color) {
 }
 
 void SDLHardwareImage::drawLine(int x0, int y0, int x1, int y1, const Color& color) {
-	SDL_SetRenderTarget(renderer, surface);
-	SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
+	detachFromAtlas();
+
+	getDevice()->setRenderTarget(surface);
+	getDevice()->setTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
 	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
 	SDL_RenderDrawLine(renderer, x0, y0, x1, y1);
-	SDL_SetRenderTarget(renderer, NULL);
+	getDevice()->setRenderTarget(NULL);
 }
 
 
@@ -200,13 +247,14 @@ void SDLHardwareImage::beginPixelBatch(Rect& bounds) {
 }
 
 void SDLHardwareImage::endPixelBatch() {
+	detachFromAtlas();
 	if (!surface || !pixel_batch_surface) return;
 
 	SDL_Texture *pixel_batch_texture = SDL_CreateTextureFromSurface(renderer, pixel_batch_surface);
 
 	if (pixel_batch_texture) {
-		SDL_SetRenderTarget(renderer, surface);
-		SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
+		getDevice()->setRenderTarget(surface);
+		getDevice()->setTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
 
 		if (pixel_batch_type == PIXEL_BATCH_ALL) {
 			SDL_RenderCopy(renderer, pixel_batch_texture, NULL, NULL);
@@ -215,7 +263,7 @@ void SDLHardwareImage::endPixelBatch() {
 			SDL_Rect dst(pixel_batch_area);
 			SDL_RenderCopy(renderer, pixel_batch_texture, NULL, &dst);
 		}
-		SDL_SetRenderTarget(renderer, NULL);
+		getDevice()->setRenderTarget(NULL);
 
 		SDL_DestroyTexture(pixel_batch_texture);
 	}
@@ -235,9 +283,15 @@ Image* SDLHardwareImage::resize(int width, int height) {
 
 	if (scaled->surface != NULL) {
 		// copy the source texture to the new texture, stretching it in the process
-		SDL_SetRenderTarget(renderer, scaled->surface);
-		SDL_RenderCopyEx(renderer, surface, NULL, NULL, 0, NULL, SDL_FLIP_NONE);
-		SDL_SetRenderTarget(renderer, NULL);
+		getDevice()->setRenderTarget(scaled->surface);
+		if (atlas_page != -1) {
+			SDL_Rect src = atlas_rect;
+			SDL_RenderCopyEx(renderer, surface, &src, NULL, 0, NULL, SDL_FLIP_NONE);
+		}
+		else {
+			SDL_RenderCopyEx(renderer, surface, NULL, NULL, 0, NULL, SDL_FLIP_NONE);
+		}
+		getDevice()->setRenderTarget(NULL);
 
 		// Remove the old surface
 		this->unref();
@@ -250,6 +304,49 @@ Image* SDLHardwareImage::resize(int width, int height) {
 	return NULL;
 }
 
+/**
+ * Clips the source rect to the image (moving dest along with it), like SDL_RenderCopy() does at the edges of a texture.
+ * This is needed for every image, since SDL_RenderGeometry() would stretch or repeat the texture instead.
+ * Images in an atlas page share the texture with other images, so the source rect is then moved to the image's place on the page.
+ * Returns false if nothing is left to draw.
+ */
+bool SDLHardwareImage::getTextureRects(SDL_Rect& src, SDL_Rect& dest) const {
+	int image_w, image_h;
+	if (atlas_page != -1) {
+		image_w = atlas_rect.w;
+		image_h = atlas_rect.h;
+	}
+	else if (!surface || SDL_QueryTexture(surface, NULL, NULL, &image_w, &image_h) != 0) {
+		return false;
+	}
+
+	if (src.x < 0) {
+		dest.x -= src.x;
+		src.w += src.x;
+		src.x = 0;
+	}
+	if (src.y < 0) {
+		dest.y -= src.y;
+		src.h += src.y;
+		src.y = 0;
+	}
+	if (src.x + src.w > image_w)
+		src.w = image_w - src.x;
+	if (src.y + src.h > image_h)
+		src.h = image_h - src.y;
+
+	if (src.w <= 0 || src.h <= 0)
+		return false;
+
+	dest.w = src.w;
+	dest.h = src.h;
+	if (atlas_page != -1) {
+		src.x += atlas_rect.x;
+		src.y += atlas_rect.y;
+	}
+	return true;
+}
+
 SDLHardwareRenderDevice::SDLHardwareRenderDevice()
 	: window(NULL)
 	, renderer(NULL)
@@ -257,6 +354,20 @@ SDLHardwareRenderDevice::SDLHardwareRenderDevice()
 	, titlebar_icon(NULL)
 	, title(NULL)
 	, background_color(0,0,0,255)
+	, atlas_generation(0)
+	, state_target_known(false)
+	, state_target(NULL)
+	, state_texture(NULL)
+	, state_blend_mode(SDL_BLENDMODE_NONE)
+	, state_mods_known(false)
+	, state_color_mod(255, 255, 255)
+	, state_alpha_mod(255)
+	, batch_texture(NULL)
+	, batch_blend_mode(SDL_BLENDMODE_NONE)
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	, batch_texture_w(1)
+	, batch_texture_h(1)
+#endif
 {
 	Utils::logInfo("Using Render Device: SDLHardwareRenderDevice (hardware, SDL 2, %s)", SDL_GetCurrentVideoDriver());
 
@@ -371,6 +482,14 @@ int SDLHardwareRenderDevice::createContextInternal() {
 			SDL_GetRendererInfo(renderer, &renderer_info);
 			Utils::logInfo("RenderDevice: Renderer driver is '%s'.", renderer_info.name);
 
+			// atlas pages can't be larger than the biggest texture the renderer supports
+			int atlas_page_size = ATLAS_PAGE_SIZE;
+			if (renderer_info.max_texture_width > 0 && renderer_info.max_texture_width < atlas_page_size)
+				atlas_page_size = renderer_info.max_texture_width;
+			if (renderer_info.max_texture_height > 0 && renderer_info.max_texture_height < atlas_page_size)
+				atlas_page_size = renderer_info.max_texture_height;
+			atlas.init(atlas_page_size);
+
 #if SDL_VERSION_ATLEAST(2, 0, 4)
 			SDL_GetDisplayDPI(0, &ddpi, 0, 0);
 			Utils::logInfo("RenderDevice: Display DPI is %f", ddpi);
@@ -393,6 +512,18 @@ int SDLHardwareRenderDevice::createContextInternal() {
 		is_initialized = (texture != NULL);
 	}
 
+	premultiplied_blend = false;
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+	if (is_initialized) {
+		// not every renderer supports custom blend modes. Try one on the screen texture and put its blend mode back afterwards
+		SDL_BlendMode prev_blend_mode;
+		if (SDL_GetTextureBlendMode(texture, &prev_blend_mode) == 0) {
+			premultiplied_blend = (SDL_SetTextureBlendMode(texture, getBlendMode(Renderable::BLEND_PREMULTIPLIED)) == 0);
+			SDL_SetTextureBlendMode(texture, prev_blend_mode);
+		}
+	}
+#endif
+
 	if (is_initialized) {
 		// update title bar text and icon
 		updateTitleBar();
@@ -425,21 +556,12 @@ int SDLHardwareRenderDevice::render(Renderable& r, Rect& dest) {
 	dest.h = r.src.h;
     SDL_Rect src = r.src;
     SDL_Rect _dest = dest;
-	SDL_SetRenderTarget(renderer, texture);
-
-	SDL_Texture *surface = static_cast<SDLHardwareImage *>(r.image)->surface;
-
-	if (r.blend_mode == Renderable::BLEND_ADD) {
-		SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_ADD);
-	}
-	else { // Renderable::BLEND_NORMAL
-		SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
-	}
 
-	SDL_SetTextureColorMod(surface, r.color_mod.r, r.color_mod.g, r.color_mod.b);
-	SDL_SetTextureAlphaMod(surface, r.alpha_mod);
+	SDLHardwareImage *image = static_cast<SDLHardwareImage *>(r.image);
+	if (!image->getTextureRects(src, _dest))
+		return 0;
 
-	return SDL_RenderCopy(renderer, surface, &src, &_dest);
+	return drawTexture(image->surface, getBlendMode(r.blend_mode), r.color_mod, r.alpha_mod, src, _dest);
 }
 
 int SDLHardwareRenderDevice::render(Sprite *r) {
@@ -468,30 +590,220 @@ int SDLHardwareRenderDevice::render(Sprite *r) {
 
     SDL_Rect src = m_clip;
     SDL_Rect dest = m_dest;
-	SDL_SetRenderTarget(renderer, texture);
 
-	SDL_Texture *surface = static_cast<SDLHardwareImage *>(r->getGraphics())->surface;
-	SDL_SetTextureColorMod(surface, r->color_mod.r, r->color_mod.g, r->color_mod.b);
-	SDL_SetTextureAlphaMod(surface, r->alpha_mod);
+	SDLHardwareImage *image = static_cast<SDLHardwareImage *>(r->getGraphics());
+	if (!image->getTextureRects(src, dest))
+		return 0;
 
-	return SDL_RenderCopy(renderer, static_cast<SDLHardwareImage *>(r->getGraphics())->surface, &src, &dest);
+	// alpha_mod only scales the alpha channel of the texture, but it has to scale the color of a premultiplied image as well
+	Color color_mod = r->color_mod;
+	if (r->blend_mode == Renderable::BLEND_PREMULTIPLIED && r->alpha_mod != 255) {
+		color_mod.r = static_cast<uint8_t>(color_mod.r * r->alpha_mod / 255);
+		color_mod.g = static_cast<uint8_t>(color_mod.g * r->alpha_mod / 255);
+		color_mod.b = static_cast<uint8_t>(color_mod.b * r->alpha_mod / 255);
+	}
+
+	// sprites share atlas pages with renderables, so the blend mode has to be set explicitly
+	return drawTexture(image->surface, getBlendMode(r->blend_mode), color_mod, r->alpha_mod, src, dest);
+}
+
+/**
+ * Maps one of Renderable::BLEND_* to the SDL blend mode that draws it
+ */
+SDL_BlendMode SDLHardwareRenderDevice::getBlendMode(uint8_t blend_mode) {
+	if (blend_mode == Renderable::BLEND_ADD)
+		return SDL_BLENDMODE_ADD;
+
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+	if (blend_mode == Renderable::BLEND_PREMULTIPLIED)
+		return SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+		                                  SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+#endif
+
+	return SDL_BLENDMODE_BLEND;
+}
+
+/**
+ * Draw (part of) a texture onto the screen texture
+ */
+int SDLHardwareRenderDevice::drawTexture(SDL_Texture *tex, SDL_BlendMode blend_mode, const Color& color_mod, uint8_t alpha_mod, const SDL_Rect& src, const SDL_Rect& dest) {
+	setRenderTarget(texture);
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	// modulation is passed as the vertex color, so only a different texture or blend mode ends a batch
+	if (tex != batch_texture || blend_mode != batch_blend_mode) {
+		flushBatch();
+
+		int w, h;
+		if (SDL_QueryTexture(tex, NULL, NULL, &w, &h) != 0 || w <= 0 || h <= 0)
+			return -1;
+
+		batch_texture = tex;
+		batch_blend_mode = blend_mode;
+		batch_texture_w = static_cast<float>(w);
+		batch_texture_h = static_cast<float>(h);
+	}
+
+	SDL_Vertex vertex;
+	vertex.color.r = color_mod.r;
+	vertex.color.g = color_mod.g;
+	vertex.color.b = color_mod.b;
+	vertex.color.a = alpha_mod;
+
+	const float x0 = static_cast<float>(dest.x);
+	const float y0 = static_cast<float>(dest.y);
+	const float x1 = static_cast<float>(dest.x + dest.w);
+	const float y1 = static_cast<float>(dest.y + dest.h);
+	const float u0 = static_cast<float>(src.x) / batch_texture_w;
+	const float v0 = static_cast<float>(src.y) / batch_texture_h;
+	const float u1 = static_cast<float>(src.x + src.w) / batch_texture_w;
+	const float v1 = static_cast<float>(src.y + src.h) / batch_texture_h;
+
+	const int first = static_cast<int>(batch_vertices.size());
+
+	vertex.position.x = x0; vertex.position.y = y0; vertex.tex_coord.x = u0; vertex.tex_coord.y = v0;
+	batch_vertices.push_back(vertex);
+	vertex.position.x = x1; vertex.position.y = y0; vertex.tex_coord.x = u1; vertex.tex_coord.y = v0;
+	batch_vertices.push_back(vertex);
+	vertex.position.x = x0; vertex.position.y = y1; vertex.tex_coord.x = u0; vertex.tex_coord.y = v1;
+	batch_vertices.push_back(vertex);
+	vertex.position.x = x1; vertex.position.y = y1; vertex.tex_coord.x = u1; vertex.tex_coord.y = v1;
+	batch_vertices.push_back(vertex);
+
+	batch_indices.push_back(first);
+	batch_indices.push_back(first + 1);
+	batch_indices.push_back(first + 2);
+	batch_indices.push_back(first + 1);
+	batch_indices.push_back(first + 3);
+	batch_indices.push_back(first + 2);
+
+	return 0;
+#else
+	setTextureBlendMode(tex, blend_mode);
+	setTextureMods(tex, color_mod, alpha_mod);
+
+	return SDL_RenderCopy(renderer, tex, &src, &dest);
+#endif
+}
+
+/**
+ * Submit the queued draws
+ */
+void SDLHardwareRenderDevice::flushBatch() {
+	if (!batch_texture)
+		return;
+
+	SDL_Texture *tex = batch_texture;
+	batch_texture = NULL;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	if (!batch_vertices.empty()) {
+		setTextureBlendMode(tex, batch_blend_mode);
+		SDL_RenderGeometry(renderer, tex, &batch_vertices[0], static_cast<int>(batch_vertices.size()), &batch_indices[0], static_cast<int>(batch_indices.size()));
+	}
+	batch_vertices.clear();
+	batch_indices.clear();
+#else
+	(void)tex;
+#endif
+}
+
+void SDLHardwareRenderDevice::setRenderTarget(SDL_Texture *target) {
+	if (state_target_known && target == state_target)
+		return;
+
+	// queued draws belong to the current target
+	flushBatch();
+
+	SDL_SetRenderTarget(renderer, target);
+	state_target = target;
+	state_target_known = true;
+}
+
+void SDLHardwareRenderDevice::setTextureBlendMode(SDL_Texture *tex, SDL_BlendMode blend_mode) {
+	if (tex == state_texture && blend_mode == state_blend_mode)
+		return;
+
+	// queued draws use the blend mode that the texture has when they are submitted
+	if (tex == batch_texture)
+		flushBatch();
+
+	SDL_SetTextureBlendMode(tex, blend_mode);
+	if (tex != state_texture)
+		state_mods_known = false;
+	state_texture = tex;
+	state_blend_mode = blend_mode;
+}
+
+/**
+ * Expects setTextureBlendMode() to have been called for the same texture first
+ */
+void SDLHardwareRenderDevice::setTextureMods(SDL_Texture *tex, const Color& color_mod, uint8_t alpha_mod) {
+	const bool known = state_mods_known && tex == state_texture;
+	if (known && state_color_mod == color_mod && state_alpha_mod == alpha_mod)
+		return;
+
+	if (tex == batch_texture)
+		flushBatch();
+
+	if (!known || state_color_mod != color_mod) {
+		SDL_SetTextureColorMod(tex, color_mod.r, color_mod.g, color_mod.b);
+		state_color_mod = color_mod;
+	}
+	if (!known || state_alpha_mod != alpha_mod) {
+		SDL_SetTextureAlphaMod(tex, alpha_mod);
+		state_alpha_mod = alpha_mod;
+	}
+	state_mods_known = true;
+}
+
+void SDLHardwareRenderDevice::destroyTexture(SDL_Texture *tex) {
+	if (!tex)
+		return;
+
+	if (tex == batch_texture)
+		flushBatch();
+	if (tex == state_texture)
+		state_texture = NULL;
+	if (tex == state_target)
+		state_target_known = false;
+
+	SDL_DestroyTexture(tex);
+}
+
+/**
+ * Forget the tracked state, for when the renderer or its textures are replaced
+ */
+void SDLHardwareRenderDevice::resetRenderState() {
+	flushBatch();
+	state_target_known = false;
+	state_texture = NULL;
+	state_mods_known = false;
 }
 
 int SDLHardwareRenderDevice::renderToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest) {
 	if (!src_image || !dest_image)
 		return -1;
 
-	if (SDL_SetRenderTarget(renderer, static_cast<SDLHardwareImage *>(dest_image)->surface) != 0)
-		return -1;
+	static_cast<SDLHardwareImage *>(dest_image)->detachFromAtlas();
+	setRenderTarget(static_cast<SDLHardwareImage *>(dest_image)->surface);
 
 	dest.w = src.w;
 	dest.h = src.h;
     SDL_Rect _src = src;
     SDL_Rect _dest = dest;
 
-	SDL_SetTextureBlendMode(static_cast<SDLHardwareImage *>(dest_image)->surface, SDL_BLENDMODE_BLEND);
-	SDL_RenderCopy(renderer, static_cast<SDLHardwareImage *>(src_image)->surface, &_src, &_dest);
-	SDL_SetRenderTarget(renderer, NULL);
+	if (!static_cast<SDLHardwareImage *>(src_image)->getTextureRects(_src, _dest)) {
+		setRenderTarget(NULL);
+		return 0;
+	}
+
+	// the source may be an atlas page that was last drawn with another blend mode or modulation
+	SDL_Texture *src_tex = static_cast<SDLHardwareImage *>(src_image)->surface;
+	setTextureBlendMode(src_tex, SDL_BLENDMODE_BLEND);
+	setTextureMods(src_tex, Color(255, 255, 255, 255), 255);
+	SDL_RenderCopy(renderer, src_tex, &_src, &_dest);
+	setRenderTarget(NULL);
 	return 0;
 }
 
@@ -518,11 +830,13 @@ Image * SDLHardwareRenderDevice::renderTextToImage(FontStyle* font_style, const
 }
 
 void SDLHardwareRenderDevice::drawPixel(int x, int y, const Color& color) {
+	flushBatch();
 	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
 	SDL_RenderDrawPoint(renderer, x, y);
 }
 
 void SDLHardwareRenderDevice::drawLine(int x0, int y0, int x1, int y1, const Color& color) {
+	flushBatch();
 	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
 	SDL_RenderDrawLine(renderer, x0, y0, x1, y1);
 }
@@ -536,16 +850,16 @@ void SDLHardwareRenderDevice::drawRectangle(const Point& p0, const Point& p1, co
 
 void SDLHardwareRenderDevice::blankScreen() {
 	SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-	SDL_SetRenderTarget(renderer, NULL);
+	setRenderTarget(NULL);
 	SDL_RenderClear(renderer);
 	SDL_SetRenderDrawColor(renderer, background_color.r, background_color.g, background_color.b, background_color.a);
-	SDL_SetRenderTarget(renderer, texture);
+	setRenderTarget(texture);
 	SDL_RenderClear(renderer);
 	return;
 }
 
 void SDLHardwareRenderDevice::commitFrame() {
-	SDL_SetRenderTarget(renderer, NULL);
+	setRenderTarget(NULL);
 	SDL_RenderCopy(renderer, texture, NULL, NULL);
 	SDL_RenderPresent(renderer);
 	inpt->window_resized = false;
@@ -559,6 +873,9 @@ void SDLHardwareRenderDevice::destroyContext() {
 	// we need to free all loaded graphics as they may be tied to the current context
 	RenderDevice::cacheRemoveAll();
 	reload_graphics = true;
+	resetRenderTargets();
+
+	destroyAtlas();
 
 	if (icons) {
 		delete icons;
@@ -572,9 +889,11 @@ void SDLHardwareRenderDevice::destroyContext() {
 	SDL_FreeSurface(titlebar_icon);
 	titlebar_icon = NULL;
 
-	SDL_DestroyTexture(texture);
+	destroyTexture(texture);
 	texture = NULL;
 
+	resetRenderState();
+
 	SDL_DestroyRenderer(renderer);
 	renderer = NULL;
 
@@ -602,11 +921,11 @@ Image *SDLHardwareRenderDevice::createImage(int width, int height) {
 			Utils::logError("SDLHardwareRenderDevice: SDL_CreateTexture failed: %s", SDL_GetError());
 		}
 		else {
-				SDL_SetRenderTarget(renderer, image->surface);
-				SDL_SetTextureBlendMode(image->surface, SDL_BLENDMODE_BLEND);
+				setRenderTarget(image->surface);
+				setTextureBlendMode(image->surface, SDL_BLENDMODE_BLEND);
 				SDL_SetRenderDrawColor(renderer, 0,0,0,0);
 				SDL_RenderClear(renderer);
-				SDL_SetRenderTarget(renderer, NULL);
+				setRenderTarget(NULL);
 		}
 	}
 
@@ -632,7 +951,7 @@ void SDLHardwareRenderDevice::updateTitleBar() {
 	if (!window) return;
 
 	title = Utils::strdup(msg->get(eset->misc.window_title));
-	titlebar_icon = IMG_Load(mods->locate("images/logo/icon.png").c_str());
+	titlebar_icon = IMG_Load_RW(mods->openRW(mods->locate("images/logo/icon.png")), 1);
 
 	if (title) SDL_SetWindowTitle(window, title);
 	if (titlebar_icon) SDL_SetWindowIcon(window, titlebar_icon);
@@ -648,7 +967,16 @@ Image *SDLHardwareRenderDevice::loadImage(const std::string& filename, int error
 	SDLHardwareImage *image = new SDLHardwareImage(this, renderer);
 	if (!image) return NULL;
 
-	image->surface = IMG_LoadTexture(renderer, mods->locate(filename).c_str());
+	// textures can only be created here, but the image may already have been decoded by prefetchImage()
+	SDL_Surface *loaded = takePrefetchedImage(filename);
+	if (!loaded)
+		loaded = IMG_Load_RW(mods->openRW(mods->locate(filename)), 1);
+
+	if (loaded) {
+		if (!addToAtlas(image, loaded))
+			image->surface = SDL_CreateTextureFromSurface(renderer, loaded);
+		SDL_FreeSurface(loaded);
+	}
 
 	if(image->surface == NULL) {
 		delete image;
@@ -669,6 +997,119 @@ Image *SDLHardwareRenderDevice::loadImage(const std::string& filename, int error
 	return image;
 }
 
+/**
+ * Decodes an image without touching the renderer or the image cache, so that this can run on a loading thread.
+ * Errors are left to loadImage(), which tries again.
+ */
+void SDLHardwareRenderDevice::prefetchImage(const std::string& filename) {
+	SDL_Surface *surface = IMG_Load_RW(mods->openRW(mods->locate(filename)), 1);
+	if (surface)
+		storePrefetchedImage(filename, surface);
+}
+
+/**
+ * Copies a loaded image into an atlas page, creating the page if needed
+ * Returns false if the image has to get a texture of its own
+ */
+bool SDLHardwareRenderDevice::addToAtlas(SDLHardwareImage *image, SDL_Surface *loaded) {
+	Point pos;
+	const int page = atlas.insert(loaded->w, loaded->h, pos);
+	if (page == -1)
+		return false;
+
+	if (atlas_pages.size() <= static_cast<size_t>(page))
+		atlas_pages.resize(page + 1, NULL);
+
+	// pages are static textures, so that they keep their contents when the renderer resets its render targets
+	if (!atlas_pages[page]) {
+		const int page_size = atlas.getPageSize();
+		atlas_pages[page] = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, page_size, page_size);
+		if (!atlas_pages[page]) {
+			Utils::logError("SDLHardwareRenderDevice: Could not create atlas page: %s", SDL_GetError());
+			atlas.release(page);
+			return false;
+		}
+	}
+
+	// draws of this page that are still queued have to be submitted before it changes
+	if (atlas_pages[page] == batch_texture)
+		flushBatch();
+
+	SDL_Surface *padded = createPaddedSurface(loaded);
+	bool updated = false;
+	if (padded) {
+		SDL_Rect dest = Rect(pos.x - TextureAtlas::PADDING, pos.y - TextureAtlas::PADDING, padded->w, padded->h);
+		updated = (SDL_UpdateTexture(atlas_pages[page], &dest, padded->pixels, padded->pitch) == 0);
+		SDL_FreeSurface(padded);
+	}
+
+	if (!updated) {
+		releaseAtlasImage(page, atlas_generation);
+		return false;
+	}
+
+	image->surface = atlas_pages[page];
+	image->atlas_page = page;
+	image->atlas_generation = atlas_generation;
+	image->atlas_rect = Rect(pos.x, pos.y, loaded->w, loaded->h);
+	return true;
+}
+
+/**
+ * Converts an image to the atlas pixel format, surrounded by TextureAtlas::PADDING pixels copied from its edges.
+ * With linear filtering, the edges of the image then blend with themselves instead of with the transparent padding.
+ */
+SDL_Surface* SDLHardwareRenderDevice::createPaddedSurface(SDL_Surface *loaded) {
+	const int pad = TextureAtlas::PADDING;
+
+	SDL_Surface *converted = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+	if (!converted)
+		return NULL;
+
+	const SDL_PixelFormat *format = converted->format;
+	SDL_Surface *padded = SDL_CreateRGBSurface(0, converted->w + pad * 2, converted->h + pad * 2, 32, format->Rmask, format->Gmask, format->Bmask, format->Amask);
+	if (!padded) {
+		SDL_FreeSurface(converted);
+		return NULL;
+	}
+
+	// both surfaces are freshly created in system memory, so they don't need to be locked
+	const int w = converted->w;
+	const int h = converted->h;
+	for (int y = 0; y < padded->h; ++y) {
+		const int src_y = std::min(std::max(y - pad, 0), h - 1);
+		const Uint32 *src_row = reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(converted->pixels) + src_y * converted->pitch);
+		Uint32 *dest_row = reinterpret_cast<Uint32*>(static_cast<Uint8*>(padded->pixels) + y * padded->pitch);
+
+		for (int x = 0; x < padded->w; ++x) {
+			dest_row[x] = src_row[std::min(std::max(x - pad, 0), w - 1)];
+		}
+	}
+
+	SDL_FreeSurface(converted);
+	return padded;
+}
+
+void SDLHardwareRenderDevice::releaseAtlasImage(int page, unsigned generation) {
+	// the image outlived the rendering context that it was loaded for
+	if (generation != atlas_generation)
+		return;
+
+	if (atlas.release(page) && static_cast<size_t>(page) < atlas_pages.size() && atlas_pages[page]) {
+		destroyTexture(atlas_pages[page]);
+		atlas_pages[page] = NULL;
+	}
+}
+
+void SDLHardwareRenderDevice::destroyAtlas() {
+	for (size_t i = 0; i < atlas_pages.size(); ++i) {
+		destroyTexture(atlas_pages[i]);
+	}
+	atlas_pages.clear();
+	atlas.clear();
+	atlas_generation++;
+}
+
 void SDLHardwareRenderDevice::getWindowSize(short unsigned *screen_w, short unsigned *screen_h) {
 	int w,h;
 	SDL_GetWindowSize(window, &w, &h);
@@ -681,9 +1122,9 @@ void SDLHardwareRenderDevice::windowResize() {
 
 	SDL_RenderSetLogicalSize(renderer, settings->view_w, settings->view_h);
 
-	if (texture) SDL_DestroyTexture(texture);
+	if (texture) destroyTexture(texture);
 	texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, settings->view_w, settings->view_h);
-	if (texture) SDL_SetRenderTarget(renderer, texture);
+	if (texture) setRenderTarget(texture);
 
 	settings->updateScreenVars();
 }
@@ -21,6 +21,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #define SDLHARDWARERENDERDEVICE_H
 
 #include "RenderDevice.h"
+#include "TextureAtlas.h"
 
 /** Provide rendering device using SDL_BlitSurface backend.
  *
@@ -37,6 +38,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
  *
  */
 
+class SDLHardwareRenderDevice;
+
 class SDLHardwareImage : public Image {
 public:
 	SDLHardwareImage(RenderDevice *device, SDL_Renderer *_renderer);
@@ -52,9 +55,19 @@ public:
 	void endPixelBatch();
 	Image* resize(int width, int height);
 
+	void detachFromAtlas();
+
+	// clips src (in image coordinates) to the image and moves it to the image's place in the texture
+	bool getTextureRects(SDL_Rect& src, SDL_Rect& dest) const;
+
 	SDL_Renderer *renderer;
 	SDL_Texture *surface;
 
+	// if the image is part of an atlas page, surface is the page and atlas_rect is where the image is on it
+	int atlas_page;
+	unsigned atlas_generation;
+	Rect atlas_rect;
+
 	SDL_Surface *pixel_batch_surface;
 	int pixel_batch_type;
 	Rect pixel_batch_area;
@@ -68,6 +81,7 @@ private:
 
 	void drawPixelSingle(int x, int y, const Color& color);
 	void drawPixelBatch(int x, int y, const Color& color);
+	SDLHardwareRenderDevice* getDevice() const;
 };
 
 class SDLHardwareRenderDevice : public RenderDevice {
@@ -96,13 +110,36 @@ public:
 	unsigned short getRefreshRate();
 
 	Image* loadImage(const std::string& filename, int error_type);
+	void prefetchImage(const std::string& filename);
+
+	void releaseAtlasImage(int page, unsigned generation);
+
+	/**
+	 * Render targets, texture blend modes and texture modulation are only changed through these,
+	 * so that setting a state that is already current can be skipped.
+	 * Queued draws are submitted before anything that could change their result.
+	 */
+	void setRenderTarget(SDL_Texture *target);
+	void setTextureBlendMode(SDL_Texture *tex, SDL_BlendMode blend_mode);
+	void setTextureMods(SDL_Texture *tex, const Color& color_mod, uint8_t alpha_mod);
+	void destroyTexture(SDL_Texture *tex);
+	void flushBatch();
 
 protected:
 	int createContextInternal();
 	void createContextError();
 
 private:
+	static const int ATLAS_PAGE_SIZE = 2048;
+
 	void getWindowSize(short unsigned *screen_w, short unsigned *screen_h);
+	static SDL_BlendMode getBlendMode(uint8_t blend_mode);
+	bool addToAtlas(SDLHardwareImage *image, SDL_Surface *loaded);
+	SDL_Surface* createPaddedSurface(SDL_Surface *loaded);
+	void destroyAtlas();
+
+	int drawTexture(SDL_Texture *tex, SDL_BlendMode blend_mode, const Color& color_mod, uint8_t alpha_mod, const SDL_Rect& src, const SDL_Rect& dest);
+	void resetRenderState();
 
 	SDL_Window *window;
 	SDL_Renderer *renderer;
@@ -111,6 +148,30 @@ private:
 	char* title;
 	Color background_color;
 
+	// loaded images are packed into these textures, see TextureAtlas
+	TextureAtlas atlas;
+	std::vector<SDL_Texture*> atlas_pages;
+	unsigned atlas_generation; // changes whenever the atlas is thrown away with the rendering context
+
+	// renderer state as last set by this device
+	bool state_target_known;
+	SDL_Texture *state_target;
+	SDL_Texture *state_texture; // the texture that the modes below were last set for, NULL if unknown
+	SDL_BlendMode state_blend_mode;
+	bool state_mods_known;
+	Color state_color_mod;
+	uint8_t state_alpha_mod;
+
+	// consecutive draws of the same texture with the same blend mode, submitted as one SDL_RenderGeometry() call
+	SDL_Texture *batch_texture;
+	SDL_BlendMode batch_blend_mode;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	float batch_texture_w;
+	float batch_texture_h;
+	std::vector<SDL_Vertex> batch_vertices;
+	std::vector<int> batch_indices;
+#endif
+
 	/* Stores the system gamma levels so they can be restored later */
 	uint16_t gamma_r[256];
 	uint16_t gamma_g[256];
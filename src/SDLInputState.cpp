@@ -370,6 +370,13 @@ void SDLInputState::handle() {
 					snd->resumeAll();
 				}
 				break;
+			// the contents of target textures were lost, for example when a Direct3D device was reset
+			case SDL_RENDER_TARGETS_RESET:
+#if SDL_VERSION_ATLEAST(2, 0, 4)
+			case SDL_RENDER_DEVICE_RESET:
+#endif
+				render_device->resetRenderTargets();
+				break;
 
 			// Mobile touch events
 			// NOTE Should these be limited to mobile only?
@@ -38,10 +38,14 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "SDLSoftwareRenderDevice.h"
 #include "SDLFontEngine.h"
+#include "UtilsBlit.h"
+
+unsigned long SDLSoftwareImage::next_serial = 0;
 
 SDLSoftwareImage::SDLSoftwareImage(RenderDevice *_device)
 	: Image(_device)
-	, surface(NULL) {
+	, surface(NULL)
+	, serial(++next_serial) {
 }
 
 SDLSoftwareImage::~SDLSoftwareImage() {
@@ -57,9 +61,17 @@ int SDLSoftwareImage::getHeight() const {
 	return surface ? surface->h : 0;
 }
 
+/**
+ * Gives the image a new serial after its pixels have changed
+ */
+void SDLSoftwareImage::touch() {
+	serial = ++next_serial;
+}
+
 void SDLSoftwareImage::fillWithColor(const Color& color) {
 	if (!surface) return;
 
+	touch();
 	SDL_FillRect(surface, NULL, MapRGBA(color.r, color.g, color.b, color.a));
 }
 
@@ -76,6 +88,8 @@ void SDLSoftwareImage::drawPixel(int x, int y, const Color& color) {
 	if (x < 0 || y < 0 || x >= getWidth() || y >= getHeight())
 		return;
 
+	touch();
+
 	Uint32 pixel = MapRGBA(color.r, color.g, color.b, color.a);
 
 	int bpp = surface->format->BytesPerPixel;
@@ -190,14 +204,25 @@ SDLSoftwareRenderDevice::SDLSoftwareRenderDevice()
 	, texture(NULL)
 	, titlebar_icon(NULL)
 	, title(NULL)
-	, background_color(0) {
+	, background_color(0)
+	, dirty_rects(settings->dirty_rects)
+	, redraw_all(true)
+	, frame_blanked(false)
+	, in_world_layer(false)
+	, has_world_origin(false)
+	, prev_has_world_origin(false)
+	, dirty_count(0) {
 	Utils::logInfo("RenderDevice: Using SDLSoftwareRenderDevice (software, SDL 2, %s)", SDL_GetCurrentVideoDriver());
+	Utils::logInfo("RenderDevice: Blitter is '%s', dirty rectangles=%d", Blit::getBackendName(), dirty_rects);
 
 	fullscreen = settings->fullscreen;
 	hwsurface = settings->hwsurface;
 	vsync = settings->vsync;
 	texture_filter = settings->texture_filter;
 
+	// done by Blit::blendPremultipliedRow()
+	premultiplied_blend = true;
+
 	min_screen.x = eset->resolutions.min_screen_w;
 	min_screen.y = eset->resolutions.min_screen_h;
 
@@ -357,19 +382,14 @@ int SDLSoftwareRenderDevice::render(Renderable& r, Rect& dest) {
 	SDL_Rect src = r.src;
 	SDL_Rect _dest = dest;
 
-	SDL_Surface *surface = static_cast<SDLSoftwareImage *>(r.image)->surface;
+	SDLSoftwareImage *image = static_cast<SDLSoftwareImage *>(r.image);
 
-	if (r.blend_mode == Renderable::BLEND_ADD) {
-		SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_ADD);
-	}
-	else { // Renderable::BLEND_NORMAL
-		SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_BLEND);
+	if (dirty_rects) {
+		recordImage(image, src, _dest, r.blend_mode, r.color_mod, r.alpha_mod);
+		return 0;
 	}
 
-	SDL_SetSurfaceColorMod(surface, r.color_mod.r, r.color_mod.g, r.color_mod.b);
-	SDL_SetSurfaceAlphaMod(surface, r.alpha_mod);
-
-	return SDL_BlitSurface(surface, &src, screen, &_dest);
+	return blitImage(image->surface, src, _dest, r.blend_mode, r.color_mod, r.alpha_mod);
 }
 
 int SDLSoftwareRenderDevice::render(Sprite *r) {
@@ -384,11 +404,92 @@ int SDLSoftwareRenderDevice::render(Sprite *r) {
 	SDL_Rect src = m_clip;
 	SDL_Rect dest = m_dest;
 
-	SDL_Surface *surface = static_cast<SDLSoftwareImage *>(r->getGraphics())->surface;
-	SDL_SetSurfaceColorMod(surface, r->color_mod.r, r->color_mod.g, r->color_mod.b);
-	SDL_SetSurfaceAlphaMod(surface, r->alpha_mod);
+	SDLSoftwareImage *image = static_cast<SDLSoftwareImage *>(r->getGraphics());
+
+	if (dirty_rects) {
+		recordImage(image, src, dest, r->blend_mode, r->color_mod, r->alpha_mod);
+		return 0;
+	}
+
+	return blitImage(image->surface, src, dest, r->blend_mode, r->color_mod, r->alpha_mod);
+}
+
+/**
+ * Clips a blit the same way as SDL_BlitSurface(): src to the image, then dest to the clip rectangle of the screen
+ * Returns false if nothing is left to draw
+ */
+bool SDLSoftwareRenderDevice::clipBlit(SDL_Surface *surface, SDL_Rect& src, SDL_Rect& dest) {
+	if (src.x < 0) {
+		src.w += src.x;
+		dest.x -= src.x;
+		src.x = 0;
+	}
+	if (src.y < 0) {
+		src.h += src.y;
+		dest.y -= src.y;
+		src.y = 0;
+	}
+	if (src.x + src.w > surface->w)
+		src.w = surface->w - src.x;
+	if (src.y + src.h > surface->h)
+		src.h = surface->h - src.y;
+
+	const SDL_Rect& clip = screen->clip_rect;
+	if (dest.x < clip.x) {
+		src.x += clip.x - dest.x;
+		src.w -= clip.x - dest.x;
+		dest.x = clip.x;
+	}
+	if (dest.y < clip.y) {
+		src.y += clip.y - dest.y;
+		src.h -= clip.y - dest.y;
+		dest.y = clip.y;
+	}
+	if (dest.x + src.w > clip.x + clip.w)
+		src.w = clip.x + clip.w - dest.x;
+	if (dest.y + src.h > clip.y + clip.h)
+		src.h = clip.y + clip.h - dest.y;
+
+	dest.w = src.w;
+	dest.h = src.h;
+	return (src.w > 0 && src.h > 0);
+}
+
+int SDLSoftwareRenderDevice::blitImage(SDL_Surface *surface, const SDL_Rect& src, const SDL_Rect& dest, uint8_t blend_mode, const Color& color_mod, uint8_t alpha_mod) {
+	if (!surface || !screen)
+		return -1;
+
+	SDL_Rect _src = src;
+	SDL_Rect _dest = dest;
+
+	// anything other than 32-bit ARGB (such as text rendered without blending) is left to SDL
+	// SDL has no blend mode for premultiplied surfaces, but images drawn onto with renderToImage() are always 32-bit ARGB
+	if (surface->format->format != SDL_PIXELFORMAT_ARGB8888 || screen->format->format != SDL_PIXELFORMAT_ARGB8888 || SDL_MUSTLOCK(surface) || SDL_MUSTLOCK(screen)) {
+		SDL_SetSurfaceBlendMode(surface, (blend_mode == Renderable::BLEND_ADD) ? SDL_BLENDMODE_ADD : SDL_BLENDMODE_BLEND);
+		SDL_SetSurfaceColorMod(surface, color_mod.r, color_mod.g, color_mod.b);
+		SDL_SetSurfaceAlphaMod(surface, alpha_mod);
+		return SDL_BlitSurface(surface, &_src, screen, &_dest);
+	}
+
+	if (!clipBlit(surface, _src, _dest))
+		return 0;
 
-	return SDL_BlitSurface(surface, &src, screen, &dest);
+	const Uint8 *src_row = static_cast<const Uint8*>(surface->pixels) + _src.y * surface->pitch + _src.x * 4;
+	Uint8 *dest_row = static_cast<Uint8*>(screen->pixels) + _dest.y * screen->pitch + _dest.x * 4;
+
+	for (int i = 0; i < _src.h; ++i) {
+		if (blend_mode == Renderable::BLEND_ADD)
+			Blit::addRow(reinterpret_cast<uint32_t*>(dest_row), reinterpret_cast<const uint32_t*>(src_row), _src.w, color_mod, alpha_mod);
+		else if (blend_mode == Renderable::BLEND_PREMULTIPLIED)
+			Blit::blendPremultipliedRow(reinterpret_cast<uint32_t*>(dest_row), reinterpret_cast<const uint32_t*>(src_row), _src.w, color_mod, alpha_mod);
+		else
+			Blit::blendRow(reinterpret_cast<uint32_t*>(dest_row), reinterpret_cast<const uint32_t*>(src_row), _src.w, color_mod, alpha_mod);
+
+		src_row += surface->pitch;
+		dest_row += screen->pitch;
+	}
+
+	return 0;
 }
 
 int SDLSoftwareRenderDevice::renderToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest) {
@@ -397,8 +498,15 @@ int SDLSoftwareRenderDevice::renderToImage(Image* src_image, Rect& src, Image* d
 	SDL_Rect _src = src;
 	SDL_Rect _dest = dest;
 
-	return SDL_BlitSurface(static_cast<SDLSoftwareImage *>(src_image)->surface, &_src,
-						   static_cast<SDLSoftwareImage *>(dest_image)->surface, &_dest);
+	static_cast<SDLSoftwareImage *>(dest_image)->touch();
+
+	// blending onto a transparent image leaves premultiplied colors, which is what Renderable::BLEND_PREMULTIPLIED expects
+	SDL_Surface *src_surface = static_cast<SDLSoftwareImage *>(src_image)->surface;
+	SDL_SetSurfaceBlendMode(src_surface, SDL_BLENDMODE_BLEND);
+	SDL_SetSurfaceColorMod(src_surface, 255, 255, 255);
+	SDL_SetSurfaceAlphaMod(src_surface, 255);
+
+	return SDL_BlitSurface(src_surface, &_src, static_cast<SDLSoftwareImage *>(dest_image)->surface, &_dest);
 }
 
 Image* SDLSoftwareRenderDevice::renderTextToImage(FontStyle* font_style, const std::string& text, const Color& color, bool blended) {
@@ -420,7 +528,21 @@ Image* SDLSoftwareRenderDevice::renderTextToImage(FontStyle* font_style, const s
 }
 
 void SDLSoftwareRenderDevice::drawPixel(int x, int y, const Color& color) {
-	Uint32 pixel = MapRGBA(color.r, color.g, color.b, color.a);
+	if (dirty_rects) {
+		recordPrimitive(DrawCommand::TYPE_PIXEL, x, y, x, y, color);
+		return;
+	}
+
+	putPixel(x, y, MapRGBA(color.r, color.g, color.b, color.a));
+}
+
+/**
+ * Sets a pixel of the screen, if it is inside of the clip rectangle
+ */
+void SDLSoftwareRenderDevice::putPixel(int x, int y, Uint32 pixel) {
+	const SDL_Rect& clip = screen->clip_rect;
+	if (x < clip.x || y < clip.y || x >= clip.x + clip.w || y >= clip.y + clip.h)
+		return;
 
 	int bpp = screen->format->BytesPerPixel;
 	/* Here p is the address to the pixel we want to set */
@@ -462,6 +584,15 @@ void SDLSoftwareRenderDevice::drawPixel(int x, int y, const Color& color) {
 }
 
 void SDLSoftwareRenderDevice::drawLine(int x0, int y0, int x1, int y1, const Color& color) {
+	if (dirty_rects) {
+		recordPrimitive(DrawCommand::TYPE_LINE, x0, y0, x1, y1, color);
+		return;
+	}
+
+	plotLine(x0, y0, x1, y1, MapRGBA(color.r, color.g, color.b, color.a));
+}
+
+void SDLSoftwareRenderDevice::plotLine(int x0, int y0, int x1, int y1, Uint32 pixel) {
 	const int dx = abs(x1-x0);
 	const int dy = abs(y1-y0);
 	const int sx = x0 < x1 ? 1 : -1;
@@ -471,7 +602,7 @@ void SDLSoftwareRenderDevice::drawLine(int x0, int y0, int x1, int y1, const Col
 	do {
 		//skip draw if outside screen
 		if (x0 > 0 && y0 > 0 && x0 < settings->view_w && y0 < settings->view_h) {
-			this->drawPixel(x0,y0,color);
+			putPixel(x0, y0, pixel);
 		}
 
 		int e2 = 2*err;
@@ -501,12 +632,27 @@ void SDLSoftwareRenderDevice::drawRectangle(const Point& p0, const Point& p1, co
 }
 
 void SDLSoftwareRenderDevice::blankScreen() {
+	if (dirty_rects) {
+		// the screen is cleared by composeFrame(), where needed
+		frame_blanked = true;
+		return;
+	}
+
 	SDL_FillRect(screen, NULL, background_color);
 	return;
 }
 
 void SDLSoftwareRenderDevice::commitFrame() {
-	SDL_UpdateTexture(texture, NULL, screen->pixels, screen->pitch);
+	if (dirty_rects && composeFrame()) {
+		const int bpp = screen->format->BytesPerPixel;
+		for (size_t i = 0; i < update_rects.size(); ++i) {
+			const SDL_Rect& r = update_rects[i];
+			SDL_UpdateTexture(texture, &r, static_cast<Uint8*>(screen->pixels) + r.y * screen->pitch + r.x * bpp, screen->pitch);
+		}
+	}
+	else {
+		SDL_UpdateTexture(texture, NULL, screen->pixels, screen->pitch);
+	}
 	SDL_RenderClear(renderer);
 	SDL_RenderCopy(renderer, texture, NULL, NULL);
 	SDL_RenderPresent(renderer);
@@ -518,9 +664,15 @@ void SDLSoftwareRenderDevice::commitFrame() {
 void SDLSoftwareRenderDevice::destroyContext() {
 	resetGamma();
 
+	// recorded draws hold references to their images
+	releaseCommands(commands);
+	releaseCommands(prev_commands);
+	redraw_all = true;
+
 	// we need to free all loaded graphics as they may be tied to the current context
 	RenderDevice::cacheRemoveAll();
 	reload_graphics = true;
+	resetRenderTargets();
 
 	if (icons) {
 		delete icons;
@@ -609,7 +761,7 @@ void SDLSoftwareRenderDevice::updateTitleBar() {
 	if (!window) return;
 
 	title = Utils::strdup(msg->get(eset->misc.window_title));
-	titlebar_icon = IMG_Load(mods->locate("images/logo/icon.png").c_str());
+	titlebar_icon = IMG_Load_RW(mods->openRW(mods->locate("images/logo/icon.png")), 1);
 
 	if (title) SDL_SetWindowTitle(window, title);
 	if (titlebar_icon) SDL_SetWindowIcon(window, titlebar_icon);
@@ -621,10 +773,19 @@ Image *SDLSoftwareRenderDevice::loadImage(const std::string& filename, int error
 	img = cacheLookup(filename);
 	if (img != NULL) return img;
 
+	// use the image decoded by prefetchImage() if there is one
+	SDL_Surface *prefetched = takePrefetchedImage(filename);
+	if (prefetched) {
+		SDLSoftwareImage *image = new SDLSoftwareImage(this);
+		image->surface = prefetched;
+		cacheStore(filename, image);
+		return image;
+	}
+
 	// load image
 	SDLSoftwareImage *image;
 	image = NULL;
-	SDL_Surface *cleanup = IMG_Load(mods->locate(filename).c_str());
+	SDL_Surface *cleanup = IMG_Load_RW(mods->openRW(mods->locate(filename)), 1);
 	if(!cleanup) {
 		if (error_type != ERROR_NONE)
 			Utils::logError("SDLSoftwareRenderDevice: Couldn't load image: '%s'. %s", filename.c_str(), IMG_GetError());
@@ -648,6 +809,22 @@ Image *SDLSoftwareRenderDevice::loadImage(const std::string& filename, int error
 	return image;
 }
 
+/**
+ * Decodes and converts an image without touching the image cache, so that this can run on a loading thread.
+ * Errors are left to loadImage(), which tries again.
+ */
+void SDLSoftwareRenderDevice::prefetchImage(const std::string& filename) {
+	SDL_Surface *cleanup = IMG_Load_RW(mods->openRW(mods->locate(filename)), 1);
+	if (!cleanup)
+		return;
+
+	SDL_Surface *surface = SDL_ConvertSurfaceFormat(cleanup, SDL_PIXELFORMAT_ARGB8888, 0);
+	SDL_FreeSurface(cleanup);
+
+	if (surface)
+		storePrefetchedImage(filename, surface);
+}
+
 void SDLSoftwareRenderDevice::getWindowSize(short unsigned *screen_w, short unsigned *screen_h) {
 	int w,h;
 	SDL_GetWindowSize(window, &w, &h);
@@ -668,12 +845,16 @@ void SDLSoftwareRenderDevice::windowResize() {
 	SDL_PixelFormatEnumToMasks(SDL_PIXELFORMAT_ARGB8888, &bpp, &rmask, &gmask, &bmask, &amask);
 	screen = SDL_CreateRGBSurface(0, settings->view_w, settings->view_h, bpp, rmask, gmask, bmask, amask);
 	texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, settings->view_w, settings->view_h);
+	redraw_all = true;
 
 	settings->updateScreenVars();
 }
 
 void SDLSoftwareRenderDevice::setBackgroundColor(Color color) {
-	background_color = SDL_MapRGBA(screen->format, color.r, color.g, color.b, 255);
+	uint32_t new_color = SDL_MapRGBA(screen->format, color.r, color.g, color.b, 255);
+	if (new_color != background_color)
+		redraw_all = true;
+	background_color = new_color;
 }
 
 void SDLSoftwareRenderDevice::setFullscreen(bool enable_fullscreen) {
@@ -713,3 +894,410 @@ unsigned short SDLSoftwareRenderDevice::getRefreshRate() {
 	return static_cast<unsigned short>(mode.refresh_rate);
 }
 
+
+void SDLSoftwareRenderDevice::beginWorldLayer(const Point& origin) {
+	in_world_layer = true;
+	has_world_origin = true;
+	world_origin = origin;
+}
+
+void SDLSoftwareRenderDevice::endWorldLayer() {
+	in_world_layer = false;
+}
+
+SDLSoftwareRenderDevice::DrawCommand::DrawCommand()
+	: type(TYPE_IMAGE)
+	, image(NULL)
+	, serial(0)
+	, blend_mode(Renderable::BLEND_NORMAL)
+	, color_mod(255, 255, 255)
+	, alpha_mod(255)
+	, world(false)
+	, hash(0)
+{
+	src.x = src.y = src.w = src.h = 0;
+	dest.x = dest.y = dest.w = dest.h = 0;
+	bounds.x = bounds.y = bounds.w = bounds.h = 0;
+}
+
+/**
+ * Everything that decides the pixels drawn by this command. World positions are relative to the world origin.
+ */
+void SDLSoftwareRenderDevice::DrawCommand::getKey(int *key) const {
+	key[0] = type;
+	key[1] = src.x;
+	key[2] = src.y;
+	key[3] = src.w;
+	key[4] = src.h;
+	key[5] = dest.x - origin.x;
+	key[6] = dest.y - origin.y;
+	key[7] = (type == TYPE_IMAGE) ? dest.w : dest.w - origin.x;
+	key[8] = (type == TYPE_IMAGE) ? dest.h : dest.h - origin.y;
+	key[9] = blend_mode;
+	key[10] = (color_mod.r << 16) | (color_mod.g << 8) | color_mod.b;
+	key[11] = alpha_mod;
+	key[12] = world;
+	key[13] = static_cast<int>(serial & 0x7fffffff);
+}
+
+void SDLSoftwareRenderDevice::DrawCommand::updateHash() {
+	int key[KEY_SIZE];
+	getKey(key);
+
+	// FNV-1a
+	hash = 2166136261u;
+	for (int i = 0; i < KEY_SIZE; ++i) {
+		hash = (hash ^ static_cast<uint32_t>(key[i])) * 16777619u;
+	}
+}
+
+bool SDLSoftwareRenderDevice::DrawCommand::matches(const DrawCommand& other) const {
+	if (hash != other.hash || serial != other.serial)
+		return false;
+
+	int key[KEY_SIZE];
+	int other_key[KEY_SIZE];
+	getKey(key);
+	other.getKey(other_key);
+
+	return memcmp(key, other_key, sizeof(key)) == 0;
+}
+
+void SDLSoftwareRenderDevice::recordImage(SDLSoftwareImage *image, const SDL_Rect& src, const SDL_Rect& dest, uint8_t blend_mode, const Color& color_mod, uint8_t alpha_mod) {
+	if (!image || !image->surface || !screen)
+		return;
+
+	DrawCommand cmd;
+	cmd.type = DrawCommand::TYPE_IMAGE;
+	cmd.image = image;
+	cmd.serial = image->serial;
+	cmd.src = src;
+	cmd.dest = dest;
+	cmd.blend_mode = blend_mode;
+	cmd.color_mod = color_mod;
+	cmd.alpha_mod = alpha_mod;
+	cmd.world = in_world_layer;
+	if (in_world_layer)
+		cmd.origin = world_origin;
+
+	SDL_Rect clipped_src = src;
+	cmd.bounds = dest;
+	if (!clipBlit(image->surface, clipped_src, cmd.bounds))
+		return;
+
+	cmd.updateHash();
+
+	// the image has to stay around until the frame is composited
+	image->ref();
+	commands.push_back(cmd);
+}
+
+void SDLSoftwareRenderDevice::recordPrimitive(uint8_t type, int x0, int y0, int x1, int y1, const Color& color) {
+	if (!screen)
+		return;
+
+	DrawCommand cmd;
+	cmd.type = type;
+	cmd.dest.x = x0;
+	cmd.dest.y = y0;
+	cmd.dest.w = x1;
+	cmd.dest.h = y1;
+	cmd.color_mod = color;
+	cmd.alpha_mod = color.a;
+	cmd.world = in_world_layer;
+	if (in_world_layer)
+		cmd.origin = world_origin;
+
+	SDL_Rect line_bounds;
+	line_bounds.x = std::min(x0, x1);
+	line_bounds.y = std::min(y0, y1);
+	line_bounds.w = std::max(x0, x1) - line_bounds.x + 1;
+	line_bounds.h = std::max(y0, y1) - line_bounds.y + 1;
+	if (!SDL_IntersectRect(&line_bounds, &screen->clip_rect, &cmd.bounds))
+		return;
+
+	cmd.updateHash();
+	commands.push_back(cmd);
+}
+
+void SDLSoftwareRenderDevice::releaseCommands(std::vector<DrawCommand>& _commands) {
+	for (size_t i = 0; i < _commands.size(); ++i) {
+		if (_commands[i].image)
+			_commands[i].image->unref();
+	}
+	_commands.clear();
+}
+
+void SDLSoftwareRenderDevice::drawCommand(const DrawCommand& cmd) {
+	if (cmd.type == DrawCommand::TYPE_IMAGE) {
+		blitImage(cmd.image->surface, cmd.src, cmd.dest, cmd.blend_mode, cmd.color_mod, cmd.alpha_mod);
+	}
+	else {
+		Uint32 pixel = MapRGBA(cmd.color_mod.r, cmd.color_mod.g, cmd.color_mod.b, cmd.alpha_mod);
+		if (cmd.type == DrawCommand::TYPE_PIXEL)
+			putPixel(cmd.dest.x, cmd.dest.y, pixel);
+		else
+			plotLine(cmd.dest.x, cmd.dest.y, cmd.dest.w, cmd.dest.h, pixel);
+	}
+}
+
+/**
+ * Draws the recorded commands of this frame to the screen surface, but only where the result differs from the previous frame.
+ * Returns true if update_rects holds the changed parts of the screen, or false if all of it needs to be uploaded.
+ */
+bool SDLSoftwareRenderDevice::composeFrame() {
+	update_rects.clear();
+
+	Point scroll;
+	if (!frame_blanked) {
+		// nothing cleared the screen (e.g. the loading screen), so this frame is drawn over the previous one
+		for (size_t i = 0; i < prev_commands.size(); ++i) {
+			if (prev_commands[i].image)
+				prev_commands[i].image->ref();
+		}
+		commands.insert(commands.begin(), prev_commands.begin(), prev_commands.end());
+
+		if (!has_world_origin) {
+			has_world_origin = prev_has_world_origin;
+			world_origin = prev_world_origin;
+		}
+	}
+	else if (has_world_origin && prev_has_world_origin) {
+		scroll.x = world_origin.x - prev_world_origin.x;
+		scroll.y = world_origin.y - prev_world_origin.y;
+	}
+
+	const bool scrolled = (scroll.x != 0 || scroll.y != 0);
+	bool full = redraw_all || abs(scroll.x) >= screen->w || abs(scroll.y) >= screen->h;
+
+	if (!full) {
+		dirty_grid.x = (screen->w + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE;
+		dirty_grid.y = (screen->h + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE;
+		dirty_tiles.assign(dirty_grid.x * dirty_grid.y, 0);
+		dirty_count = 0;
+
+		if (scrolled) {
+			scrollScreen(scroll);
+
+			// the edges that scrolled into view
+			SDL_Rect edge;
+			edge.x = (scroll.x > 0) ? 0 : screen->w + scroll.x;
+			edge.y = 0;
+			edge.w = abs(scroll.x);
+			edge.h = screen->h;
+			markDirty(edge);
+
+			edge.x = 0;
+			edge.y = (scroll.y > 0) ? 0 : screen->h + scroll.y;
+			edge.w = screen->w;
+			edge.h = abs(scroll.y);
+			markDirty(edge);
+		}
+
+		matchCommands(scroll);
+
+		// drawing everything is cheaper than testing every command against lots of small areas
+		if (dirty_count * 4 > dirty_grid.x * dirty_grid.y * 3)
+			full = true;
+	}
+
+	if (full) {
+		SDL_FillRect(screen, NULL, background_color);
+		for (size_t i = 0; i < commands.size(); ++i) {
+			drawCommand(commands[i]);
+		}
+	}
+	else {
+		getDirtyRects(update_rects);
+
+		for (size_t i = 0; i < update_rects.size(); ++i) {
+			const SDL_Rect& r = update_rects[i];
+
+			SDL_SetClipRect(screen, &r);
+			SDL_FillRect(screen, &r, background_color);
+			for (size_t j = 0; j < commands.size(); ++j) {
+				if (SDL_HasIntersection(&commands[j].bounds, &r))
+					drawCommand(commands[j]);
+			}
+		}
+		SDL_SetClipRect(screen, NULL);
+	}
+
+	releaseCommands(prev_commands);
+	prev_commands.swap(commands);
+	prev_has_world_origin = has_world_origin;
+	prev_world_origin = world_origin;
+
+	has_world_origin = false;
+	in_world_layer = false;
+	frame_blanked = false;
+	redraw_all = false;
+
+	// after a scroll, all of the screen has moved
+	return !full && !scrolled;
+}
+
+/**
+ * Pairs the commands of this frame with identical commands of the previous frame, keeping the draw order.
+ * Unpaired commands from either frame mark the screen as dirty where they draw.
+ */
+void SDLSoftwareRenderDevice::matchCommands(const Point& scroll) {
+	const bool scrolled = (scroll.x != 0 || scroll.y != 0);
+
+	// previous commands sorted by hash, and by draw order for the same hash
+	std::vector< std::pair<uint32_t, size_t> > prev_order(prev_commands.size());
+	for (size_t i = 0; i < prev_commands.size(); ++i) {
+		prev_order[i] = std::make_pair(prev_commands[i].hash, i);
+	}
+	std::sort(prev_order.begin(), prev_order.end());
+
+	// for the first entry of each hash, the first entry that might still match
+	std::vector<size_t> cursor(prev_order.size());
+	for (size_t i = 0; i < cursor.size(); ++i) {
+		cursor[i] = i;
+	}
+
+	std::vector<bool> prev_matched(prev_commands.size(), false);
+
+	// matched commands have to be in the same order in both frames, so only previous commands from here on can match
+	size_t next_prev = 0;
+
+	for (size_t i = 0; i < commands.size(); ++i) {
+		const DrawCommand& cmd = commands[i];
+		bool matched = false;
+
+		// when scrolling, what was drawn in screen space has moved along with the map
+		if (!scrolled || cmd.world) {
+			std::vector< std::pair<uint32_t, size_t> >::iterator it = std::lower_bound(prev_order.begin(), prev_order.end(), std::make_pair(cmd.hash, static_cast<size_t>(0)));
+
+			if (it != prev_order.end() && it->first == cmd.hash) {
+				size_t& pos = cursor[it - prev_order.begin()];
+				while (pos < prev_order.size() && prev_order[pos].first == cmd.hash && prev_order[pos].second < next_prev) {
+					++pos;
+				}
+
+				// don't skip over a large part of the previous frame to match a single command that changed its place in the draw order
+				for (size_t j = pos; j < prev_order.size() && prev_order[j].first == cmd.hash; ++j) {
+					const size_t index = prev_order[j].second;
+					if (index - next_prev > static_cast<size_t>(MAX_MATCH_SKIP))
+						break;
+
+					// the old pixels have to be where the screen was scrolled to
+					const DrawCommand& prev = prev_commands[index];
+					if (prev.origin.x + scroll.x != cmd.origin.x || prev.origin.y + scroll.y != cmd.origin.y)
+						continue;
+
+					if (prev.matches(cmd)) {
+						prev_matched[index] = true;
+						next_prev = index + 1;
+						matched = true;
+						break;
+					}
+				}
+			}
+		}
+
+		if (!matched)
+			markDirty(cmd.bounds);
+	}
+
+	// the pixels of the previous frame have moved along with the scroll
+	for (size_t i = 0; i < prev_commands.size(); ++i) {
+		if (prev_matched[i])
+			continue;
+
+		SDL_Rect r = prev_commands[i].bounds;
+		r.x += scroll.x;
+		r.y += scroll.y;
+		markDirty(r);
+	}
+}
+
+/**
+ * Moves the pixels of the screen by scroll. The uncovered edges are left as they are.
+ */
+void SDLSoftwareRenderDevice::scrollScreen(const Point& scroll) {
+	const int w = screen->w - abs(scroll.x);
+	const int h = screen->h - abs(scroll.y);
+	if (w <= 0 || h <= 0)
+		return;
+
+	const int bpp = screen->format->BytesPerPixel;
+	const int src_x = std::max(-scroll.x, 0) * bpp;
+	const int dest_x = std::max(scroll.x, 0) * bpp;
+	const size_t row_size = static_cast<size_t>(w * bpp);
+	Uint8 *pixels = static_cast<Uint8*>(screen->pixels);
+
+	if (scroll.y > 0) {
+		// moving down, so start at the bottom to not overwrite rows before they are moved
+		for (int y = h - 1; y >= 0; --y) {
+			memmove(pixels + (y + scroll.y) * screen->pitch + dest_x, pixels + y * screen->pitch + src_x, row_size);
+		}
+	}
+	else {
+		for (int y = 0; y < h; ++y) {
+			memmove(pixels + y * screen->pitch + dest_x, pixels + (y - scroll.y) * screen->pitch + src_x, row_size);
+		}
+	}
+}
+
+void SDLSoftwareRenderDevice::markDirty(const SDL_Rect& r) {
+	const int x1 = std::max(r.x, 0);
+	const int y1 = std::max(r.y, 0);
+	const int x2 = std::min(r.x + r.w, screen->w);
+	const int y2 = std::min(r.y + r.h, screen->h);
+	if (x1 >= x2 || y1 >= y2)
+		return;
+
+	for (int ty = y1 / DIRTY_TILE_SIZE; ty <= (y2 - 1) / DIRTY_TILE_SIZE; ++ty) {
+		for (int tx = x1 / DIRTY_TILE_SIZE; tx <= (x2 - 1) / DIRTY_TILE_SIZE; ++tx) {
+			unsigned char& tile = dirty_tiles[ty * dirty_grid.x + tx];
+			if (!tile) {
+				tile = 1;
+				dirty_count++;
+			}
+		}
+	}
+}
+
+/**
+ * Joins the dirty tiles into rectangles: runs of tiles in a row, extended downwards while the next row has the same run
+ */
+void SDLSoftwareRenderDevice::getDirtyRects(std::vector<SDL_Rect>& rects) {
+	rects.clear();
+
+	for (int ty = 0; ty < dirty_grid.y; ++ty) {
+		int tx = 0;
+		while (tx < dirty_grid.x) {
+			if (!dirty_tiles[ty * dirty_grid.x + tx]) {
+				++tx;
+				continue;
+			}
+
+			int run_end = tx;
+			while (run_end < dirty_grid.x && dirty_tiles[ty * dirty_grid.x + run_end]) {
+				++run_end;
+			}
+
+			SDL_Rect r;
+			r.x = tx * DIRTY_TILE_SIZE;
+			r.y = ty * DIRTY_TILE_SIZE;
+			r.w = std::min(run_end * DIRTY_TILE_SIZE, screen->w) - r.x;
+			r.h = std::min((ty + 1) * DIRTY_TILE_SIZE, screen->h) - r.y;
+
+			bool extended = false;
+			for (size_t i = rects.size(); i > 0; --i) {
+				SDL_Rect& above = rects[i-1];
+				if (above.y + above.h == r.y && above.x == r.x && above.w == r.w) {
+					above.h += r.h;
+					extended = true;
+					break;
+				}
+			}
+			if (!extended)
+				rects.push_back(r);
+
+			tx = run_end;
+		}
+	}
+}
@@ -50,11 +50,17 @@ public:
 	void drawPixel(int x, int y, const Color& color);
 	void drawLine(int x0, int y0, int x1, int y1, const Color& color);
 	Image* resize(int width, int height);
+	void touch();
 
 	SDL_Surface *surface;
 
+	// identifies the current pixels of surface. It changes whenever the image is drawn to
+	unsigned long serial;
+
 private:
 	Uint32 MapRGBA(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+
+	static unsigned long next_serial;
 };
 
 class SDLSoftwareRenderDevice : public RenderDevice {
@@ -83,15 +89,72 @@ public:
 	unsigned short getRefreshRate();
 
 	Image* loadImage(const std::string& filename, int error_type);
+	void prefetchImage(const std::string& filename);
+
+	void beginWorldLayer(const Point& origin);
+	void endWorldLayer();
 
 protected:
 	int createContextInternal();
 	void createContextError();
 
 private:
+	/**
+	 * In dirty rectangle mode, draws are recorded during the frame and composited in commitFrame().
+	 * A command that matches one of the previous frame (in the same order) does not need to be drawn again,
+	 * unless it overlaps a part of the screen that changed.
+	 */
+	class DrawCommand {
+	public:
+		enum {
+			TYPE_IMAGE = 0,
+			TYPE_PIXEL = 1,
+			TYPE_LINE = 2
+		};
+
+		uint8_t type;
+		SDLSoftwareImage *image;
+		unsigned long serial;
+		SDL_Rect src;
+		SDL_Rect dest; // for TYPE_PIXEL and TYPE_LINE, the end points are (x, y) and (w, h)
+		uint8_t blend_mode; // one of Renderable::BLEND_*
+		Color color_mod;
+		uint8_t alpha_mod;
+		Point origin; // world layer origin, or (0, 0) for screen space commands
+		bool world;
+		SDL_Rect bounds; // the part of the screen this command draws to
+		uint32_t hash;
+
+		DrawCommand();
+		void updateHash();
+		bool matches(const DrawCommand& other) const;
+
+	private:
+		static const int KEY_SIZE = 14;
+		void getKey(int *key) const;
+	};
+
+	static const int DIRTY_TILE_SIZE = 32;
+	static const int MAX_MATCH_SKIP = 256;
+
 	Uint32 MapRGBA(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
 	void getWindowSize(short unsigned *screen_w, short unsigned *screen_h);
 
+	bool clipBlit(SDL_Surface *surface, SDL_Rect& src, SDL_Rect& dest);
+	int blitImage(SDL_Surface *surface, const SDL_Rect& src, const SDL_Rect& dest, uint8_t blend_mode, const Color& color_mod, uint8_t alpha_mod);
+	void putPixel(int x, int y, Uint32 pixel);
+	void plotLine(int x0, int y0, int x1, int y1, Uint32 pixel);
+
+	void recordImage(SDLSoftwareImage *image, const SDL_Rect& src, const SDL_Rect& dest, uint8_t blend_mode, const Color& color_mod, uint8_t alpha_mod);
+	void recordPrimitive(uint8_t type, int x0, int y0, int x1, int y1, const Color& color);
+	void releaseCommands(std::vector<DrawCommand>& _commands);
+	void drawCommand(const DrawCommand& cmd);
+	bool composeFrame();
+	void matchCommands(const Point& scroll);
+	void scrollScreen(const Point& scroll);
+	void markDirty(const SDL_Rect& r);
+	void getDirtyRects(std::vector<SDL_Rect>& rects);
+
 	SDL_Surface* screen;
 	SDL_Window* window;
 	SDL_Renderer* renderer;
@@ -100,6 +163,21 @@ private:
 	char* title;
 	uint32_t background_color;
 
+	bool dirty_rects;
+	bool redraw_all;
+	bool frame_blanked;
+	bool in_world_layer;
+	bool has_world_origin;
+	bool prev_has_world_origin;
+	Point world_origin;
+	Point prev_world_origin;
+	std::vector<DrawCommand> commands;
+	std::vector<DrawCommand> prev_commands;
+	std::vector<unsigned char> dirty_tiles;
+	Point dirty_grid;
+	int dirty_count;
+	std::vector<SDL_Rect> update_rects;
+
 	/* Stores the system gamma levels so they can be restored later */
 	uint16_t gamma_r[256];
 	uint16_t gamma_g[256];
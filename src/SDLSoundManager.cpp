@@ -171,7 +171,7 @@ SoundID SDLSoundManager::load(const std::string& filename, const std::string& er
 	}
 
 	/* load non existing sound */
-	lsnd.chunk = Mix_LoadWAV(realfilename.c_str());
+	lsnd.chunk = Mix_LoadWAV_RW(mods->openRW(realfilename), 1);
 	lsnd.refCnt = 1;
 	if (!lsnd.chunk) {
 		Utils::logError("SoundManager: %s: Loading sound %s (%s) failed: %s", errormessage.c_str(),
@@ -319,7 +319,7 @@ void SDLSoundManager::loadMusic(const std::string& filename) {
 	if (filename == "")
 		return;
 
-	music = Mix_LoadMUS(mods->locate(filename).c_str());
+	music = Mix_LoadMUS_RW(mods->openRW(mods->locate(filename)), 1);
 	if (music) {
 		music_filename = filename;
 		playMusic();
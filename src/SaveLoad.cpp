@@ -68,6 +68,13 @@ SaveLoad::SaveLoad()
 SaveLoad::~SaveLoad() {
 }
 
+/**
+ * Block until all queued save files are on the disk
+ */
+void SaveLoad::flushSaves() {
+	save_writer.flush();
+}
+
 /**
  * Before exiting the game, save to file
  */
@@ -82,140 +89,132 @@ void SaveLoad::saveGame() {
 	menu->inv->inventory[MenuInventory::EQUIPMENT].clean();
 	menu->inv->inventory[MenuInventory::CARRIED].clean();
 
-	std::ofstream outfile;
-
 	std::stringstream ss;
 	ss << settings->path_user << "saves/" << eset->misc.save_prefix << "/" << game_slot << "/avatar.txt";
 
-	outfile.open(Filesystem::convertSlashes(ss.str()).c_str(), std::ios::out);
+	// the file contents are built here and written to disk by save_writer on its own thread
+	std::stringstream outfile;
 
-	if (outfile.is_open()) {
+	// comment
+	outfile << "## flare-engine save file ##" << "\n";
 
-		// comment
-		outfile << "## flare-engine save file ##" << "\n";
-
-		// hero name
-		outfile << "name=" << pc->stats.name << "\n";
+	// hero name
+	outfile << "name=" << pc->stats.name << "\n";
 
-		// permadeath
-		outfile << "permadeath=" << pc->stats.permadeath << "\n";
+	// permadeath
+	outfile << "permadeath=" << pc->stats.permadeath << "\n";
 
-		// hero visual option
-		outfile << "option=" << pc->stats.gfx_base << "," << pc->stats.gfx_head << "," << pc->stats.gfx_portrait << "\n";
+	// hero visual option
+	outfile << "option=" << pc->stats.gfx_base << "," << pc->stats.gfx_head << "," << pc->stats.gfx_portrait << "\n";
 
-		// hero class
-		outfile << "class=" << pc->stats.character_class << "," << pc->stats.character_subclass << "\n";
+	// hero class
+	outfile << "class=" << pc->stats.character_class << "," << pc->stats.character_subclass << "\n";
 
-		// current experience
-		outfile << "xp=" << pc->stats.xp << "\n";
+	// current experience
+	outfile << "xp=" << pc->stats.xp << "\n";
 
-		// hp and mp
-		if (eset->misc.save_hpmp) outfile << "hpmp=" << pc->stats.hp << "," << pc->stats.mp << "\n";
+	// hp and mp
+	if (eset->misc.save_hpmp) outfile << "hpmp=" << pc->stats.hp << "," << pc->stats.mp << "\n";
 
-		// stat spec
-		outfile << "build=";
-		for (size_t i = 0; i < eset->primary_stats.list.size(); ++i) {
-			outfile << pc->stats.primary[i];
-			if (i < eset->primary_stats.list.size() - 1)
-				outfile << ",";
+	// stat spec
+	outfile << "build=";
+	for (size_t i = 0; i < eset->primary_stats.list.size(); ++i) {
+		outfile << pc->stats.primary[i];
+		if (i < eset->primary_stats.list.size() - 1)
+			outfile << ",";
+	}
+	outfile << "\n";
+
+	// equipped gear
+	outfile << "equipped_quantity=" << menu->inv->inventory[MenuInventory::EQUIPMENT].getQuantities() << "\n";
+	outfile << "equipped=" << menu->inv->inventory[MenuInventory::EQUIPMENT].getItems() << "\n";
+
+	// active equipped set
+	outfile << "active_equipment_set=" << menu->inv->active_equipment_set << "\n";
+
+	// carried items
+	outfile << "carried_quantity=" << menu->inv->inventory[MenuInventory::CARRIED].getQuantities() << "\n";
+	outfile << "carried=" << menu->inv->inventory[MenuInventory::CARRIED].getItems() << "\n";
+
+	// spawn point
+	outfile << "spawn=" << mapr->respawn_map << "," << static_cast<int>(mapr->respawn_point.x) << "," << static_cast<int>(mapr->respawn_point.y) << "\n";
+
+	// action bar
+	// NOTE we need to reset any bonus-modified powers in the action bar before writing
+	// we use menu->pow->setUnlockedPowers() after to restore the action bar state
+	menu->pow->clearActionBarBonusLevels();
+	outfile << "actionbar=";
+	for (unsigned i = 0; i < static_cast<unsigned>(MenuActionBar::SLOT_MAX); i++) {
+		if (i < menu->act->slots_count)
+		{
+			if (pc->stats.transformed) outfile << menu->act->hotkeys_temp[i];
+			else outfile << menu->act->hotkeys[i];
 		}
-		outfile << "\n";
-
-		// equipped gear
-		outfile << "equipped_quantity=" << menu->inv->inventory[MenuInventory::EQUIPMENT].getQuantities() << "\n";
-		outfile << "equipped=" << menu->inv->inventory[MenuInventory::EQUIPMENT].getItems() << "\n";
-
-		// active equipped set
-		outfile << "active_equipment_set=" << menu->inv->active_equipment_set << "\n";
-
-		// carried items
-		outfile << "carried_quantity=" << menu->inv->inventory[MenuInventory::CARRIED].getQuantities() << "\n";
-		outfile << "carried=" << menu->inv->inventory[MenuInventory::CARRIED].getItems() << "\n";
-
-		// spawn point
-		outfile << "spawn=" << mapr->respawn_map << "," << static_cast<int>(mapr->respawn_point.x) << "," << static_cast<int>(mapr->respawn_point.y) << "\n";
-
-		// action bar
-		// NOTE we need to reset any bonus-modified powers in the action bar before writing
-		// we use menu->pow->setUnlockedPowers() after to restore the action bar state
-		menu->pow->clearActionBarBonusLevels();
-		outfile << "actionbar=";
-		for (unsigned i = 0; i < static_cast<unsigned>(MenuActionBar::SLOT_MAX); i++) {
-			if (i < menu->act->slots_count)
-			{
-				if (pc->stats.transformed) outfile << menu->act->hotkeys_temp[i];
-				else outfile << menu->act->hotkeys[i];
-			}
-			else
-			{
-				outfile << 0;
-			}
-			if (i < MenuActionBar::SLOT_MAX - 1) outfile << ",";
+		else
+		{
+			outfile << 0;
 		}
-		outfile << "\n";
-		menu->pow->setUnlockedPowers();
+		if (i < MenuActionBar::SLOT_MAX - 1) outfile << ",";
+	}
+	outfile << "\n";
+	menu->pow->setUnlockedPowers();
 
-		//shapeshifter value
-		if (pc->stats.transform_type == "untransform" || pc->stats.transform_duration != -1) outfile << "transformed=" << "\n";
-		else outfile << "transformed=" << pc->stats.transform_type << "," << pc->stats.manual_untransform << "\n";
+	//shapeshifter value
+	if (pc->stats.transform_type == "untransform" || pc->stats.transform_duration != -1) outfile << "transformed=" << "\n";
+	else outfile << "transformed=" << pc->stats.transform_type << "," << pc->stats.manual_untransform << "\n";
 
-		// restore hero powers
-		if (pc->stats.transformed && pc->hero_stats) {
-			pc->stats.powers_list = pc->hero_stats->powers_list;
-		}
+	// restore hero powers
+	if (pc->stats.transformed && pc->hero_stats) {
+		pc->stats.powers_list = pc->hero_stats->powers_list;
+	}
 
-		// enabled powers
-		outfile << "powers=";
-		for (unsigned int i=0; i<pc->stats.powers_list.size(); i++) {
-			if (i < pc->stats.powers_list.size()-1) {
-				if (pc->stats.powers_list[i] > 0)
-					outfile << pc->stats.powers_list[i] << ",";
-			}
-			else {
-				if (pc->stats.powers_list[i] > 0)
-					outfile << pc->stats.powers_list[i];
-			}
+	// enabled powers
+	outfile << "powers=";
+	for (unsigned int i=0; i<pc->stats.powers_list.size(); i++) {
+		if (i < pc->stats.powers_list.size()-1) {
+			if (pc->stats.powers_list[i] > 0)
+				outfile << pc->stats.powers_list[i] << ",";
 		}
-		outfile << "\n";
-
-		// restore transformed powers
-		if (pc->stats.transformed && pc->charmed_stats) {
-			pc->stats.powers_list = pc->charmed_stats->powers_list;
+		else {
+			if (pc->stats.powers_list[i] > 0)
+				outfile << pc->stats.powers_list[i];
 		}
+	}
+	outfile << "\n";
 
-		// campaign data
-		outfile << "campaign=" << camp->getAll() << "\n";
+	// restore transformed powers
+	if (pc->stats.transformed && pc->charmed_stats) {
+		pc->stats.powers_list = pc->charmed_stats->powers_list;
+	}
 
-		outfile << "time_played=" << pc->time_played << "\n";
+	// campaign data
+	outfile << "campaign=" << camp->getAll() << "\n";
 
-		// save the engine version for troubleshooting purposes
-		outfile << "engine_version=" << VersionInfo::ENGINE.getString() << "\n";
+	outfile << "time_played=" << pc->time_played << "\n";
 
-		// save the vendor buyback
-		if (eset->misc.save_buyback) {
-			std::map<std::string, ItemStorage>::iterator it;
+	// save the engine version for troubleshooting purposes
+	outfile << "engine_version=" << VersionInfo::ENGINE.getString() << "\n";
 
-			for (it = menu->vendor->buyback_stock.begin(); it != menu->vendor->buyback_stock.end(); ++it) {
-				if (it->second.empty())
-					continue;
+	// save the vendor buyback
+	if (eset->misc.save_buyback) {
+		std::map<std::string, ItemStorage>::iterator it;
 
-				outfile << "buyback_item=" << it->first << ";" << it->second.getItems() << "\n";
-				outfile << "buyback_quantity=" << it->first << ";" << it->second.getQuantities() << "\n";
-			}
-		}
+		for (it = menu->vendor->buyback_stock.begin(); it != menu->vendor->buyback_stock.end(); ++it) {
+			if (it->second.empty())
+				continue;
 
-		outfile << "questlog_dismissed=" << !menu->act->requires_attention[MenuActionBar::MENU_LOG] << "\n";
+			outfile << "buyback_item=" << it->first << ";" << it->second.getItems() << "\n";
+			outfile << "buyback_quantity=" << it->first << ";" << it->second.getQuantities() << "\n";
+		}
+	}
 
-		outfile << "stash_tab=" << menu->stash->getTab();
+	outfile << "questlog_dismissed=" << !menu->act->requires_attention[MenuActionBar::MENU_LOG] << "\n";
 
-		outfile << std::endl;
+	outfile << "stash_tab=" << menu->stash->getTab();
 
-		if (outfile.bad()) Utils::logError("SaveLoad: Unable to save the game. No write access or disk is full!");
-		outfile.close();
-		outfile.clear();
+	outfile << std::endl;
 
-		platform.FSCommit();
-	}
+	save_writer.write(ss.str(), outfile.str());
 
 	// Save stashes
 	for (size_t i = 0; i < menu->stash->tabs.size(); ++i) {
@@ -228,24 +227,18 @@ void SaveLoad::saveGame() {
 		if (menu->stash->tabs[i].is_private)
 			ss << "/" << game_slot;
 		ss << "/" << menu->stash->tabs[i].filename;
-		outfile.open(Filesystem::convertSlashes(ss.str()).c_str(), std::ios::out);
-
-		if (outfile.is_open()) {
 
-			// comment
-			outfile << "# flare-engine stash file: \"" << menu->stash->tabs[i].id << "\"\n";
+		outfile.str("");
 
-			outfile << "quantity=" << menu->stash->tabs[i].stock.getQuantities() << "\n";
-			outfile << "item=" << menu->stash->tabs[i].stock.getItems() << "\n";
+		// comment
+		outfile << "# flare-engine stash file: \"" << menu->stash->tabs[i].id << "\"\n";
 
-			outfile << std::endl;
+		outfile << "quantity=" << menu->stash->tabs[i].stock.getQuantities() << "\n";
+		outfile << "item=" << menu->stash->tabs[i].stock.getItems() << "\n";
 
-			if (outfile.bad()) Utils::logError("SaveLoad: Unable to save stash. No write access or disk is full!");
-			outfile.close();
-			outfile.clear();
+		outfile << std::endl;
 
-			platform.FSCommit();
-		}
+		save_writer.write(ss.str(), outfile.str());
 	}
 
 	// Save fow dark layer
@@ -253,36 +246,32 @@ void SaveLoad::saveGame() {
 		ss.str("");
 		ss << settings->path_user << "saves/" << eset->misc.save_prefix << "/" << game_slot << "/fow/" << Utils::hashString(mapr->getFilename()) << ".txt";
 
-		outfile.open(Filesystem::convertSlashes(ss.str()).c_str(), std::ios::out);
-
-		if (outfile.is_open()) {
-			outfile << "# " << mapr->getFilename() << std::endl;
-			outfile << "[layer]" << std::endl;
-			outfile << "type=" << mapr->layernames[fow->dark_layer_id] << std::endl;
-			outfile << "data=" << std::endl;
-
-			std::string layer = "";
-			for (int line = 0; line < mapr->h; line++) {
-				std::stringstream map_row;
-				for (int tile = 0; tile < mapr->w; tile++) {
-					unsigned short val = mapr->layers[fow->dark_layer_id][tile][line];
-					map_row << val << ",";
-				}
-				layer += map_row.str();
-				layer += '\n';
+		outfile.str("");
+		outfile << "# " << mapr->getFilename() << std::endl;
+		outfile << "[layer]" << std::endl;
+		outfile << "type=" << mapr->layernames[fow->dark_layer_id] << std::endl;
+		outfile << "data=" << std::endl;
+
+		std::string layer = "";
+		for (int line = 0; line < mapr->h; line++) {
+			std::stringstream map_row;
+			for (int tile = 0; tile < mapr->w; tile++) {
+				unsigned short val = mapr->layers[fow->dark_layer_id].get(tile, line);
+				map_row << val << ",";
 			}
-			layer.erase(layer.end()-2, layer.end());
+			layer += map_row.str();
 			layer += '\n';
-			outfile << layer << std::endl;
-
-			if (outfile.bad()) Utils::logError("SaveLoad: Unable to save map data. No write access or disk is full!");
-			outfile.close();
-			outfile.clear();
-
-			platform.FSCommit();
 		}
+		layer.erase(layer.end()-2, layer.end());
+		layer += '\n';
+		outfile << layer << std::endl;
+
+		save_writer.write(ss.str(), outfile.str());
 	}
 
+	// without a writer thread (e.g. Emscripten), the files have already been written at this point
+	platform.FSCommit();
+
 	settings->prev_save_slot = game_slot-1;
 
 	// display a log message saying that we saved the game
@@ -296,6 +285,9 @@ void SaveLoad::saveGame() {
 void SaveLoad::loadGame() {
 	if (game_slot <= 0) return;
 
+	// make sure we don't read a save that is still being written
+	save_writer.flush();
+
 	float saved_hp = 0;
 	float saved_mp = 0;
 	int currency = 0;
@@ -359,7 +351,7 @@ void SaveLoad::loadGame() {
 			}
 			else if (infile.key == "spawn") {
 				mapr->teleport_mapname = Parse::popFirstString(infile.val);
-				if (mapr->teleport_mapname != "" && Filesystem::fileExists(mods->locate(mapr->teleport_mapname))) {
+				if (mapr->teleport_mapname != "" && !mods->locate(mapr->teleport_mapname).empty()) {
 					mapr->teleport_destination.x = static_cast<float>(Parse::popFirstInt(infile.val)) + 0.5f;
 					mapr->teleport_destination.y = static_cast<float>(Parse::popFirstInt(infile.val)) + 0.5f;
 					mapr->teleportation = true;
@@ -25,6 +25,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #ifndef SAVELOAD_H
 #define SAVELOAD_H
 
+#include "SaveWriter.h"
+
 class SaveLoad {
 public:
 	SaveLoad();
@@ -41,12 +43,15 @@ public:
 	void loadGame();
 	void loadClass(int index);
 	void loadStash();
+	void flushSaves();
 
 private:
 	void applyPlayerData();
 	void loadPowerTree();
 
 	int game_slot;
+
+	SaveWriter save_writer;
 };
 
 #endif
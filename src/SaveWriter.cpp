@@ -0,0 +1,131 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "SaveWriter.h"
+#include "Utils.h"
+#include "UtilsFileSystem.h"
+
+SaveWriter::SaveWriter()
+	: thread(NULL)
+	, mutex(SDL_CreateMutex())
+	, cond(SDL_CreateCond())
+	, busy(false)
+	, quit(false)
+{
+}
+
+SaveWriter::~SaveWriter() {
+	if (thread) {
+		SDL_LockMutex(mutex);
+		quit = true;
+		SDL_CondBroadcast(cond);
+		SDL_UnlockMutex(mutex);
+
+		// the thread finishes the remaining jobs before quitting
+		SDL_WaitThread(thread, NULL);
+	}
+
+	SDL_DestroyCond(cond);
+	SDL_DestroyMutex(mutex);
+}
+
+void SaveWriter::write(const std::string& filename, const std::string& data) {
+	// the thread is started with the first save
+	if (!thread) {
+		thread = SDL_CreateThread(threadFunction, "SaveWriter", this);
+		if (!thread) {
+			Utils::logError("SaveWriter: Could not create thread, saving on the main thread: %s", SDL_GetError());
+
+			Job job;
+			job.filename = filename;
+			job.data = data;
+			writeJob(job);
+			return;
+		}
+	}
+
+	SDL_LockMutex(mutex);
+
+	bool queued = false;
+	for (size_t i = 0; i < jobs.size(); ++i) {
+		if (jobs[i].filename == filename) {
+			jobs[i].data = data;
+			queued = true;
+			break;
+		}
+	}
+
+	if (!queued) {
+		jobs.push_back(Job());
+		jobs.back().filename = filename;
+		jobs.back().data = data;
+	}
+
+	SDL_CondBroadcast(cond);
+	SDL_UnlockMutex(mutex);
+}
+
+void SaveWriter::flush() {
+	if (!thread)
+		return;
+
+	SDL_LockMutex(mutex);
+	while (busy || !jobs.empty()) {
+		SDL_CondWait(cond, mutex);
+	}
+	SDL_UnlockMutex(mutex);
+}
+
+int SaveWriter::threadFunction(void* data) {
+	static_cast<SaveWriter*>(data)->run();
+	return 0;
+}
+
+void SaveWriter::run() {
+	SDL_LockMutex(mutex);
+
+	while (true) {
+		while (jobs.empty() && !quit) {
+			SDL_CondWait(cond, mutex);
+		}
+
+		if (jobs.empty())
+			break;
+
+		Job job;
+		job.filename.swap(jobs.front().filename);
+		job.data.swap(jobs.front().data);
+		jobs.pop_front();
+		busy = true;
+
+		// write without holding the lock, so the game can keep queuing files
+		SDL_UnlockMutex(mutex);
+		writeJob(job);
+		SDL_LockMutex(mutex);
+
+		busy = false;
+		SDL_CondBroadcast(cond);
+	}
+
+	SDL_UnlockMutex(mutex);
+}
+
+void SaveWriter::writeJob(const Job& job) {
+	if (!Filesystem::writeFileAtomic(job.filename, job.data)) {
+		Utils::logError("SaveWriter: Unable to write '%s'. No write access or disk is full!", job.filename.c_str());
+	}
+}
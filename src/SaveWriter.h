@@ -0,0 +1,66 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class SaveWriter
+ *
+ * Writes save files on a background thread, so that saving doesn't stall the game on slow storage.
+ * The caller builds the complete file contents in memory and hands them over with write().
+ * Each file is written with Filesystem::writeFileAtomic(), so a crash during a save never leaves a truncated file behind.
+ *
+ * Files are written in the order they were queued. If a file is queued again before it was written,
+ * only the newest contents are written.
+ */
+
+#ifndef SAVE_WRITER_H
+#define SAVE_WRITER_H
+
+#include "CommonIncludes.h"
+
+#include <deque>
+
+class SaveWriter {
+public:
+	SaveWriter();
+	~SaveWriter();
+
+	void write(const std::string& filename, const std::string& data);
+
+	// blocks until all queued files have been written
+	void flush();
+
+private:
+	class Job {
+	public:
+		std::string filename;
+		std::string data;
+	};
+
+	static int threadFunction(void* data);
+	void run();
+	void writeJob(const Job& job);
+
+	std::deque<Job> jobs;
+
+	SDL_Thread* thread;
+	SDL_mutex* mutex;
+	SDL_cond* cond;
+	bool busy;
+	bool quit;
+};
+
+#endif
@@ -36,6 +36,7 @@ Created and destroyed by main.cpp
 #include "InputState.h"
 #include "MessageEngine.h"
 #include "ModManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "SaveLoad.h"
 #include "Settings.h"
@@ -52,6 +53,7 @@ IconManager *icons = NULL;
 InputState *inpt = NULL;
 MessageEngine *msg = NULL;
 ModManager *mods = NULL;
+Profiler *profiler = NULL;
 RenderDevice *render_device = NULL;
 SaveLoad *save_load = NULL;
 Settings *settings = NULL;
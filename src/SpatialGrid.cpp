@@ -0,0 +1,183 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "SpatialGrid.h"
+
+#include <algorithm>
+
+SpatialGrid::Entry::Entry(int _id, const FPoint& _pos)
+	: id(_id)
+	, pos(_pos)
+{
+}
+
+SpatialGrid::SpatialGrid()
+	: cell_size(DEFAULT_CELL_SIZE)
+	, grid_size(1, 1)
+	, count(0)
+{
+	cells.resize(1);
+}
+
+SpatialGrid::~SpatialGrid() {
+}
+
+void SpatialGrid::init(int map_w, int map_h, int _cell_size) {
+	cell_size = std::max(1, _cell_size);
+	grid_size.x = std::max(1, (map_w + cell_size - 1) / cell_size);
+	grid_size.y = std::max(1, (map_h + cell_size - 1) / cell_size);
+
+	cells.clear();
+	cells.resize(grid_size.x * grid_size.y);
+	count = 0;
+}
+
+/**
+ * Empty every cell, but keep the memory around for the next rebuild
+ */
+void SpatialGrid::clear() {
+	if (count == 0)
+		return;
+
+	for (size_t i = 0; i < cells.size(); ++i) {
+		cells[i].clear();
+	}
+	count = 0;
+}
+
+void SpatialGrid::add(int id, const FPoint& pos) {
+	cells[getCellX(pos.x) + getCellY(pos.y) * grid_size.x].push_back(Entry(id, pos));
+	count++;
+}
+
+int SpatialGrid::getCellX(float x) const {
+	int cx = static_cast<int>(x) / cell_size;
+	if (x < 0) cx = 0;
+	return std::min(cx, grid_size.x - 1);
+}
+
+int SpatialGrid::getCellY(float y) const {
+	int cy = static_cast<int>(y) / cell_size;
+	if (y < 0) cy = 0;
+	return std::min(cy, grid_size.y - 1);
+}
+
+void SpatialGrid::addCell(int cx, int cy, std::vector<int>& result) const {
+	const std::vector<Entry>& cell = cells[cx + cy * grid_size.x];
+	for (size_t i = 0; i < cell.size(); ++i) {
+		result.push_back(cell[i].id);
+	}
+}
+
+/**
+ * Get the ids of all objects with top_left <= position <= bottom_right
+ */
+void SpatialGrid::queryRect(const FPoint& top_left, const FPoint& bottom_right, std::vector<int>& result) const {
+	result.clear();
+
+	if (count == 0)
+		return;
+
+	const int x1 = getCellX(top_left.x);
+	const int y1 = getCellY(top_left.y);
+	const int x2 = getCellX(bottom_right.x);
+	const int y2 = getCellY(bottom_right.y);
+
+	for (int cy = y1; cy <= y2; ++cy) {
+		for (int cx = x1; cx <= x2; ++cx) {
+			const std::vector<Entry>& cell = cells[cx + cy * grid_size.x];
+			for (size_t i = 0; i < cell.size(); ++i) {
+				const FPoint& pos = cell[i].pos;
+				if (pos.x >= top_left.x && pos.x <= bottom_right.x && pos.y >= top_left.y && pos.y <= bottom_right.y)
+					result.push_back(cell[i].id);
+			}
+		}
+	}
+
+	std::sort(result.begin(), result.end());
+}
+
+/**
+ * Get the ids of all objects that pass Utils::isWithinRadius()
+ */
+void SpatialGrid::queryRadius(const FPoint& center, float radius, std::vector<int>& result) const {
+	result.clear();
+
+	if (count == 0)
+		return;
+
+	const int x1 = getCellX(center.x - radius);
+	const int y1 = getCellY(center.y - radius);
+	const int x2 = getCellX(center.x + radius);
+	const int y2 = getCellY(center.y + radius);
+
+	for (int cy = y1; cy <= y2; ++cy) {
+		for (int cx = x1; cx <= x2; ++cx) {
+			const std::vector<Entry>& cell = cells[cx + cy * grid_size.x];
+			for (size_t i = 0; i < cell.size(); ++i) {
+				if (Utils::isWithinRadius(center, radius, cell[i].pos))
+					result.push_back(cell[i].id);
+			}
+		}
+	}
+
+	std::sort(result.begin(), result.end());
+}
+
+/**
+ * Appends the objects of one ring of cells around center to result (unsorted)
+ * Returns false once the ring lies completely outside of the grid
+ */
+bool SpatialGrid::queryRing(const FPoint& center, int ring, std::vector<int>& result) const {
+	const int cx = getCellX(center.x);
+	const int cy = getCellY(center.y);
+
+	if (cx - ring < 0 && cy - ring < 0 && cx + ring >= grid_size.x && cy + ring >= grid_size.y)
+		return false;
+
+	if (ring == 0) {
+		addCell(cx, cy, result);
+		return true;
+	}
+
+	for (int x = cx - ring; x <= cx + ring; ++x) {
+		if (x < 0 || x >= grid_size.x)
+			continue;
+		if (cy - ring >= 0)
+			addCell(x, cy - ring, result);
+		if (cy + ring < grid_size.y)
+			addCell(x, cy + ring, result);
+	}
+	for (int y = cy - ring + 1; y <= cy + ring - 1; ++y) {
+		if (y < 0 || y >= grid_size.y)
+			continue;
+		if (cx - ring >= 0)
+			addCell(cx - ring, y, result);
+		if (cx + ring < grid_size.x)
+			addCell(cx + ring, y, result);
+	}
+
+	return true;
+}
+
+float SpatialGrid::getRingDistance(int ring) const {
+	return static_cast<float>(ring * cell_size);
+}
+
+bool SpatialGrid::isEmpty() const {
+	return count == 0;
+}
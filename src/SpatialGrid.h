@@ -0,0 +1,73 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class SpatialGrid
+ *
+ * A uniform grid of map-space buckets used to find objects near a position without looking at every object.
+ * Objects are stored as integer ids (usually an index into the owner's list) together with their position.
+ * Query results are always sorted by id, so callers see objects in the same order as a plain loop over their list.
+ */
+
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <vector>
+
+#include "Utils.h"
+
+class SpatialGrid {
+public:
+	static const int DEFAULT_CELL_SIZE = 4;
+
+	SpatialGrid();
+	~SpatialGrid();
+
+	// sets the area covered by the grid. Positions outside of it are stored in the nearest edge cell
+	void init(int map_w, int map_h, int _cell_size = DEFAULT_CELL_SIZE);
+	void clear();
+	void add(int id, const FPoint& pos);
+
+	void queryRect(const FPoint& top_left, const FPoint& bottom_right, std::vector<int>& result) const;
+	void queryRadius(const FPoint& center, float radius, std::vector<int>& result) const;
+
+	// objects in the cells exactly 'ring' cells away (in either direction) from the cell containing center
+	// nothing in ring n+1 or beyond is closer than getRingDistance(n)
+	bool queryRing(const FPoint& center, int ring, std::vector<int>& result) const;
+	float getRingDistance(int ring) const;
+
+	bool isEmpty() const;
+
+private:
+	class Entry {
+	public:
+		int id;
+		FPoint pos;
+		Entry(int _id, const FPoint& _pos);
+	};
+
+	int getCellX(float x) const;
+	int getCellY(float y) const;
+	void addCell(int cx, int cy, std::vector<int>& result) const;
+
+	int cell_size;
+	Point grid_size;
+	size_t count;
+	std::vector< std::vector<Entry> > cells;
+};
+
+#endif
@@ -40,6 +40,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "MessageEngine.h"
 #include "ModManager.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "Settings.h"
 #include "SharedGameResources.h"
 #include "SharedResources.h"
@@ -77,6 +78,7 @@ StatBlock::StatBlock()
 	, permadeath(false)
 	, transformed(false)
 	, refresh_stats(false)
+	, stats_dirty(true)
 	, converted(false)
 	, summoned(false)
 	, summoned_power_index(0)
@@ -553,13 +555,32 @@ bool StatBlock::isNPCStat(FileParser *infile) {
 	return false;
 }
 
+/**
+ * Only reads the "animations" key of an enemy definition. This doesn't touch any game state, so it is safe to call from a loading thread.
+ */
+std::string StatBlock::getAnimationsFilename(const std::string& filename) {
+	std::string animations_filename;
+
+	FileParser infile;
+	if (!infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NONE))
+		return animations_filename;
+
+	while (infile.next()) {
+		if (infile.key == "animations")
+			animations_filename = infile.val;
+	}
+	infile.close();
+
+	return animations_filename;
+}
+
 /**
  * load a statblock, typically for an enemy definition
  */
 void StatBlock::load(const std::string& filename) {
 	// @CLASS StatBlock: Enemies|Description of enemies in enemies/
 	FileParser infile;
-	if (!infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+	if (!infile.openCompiled(filename, FileParser::ERROR_NORMAL))
 		return;
 
 	bool clear_loot = true;
@@ -898,6 +919,12 @@ void StatBlock::calcBase() {
  * Recalc derived stats from base stats + effect bonuses
  */
 void StatBlock::applyEffects() {
+	// effects may have been added or removed since EffectManager::logic() last ran
+	effects.updateStatus();
+
+	stats_dirty = false;
+	effects.bonus_changed = false;
+
 	// preserve hp/mp states
 	// max HP and MP can't drop below 1
 	prev_maxhp = std::max(get(Stats::HP_MAX), 1.0f);
@@ -956,10 +983,27 @@ void StatBlock::logic() {
 	}
 
 	// handle effect timers
-	effects.logic();
+	{
+		PROFILE_SCOPE(Profiler::SECTION_EFFECTS);
+		effects.logic();
+	}
 
 	// apply bonuses from items/effects to base stats
-	applyEffects();
+	// derived stats only change when effects or equipment do, so skip the full recalculation otherwise
+	if (stats_dirty || effects.bonus_changed) {
+		applyEffects();
+	}
+	else {
+		prev_maxhp = get(Stats::HP_MAX);
+		prev_maxmp = get(Stats::MP_MAX);
+		prev_hp = hp;
+		prev_mp = mp;
+
+		if (hp > get(Stats::HP_MAX)) hp = get(Stats::HP_MAX);
+		if (mp > get(Stats::MP_MAX)) mp = get(Stats::MP_MAX);
+
+		speed = speed_default;
+	}
 
 	if (hero && effects.refresh_stats) {
 		refresh_stats = true;
@@ -977,9 +1021,8 @@ void StatBlock::logic() {
 	// handle cooldowns
 	cooldown.tick(); // global cooldown
 
-	for (size_t i=0; i<powers_ai.size(); ++i) { // NPC/enemy powerslot cooldown
-		powers_ai[i].cooldown.tick();
-	}
+	// NPC/enemy powerslot cooldowns
+	powers_ai_cooldowns.tick();
 
 	// HP regen
 	if (hp <= get(Stats::HP_MAX) && hp > 0) {
@@ -1308,7 +1351,7 @@ StatBlock::AIPower* StatBlock::getAIPower(int ai_type) {
 		if (chance > powers_ai[i].chance)
 			continue;
 
-		if (!powers_ai[i].cooldown.isEnd())
+		if (!powers_ai_cooldowns.isEnd(i))
 			continue;
 
 		if (powers->powers[powers_ai[i].id].type == Power::TYPE_SPAWN) {
@@ -1349,12 +1392,12 @@ bool StatBlock::checkRequiredSpawns(int req_amount) const {
 
 int StatBlock::getPowerCooldown(PowerID power_id) {
 	if (hero) {
-		return pc->power_cooldown_timers[power_id].getDuration();
+		return pc->power_cooldown_timers.getDuration(power_id);
 	}
 	else {
 		for (size_t i = 0; i < powers_ai.size(); ++i) {
 			if (power_id == powers_ai[i].id)
-				return powers_ai[i].cooldown.getDuration();
+				return powers_ai_cooldowns.getDuration(i);
 		}
 	}
 
@@ -1363,12 +1406,12 @@ int StatBlock::getPowerCooldown(PowerID power_id) {
 
 void StatBlock::setPowerCooldown(PowerID power_id, int power_cooldown) {
 	if (hero) {
-		pc->power_cooldown_timers[power_id].setDuration(power_cooldown);
+		pc->power_cooldown_timers.setDuration(power_id, power_cooldown);
 	}
 	else {
 		for (size_t i = 0; i < powers_ai.size(); ++i) {
 			if (power_id == powers_ai[i].id) {
-				powers_ai[i].cooldown.setDuration(power_cooldown);
+				powers_ai_cooldowns.setDuration(i, power_cooldown);
 				break;
 			}
 		}
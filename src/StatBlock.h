@@ -30,6 +30,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "EffectManager.h"
 #include "EventManager.h"
 #include "Stats.h"
+#include "TimerWheel.h"
 #include "Utils.h"
 
 class FileParser;
@@ -78,13 +79,11 @@ public:
 		int type;
 		PowerID id;
 		int chance;
-		Timer cooldown;
 
 		AIPower()
 			: type(AI_POWER_MELEE)
 			, id(0)
 			, chance(0)
-			, cooldown()
 		{}
 	};
 
@@ -101,6 +100,10 @@ public:
 	~StatBlock();
 
 	void load(const std::string& filename);
+
+	// the animation definition of an enemy, without loading the rest of it
+	static std::string getAnimationsFilename(const std::string& filename);
+
 	void takeDamage(float dmg, bool crit, int source_type);
 	void recalc();
 	void applyEffects();
@@ -133,6 +136,7 @@ public:
 	bool permadeath;
 	bool transformed;
 	bool refresh_stats;
+	bool stats_dirty; // derived stats need to be recalculated, e.g. after an equipment change
 	bool converted;
 	bool summoned;
 	PowerID summoned_power_index;
@@ -256,6 +260,7 @@ public:
 	std::vector<PowerID> powers_list_items;
 	std::vector<PowerID> powers_passive;
 	std::vector<AIPower> powers_ai;
+	TimerWheel powers_ai_cooldowns; // indexed like powers_ai
 
 	bool canUsePower(PowerID powerid, bool allow_passive) const;
 
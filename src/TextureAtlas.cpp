@@ -0,0 +1,144 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "TextureAtlas.h"
+
+TextureAtlas::Shelf::Shelf(int _y, int _h)
+	: y(_y)
+	, h(_h)
+	, used_w(0)
+{
+}
+
+TextureAtlas::Page::Page()
+	: used_h(0)
+	, image_count(0)
+{
+}
+
+TextureAtlas::TextureAtlas()
+	: page_size(0)
+{
+}
+
+TextureAtlas::~TextureAtlas() {
+}
+
+void TextureAtlas::init(int _page_size) {
+	clear();
+	page_size = std::max(_page_size, 0);
+}
+
+void TextureAtlas::clear() {
+	pages.clear();
+}
+
+bool TextureAtlas::accepts(int w, int h) const {
+	if (page_size == 0 || w <= 0 || h <= 0)
+		return false;
+
+	const int max_size = page_size / 2 - PADDING * 2;
+	return w <= max_size && h <= max_size;
+}
+
+/**
+ * Put the image on the lowest shelf it fits on without wasting much height, otherwise start a new shelf
+ */
+bool TextureAtlas::insertOnPage(Page& page, int w, int h, Point& pos) {
+	const int padded_w = w + PADDING * 2;
+	const int padded_h = h + PADDING * 2;
+
+	Shelf* best = NULL;
+	Shelf* best_wasteful = NULL;
+	for (size_t i = 0; i < page.shelves.size(); ++i) {
+		Shelf& shelf = page.shelves[i];
+		if (shelf.h < padded_h || shelf.used_w + padded_w > page_size)
+			continue;
+
+		// an image much shorter than the shelf would waste the space above it
+		if (padded_h < shelf.h / 2) {
+			if (!best_wasteful || shelf.h < best_wasteful->h)
+				best_wasteful = &shelf;
+			continue;
+		}
+
+		if (!best || shelf.h < best->h)
+			best = &shelf;
+	}
+
+	if (!best) {
+		if (page.used_h + padded_h <= page_size) {
+			page.shelves.push_back(Shelf(page.used_h, padded_h));
+			page.used_h += padded_h;
+			best = &page.shelves.back();
+		}
+		else if (best_wasteful) {
+			best = best_wasteful;
+		}
+		else {
+			return false;
+		}
+	}
+
+	pos.x = best->used_w + PADDING;
+	pos.y = best->y + PADDING;
+	best->used_w += padded_w;
+	page.image_count++;
+	return true;
+}
+
+int TextureAtlas::insert(int w, int h, Point& pos) {
+	if (!accepts(w, h))
+		return -1;
+
+	for (size_t i = 0; i < pages.size(); ++i) {
+		if (insertOnPage(pages[i], w, h, pos))
+			return static_cast<int>(i);
+	}
+
+	pages.push_back(Page());
+	if (insertOnPage(pages.back(), w, h, pos))
+		return static_cast<int>(pages.size() - 1);
+
+	pages.pop_back();
+	return -1;
+}
+
+bool TextureAtlas::release(int page) {
+	if (page < 0 || static_cast<size_t>(page) >= pages.size())
+		return false;
+
+	Page& p = pages[page];
+	if (p.image_count > 0)
+		p.image_count--;
+
+	if (p.image_count == 0) {
+		p.shelves.clear();
+		p.used_h = 0;
+		return true;
+	}
+
+	return false;
+}
+
+int TextureAtlas::getPageSize() const {
+	return page_size;
+}
+
+size_t TextureAtlas::getPageCount() const {
+	return pages.size();
+}
@@ -0,0 +1,83 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class TextureAtlas
+ *
+ * Packs rectangles into square pages, row by row ("shelves"). SDLHardwareRenderDevice uses it to put
+ * the images it loads (tile sheets, icons, animation sheets) into a few large textures, so drawing a scene
+ * switches between fewer textures. The atlas only does the book keeping, the textures belong to the render device.
+ *
+ * Space on a page is not reused when a single image is freed. Once every image on a page has been freed,
+ * the page is emptied and can be filled again.
+ */
+
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include "CommonIncludes.h"
+#include "Utils.h"
+
+class TextureAtlas {
+public:
+	// pixels kept around each image, so that texture filtering doesn't pick up the neighbouring images.
+	// the render device fills them with copies of the image's edge pixels
+	static const int PADDING = 1;
+
+	TextureAtlas();
+	~TextureAtlas();
+
+	// page_size of 0 disables the atlas
+	void init(int _page_size);
+	void clear();
+
+	// only images up to half the page size are packed, larger ones would leave little room for anything else
+	bool accepts(int w, int h) const;
+
+	// returns the page index, or -1 if there is no room. pos is the top left corner of the image on the page
+	int insert(int w, int h, Point& pos);
+
+	// returns true if this emptied the page
+	bool release(int page);
+
+	int getPageSize() const;
+	size_t getPageCount() const;
+
+private:
+	class Shelf {
+	public:
+		int y;
+		int h;
+		int used_w;
+		Shelf(int _y, int _h);
+	};
+
+	class Page {
+	public:
+		std::vector<Shelf> shelves;
+		int used_h;
+		int image_count;
+		Page();
+	};
+
+	bool insertOnPage(Page& page, int w, int h, Point& pos);
+
+	int page_size;
+	std::vector<Page> pages;
+};
+
+#endif
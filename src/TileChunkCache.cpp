@@ -0,0 +1,311 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "EngineSettings.h"
+#include "RenderDevice.h"
+#include "Settings.h"
+#include "SharedResources.h"
+#include "TileChunkCache.h"
+#include "TileSet.h"
+
+static int floorDiv(int a, int b) {
+	return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+static int ceilDiv(int a, int b) {
+	return -floorDiv(-a, b);
+}
+
+TileChunkCache::Chunk::Chunk()
+	: sprite(NULL)
+	, dirty(true)
+	, last_used(0)
+{
+}
+
+TileChunkCache::TileChunkCache()
+	: map_w(0)
+	, map_h(0)
+	, tile_set(NULL)
+	, layer_count(0)
+	, chunk_count(0)
+	, frame(0)
+	, target_generation(0)
+{
+}
+
+TileChunkCache::~TileChunkCache() {
+	clear();
+}
+
+void TileChunkCache::init(int _map_w, int _map_h, const TileSet* _tile_set) {
+	clear();
+
+	map_w = _map_w;
+	map_h = _map_h;
+	tile_set = _tile_set;
+
+	if (!tile_set || map_w <= 0 || map_h <= 0)
+		return;
+
+	chunk_size.x = CHUNK_TILES * eset->tileset.tile_w;
+	chunk_size.y = CHUNK_TILES * eset->tileset.tile_h;
+
+	// the area any tile can cover, relative to the center of its map position
+	Point bounds_min(0, 0);
+	Point bounds_max(0, 0);
+	for (size_t i = 0; i < tile_set->tiles.size(); ++i) {
+		const Tile_Def& tile = tile_set->tiles[i];
+		if (!tile.tile)
+			continue;
+
+		const Rect clip = tile.tile->getClip();
+		bounds_min.x = std::min(bounds_min.x, -tile.offset.x);
+		bounds_min.y = std::min(bounds_min.y, -tile.offset.y);
+		bounds_max.x = std::max(bounds_max.x, clip.w - tile.offset.x);
+		bounds_max.y = std::max(bounds_max.y, clip.h - tile.offset.y);
+	}
+	tile_bounds.x = bounds_min.x;
+	tile_bounds.y = bounds_min.y;
+	tile_bounds.w = bounds_max.x - bounds_min.x;
+	tile_bounds.h = bounds_max.y - bounds_min.y;
+
+	// pixel extent of the whole map
+	Point map_min;
+	Point map_max;
+	if (eset->tileset.orientation == eset->tileset.TILESET_ISOMETRIC) {
+		map_min.x = getTilePos(0, map_h - 1).x;
+		map_min.y = 0;
+		map_max.x = getTilePos(map_w - 1, 0).x;
+		map_max.y = getTilePos(map_w - 1, map_h - 1).y;
+	}
+	else {
+		map_max = getTilePos(map_w - 1, map_h - 1);
+	}
+
+	grid_pos.x = map_min.x + tile_bounds.x;
+	grid_pos.y = map_min.y + tile_bounds.y;
+	grid_size.x = std::max(1, ceilDiv(map_max.x + tile_bounds.x + tile_bounds.w - grid_pos.x, chunk_size.x));
+	grid_size.y = std::max(1, ceilDiv(map_max.y + tile_bounds.y + tile_bounds.h - grid_pos.y, chunk_size.y));
+
+	chunks.resize(grid_size.x * grid_size.y);
+}
+
+void TileChunkCache::clear() {
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		freeChunk(chunks[i]);
+	}
+	chunks.clear();
+	layer_count = 0;
+}
+
+void TileChunkCache::invalidateAll() {
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		chunks[i].dirty = true;
+	}
+}
+
+/**
+ * Flags every chunk that the tile at this map position can be drawn on
+ */
+void TileChunkCache::invalidateTile(int x, int y) {
+	if (chunks.empty())
+		return;
+
+	const Point pos = getTilePos(x, y);
+	const int left = pos.x + tile_bounds.x - grid_pos.x;
+	const int top = pos.y + tile_bounds.y - grid_pos.y;
+
+	const int cx1 = std::max(0, floorDiv(left, chunk_size.x));
+	const int cy1 = std::max(0, floorDiv(top, chunk_size.y));
+	const int cx2 = std::min(grid_size.x - 1, floorDiv(left + tile_bounds.w, chunk_size.x));
+	const int cy2 = std::min(grid_size.y - 1, floorDiv(top + tile_bounds.h, chunk_size.y));
+
+	for (int cy = cy1; cy <= cy2; ++cy) {
+		for (int cx = cx1; cx <= cx2; ++cx) {
+			chunks[cy * grid_size.x + cx].dirty = true;
+		}
+	}
+}
+
+void TileChunkCache::render(const std::vector<Map_Layer>& layers, size_t _layer_count, const Point& origin) {
+	if (layer_count != _layer_count) {
+		invalidateAll();
+		layer_count = _layer_count;
+	}
+
+	// the chunk images were cleared by a window resize, a graphics reload or a render target reset
+	if (target_generation != render_device->getTargetGeneration()) {
+		invalidateAll();
+		target_generation = render_device->getTargetGeneration();
+	}
+
+	if (layer_count == 0 || chunks.empty())
+		return;
+
+	frame++;
+
+	const int left = -origin.x - grid_pos.x;
+	const int top = -origin.y - grid_pos.y;
+
+	const int cx1 = std::max(0, floorDiv(left, chunk_size.x));
+	const int cy1 = std::max(0, floorDiv(top, chunk_size.y));
+	const int cx2 = std::min(grid_size.x - 1, floorDiv(left + settings->view_w - 1, chunk_size.x));
+	const int cy2 = std::min(grid_size.y - 1, floorDiv(top + settings->view_h - 1, chunk_size.y));
+
+	for (int cy = cy1; cy <= cy2; ++cy) {
+		for (int cx = cx1; cx <= cx2; ++cx) {
+			Chunk& chunk = chunks[cy * grid_size.x + cx];
+			if (chunk.dirty)
+				renderChunk(cx, cy, layers);
+
+			// chunks without any tiles don't have an image
+			if (!chunk.sprite)
+				continue;
+
+			chunk.last_used = frame;
+			chunk.sprite->setDest(grid_pos.x + cx * chunk_size.x + origin.x, grid_pos.y + cy * chunk_size.y + origin.y);
+			render_device->render(chunk.sprite);
+		}
+	}
+
+	freeUnusedChunks();
+}
+
+/**
+ * Draws all tiles that touch this chunk, in the same order as MapRenderer draws them
+ */
+void TileChunkCache::renderChunk(int cx, int cy, const std::vector<Map_Layer>& layers) {
+	Chunk& chunk = chunks[cy * grid_size.x + cx];
+	freeChunk(chunk);
+	chunk.dirty = false;
+
+	const Rect chunk_rect(grid_pos.x + cx * chunk_size.x, grid_pos.y + cy * chunk_size.y, chunk_size.x, chunk_size.y);
+
+	// range of tile centers that can be drawn on this chunk
+	const int min_x = chunk_rect.x - tile_bounds.x - tile_bounds.w + 1;
+	const int max_x = chunk_rect.x + chunk_rect.w - tile_bounds.x - 1;
+	const int min_y = chunk_rect.y - tile_bounds.y - tile_bounds.h + 1;
+	const int max_y = chunk_rect.y + chunk_rect.h - tile_bounds.y - 1;
+
+	if (eset->tileset.orientation == eset->tileset.TILESET_ISOMETRIC) {
+		// tiles are drawn in rows of (x + y), from left to right (x - y)
+		const int s1 = std::max(0, ceilDiv(min_y, eset->tileset.tile_h_half));
+		const int s2 = std::min(map_w + map_h - 2, floorDiv(max_y, eset->tileset.tile_h_half));
+		const int d1 = ceilDiv(min_x, eset->tileset.tile_w_half);
+		const int d2 = floorDiv(max_x, eset->tileset.tile_w_half);
+
+		for (size_t layer = 0; layer < layer_count; ++layer) {
+			for (int s = s1; s <= s2; ++s) {
+				const int d_start = std::max(d1, std::max(-s, s - 2 * (map_h - 1)));
+				const int d_end = std::min(d2, std::min(s, 2 * (map_w - 1) - s));
+
+				for (int d = d_start; d <= d_end; ++d) {
+					if ((s + d) % 2 != 0)
+						continue;
+
+					const int x = (s + d) / 2;
+					const int y = s - x;
+					if (const unsigned short tile_id = layers[layer].get(x, y))
+						renderTile(chunk, chunk_rect, getTilePos(x, y), tile_id);
+				}
+			}
+		}
+	}
+	else {
+		const int x1 = std::max(0, ceilDiv(min_x, eset->tileset.tile_w));
+		const int x2 = std::min(map_w - 1, floorDiv(max_x, eset->tileset.tile_w));
+		const int y1 = std::max(0, ceilDiv(min_y, eset->tileset.tile_h));
+		const int y2 = std::min(map_h - 1, floorDiv(max_y, eset->tileset.tile_h));
+
+		for (size_t layer = 0; layer < layer_count; ++layer) {
+			for (int y = y1; y <= y2; ++y) {
+				for (int x = x1; x <= x2; ++x) {
+					if (const unsigned short tile_id = layers[layer].get(x, y))
+						renderTile(chunk, chunk_rect, getTilePos(x, y), tile_id);
+				}
+			}
+		}
+	}
+}
+
+void TileChunkCache::renderTile(Chunk& chunk, const Rect& chunk_rect, const Point& tile_pos, unsigned short tile_id) {
+	const Tile_Def& tile = tile_set->tiles[tile_id];
+	if (!tile.tile)
+		return;
+
+	Rect clip = tile.tile->getClip();
+	Rect dest;
+	dest.x = tile_pos.x - tile.offset.x - chunk_rect.x;
+	dest.y = tile_pos.y - tile.offset.y - chunk_rect.y;
+	dest.w = clip.w;
+	dest.h = clip.h;
+
+	if (dest.x >= chunk_rect.w || dest.y >= chunk_rect.h || dest.x + dest.w <= 0 || dest.y + dest.h <= 0)
+		return;
+
+	// the image is only created once there is something to draw on it
+	if (!chunk.sprite) {
+		Image *graphics = render_device->createImage(chunk_rect.w, chunk_rect.h);
+		if (!graphics)
+			return;
+
+		chunk.sprite = graphics->createSprite();
+		chunk.sprite->blend_mode = Renderable::BLEND_PREMULTIPLIED;
+		chunk.sprite->getGraphics()->fillWithColor(Color(0,0,0,0));
+		graphics->unref();
+		chunk_count++;
+	}
+
+	render_device->renderToImage(tile.tile->getGraphics(), clip, chunk.sprite->getGraphics(), dest);
+}
+
+void TileChunkCache::freeChunk(Chunk& chunk) {
+	if (!chunk.sprite)
+		return;
+
+	delete chunk.sprite;
+	chunk.sprite = NULL;
+	chunk.dirty = true;
+	chunk_count--;
+}
+
+/**
+ * Frees the least recently drawn chunks until at most MAX_CHUNKS images are left.
+ * Chunks drawn in the current frame are always kept.
+ */
+void TileChunkCache::freeUnusedChunks() {
+	while (chunk_count > MAX_CHUNKS) {
+		Chunk* oldest = NULL;
+		for (size_t i = 0; i < chunks.size(); ++i) {
+			if (chunks[i].sprite && chunks[i].last_used != frame && (!oldest || chunks[i].last_used < oldest->last_used))
+				oldest = &chunks[i];
+		}
+
+		if (!oldest)
+			break;
+
+		freeChunk(*oldest);
+	}
+}
+
+Point TileChunkCache::getTilePos(int x, int y) {
+	if (eset->tileset.orientation == eset->tileset.TILESET_ISOMETRIC)
+		return Point((x - y) * eset->tileset.tile_w_half, (x + y) * eset->tileset.tile_h_half);
+	else
+		return Point(x * eset->tileset.tile_w, y * eset->tileset.tile_h);
+}
@@ -0,0 +1,96 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class TileChunkCache
+ *
+ * Keeps pre-rendered images ("chunks") of the map layers that are drawn below the object layer.
+ * Chunks are screen-aligned rectangles of CHUNK_TILES x CHUNK_TILES tiles, so blitting the visible
+ * chunks gives the same picture as drawing every tile of those layers in the regular order.
+ *
+ * Chunks are rendered the first time they become visible and are re-rendered only after one of
+ * their tiles was changed with invalidateTile(), or after the render device lost the contents of its
+ * render targets. Chunks that were not visible for a while are freed.
+ *
+ * Tiles are blended onto transparent chunks, which leaves the chunk colors multiplied by their alpha.
+ * Chunks are therefore drawn with Renderable::BLEND_PREMULTIPLIED, so that alpha isn't applied twice.
+ */
+
+#ifndef TILE_CHUNK_CACHE_H
+#define TILE_CHUNK_CACHE_H
+
+#include "CommonIncludes.h"
+#include "MapLayer.h"
+#include "Utils.h"
+
+class Sprite;
+class TileSet;
+
+class TileChunkCache {
+public:
+	static const int CHUNK_TILES = 16;
+	static const size_t MAX_CHUNKS = 32;
+
+	TileChunkCache();
+	~TileChunkCache();
+
+	// prepares the cache for a map of the given size. Must be called after the tile set is loaded
+	void init(int _map_w, int _map_h, const TileSet* _tile_set);
+	void clear();
+
+	void invalidateAll();
+	void invalidateTile(int x, int y);
+
+	// draws layers [0, layer_count). origin is the screen position of the center of tile (0, 0)
+	void render(const std::vector<Map_Layer>& layers, size_t layer_count, const Point& origin);
+
+	// position of the center of a tile relative to the center of tile (0, 0), in pixels
+	static Point getTilePos(int x, int y);
+
+private:
+	class Chunk {
+	public:
+		Sprite* sprite;
+		bool dirty;
+		unsigned last_used;
+		Chunk();
+	};
+
+	void renderChunk(int cx, int cy, const std::vector<Map_Layer>& layers);
+	void renderTile(Chunk& chunk, const Rect& chunk_rect, const Point& tile_pos, unsigned short tile_id);
+	void freeChunk(Chunk& chunk);
+	void freeUnusedChunks();
+
+	int map_w;
+	int map_h;
+	const TileSet* tile_set;
+
+	// bounding box of every tile in the tile set, relative to the tile center
+	Rect tile_bounds;
+
+	Point chunk_size;
+	Point grid_pos; // pixel position of the top left corner of chunk (0, 0), relative to the center of tile (0, 0)
+	Point grid_size;
+	std::vector<Chunk> chunks;
+
+	size_t layer_count;
+	size_t chunk_count;
+	unsigned frame;
+	unsigned target_generation;
+};
+
+#endif
@@ -189,6 +189,24 @@ void TileSet::logic() {
 	}
 }
 
+void TileSet::getImageFilenames(const std::string& filename, std::vector<std::string>& image_filenames) {
+	image_filenames.clear();
+
+	FileParser infile;
+	if (!infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NONE))
+		return;
+
+	while (infile.next()) {
+		if (infile.key == "img" && !infile.val.empty())
+			image_filenames.push_back(infile.val);
+	}
+	infile.close();
+}
+
+bool TileSet::isAnimated(size_t index) const {
+	return index < anim.size() && anim[index].frames > 0;
+}
+
 TileSet::~TileSet() {
 	for (size_t i = 0; i < sprites.size(); ++i) {
 		if (sprites[i])
@@ -77,6 +77,12 @@ public:
 	void load(const std::string& filename);
 	void logic();
 
+	// the tile sheet images used by a tileset definition, without loading them
+	static void getImageFilenames(const std::string& filename, std::vector<std::string>& image_filenames);
+
+	// true if the tile is changed by logic()
+	bool isAnimated(size_t index) const;
+
 	std::vector<Tile_Def> tiles;
 
 	// oversize of the largest tile available, in number of tiles.
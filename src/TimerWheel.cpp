@@ -0,0 +1,253 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "Settings.h"
+#include "SharedResources.h"
+#include "TimerWheel.h"
+#include "Utils.h"
+
+TimerWheel::Entry::Entry()
+	: deadline(0)
+	, duration(0)
+	, serial(0)
+	, active(false)
+{
+}
+
+TimerWheel::SlotEntry::SlotEntry(size_t _id, unsigned _serial)
+	: id(_id)
+	, serial(_serial)
+{
+}
+
+TimerWheel::TimerWheel()
+	: now(0)
+{
+}
+
+TimerWheel::~TimerWheel() {
+}
+
+void TimerWheel::clear() {
+	entries.clear();
+	free_ids.clear();
+	slots.clear();
+	now = 0;
+}
+
+/**
+ * Ends all timers, but keeps their durations
+ */
+void TimerWheel::resetAll() {
+	for (size_t i = 0; i < entries.size(); ++i) {
+		entries[i].active = false;
+		entries[i].serial++;
+	}
+	for (size_t i = 0; i < slots.size(); ++i) {
+		slots[i].clear();
+	}
+}
+
+/**
+ * Advance all timers by one frame
+ * The listener, if given, is told about every timer that reached its end. It is called after the wheel is
+ * done with this tick, so it may start, stop or remove timers.
+ */
+void TimerWheel::tick(Listener* listener) {
+	now++;
+
+	if (slots.empty())
+		return;
+
+	// when a lower level wraps around, the matching slot of the level above is spread out over the lower levels
+	// higher levels go first, since they can drop timers into the slot of the level below that's about to be cascaded
+	unsigned wrapped = 0;
+	while (wrapped + 1 < LEVEL_COUNT && ((now >> (SLOT_BITS * (wrapped + 1))) << (SLOT_BITS * (wrapped + 1))) == now) {
+		wrapped++;
+	}
+	for (unsigned level = wrapped; level > 0; --level) {
+		cascade(level);
+	}
+
+	std::vector<SlotEntry>& slot = getSlot(0, now);
+	for (size_t i = 0; i < slot.size(); ++i) {
+		if (!isValid(slot[i]))
+			continue;
+
+		Entry& e = entries[slot[i].id];
+		if (e.deadline != now)
+			continue;
+
+		e.active = false;
+		if (listener)
+			expired_buffer.push_back(slot[i].id);
+	}
+	slot.clear();
+
+	if (!listener)
+		return;
+
+	// the listener can start new timers, so it gets the ids from a copy
+	std::vector<size_t> expired;
+	expired.swap(expired_buffer);
+	for (size_t i = 0; i < expired.size(); ++i) {
+		listener->onTimerEnd(expired[i]);
+	}
+	expired.clear();
+	expired_buffer.swap(expired);
+}
+
+/**
+ * Starts a timer with an unused id and returns the id
+ */
+size_t TimerWheel::add(unsigned duration) {
+	size_t id = entries.size();
+	if (!free_ids.empty()) {
+		id = free_ids.back();
+		free_ids.pop_back();
+	}
+
+	setDuration(id, duration);
+	return id;
+}
+
+/**
+ * Stops a timer that was started with add(), so that its id can be handed out again
+ */
+void TimerWheel::remove(size_t id) {
+	if (id >= entries.size())
+		return;
+
+	entries[id].duration = 0;
+	start(id, 0);
+	free_ids.push_back(id);
+}
+
+/**
+ * Starts the timer with the given id from the beginning. A duration of 0 stops the timer.
+ */
+void TimerWheel::setDuration(size_t id, unsigned val) {
+	if (id >= entries.size())
+		entries.resize(id + 1);
+
+	entries[id].duration = val;
+	start(id, val);
+}
+
+void TimerWheel::reset(size_t id, int type) {
+	if (id >= entries.size())
+		return;
+
+	if (type == Timer::END) {
+		entries[id].active = false;
+		entries[id].serial++;
+	}
+	else if (type == Timer::BEGIN) {
+		start(id, entries[id].duration);
+	}
+}
+
+unsigned TimerWheel::getCurrent(size_t id) const {
+	if (id >= entries.size() || !entries[id].active)
+		return 0;
+
+	return static_cast<unsigned>(entries[id].deadline - now);
+}
+
+unsigned TimerWheel::getDuration(size_t id) const {
+	if (id >= entries.size())
+		return 0;
+
+	return entries[id].duration;
+}
+
+bool TimerWheel::isEnd(size_t id) const {
+	return getCurrent(id) == 0;
+}
+
+bool TimerWheel::isBegin(size_t id) const {
+	return getCurrent(id) == getDuration(id);
+}
+
+bool TimerWheel::isWholeSecond(size_t id) const {
+	return getCurrent(id) % settings->max_frames_per_sec == 0;
+}
+
+void TimerWheel::start(size_t id, unsigned val) {
+	Entry& e = entries[id];
+
+	// anything still filed under the old serial is ignored from now on
+	e.serial++;
+	e.active = (val > 0);
+
+	if (!e.active)
+		return;
+
+	e.deadline = now + val;
+	schedule(SlotEntry(id, e.serial));
+}
+
+/**
+ * File a timer into the lowest level that can hold its remaining time
+ * Timers that are further away than the whole wheel wait in the top level and get filed again when it comes around
+ */
+void TimerWheel::schedule(const SlotEntry& slot_entry) {
+	const unsigned long deadline = entries[slot_entry.id].deadline;
+	const unsigned long delta = deadline - now;
+
+	unsigned level = 0;
+	while (level + 1 < LEVEL_COUNT && (delta >> (SLOT_BITS * (level + 1))) > 0) {
+		level++;
+	}
+
+	unsigned long slot_time = deadline;
+	if ((delta >> (SLOT_BITS * LEVEL_COUNT)) > 0) {
+		// the last slot to come around before wrapping
+		slot_time = now + (static_cast<unsigned long>(SLOT_MASK) << (SLOT_BITS * level));
+	}
+
+	if (slots.empty())
+		slots.resize(LEVEL_COUNT * SLOT_COUNT);
+
+	getSlot(level, slot_time).push_back(slot_entry);
+}
+
+void TimerWheel::cascade(unsigned level) {
+	std::vector<SlotEntry>& slot = getSlot(level, now);
+
+	// re-filing can put timers back into this very slot, so work from a copy
+	cascade_buffer.swap(slot);
+	slot.clear();
+
+	for (size_t i = 0; i < cascade_buffer.size(); ++i) {
+		if (isValid(cascade_buffer[i]))
+			schedule(cascade_buffer[i]);
+	}
+	cascade_buffer.clear();
+}
+
+/**
+ * The slot of the given level that comes around at slot_time
+ */
+std::vector<TimerWheel::SlotEntry>& TimerWheel::getSlot(unsigned level, unsigned long slot_time) {
+	return slots[level * SLOT_COUNT + ((slot_time >> (SLOT_BITS * level)) & SLOT_MASK)];
+}
+
+bool TimerWheel::isValid(const SlotEntry& slot_entry) const {
+	const Entry& e = entries[slot_entry.id];
+	return e.active && e.serial == slot_entry.serial;
+}
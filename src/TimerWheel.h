@@ -0,0 +1,104 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class TimerWheel
+ *
+ * A set of countdown timers, addressed by an id (e.g. a PowerID), that share a single tick().
+ * Running timers are filed into a hierarchical timing wheel by their deadline,
+ * so a tick only has to look at the timers that actually expire instead of every timer.
+ * The query functions mirror the Timer class, so readers don't need to keep their own copy of the state.
+ *
+ * Ids are either chosen by the owner (setDuration() on any id), or handed out by add() and given back with remove().
+ * A wheel is a plain value: copying it (e.g. along with a StatBlock) copies every timer, and the copy runs on its own.
+ * The slots are only allocated once a timer is started, so a wheel without running timers is small.
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <cstddef>
+#include <vector>
+
+class TimerWheel {
+public:
+	// gets told about the timers that reach their end during tick()
+	class Listener {
+	public:
+		virtual ~Listener() {}
+		virtual void onTimerEnd(size_t id) = 0;
+	};
+
+	TimerWheel();
+	~TimerWheel();
+
+	void clear();
+	void resetAll();
+	void tick(Listener* listener = NULL);
+
+	size_t add(unsigned duration);
+	void remove(size_t id);
+
+	void setDuration(size_t id, unsigned val);
+	void reset(size_t id, int type);
+
+	unsigned getCurrent(size_t id) const;
+	unsigned getDuration(size_t id) const;
+	bool isEnd(size_t id) const;
+	bool isBegin(size_t id) const;
+	bool isWholeSecond(size_t id) const;
+
+private:
+	static const unsigned SLOT_BITS = 6;
+	static const unsigned SLOT_COUNT = 1 << SLOT_BITS;
+	static const unsigned SLOT_MASK = SLOT_COUNT - 1;
+	static const unsigned LEVEL_COUNT = 4;
+
+	class Entry {
+	public:
+		unsigned long deadline;
+		unsigned duration;
+		unsigned serial;
+		bool active;
+		Entry();
+	};
+
+	class SlotEntry {
+	public:
+		size_t id;
+		unsigned serial;
+		SlotEntry(size_t _id, unsigned _serial);
+	};
+
+	void start(size_t id, unsigned val);
+	void schedule(const SlotEntry& slot_entry);
+	void cascade(unsigned level);
+	bool isValid(const SlotEntry& slot_entry) const;
+	std::vector<SlotEntry>& getSlot(unsigned level, unsigned long slot_time);
+
+	unsigned long now;
+	std::vector<Entry> entries;
+	std::vector<size_t> free_ids;
+
+	// LEVEL_COUNT * SLOT_COUNT slots, level by level. Empty until the first timer is started
+	std::vector< std::vector<SlotEntry> > slots;
+
+	std::vector<SlotEntry> cascade_buffer;
+	std::vector<size_t> expired_buffer;
+};
+
+#endif
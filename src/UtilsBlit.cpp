@@ -0,0 +1,335 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * UtilsBlit
+ *
+ * Row blitters for 32-bit ARGB pixels, used by the software renderer.
+ * SSE2 or NEON is used when the compiler targets it, with a plain C++ version for everything else.
+ */
+
+#include "UtilsBlit.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLIT_SSE2
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && SDL_BYTEORDER == SDL_LIL_ENDIAN
+#define BLIT_NEON
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+/**
+ * x / 255, rounded. Exact for any product of two 8-bit values.
+ */
+inline uint32_t div255(uint32_t x) {
+	x += 128;
+	return (x + (x >> 8)) >> 8;
+}
+
+void blendPixel(uint32_t *dest, uint32_t src, const Color& color_mod, uint8_t alpha_mod) {
+	const uint32_t sa = div255((src >> 24) * alpha_mod);
+	if (sa == 0)
+		return;
+
+	const uint32_t ia = 255 - sa;
+	const uint32_t d = *dest;
+
+	const uint32_t sr = div255(((src >> 16) & 0xff) * color_mod.r);
+	const uint32_t sg = div255(((src >> 8) & 0xff) * color_mod.g);
+	const uint32_t sb = div255((src & 0xff) * color_mod.b);
+
+	const uint32_t a = sa + div255((d >> 24) * ia);
+	const uint32_t r = div255(sr * sa + ((d >> 16) & 0xff) * ia);
+	const uint32_t g = div255(sg * sa + ((d >> 8) & 0xff) * ia);
+	const uint32_t b = div255(sb * sa + (d & 0xff) * ia);
+
+	*dest = (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+void addPixel(uint32_t *dest, uint32_t src, const Color& color_mod, uint8_t alpha_mod) {
+	const uint32_t sa = div255((src >> 24) * alpha_mod);
+	if (sa == 0)
+		return;
+
+	const uint32_t d = *dest;
+
+	uint32_t r = ((d >> 16) & 0xff) + div255(div255(((src >> 16) & 0xff) * color_mod.r) * sa);
+	uint32_t g = ((d >> 8) & 0xff) + div255(div255(((src >> 8) & 0xff) * color_mod.g) * sa);
+	uint32_t b = (d & 0xff) + div255(div255((src & 0xff) * color_mod.b) * sa);
+	if (r > 255) r = 255;
+	if (g > 255) g = 255;
+	if (b > 255) b = 255;
+
+	*dest = (d & 0xff000000) | (r << 16) | (g << 8) | b;
+}
+
+/**
+ * color_mod has to be multiplied by alpha_mod already, since alpha_mod scales every channel of a premultiplied pixel
+ */
+void blendPremultipliedPixel(uint32_t *dest, uint32_t src, const Color& color_mod, uint8_t alpha_mod) {
+	if (src == 0)
+		return;
+
+	const uint32_t sa = div255((src >> 24) * alpha_mod);
+	const uint32_t ia = 255 - sa;
+	const uint32_t d = *dest;
+
+	const uint32_t a = sa + div255((d >> 24) * ia);
+	uint32_t r = div255(((src >> 16) & 0xff) * color_mod.r) + div255(((d >> 16) & 0xff) * ia);
+	uint32_t g = div255(((src >> 8) & 0xff) * color_mod.g) + div255(((d >> 8) & 0xff) * ia);
+	uint32_t b = div255((src & 0xff) * color_mod.b) + div255((d & 0xff) * ia);
+	if (r > 255) r = 255;
+	if (g > 255) g = 255;
+	if (b > 255) b = 255;
+
+	*dest = (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+#if defined(BLIT_SSE2)
+
+/**
+ * Pixels are stored as B, G, R, A bytes. Unpacked, each 16-bit lane holds one channel of two pixels.
+ */
+inline __m128i div255x8(__m128i x) {
+	x = _mm_add_epi16(x, _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+inline __m128i broadcastAlpha(__m128i x) {
+	x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+	return _mm_shufflehi_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+#elif defined(BLIT_NEON)
+
+inline uint8x8_t div255x8(uint16x8_t x) {
+	x = vaddq_u16(x, vdupq_n_u16(128));
+	return vshrn_n_u16(vsraq_n_u16(x, x, 8), 8);
+}
+
+#endif
+
+} // namespace
+
+namespace Blit {
+
+void blendRow(uint32_t *dest, const uint32_t *src, int count, const Color& color_mod, uint8_t alpha_mod) {
+	int i = 0;
+
+#if defined(BLIT_SSE2)
+	const bool no_mods = (color_mod.r == 255 && color_mod.g == 255 && color_mod.b == 255 && alpha_mod == 255);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alpha_mask = _mm_set1_epi32(static_cast<int>(0xff000000));
+	const __m128i mods = _mm_set_epi16(alpha_mod, color_mod.r, color_mod.g, color_mod.b, alpha_mod, color_mod.r, color_mod.g, color_mod.b);
+	const __m128i max_alpha = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+	const __m128i max_value = _mm_set1_epi16(255);
+
+	for (; i + 4 <= count; i += 4) {
+		const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		const __m128i s_alpha = _mm_and_si128(s, alpha_mask);
+
+		// fully transparent pixels are common around sprites, fully opaque ones inside them
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(s_alpha, zero)) == 0xffff)
+			continue;
+		if (no_mods && _mm_movemask_epi8(_mm_cmpeq_epi32(s_alpha, alpha_mask)) == 0xffff) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), s);
+			continue;
+		}
+
+		const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dest + i));
+
+		__m128i s_lo = div255x8(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), mods));
+		__m128i s_hi = div255x8(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), mods));
+		const __m128i a_lo = broadcastAlpha(s_lo);
+		const __m128i a_hi = broadcastAlpha(s_hi);
+
+		// the alpha channel is multiplied by 255 instead of itself, so that dest alpha = src alpha + dest alpha * (1 - src alpha)
+		s_lo = _mm_mullo_epi16(s_lo, _mm_max_epi16(a_lo, max_alpha));
+		s_hi = _mm_mullo_epi16(s_hi, _mm_max_epi16(a_hi, max_alpha));
+
+		const __m128i d_lo = _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(max_value, a_lo));
+		const __m128i d_hi = _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(max_value, a_hi));
+
+		const __m128i out = _mm_packus_epi16(div255x8(_mm_add_epi16(s_lo, d_lo)), div255x8(_mm_add_epi16(s_hi, d_hi)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), out);
+	}
+#elif defined(BLIT_NEON)
+	const uint8x8_t mod_b = vdup_n_u8(color_mod.b);
+	const uint8x8_t mod_g = vdup_n_u8(color_mod.g);
+	const uint8x8_t mod_r = vdup_n_u8(color_mod.r);
+	const uint8x8_t mod_a = vdup_n_u8(alpha_mod);
+	const uint8x8_t max_value = vdup_n_u8(255);
+
+	for (; i + 8 <= count; i += 8) {
+		uint8x8x4_t s = vld4_u8(reinterpret_cast<const uint8_t*>(src + i));
+
+		// skip fully transparent pixels
+		if (vget_lane_u64(vreinterpret_u64_u8(s.val[3]), 0) == 0)
+			continue;
+
+		uint8x8x4_t d = vld4_u8(reinterpret_cast<const uint8_t*>(dest + i));
+
+		const uint8x8_t a = div255x8(vmull_u8(s.val[3], mod_a));
+		const uint8x8_t ia = vsub_u8(max_value, a);
+
+		s.val[0] = div255x8(vmull_u8(s.val[0], mod_b));
+		s.val[1] = div255x8(vmull_u8(s.val[1], mod_g));
+		s.val[2] = div255x8(vmull_u8(s.val[2], mod_r));
+
+		d.val[0] = div255x8(vmlal_u8(vmull_u8(s.val[0], a), d.val[0], ia));
+		d.val[1] = div255x8(vmlal_u8(vmull_u8(s.val[1], a), d.val[1], ia));
+		d.val[2] = div255x8(vmlal_u8(vmull_u8(s.val[2], a), d.val[2], ia));
+		d.val[3] = div255x8(vmlal_u8(vmull_u8(a, max_value), d.val[3], ia));
+
+		vst4_u8(reinterpret_cast<uint8_t*>(dest + i), d);
+	}
+#endif
+
+	for (; i < count; ++i) {
+		blendPixel(dest + i, src[i], color_mod, alpha_mod);
+	}
+}
+
+void addRow(uint32_t *dest, const uint32_t *src, int count, const Color& color_mod, uint8_t alpha_mod) {
+	int i = 0;
+
+#if defined(BLIT_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alpha_mask = _mm_set1_epi32(static_cast<int>(0xff000000));
+	const __m128i mods = _mm_set_epi16(alpha_mod, color_mod.r, color_mod.g, color_mod.b, alpha_mod, color_mod.r, color_mod.g, color_mod.b);
+	const __m128i color_lanes = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+
+	for (; i + 4 <= count; i += 4) {
+		const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alpha_mask), zero)) == 0xffff)
+			continue;
+
+		const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dest + i));
+
+		__m128i s_lo = div255x8(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), mods));
+		__m128i s_hi = div255x8(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), mods));
+
+		// dest alpha is left as it is
+		s_lo = div255x8(_mm_mullo_epi16(s_lo, _mm_and_si128(broadcastAlpha(s_lo), color_lanes)));
+		s_hi = div255x8(_mm_mullo_epi16(s_hi, _mm_and_si128(broadcastAlpha(s_hi), color_lanes)));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_adds_epu8(d, _mm_packus_epi16(s_lo, s_hi)));
+	}
+#elif defined(BLIT_NEON)
+	const uint8x8_t mod_b = vdup_n_u8(color_mod.b);
+	const uint8x8_t mod_g = vdup_n_u8(color_mod.g);
+	const uint8x8_t mod_r = vdup_n_u8(color_mod.r);
+	const uint8x8_t mod_a = vdup_n_u8(alpha_mod);
+
+	for (; i + 8 <= count; i += 8) {
+		const uint8x8x4_t s = vld4_u8(reinterpret_cast<const uint8_t*>(src + i));
+		if (vget_lane_u64(vreinterpret_u64_u8(s.val[3]), 0) == 0)
+			continue;
+
+		uint8x8x4_t d = vld4_u8(reinterpret_cast<const uint8_t*>(dest + i));
+
+		const uint8x8_t a = div255x8(vmull_u8(s.val[3], mod_a));
+
+		d.val[0] = vqadd_u8(d.val[0], div255x8(vmull_u8(div255x8(vmull_u8(s.val[0], mod_b)), a)));
+		d.val[1] = vqadd_u8(d.val[1], div255x8(vmull_u8(div255x8(vmull_u8(s.val[1], mod_g)), a)));
+		d.val[2] = vqadd_u8(d.val[2], div255x8(vmull_u8(div255x8(vmull_u8(s.val[2], mod_r)), a)));
+
+		vst4_u8(reinterpret_cast<uint8_t*>(dest + i), d);
+	}
+#endif
+
+	for (; i < count; ++i) {
+		addPixel(dest + i, src[i], color_mod, alpha_mod);
+	}
+}
+
+void blendPremultipliedRow(uint32_t *dest, const uint32_t *src, int count, const Color& color_mod, uint8_t alpha_mod) {
+	const Color mod(static_cast<uint8_t>(div255(color_mod.r * alpha_mod)), static_cast<uint8_t>(div255(color_mod.g * alpha_mod)), static_cast<uint8_t>(div255(color_mod.b * alpha_mod)));
+	int i = 0;
+
+#if defined(BLIT_SSE2)
+	const bool no_mods = (alpha_mod == 255 && mod.r == 255 && mod.g == 255 && mod.b == 255);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alpha_mask = _mm_set1_epi32(static_cast<int>(0xff000000));
+	const __m128i mods = _mm_set_epi16(alpha_mod, mod.r, mod.g, mod.b, alpha_mod, mod.r, mod.g, mod.b);
+	const __m128i max_value = _mm_set1_epi16(255);
+
+	for (; i + 4 <= count; i += 4) {
+		const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xffff)
+			continue;
+		if (no_mods && _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alpha_mask), alpha_mask)) == 0xffff) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), s);
+			continue;
+		}
+
+		const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dest + i));
+
+		const __m128i s_lo = div255x8(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), mods));
+		const __m128i s_hi = div255x8(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), mods));
+
+		const __m128i d_lo = div255x8(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(max_value, broadcastAlpha(s_lo))));
+		const __m128i d_hi = div255x8(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(max_value, broadcastAlpha(s_hi))));
+
+		const __m128i out = _mm_packus_epi16(_mm_add_epi16(s_lo, d_lo), _mm_add_epi16(s_hi, d_hi));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), out);
+	}
+#elif defined(BLIT_NEON)
+	const uint8x8_t mod_b = vdup_n_u8(mod.b);
+	const uint8x8_t mod_g = vdup_n_u8(mod.g);
+	const uint8x8_t mod_r = vdup_n_u8(mod.r);
+	const uint8x8_t mod_a = vdup_n_u8(alpha_mod);
+	const uint8x8_t max_value = vdup_n_u8(255);
+
+	for (; i + 8 <= count; i += 8) {
+		const uint8x8x4_t s = vld4_u8(reinterpret_cast<const uint8_t*>(src + i));
+		const uint8x8_t any = vorr_u8(vorr_u8(s.val[0], s.val[1]), vorr_u8(s.val[2], s.val[3]));
+		if (vget_lane_u64(vreinterpret_u64_u8(any), 0) == 0)
+			continue;
+
+		uint8x8x4_t d = vld4_u8(reinterpret_cast<const uint8_t*>(dest + i));
+
+		const uint8x8_t a = div255x8(vmull_u8(s.val[3], mod_a));
+		const uint8x8_t ia = vsub_u8(max_value, a);
+
+		d.val[0] = vqadd_u8(div255x8(vmull_u8(s.val[0], mod_b)), div255x8(vmull_u8(d.val[0], ia)));
+		d.val[1] = vqadd_u8(div255x8(vmull_u8(s.val[1], mod_g)), div255x8(vmull_u8(d.val[1], ia)));
+		d.val[2] = vqadd_u8(div255x8(vmull_u8(s.val[2], mod_r)), div255x8(vmull_u8(d.val[2], ia)));
+		d.val[3] = vqadd_u8(a, div255x8(vmull_u8(d.val[3], ia)));
+
+		vst4_u8(reinterpret_cast<uint8_t*>(dest + i), d);
+	}
+#endif
+
+	for (; i < count; ++i) {
+		blendPremultipliedPixel(dest + i, src[i], mod, alpha_mod);
+	}
+}
+
+const char* getBackendName() {
+#if defined(BLIT_SSE2)
+	return "SSE2";
+#elif defined(BLIT_NEON)
+	return "NEON";
+#else
+	return "generic";
+#endif
+}
+
+} // namespace Blit
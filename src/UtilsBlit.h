@@ -0,0 +1,42 @@
+/*
+Copyright © 2026 dugulinghu
+
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * UtilsBlit
+ *
+ * Row blitters for 32-bit ARGB pixels, used by the software renderer.
+ * SSE2 or NEON is used when the compiler targets it, with a plain C++ version for everything else.
+ */
+
+#ifndef UTILS_BLIT_H
+#define UTILS_BLIT_H
+
+#include "CommonIncludes.h"
+#include "Utils.h"
+
+namespace Blit {
+	// color_mod and alpha_mod are applied to the source pixels like SDL_SetSurfaceColorMod() / SDL_SetSurfaceAlphaMod()
+	void blendRow(uint32_t *dest, const uint32_t *src, int count, const Color& color_mod, uint8_t alpha_mod);
+	void addRow(uint32_t *dest, const uint32_t *src, int count, const Color& color_mod, uint8_t alpha_mod);
+
+	// for source pixels that are already multiplied by their alpha, such as images that were drawn onto with renderToImage()
+	void blendPremultipliedRow(uint32_t *dest, const uint32_t *src, int count, const Color& color_mod, uint8_t alpha_mod);
+
+	const char* getBackendName();
+}
+
+#endif
@@ -32,6 +32,13 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include <errno.h>
 #include <stdlib.h>
 
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
 /**
  * Check to see if a directory/folder exists
  */
@@ -40,6 +47,20 @@ bool Filesystem::pathExists(const std::string &path) {
 	return (stat(convertSlashes(path).c_str(), &st) == 0);
 }
 
+/**
+ * Get the size (in bytes) and last modification time of a file
+ * Returns false if the file can't be accessed
+ */
+bool Filesystem::getFileInfo(const std::string &filename, uint64_t *size, int64_t *modified_time) {
+	struct stat st;
+	if (stat(convertSlashes(filename).c_str(), &st) != 0)
+		return false;
+
+	if (size) *size = static_cast<uint64_t>(st.st_size);
+	if (modified_time) *modified_time = static_cast<int64_t>(st.st_mtime);
+	return true;
+}
+
 /**
  * Create this folder if it doesn't already exist
  */
@@ -116,6 +137,36 @@ int Filesystem::getDirList(const std::string &dir, std::vector<std::string> &dir
 	return 0;
 }
 
+/**
+ * Returns the names of all files and all directories in a given directory
+ */
+int Filesystem::getDirContents(const std::string &dir, std::vector<std::string> &files, std::vector<std::string> &dirs) {
+	DIR *dp;
+	struct dirent *dirp;
+	struct stat st;
+
+	if((dp = opendir(convertSlashes(dir).c_str())) == NULL) {
+		return errno;
+	}
+
+	while ((dirp = readdir(dp)) != NULL) {
+		//	do not use dirp->d_type, it's not portable
+		std::string name = std::string(dirp->d_name);
+		if (name == "." || name == "..")
+			continue;
+
+		if (stat(convertSlashes(dir + "/" + name).c_str(), &st) == -1)
+			continue;
+
+		if (S_ISDIR(st.st_mode))
+			dirs.push_back(name);
+		else
+			files.push_back(name);
+	}
+	closedir(dp);
+	return 0;
+}
+
 bool Filesystem::isDirectory(const std::string &path, bool show_error) {
 	std::string clean_path = convertSlashes(path);
 	struct stat st;
@@ -205,6 +256,49 @@ bool Filesystem::renameFile(const std::string &_oldfile, const std::string &_new
 	return true;
 }
 
+/**
+ * Write data to a temporary file, flush it to the disk and then move it over filename.
+ * If writing fails at any point, the existing file is left untouched.
+ */
+bool Filesystem::writeFileAtomic(const std::string &_filename, const std::string &data) {
+	std::string filename = convertSlashes(_filename);
+	std::string temp_filename = filename + ".tmp";
+
+	FILE* file = fopen(temp_filename.c_str(), "w");
+	if (!file) {
+		std::string error_msg = "Filesystem::writeFileAtomic (" + temp_filename + ")";
+		perror(error_msg.c_str());
+		return false;
+	}
+
+	bool success = (fwrite(data.c_str(), 1, data.size(), file) == data.size());
+	success = (fflush(file) == 0) && success;
+#ifdef _WIN32
+	success = success && (_commit(_fileno(file)) == 0);
+#else
+	success = success && (fsync(fileno(file)) == 0);
+#endif
+	success = (fclose(file) == 0) && success;
+
+	if (success) {
+#ifdef _WIN32
+		// rename() can't replace an existing file on Windows
+		success = (MoveFileExA(temp_filename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0);
+#else
+		success = (rename(temp_filename.c_str(), filename.c_str()) == 0);
+#endif
+	}
+
+	if (!success) {
+		std::string error_msg = "Filesystem::writeFileAtomic (" + filename + ")";
+		perror(error_msg.c_str());
+		remove(temp_filename.c_str());
+		return false;
+	}
+
+	return true;
+}
+
 std::string Filesystem::removeTrailingSlash(const std::string& path) {
 	// windows
 	if (!path.empty() && path.at(path.length()-1) == '\\')
@@ -25,7 +25,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #ifndef UTILS_FILE_SYSTEM_H
 #define UTILS_FILE_SYSTEM_H
 
-#include <string>
+#include "CommonIncludes.h"
 
 namespace Filesystem {
 	bool pathExists(const std::string &path);
@@ -33,8 +33,10 @@ namespace Filesystem {
 	bool fileExists(const std::string &filename);
 	int getFileList(const std::string &dir, const std::string &ext, std::vector<std::string> &files);
 	int getDirList(const std::string &dir, std::vector<std::string> &dirs);
+	int getDirContents(const std::string &dir, std::vector<std::string> &files, std::vector<std::string> &dirs);
 
 	bool isDirectory(const std::string &path, bool show_error = true);
+	bool getFileInfo(const std::string &filename, uint64_t *size, int64_t *modified_time);
 
 	bool removeFile(const std::string &file);
 	bool removeDir(const std::string &dir);
@@ -43,6 +45,7 @@ namespace Filesystem {
 	std::string convertSlashes(const std::string& _path);
 
 	bool renameFile(const std::string &_oldfile, const std::string &_newfile);
+	bool writeFileAtomic(const std::string &_filename, const std::string &data);
 
 	std::string removeTrailingSlash(const std::string& path);
 }
@@ -65,7 +65,7 @@ std::string Parse::stripCarriageReturn(const std::string& line) {
 	return line;
 }
 
-std::string Parse::getLine(std::ifstream &infile) {
+std::string Parse::getLine(std::istream &infile) {
 	std::string line;
 	// This is the standard way to check whether a read failed.
 	if (!getline(infile, line))
@@ -27,12 +27,15 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "AnimationManager.h"
 #include "CombatText.h"
+#include "CompiledMap.h"
 #include "DeviceList.h"
 #include "EngineSettings.h"
 #include "GameSwitcher.h"
 #include "InputState.h"
 #include "MessageEngine.h"
+#include "ModArchive.h"
 #include "ModManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "SaveLoad.h"
 #include "SDLFontEngine.h"
@@ -162,6 +165,10 @@ static void init(const CmdLineArgs& cmd_line_args) {
 
 	tooltipm = new TooltipManager();
 
+#ifdef FLARE_PROFILER
+	profiler = new Profiler();
+#endif
+
 	gswitch = new GameSwitcher();
 }
 
@@ -201,7 +208,10 @@ static void mainLoop () {
 			if (inpt->window_minimized && !inpt->window_restored && !inpt->done)
 				break;
 
-			gswitch->logic();
+			{
+				PROFILE_SCOPE(Profiler::SECTION_FRAME_LOGIC);
+				gswitch->logic();
+			}
 			inpt->resetScroll();
 
 			// Engine done means the user escapes the main game menu.
@@ -236,7 +246,15 @@ static void mainLoop () {
 				gswitch->showFPS(last_fps);
 			}
 
-			render_device->commitFrame();
+			gswitch->showProfiler();
+
+			{
+				PROFILE_SCOPE(Profiler::SECTION_COMMIT_FRAME);
+				render_device->commitFrame();
+			}
+
+			if (profiler)
+				profiler->endFrame();
 
 			// calculate the FPS
 			// if the frame completed quickly, we estimate the delay here
@@ -273,16 +291,21 @@ static void cleanup() {
 
 	delete gswitch;
 
+	delete profiler;
+	profiler = NULL;
+
 	delete anim;
 	delete comb;
 	delete font;
 	delete inpt;
-	delete mods;
 	delete msg;
 	delete snd;
 	delete save_load;
 	delete eset;
 
+	// fonts and music read from mod archives while they are open, so the archives have to be closed last
+	delete mods;
+
 	if (render_device)
 		render_device->destroyContext();
 	delete render_device;
@@ -345,6 +368,8 @@ int main(int argc, char *argv[]) {
 	settings = new Settings();
 
 	bool debug_event = false;
+	bool compile_maps = false;
+	std::string pack_mod_dir;
 	bool done = false;
 	CmdLineArgs cmd_line_args;
 
@@ -404,6 +429,12 @@ int main(int argc, char *argv[]) {
 		else if (arg == "safe-video") {
 			settings->safe_video = true;
 		}
+		else if (arg == "compile-maps") {
+			compile_maps = true;
+		}
+		else if (arg == "pack-mod") {
+			pack_mod_dir = parseArgValue(arg_full);
+		}
 		else if (arg == "help") {
 			Utils::logInfo("Command line options:\n\
 --help                   Prints this message.\n\
@@ -417,7 +448,11 @@ int main(int argc, char *argv[]) {
 --load-slot=<SLOT>       Loads a save slot by numerical index.\n\
 --load-script=<SCRIPT>   Execute's a script upon loading a saved game.\n\
                          The script path is mod-relative.\n\
---safe-video             Launches with the minimum video settings.");
+--safe-video             Launches with the minimum video settings.\n\
+--compile-maps           Compiles all maps of the enabled mods to the\n\
+                         binary cache and exits.\n\
+--pack-mod=<DIR>         Packs the mod directory DIR into DIR.flaremod\n\
+                         and exits.");
 			done = true;
 		}
 		else {
@@ -425,6 +460,20 @@ int main(int argc, char *argv[]) {
 		}
 	}
 
+	if (compile_maps && !done) {
+		platform.setPaths();
+		mods = new ModManager(&(cmd_line_args.mod_list));
+		CompiledMap::compileAll();
+		delete mods;
+		mods = NULL;
+		done = true;
+	}
+
+	if (!pack_mod_dir.empty() && !done) {
+		ModArchive::pack(pack_mod_dir, Filesystem::removeTrailingSlash(pack_mod_dir) + ModArchive::EXTENSION);
+		done = true;
+	}
+
 soft_reset:
 	if (!done) {
 		srand(static_cast<unsigned int>(time(NULL)));